@@ -0,0 +1,106 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/AdvancedTimer.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <sstream>
+
+using sofa::helper::AdvancedTimer;
+
+namespace
+{
+
+const unsigned int nbThreads = 4;
+const unsigned int nbIterations = 200;
+
+std::size_t count(const std::string& text, const std::string& pattern)
+{
+    std::size_t nb = 0;
+    for (std::size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos+1))
+        ++nb;
+    return nb;
+}
+
+TEST(AdvancedTimerTest, idsSharedByThreads)
+{
+    std::vector<unsigned int> ids(nbThreads);
+    std::vector<std::thread> threads;
+    for (unsigned int t=0; t<nbThreads; ++t)
+    {
+        threads.push_back(std::thread([&ids, t]()
+        {
+            // create other ids concurrently, which would shift the ids of a per-thread factory
+            for (unsigned int i=0; i<=t; ++i)
+                AdvancedTimer::IdTimer(std::string("idsSharedByThreads_") + std::to_string(t) + "_" + std::to_string(i));
+            ids[t] = AdvancedTimer::IdTimer("idsSharedByThreads");
+        }));
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    for (unsigned int t=0; t<nbThreads; ++t)
+    {
+        EXPECT_EQ(ids[0], ids[t]);
+        EXPECT_EQ("idsSharedByThreads", (std::string)AdvancedTimer::IdTimer(ids[t]));
+    }
+}
+
+TEST(AdvancedTimerTest, timerEndedByThreads)
+{
+    AdvancedTimer::IdTimer id("timerEndedByThreads");
+    AdvancedTimer::setInterval(id, nbThreads*nbIterations);
+    AdvancedTimer::setEnabled(id, true);
+
+    std::vector<std::stringstream> outputs(nbThreads);
+    std::vector<std::thread> threads;
+    for (unsigned int t=0; t<nbThreads; ++t)
+    {
+        threads.push_back(std::thread([&outputs, id, t]()
+        {
+            for (unsigned int i=0; i<nbIterations; ++i)
+            {
+                AdvancedTimer::begin(id);
+                AdvancedTimer::stepBegin("timerEndedByThreadsStep");
+                AdvancedTimer::valSet("timerEndedByThreadsVal", i);
+                AdvancedTimer::stepEnd("timerEndedByThreadsStep");
+                AdvancedTimer::end(id, outputs[t]);
+            }
+        }));
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    std::string output;
+    for (unsigned int t=0; t<nbThreads; ++t)
+        output += outputs[t].str();
+
+    // the iterations of all the threads are merged in the statistics of the timer, which are
+    // printed once the interval is reached
+    EXPECT_EQ(1u, count(output, "Timer: timerEndedByThreads\n"));
+    EXPECT_EQ(1u, count(output, "timerEndedByThreadsStep"));
+    EXPECT_EQ(1u, count(output, "timerEndedByThreadsVal"));
+
+    AdvancedTimer::setEnabled(id, false);
+}
+
+}
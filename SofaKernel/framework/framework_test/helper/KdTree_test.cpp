@@ -136,11 +136,64 @@ struct KdTreeTest: public BaseTest
 
     }
 
+    /// test if kdtree finds the right points within a radius from source to target
+    void testPointsWithinRadius(const unsigned int nbp_source, const unsigned int nbp_target,const Real range, const Real radius)
+    {
+        VecCoord sourceposition;
+        generateRandomPoint(sourceposition,nbp_source,range);
+        VecCoord targetposition;
+        generateRandomPoint(targetposition,nbp_target,range);
+
+        kdT KDT;
+        KDT.build(targetposition);
+
+        for(unsigned int i=0;i<nbp_source;i++)
+        {
+            distanceSet closest_kdt; KDT.getPointsWithinRadius(closest_kdt, sourceposition[i],targetposition,radius);
+            distanceSet closest_brute; getClosetNPoints(closest_brute,sourceposition[i],targetposition,nbp_target);
+            distanceSet::iterator closestKdt=closest_kdt.begin();
+            for(distanceSet::iterator closestBrute=closest_brute.begin();closestBrute!=closest_brute.end() && closestBrute->first<=radius*radius;++closestBrute)
+            {
+                ASSERT_TRUE( closestKdt!=closest_kdt.end() );
+                ASSERT_EQ( closestBrute->second , closestKdt->second);
+                closestKdt++;
+            }
+            ASSERT_TRUE( closestKdt==closest_kdt.end() );
+        }
+    }
+
+    /// test if kdtree built on a subset of target finds the right closest points for all source points at once
+    void testBatchROIPointPointCorrespondences(const unsigned int nbp_source, const unsigned int nbp_target,const Real range)
+    {
+        VecCoord sourceposition;
+        generateRandomPoint(sourceposition,nbp_source,range);
+        VecCoord targetposition;
+        generateRandomPoint(targetposition,nbp_target,range);
+
+        helper::vector<unsigned int> ROI;
+        VecCoord ROIposition;
+        for(unsigned int i=0;i<nbp_target;i+=2) { ROI.push_back(i); ROIposition.push_back(targetposition[i]); }
+
+        kdT KDT;
+        KDT.build(targetposition,ROI);
+
+        helper::vector<unsigned int> closest_kdt; KDT.getClosest(closest_kdt,sourceposition,targetposition);
+        ASSERT_EQ( closest_kdt.size() , nbp_source);
+        for(unsigned int i=0;i<nbp_source;i++)
+        {
+            distanceSet closest_brute; getClosetNPoints(closest_brute,sourceposition[i],ROIposition,1);
+            ASSERT_EQ( ROI[closest_brute.begin()->second] , closest_kdt[i]);
+        }
+    }
+
 };
 
 TEST_F(KdTreeTest, point_point ) {    testPointPointCorrespondences(100,100,10); }
 TEST_F(KdTreeTest, point_Npoints ) {   testPointNPointsCorrespondences(100,100,10,10); }
 TEST_F(KdTreeTest, cached_point_point ) {   testCachedPointPointCorrespondences(100,100,10,0.5,5); }
+TEST_F(KdTreeTest, point_Npoints_large ) {   testPointNPointsCorrespondences(100,10000,10,10); }
+TEST_F(KdTreeTest, point_radius ) {   testPointsWithinRadius(100,1000,10,2); }
+TEST_F(KdTreeTest, batch_roi_point_point ) {   testBatchROIPointPointCorrespondences(100,1000,10); }
 
 
 } // namespace sofa
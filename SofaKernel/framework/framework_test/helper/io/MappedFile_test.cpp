@@ -0,0 +1,111 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/io/MappedFile.h>
+#include <gtest/gtest.h>
+#include <fstream>
+#include <istream>
+#include <string>
+
+using sofa::helper::io::MappedFile;
+using sofa::helper::io::MemoryStreamBuf;
+
+static std::string getPath(std::string s) {
+    return std::string(FRAMEWORK_TEST_RESOURCES_DIR) + std::string("/") + s;
+}
+
+TEST(MappedFileTest, open)
+{
+    const std::string filename = getPath("UtilsTest.ini");
+    std::ifstream file(filename.c_str(), std::ios_base::in | std::ios_base::binary);
+    const std::string expected((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    MappedFile mapped(filename);
+    ASSERT_TRUE(mapped.isOpen());
+    EXPECT_EQ(expected, std::string(mapped.begin(), mapped.end()));
+
+    mapped.close();
+    EXPECT_FALSE(mapped.isOpen());
+    EXPECT_EQ(0u, mapped.size());
+}
+
+TEST(MappedFileTest, openMissingFile)
+{
+    MappedFile mapped(getPath("this-file-does-not-exist.txt"));
+    EXPECT_FALSE(mapped.isOpen());
+}
+
+TEST(MappedFileTest, copyOnWrite)
+{
+    const std::string filename = getPath("UtilsTest.ini");
+    std::ifstream file(filename.c_str(), std::ios_base::in | std::ios_base::binary);
+    const std::string expected((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ASSERT_FALSE(expected.empty());
+
+    MappedFile readOnly(filename);
+    ASSERT_TRUE(readOnly.isOpen());
+    EXPECT_EQ((char*)NULL, readOnly.writableData());
+
+    MappedFile mapped(filename, MappedFile::CopyOnWrite);
+    ASSERT_TRUE(mapped.isOpen());
+    ASSERT_NE((char*)NULL, mapped.writableData());
+    EXPECT_EQ(mapped.begin(), mapped.writableData());
+    EXPECT_EQ(expected, std::string(mapped.begin(), mapped.end()));
+
+    // the modifications are private: neither the file nor its other views change
+    mapped.writableData()[0] = expected[0] == '#' ? ';' : '#';
+    EXPECT_NE(expected[0], *mapped.begin());
+    EXPECT_EQ(expected, std::string(readOnly.begin(), readOnly.end()));
+
+    MappedFile reopened(filename);
+    EXPECT_EQ(expected, std::string(reopened.begin(), reopened.end()));
+}
+
+TEST(MemoryStreamBufTest, streamAndSeek)
+{
+    const std::string content = "first line\nsecond 2 3.5\n";
+    MemoryStreamBuf buffer(content.data(), content.data() + content.size());
+    std::istream in(&buffer);
+
+    std::string line;
+    std::getline(in, line);
+    EXPECT_EQ("first line", line);
+
+    const std::istream::pos_type position = in.tellg();
+    EXPECT_EQ(11, (int)position);
+
+    std::string word;
+    int i = 0;
+    double d = 0;
+    in >> word >> i >> d;
+    EXPECT_EQ("second", word);
+    EXPECT_EQ(2, i);
+    EXPECT_EQ(3.5, d);
+
+    in.seekg(position);
+    EXPECT_EQ('s', *buffer.current());
+    buffer.advance(7);
+    in >> i;
+    EXPECT_EQ(2, i);
+
+    buffer.advance(1000);
+    EXPECT_EQ(buffer.end(), buffer.current());
+}
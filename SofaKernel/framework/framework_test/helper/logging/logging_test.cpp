@@ -23,6 +23,8 @@
 #include <exception>
 #include <algorithm>
 #include <thread>
+#include <cstdio>
+#include <iterator>
 
 #include <iostream>
 using std::endl ;
@@ -54,6 +56,18 @@ using sofa::helper::logging::MainRoutingMessageHandler ;
 #include <sofa/helper/logging/ConsoleMessageHandler.h>
 using sofa::helper::logging::ConsoleMessageHandler ;
 
+#include <sofa/helper/logging/SilentMessageHandler.h>
+using sofa::helper::logging::SilentMessageHandler ;
+
+#include <sofa/helper/logging/FileMessageHandler.h>
+using sofa::helper::logging::FileMessageHandler ;
+
+#include <sofa/helper/logging/AsyncMessageHandler.h>
+using sofa::helper::logging::AsyncMessageHandler ;
+
+#include <sofa/helper/logging/RateLimitingMessageHandler.h>
+using sofa::helper::logging::RateLimitingMessageHandler ;
+
 #include <sofa/core/logging/PerComponentLoggingMessageHandler.h>
 using sofa::helper::logging::PerComponentLoggingMessageHandler ;
 using sofa::helper::logging::MainPerComponentLoggingMessageHandler ;
@@ -628,3 +642,147 @@ TEST(LoggingTest, checkRoutingMessageHandler)
 
     delete consolehandler ;
 }
+
+static int countConstructions(int& counter)
+{
+    return ++counter ;
+}
+
+TEST(LoggingTest, checkAcceptedTypes)
+{
+    MessageDispatcher::clearHandlers() ;
+    SilentMessageHandler silent ;
+    MessageDispatcher::addHandler(&silent) ;
+
+    EXPECT_FALSE( MessageDispatcher::isAccepted(Message::Info) ) ;
+    EXPECT_FALSE( MessageDispatcher::isAccepted(Message::Warning) ) ;
+
+    /// the messages nobody accepts are not even built
+    int counter = 0 ;
+    msg_info("") << "never built " << countConstructions(counter) ;
+    msg_advice("") << "never built " << countConstructions(counter) ;
+    msg_warning_when(true, "") << "never built " << countConstructions(counter) ;
+    EXPECT_EQ( counter, 0 ) ;
+
+    MyMessageHandler h ;
+    MessageDispatcher::addHandler(&h) ;
+    EXPECT_TRUE( MessageDispatcher::isAccepted(Message::Info) ) ;
+
+    msg_info("") << "built " << countConstructions(counter) ;
+    msg_warning_when(true, "") << "built " << countConstructions(counter) ;
+    EXPECT_EQ( counter, 2 ) ;
+    EXPECT_EQ( h.numMessages(), 2u ) ;
+
+    MessageDispatcher::rmHandler(&h) ;
+    EXPECT_FALSE( MessageDispatcher::isAccepted(Message::Info) ) ;
+
+    MessageDispatcher::clearHandlers() ;
+}
+
+TEST(LoggingTest, checkConsoleAndFileAcceptedTypes)
+{
+    MessageDispatcher::clearHandlers() ;
+    ConsoleMessageHandler console ;
+    console.setAcceptedTypes({Message::Warning, Message::Error, Message::Fatal}) ;
+    MessageDispatcher::addHandler(&console) ;
+
+    EXPECT_FALSE( MessageDispatcher::isAccepted(Message::Info) ) ;
+    EXPECT_TRUE( MessageDispatcher::isAccepted(Message::Warning) ) ;
+
+    int counter = 0 ;
+    msg_info("") << "never built " << countConstructions(counter) ;
+    EXPECT_EQ( counter, 0 ) ;
+
+    MessageDispatcher::clearHandlers() ;
+    const std::string filename = "checkConsoleAndFileAcceptedTypes.log" ;
+    {
+        FileMessageHandler file(filename.c_str()) ;
+        ASSERT_TRUE( file.isValid() ) ;
+        file.setAcceptedTypes({Message::Error}) ;
+        MessageDispatcher::addHandler(&file) ;
+
+        EXPECT_FALSE( MessageDispatcher::isAccepted(Message::Warning) ) ;
+        EXPECT_TRUE( MessageDispatcher::isAccepted(Message::Error) ) ;
+
+        msg_warning("") << "discarded warning" ;
+        msg_error("") << "saved error" ;
+        MessageDispatcher::clearHandlers() ;
+    }
+
+    std::ifstream in(filename.c_str()) ;
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>()) ;
+    in.close() ;
+    std::remove(filename.c_str()) ;
+    EXPECT_NE( content.find("saved error"), std::string::npos ) ;
+    EXPECT_EQ( content.find("discarded warning"), std::string::npos ) ;
+
+    /// a file handler which could not open its file accepts nothing
+    {
+        FileMessageHandler invalid("") ;
+        EXPECT_FALSE( invalid.isValid() ) ;
+        EXPECT_FALSE( invalid.accepts(Message::Error) ) ;
+    }
+}
+
+TEST(LoggingTest, checkAsyncMessageHandler)
+{
+    MessageDispatcher::clearHandlers() ;
+    MyMessageHandler h ;
+    {
+        AsyncMessageHandler async(&h) ;
+        MessageDispatcher::addHandler(&async) ;
+
+        /// more messages than the size of the queue, from several threads
+        auto emit = []()
+        {
+            for(unsigned int i=0;i<300;i++)
+                msg_warning("") << "asynchronous message " << i ;
+        } ;
+        std::thread t1(emit) ;
+        std::thread t2(emit) ;
+        emit() ;
+        t1.join() ;
+        t2.join() ;
+
+        async.flush() ;
+        EXPECT_EQ( h.numMessages(), 900u ) ;
+
+        msg_info("") << "last message" ;
+        MessageDispatcher::rmHandler(&async) ;
+    }
+    /// the pending messages are processed when the handler is destroyed
+    ASSERT_EQ( h.numMessages(), 901u ) ;
+    EXPECT_EQ( h.lastMessage().messageAsString(), "last message" ) ;
+}
+
+TEST(LoggingTest, checkRateLimitingMessageHandler)
+{
+    MessageDispatcher::clearHandlers() ;
+    MyMessageHandler h ;
+    RateLimitingMessageHandler limiter(&h, 3, 1000.0) ;
+    MessageDispatcher::addHandler(&limiter) ;
+
+    /// only the first messages of a call site are forwarded
+    for(unsigned int i=0;i<10;i++)
+        msg_warning("") << "different message " << i ;
+    EXPECT_EQ( h.numMessages(), 3u ) ;
+
+    /// repeated messages are forwarded once
+    for(unsigned int i=0;i<5;i++)
+        msg_warning("") << "same message" ;
+    EXPECT_EQ( h.numMessages(), 4u ) ;
+    EXPECT_EQ( limiter.getSuppressedCount(), 11u ) ;
+
+    /// messages without file information are always forwarded
+    Message m(Message::Runtime, Message::Warning) ;
+    for(unsigned int i=0;i<5;i++)
+        MessageDispatcher::process(m) ;
+    EXPECT_EQ( h.numMessages(), 9u ) ;
+
+    /// one report per call site with suppressed messages
+    limiter.flush() ;
+    EXPECT_EQ( h.numMessages(), 11u ) ;
+    EXPECT_EQ( h.lastMessage().type(), Message::Warning ) ;
+
+    MessageDispatcher::clearHandlers() ;
+}
@@ -0,0 +1,105 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <sofa/helper/system/thread/TripleBuffer.h>
+#include <gtest/gtest.h>
+#include <thread>
+
+using sofa::helper::system::thread::TripleBuffer;
+
+TEST(TripleBufferTest, publishAndAcquire)
+{
+    TripleBuffer buffers;
+    EXPECT_FALSE(buffers.acquire());
+
+    // the buffers of the two threads and the published one are always different
+    const unsigned int first = buffers.backBuffer();
+    EXPECT_NE(buffers.frontBuffer(), first);
+    const unsigned int second = buffers.publish();
+    EXPECT_NE(first, second);
+    EXPECT_NE(buffers.frontBuffer(), second);
+
+    EXPECT_TRUE(buffers.acquire());
+    EXPECT_EQ(first, buffers.frontBuffer());
+    EXPECT_FALSE(buffers.acquire());
+
+    // a buffer which is not acquired is given back to the producer by the next publication
+    const unsigned int third = buffers.publish();
+    EXPECT_NE(first, third);
+    const unsigned int fourth = buffers.publish();
+    EXPECT_EQ(second, fourth);
+
+    EXPECT_TRUE(buffers.acquire());
+    EXPECT_EQ(third, buffers.frontBuffer());
+    EXPECT_NE(fourth, buffers.frontBuffer());
+}
+
+TEST(TripleBufferTest, producerAndConsumerThreads)
+{
+    static const int nbPublications = 20000;
+    static const int bufferSize = 64;
+
+    TripleBuffer buffers;
+    int content[3][bufferSize] = {};
+
+    // the producer fills its buffer with the number of the publication
+    std::thread producer([&]()
+    {
+        for (int publication = 1; publication <= nbPublications; ++publication)
+        {
+            int* buffer = content[buffers.backBuffer()];
+            for (int i = 0; i < bufferSize; ++i)
+                buffer[i] = publication;
+            buffers.publish();
+        }
+    });
+
+    // the consumer must always read whole and increasingly recent publications
+    int nbAcquired = 0, nbErrors = 0, lastPublication = 0;
+    while (lastPublication < nbPublications)
+    {
+        if (!buffers.acquire())
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        ++nbAcquired;
+
+        const int* buffer = content[buffers.frontBuffer()];
+        const int publication = buffer[0];
+        if (publication <= lastPublication)
+            ++nbErrors;
+        for (int i = 1; i < bufferSize; ++i)
+        {
+            if (buffer[i] != publication)
+                ++nbErrors;
+        }
+        lastPublication = publication;
+    }
+
+    producer.join();
+
+    EXPECT_EQ(0, nbErrors);
+    EXPECT_EQ(nbPublications, lastPublication);
+    EXPECT_GT(nbAcquired, 0);
+    EXPECT_FALSE(buffers.acquire());
+}
@@ -0,0 +1,281 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/core/BinaryDataIO.h>
+#include <sofa/core/objectmodel/Data.h>
+#include <sofa/core/loader/PrimitiveGroup.h>
+#include <sofa/core/topology/Topology.h>
+#include <sofa/defaulttype/DataTypeInfo.h>
+
+#include <memory>
+#include <sstream>
+
+namespace sofa
+{
+
+namespace core
+{
+
+namespace
+{
+
+enum BinaryDataEncoding
+{
+    BINARYDATA_RAW = 0,     ///< number of values followed by the memory of the values
+    BINARYDATA_TEXT = 1,    ///< text representation of the value
+    BINARYDATA_GROUPS = 2,  ///< vector of primitive groups
+    BINARYDATA_INDICES = 3  ///< vector of vectors of indices
+};
+
+typedef helper::vector< loader::PrimitiveGroup > VecPrimitiveGroup;
+typedef helper::vector< helper::vector< topology::Topology::ElemID > > VecIndices;
+
+/// Values which can be copied in and out as a single block of memory
+bool isRawCopyable(const defaulttype::AbstractTypeInfo* typeinfo)
+{
+    return typeinfo->ValidInfo() && typeinfo->SimpleLayout() && !typeinfo->Text()
+            && typeinfo->BaseType()->FixedSize();
+}
+
+void writeValue(BinaryDataWriter& out, const loader::PrimitiveGroup& group)
+{
+    out.write(group.groupName);
+    out.write(group.materialName);
+    out.write((int32_t)group.materialId);
+    out.write((int32_t)group.p0);
+    out.write((int32_t)group.nbp);
+}
+
+void writeValue(BinaryDataWriter& out, const helper::vector< topology::Topology::ElemID >& indices)
+{
+    out.write((uint64_t)indices.size());
+    if (!indices.empty())
+        out.write(&indices[0], indices.size() * sizeof(topology::Topology::ElemID));
+}
+
+template<class T>
+void writeValue(BinaryDataWriter& out, const helper::vector<T>& values)
+{
+    out.write((uint64_t)values.size());
+    for (std::size_t i = 0; i < values.size(); ++i)
+        writeValue(out, values[i]);
+}
+
+bool readValue(BinaryDataReader& in, loader::PrimitiveGroup& group)
+{
+    int32_t materialId = 0, p0 = 0, nbp = 0;
+    if (!in.read(group.groupName) || !in.read(group.materialName)
+            || !in.read(materialId) || !in.read(p0) || !in.read(nbp))
+        return false;
+    group.materialId = materialId;
+    group.p0 = p0;
+    group.nbp = nbp;
+    return true;
+}
+
+bool readValue(BinaryDataReader& in, helper::vector< topology::Topology::ElemID >& indices)
+{
+    uint64_t size = 0;
+    if (!in.read(size) || size > (uint64_t)((std::size_t)-1 / sizeof(topology::Topology::ElemID)))
+        return false;
+    const char* p = in.readBytes((std::size_t)size * sizeof(topology::Topology::ElemID));
+    if (!p)
+        return false;
+    indices.resize((std::size_t)size);
+    if (size > 0)
+        std::memcpy(&indices[0], p, (std::size_t)size * sizeof(topology::Topology::ElemID));
+    return true;
+}
+
+template<class T>
+bool readValue(BinaryDataReader& in, helper::vector<T>& values)
+{
+    uint64_t size = 0;
+    if (!in.read(size))
+        return false;
+    values.clear();
+    for (uint64_t i = 0; i < size; ++i)
+    {
+        T value;
+        if (!readValue(in, value))
+            return false;
+        values.push_back(value);
+    }
+    return true;
+}
+
+template<class T>
+bool assignValue(const BinaryDataValue& value, objectmodel::BaseData* data)
+{
+    objectmodel::Data<T>* typedData = dynamic_cast< objectmodel::Data<T>* >(data);
+    if (!typedData)
+        return false;
+    BinaryDataReader in(value.begin, value.end);
+    T v;
+    if (!readValue(in, v) || !in.atEnd())
+        return false;
+    helper::WriteOnlyAccessor< objectmodel::Data<T> > w = *typedData;
+    w.wref().swap(v);
+    return true;
+}
+
+} // anonymous namespace
+
+void BinaryDataWriter::write(const std::string& value)
+{
+    write((uint64_t)value.size());
+    write(value.data(), value.size());
+}
+
+void BinaryDataWriter::writeData(const objectmodel::BaseData* data)
+{
+    const defaulttype::AbstractTypeInfo* typeinfo = data->getValueTypeInfo();
+    write(data->getName());
+    write(data->getValueTypeString());
+
+    if (isRawCopyable(typeinfo))
+    {
+        const void* value = data->getValueVoidPtr();
+        const uint64_t nbValues = typeinfo->size(value);
+        const uint64_t nbBytes = nbValues * typeinfo->byteSize();
+        write((uint8_t)BINARYDATA_RAW);
+        write((uint64_t)(sizeof(uint64_t) + nbBytes));
+        write(nbValues);
+        if (nbBytes > 0)
+            write(typeinfo->getValuePtr(value), (std::size_t)nbBytes);
+        return;
+    }
+
+    std::ostringstream payload;
+    BinaryDataWriter payloadWriter(payload);
+    uint8_t encoding = BINARYDATA_TEXT;
+    if (const objectmodel::Data<VecPrimitiveGroup>* groups = dynamic_cast< const objectmodel::Data<VecPrimitiveGroup>* >(data))
+    {
+        encoding = BINARYDATA_GROUPS;
+        writeValue(payloadWriter, groups->getValue());
+    }
+    else if (const objectmodel::Data<VecIndices>* indices = dynamic_cast< const objectmodel::Data<VecIndices>* >(data))
+    {
+        encoding = BINARYDATA_INDICES;
+        writeValue(payloadWriter, indices->getValue());
+    }
+    else
+    {
+        const std::string text = data->getValueString();
+        payloadWriter.write(text.data(), text.size());
+    }
+    const std::string bytes = payload.str();
+    write(encoding);
+    write(bytes);
+}
+
+bool BinaryDataReader::read(std::string& value)
+{
+    uint64_t size = 0;
+    if (!read(size))
+        return false;
+    const char* p = readBytes((std::size_t)size);
+    if (!p)
+        return false;
+    value.assign(p, (std::size_t)size);
+    return true;
+}
+
+bool BinaryDataReader::readData(BinaryDataValue& value)
+{
+    uint64_t size = 0;
+    if (!read(value.name) || !read(value.typeName) || !read(value.encoding) || !read(size))
+        return false;
+    value.begin = readBytes((std::size_t)size);
+    if (!value.begin)
+        return false;
+    value.end = value.begin + size;
+    return true;
+}
+
+bool BinaryDataValue::canAssign(const objectmodel::BaseData* data) const
+{
+    if (!data || data->getValueTypeString() != typeName)
+        return false;
+
+    switch (encoding)
+    {
+    case BINARYDATA_RAW:
+    {
+        const defaulttype::AbstractTypeInfo* typeinfo = data->getValueTypeInfo();
+        uint64_t nbValues = 0;
+        if (!isRawCopyable(typeinfo) || !BinaryDataReader(begin, end).read(nbValues))
+            return false;
+        return (uint64_t)(end - begin) == sizeof(uint64_t) + nbValues * typeinfo->byteSize();
+    }
+    case BINARYDATA_TEXT:
+        return true;
+    case BINARYDATA_GROUPS:
+        return dynamic_cast< const objectmodel::Data<VecPrimitiveGroup>* >(data) != NULL;
+    case BINARYDATA_INDICES:
+        return dynamic_cast< const objectmodel::Data<VecIndices>* >(data) != NULL;
+    default:
+        return false;
+    }
+}
+
+bool BinaryDataValue::assign(objectmodel::BaseData* data) const
+{
+    if (!canAssign(data))
+        return false;
+
+    switch (encoding)
+    {
+    case BINARYDATA_RAW:
+    {
+        const defaulttype::AbstractTypeInfo* typeinfo = data->getValueTypeInfo();
+        uint64_t nbValues = 0;
+        BinaryDataReader(begin, end).read(nbValues);
+        const std::size_t nbBytes = (std::size_t)(end - begin) - sizeof(uint64_t);
+        void* value = data->beginEditVoidPtr();
+        typeinfo->setSize(value, (std::size_t)nbValues);
+        const bool validSize = (typeinfo->size(value) == nbValues);
+        if (validSize && nbBytes > 0)
+            std::memcpy(typeinfo->getValuePtr(value), begin + sizeof(uint64_t), nbBytes);
+        data->endEditVoidPtr();
+        return validSize;
+    }
+    case BINARYDATA_TEXT:
+    {
+        // the text is parsed in a new instance of the Data, which already holds the value of an empty text:
+        // the default value of the type
+        std::unique_ptr<objectmodel::BaseData> value(data->getNewInstance());
+        if (!value || (begin != end && !value->read(std::string(begin, end))))
+            return false;
+        return data->copyValue(value.get());
+    }
+    case BINARYDATA_GROUPS:
+        return assignValue<VecPrimitiveGroup>(*this, data);
+    case BINARYDATA_INDICES:
+        return assignValue<VecIndices>(*this, data);
+    default:
+        return false;
+    }
+}
+
+} // namespace core
+
+} // namespace sofa
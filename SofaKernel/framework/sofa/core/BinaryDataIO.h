@@ -0,0 +1,126 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_CORE_BINARYDATAIO_H
+#define SOFA_CORE_BINARYDATAIO_H
+
+#include <sofa/core/core.h>
+#include <sofa/core/objectmodel/BaseData.h>
+
+#include <ostream>
+#include <string>
+#include <cstring>
+#include <stdint.h>
+
+namespace sofa
+{
+
+namespace core
+{
+
+/// Binary serialization of Data values, used to store the content of components in caches and snapshots.
+///
+/// Values with a simple memory layout (vectors of coordinates, of fixed-size elements...) are stored as raw
+/// memory, primitive groups and nested index lists use a dedicated encoding as their text representation
+/// does not round-trip, and all other values are stored as their text representation.
+/// The files are meant to be read back on the same platform: no byte swapping is done.
+class SOFA_CORE_API BinaryDataWriter
+{
+public:
+    BinaryDataWriter(std::ostream& out) : m_out(out) {}
+
+    void write(const void* data, std::size_t size) { m_out.write((const char*)data, (std::streamsize)size); }
+
+    template<class T>
+    void write(const T& value) { write(&value, sizeof(T)); }
+
+    void write(const std::string& value);
+
+    /// Write the name, the type and the value of a Data
+    void writeData(const objectmodel::BaseData* data);
+
+    bool good() const { return m_out.good(); }
+
+protected:
+    std::ostream& m_out;
+};
+
+/// Value of a Data written by BinaryDataWriter::writeData, pointing to the memory it was read from
+struct SOFA_CORE_API BinaryDataValue
+{
+    std::string name;
+    std::string typeName;
+    uint8_t encoding;
+    const char* begin;
+    const char* end;
+
+    BinaryDataValue() : encoding(0), begin(NULL), end(NULL) {}
+
+    /// Return true if the value can be assigned to the given Data (same type, valid encoding)
+    bool canAssign(const objectmodel::BaseData* data) const;
+
+    /// Assign the value to the given Data
+    bool assign(objectmodel::BaseData* data) const;
+};
+
+/// Reading of values written by BinaryDataWriter from memory (typically a mapped file)
+class SOFA_CORE_API BinaryDataReader
+{
+public:
+    BinaryDataReader(const char* begin, const char* end) : m_current(begin), m_end(end) {}
+
+    /// Return a pointer to the next size bytes, or NULL if there are not enough bytes left
+    const char* readBytes(std::size_t size)
+    {
+        if ((std::size_t)(m_end - m_current) < size)
+            return NULL;
+        const char* p = m_current;
+        m_current += size;
+        return p;
+    }
+
+    template<class T>
+    bool read(T& value)
+    {
+        const char* p = readBytes(sizeof(T));
+        if (!p) return false;
+        std::memcpy(&value, p, sizeof(T));
+        return true;
+    }
+
+    bool read(std::string& value);
+
+    /// Read a value written by BinaryDataWriter::writeData
+    bool readData(BinaryDataValue& value);
+
+    const char* current() const { return m_current; }
+    bool atEnd() const { return m_current == m_end; }
+
+protected:
+    const char* m_current;
+    const char* m_end;
+};
+
+} // namespace core
+
+} // namespace sofa
+
+#endif // SOFA_CORE_BINARYDATAIO_H
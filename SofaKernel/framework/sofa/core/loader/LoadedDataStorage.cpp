@@ -0,0 +1,121 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/core/loader/LoadedDataStorage.h>
+
+namespace sofa
+{
+
+namespace core
+{
+
+namespace loader
+{
+
+LoadedDataStorage& LoadedDataStorage::getInstance()
+{
+    static LoadedDataStorage instance;
+    return instance;
+}
+
+LoadedDataStorage::~LoadedDataStorage()
+{
+    for (std::map<std::string, Entry>::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+        for (std::size_t i = 0; i < it->second.values.size(); ++i)
+            delete it->second.values[i];
+}
+
+bool LoadedDataStorage::share(const std::string& key, objectmodel::Base* loader)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::map<std::string, Entry>::iterator it = m_entries.find(key);
+    if (it == m_entries.end())
+        return false;
+
+    const helper::vector<objectmodel::BaseData*>& values = it->second.values;
+    helper::vector<objectmodel::BaseData*> fields(values.size());
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+        fields[i] = loader->findData(values[i]->getName());
+        if (!fields[i] || fields[i]->getValueTypeInfo() != values[i]->getValueTypeInfo())
+            return false;
+    }
+
+    for (std::size_t i = 0; i < values.size(); ++i)
+        fields[i]->shareValue(values[i]);
+    ++it->second.nbRefs;
+    return true;
+}
+
+void LoadedDataStorage::store(const std::string& key, const helper::vector<objectmodel::BaseData*>& values)
+{
+    helper::vector<objectmodel::BaseData*> copies;
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+        objectmodel::BaseData* copy = values[i]->getNewInstance();
+        if (!copy || !copy->shareValue(values[i]))
+        {
+            delete copy;
+            for (std::size_t j = 0; j < copies.size(); ++j)
+                delete copies[j];
+            return;
+        }
+        copy->setName(values[i]->getName());
+        copies.push_back(copy);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Entry& entry = m_entries[key];
+    if (entry.values.empty())
+        entry.values.swap(copies);
+    ++entry.nbRefs;
+    for (std::size_t j = 0; j < copies.size(); ++j)
+        delete copies[j];
+}
+
+void LoadedDataStorage::release(const std::string& key)
+{
+    helper::vector<objectmodel::BaseData*> values;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<std::string, Entry>::iterator it = m_entries.find(key);
+        if (it == m_entries.end())
+            return;
+        if (--it->second.nbRefs > 0)
+            return;
+        values.swap(it->second.values);
+        m_entries.erase(it);
+    }
+    for (std::size_t i = 0; i < values.size(); ++i)
+        delete values[i];
+}
+
+std::size_t LoadedDataStorage::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+} // namespace loader
+
+} // namespace core
+
+} // namespace sofa
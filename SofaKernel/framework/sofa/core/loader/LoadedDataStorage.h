@@ -0,0 +1,99 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_CORE_LOADER_LOADEDDATASTORAGE_H
+#define SOFA_CORE_LOADER_LOADEDDATASTORAGE_H
+
+#include <sofa/core/objectmodel/Base.h>
+#include <sofa/core/objectmodel/BaseData.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace sofa
+{
+
+namespace core
+{
+
+namespace loader
+{
+
+/**
+ *  \brief Process-wide storage of the values produced by loaders.
+ *
+ *  The values are stored under a key identifying the loaded content (typically the loader
+ *  class, the file and its modification time, and the loader parameters). Loaders producing
+ *  the same key share the stored values instead of loading the file again: the Data of types
+ *  using copy-on-write (e.g. vectors) then refer to the same memory, which is only duplicated
+ *  by the loader modifying it (see BaseData::shareValue()).
+ *
+ *  Each loader sharing an entry holds a reference on it, an entry is removed when its last
+ *  loader releases it.
+ */
+class SOFA_CORE_API LoadedDataStorage
+{
+public:
+    static LoadedDataStorage& getInstance();
+
+    /// Make the Data of the loader share the values stored for the key, and hold a reference on them.
+    /// @return false if there are no values for this key, or if they do not match the Data of
+    /// the loader (in that case the loader is left unchanged).
+    bool share(const std::string& key, objectmodel::Base* loader);
+
+    /// Store the values of the given Data for the key, and hold a reference on them.
+    /// The values are only stored if there are none yet for this key.
+    void store(const std::string& key, const helper::vector<objectmodel::BaseData*>& values);
+
+    /// Release a reference held by share() or store()
+    void release(const std::string& key);
+
+    /// Number of stored entries
+    std::size_t size() const;
+
+protected:
+    LoadedDataStorage() {}
+    ~LoadedDataStorage();
+
+    struct Entry
+    {
+        helper::vector<objectmodel::BaseData*> values; ///< detached Data sharing the stored values
+        int nbRefs;
+
+        Entry() : nbRefs(0) {}
+    };
+
+    std::map<std::string, Entry> m_entries;
+    mutable std::mutex m_mutex;
+
+private:
+    LoadedDataStorage(const LoadedDataStorage&);
+    LoadedDataStorage& operator=(const LoadedDataStorage&);
+};
+
+} // namespace loader
+
+} // namespace core
+
+} // namespace sofa
+
+#endif
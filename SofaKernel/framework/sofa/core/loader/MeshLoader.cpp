@@ -20,8 +20,20 @@
 * Contact information: contact@sofa-framework.org                             *
 ******************************************************************************/
 #include <sofa/core/loader/MeshLoader.h>
+#include <sofa/core/loader/LoadedDataStorage.h>
+#include <sofa/core/BinaryDataIO.h>
 #include <sofa/helper/io/Mesh.h>
+#include <sofa/helper/io/MappedFile.h>
+#include <sofa/helper/system/FileSystem.h>
+#include <boost/filesystem/operations.hpp>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <memory>
+#include <functional>
 
 namespace sofa
 {
@@ -67,6 +79,9 @@ MeshLoader::MeshLoader() : BaseLoader()
     , d_rotation(initData(&d_rotation, Vector3(), "rotation", "Rotation of the DOFs"))
     , d_scale(initData(&d_scale, Vector3(1.0, 1.0, 1.0), "scale3d", "Scale of the DOFs in 3 dimensions"))
     , d_transformation(initData(&d_transformation, Matrix4::s_identity, "transformation", "4x4 Homogeneous matrix to transform the DOFs (when present replace any)"))
+    , d_useCache(initData(&d_useCache, false, "useCache", "Store the loaded mesh in a binary file of the cache directory (with the .meshcache extension), and read it instead of the source file while it is up to date"))
+    , d_cacheDirectory(initData(&d_cacheDirectory, "cacheDirectory", "Directory of the cache files, by default the sofa-meshcache directory of the temporary directory of the system"))
+    , d_shareData(initData(&d_shareData, false, "shareData", "Share the loaded mesh with the other loaders of the process loading the same file with the same parameters. The memory is duplicated only for the loaders modifying it."))
     , d_previousTransformation( Matrix4::s_identity )
 {
     addAlias(&d_tetrahedra, "tetras");
@@ -82,6 +97,9 @@ MeshLoader::MeshLoader() : BaseLoader()
     d_scale.setAutoLink(false);
     d_transformation.setAutoLink(false);
     d_transformation.setDirtyValue();
+    d_useCache.setAutoLink(false);
+    d_cacheDirectory.setAutoLink(false);
+    d_shareData.setAutoLink(false);
 
     d_positions.setPersistent(false);
     d_polylines.setPersistent(false);
@@ -109,13 +127,26 @@ void MeshLoader::parse(sofa::core::objectmodel::BaseObjectDescription* arg)
 
     bool success = false;
     if (canLoad())
-        success = load(/*m_filename.getFullPath().c_str()*/);
+    {
+        if (d_shareData.getValue())
+            success = loadShared();
+        else if (d_useCache.getValue())
+            success = loadWithCache();
+        else
+            success = load(/*m_filename.getFullPath().c_str()*/);
+    }
 
     // File not loaded, component is set to invalid
     if (!success)
         m_componentstate = sofa::core::objectmodel::ComponentState::Invalid;
 }
 
+MeshLoader::~MeshLoader()
+{
+    if (!m_sharedKey.empty())
+        LoadedDataStorage::getInstance().release(m_sharedKey);
+}
+
 void MeshLoader::init()
 {
     BaseLoader::init();
@@ -167,6 +198,225 @@ bool MeshLoader::canLoad()
     return BaseLoader::canLoad();
 }
 
+namespace
+{
+
+const char meshCacheMagic[8] = { 'S', 'O', 'F', 'A', 'M', 'S', 'H', '\0' };
+const uint32_t meshCacheVersion = 1;
+const uint32_t meshCacheEndianness = 0x01020304;
+
+/// Data modified since their counters were recorded
+helper::vector<objectmodel::BaseData*> getModifiedFields(const objectmodel::Base::VecData& fields, const std::vector<int>& counters)
+{
+    helper::vector<objectmodel::BaseData*> modified;
+    for (std::size_t i = 0; i < fields.size(); ++i)
+        if (fields[i]->getCounter() != counters[i])
+            modified.push_back(fields[i]);
+    return modified;
+}
+
+} // anonymous namespace
+
+std::string MeshLoader::getCacheFilename() const
+{
+    std::string directory = d_cacheDirectory.getValue();
+    if (directory.empty())
+    {
+        boost::system::error_code error;
+        const boost::filesystem::path temp = boost::filesystem::temp_directory_path(error);
+        if (error)
+            return std::string();
+        directory = temp.string() + "/sofa-meshcache";
+    }
+
+    // the files of the same name are told apart by the hash of their path, and the key
+    // stored in the cache is checked anyway
+    const std::string& filename = m_filename.getFullPath();
+    std::ostringstream out;
+    out << directory << '/' << helper::system::FileSystem::stripDirectory(filename) << '-'
+        << std::hex << std::setw(16) << std::setfill('0') << (unsigned long long)std::hash<std::string>()(filename)
+        << ".meshcache";
+    return out.str();
+}
+
+std::string MeshLoader::getCacheKey() const
+{
+    const std::string& filename = m_filename.getFullPath();
+    unsigned long long size = 0;
+    long long lastWriteTime = 0;
+    if (!helper::system::FileSystem::getFileInfo(filename, size, lastWriteTime))
+        return std::string();
+
+    std::ostringstream key;
+    key << getClassName() << getTemplateName() << '\n'
+        << filename << '\n' << size << ' ' << lastWriteTime << '\n';
+
+    // parameters given to the loader, which may change what load() produces
+    const VecData& fields = this->getDataFields();
+    for (std::size_t i = 0; i < fields.size(); ++i)
+    {
+        const objectmodel::BaseData* data = fields[i];
+        if (!data->isSet() || data == &m_filename || data == &d_useCache || data == &d_cacheDirectory || data == &d_shareData || data == &name
+                || data == &f_printLog || data == &f_tags || data == &f_bbox || data == &f_listening)
+            continue;
+        key << data->getName() << '=' << data->getValueString() << '\n';
+    }
+    return key.str();
+}
+
+bool MeshLoader::loadWithCache()
+{
+    const std::string key = getCacheKey();
+    if (!key.empty() && readCache(key))
+    {
+        msg_info() << "Mesh read from the cache file " << getCacheFilename();
+        return true;
+    }
+
+    // the outputs of load() are the Data it modifies
+    const VecData fields = this->getDataFields();
+    std::vector<int> counters(fields.size());
+    for (std::size_t i = 0; i < fields.size(); ++i)
+        counters[i] = fields[i]->getCounter();
+
+    if (!load())
+        return false;
+
+    if (key.empty())
+        return true;
+
+    if (this->getDataFields().size() != fields.size())
+    {
+        msg_info() << "Mesh not cached: the loaded file defines additional data fields.";
+        return true;
+    }
+
+    const helper::vector<objectmodel::BaseData*> outputs = getModifiedFields(fields, counters);
+    if (!writeCache(key, outputs))
+        msg_warning() << "Unable to write the cache file " << getCacheFilename();
+    return true;
+}
+
+bool MeshLoader::loadShared()
+{
+    LoadedDataStorage& storage = LoadedDataStorage::getInstance();
+    if (!m_sharedKey.empty())
+    {
+        storage.release(m_sharedKey);
+        m_sharedKey.clear();
+    }
+
+    const std::string key = getCacheKey();
+    if (!key.empty() && storage.share(key, this))
+    {
+        msg_info() << "Mesh shared with another loader of " << m_filename.getFullPath();
+        m_sharedKey = key;
+        return true;
+    }
+
+    const VecData fields = this->getDataFields();
+    std::vector<int> counters(fields.size());
+    for (std::size_t i = 0; i < fields.size(); ++i)
+        counters[i] = fields[i]->getCounter();
+
+    const bool success = d_useCache.getValue() ? loadWithCache() : load();
+    if (!success || key.empty())
+        return success;
+
+    if (this->getDataFields().size() != fields.size())
+    {
+        msg_info() << "Mesh not shared: the loaded file defines additional data fields.";
+        return true;
+    }
+
+    storage.store(key, getModifiedFields(fields, counters));
+    m_sharedKey = key;
+    return true;
+}
+
+bool MeshLoader::readCache(const std::string& key)
+{
+    helper::io::MappedFile file;
+    if (!file.open(getCacheFilename()))
+        return false;
+
+    BinaryDataReader in(file.begin(), file.end());
+    const char* magic = in.readBytes(sizeof(meshCacheMagic));
+    uint32_t version = 0, endianness = 0;
+    std::string cacheKey;
+    uint32_t nbValues = 0;
+    if (!magic || std::memcmp(magic, meshCacheMagic, sizeof(meshCacheMagic)) != 0
+            || !in.read(version) || version != meshCacheVersion
+            || !in.read(endianness) || endianness != meshCacheEndianness
+            || !in.read(cacheKey) || cacheKey != key
+            || !in.read(nbValues))
+        return false;
+
+    // check the whole content before modifying any Data
+    std::vector<BinaryDataValue> values(nbValues);
+    std::vector<objectmodel::BaseData*> fields(nbValues);
+    for (uint32_t i = 0; i < nbValues; ++i)
+    {
+        if (!in.readData(values[i]))
+            return false;
+        fields[i] = this->findData(values[i].name);
+        if (!values[i].canAssign(fields[i]))
+            return false;
+    }
+
+    // the values are assigned to new instances of the Data, which are copied to the loader
+    // only once they are all valid, so that a failure leaves the loader unchanged
+    std::vector< std::unique_ptr<objectmodel::BaseData> > newValues(nbValues);
+    for (uint32_t i = 0; i < nbValues; ++i)
+    {
+        newValues[i].reset(fields[i]->getNewInstance());
+        if (!newValues[i] || !values[i].assign(newValues[i].get()))
+            return false;
+    }
+
+    for (uint32_t i = 0; i < nbValues; ++i)
+        fields[i]->copyValue(newValues[i].get());
+    return true;
+}
+
+bool MeshLoader::writeCache(const std::string& key, const helper::vector<objectmodel::BaseData*>& outputs)
+{
+    // write to a temporary file first, so that other processes never read a partial cache
+    const std::string filename = getCacheFilename();
+    if (filename.empty())
+        return false;
+    helper::system::FileSystem::findOrCreateAValidPath(helper::system::FileSystem::getParentDirectory(filename));
+    const std::string tmpFilename = filename + ".tmp";
+    {
+        std::ofstream file(tmpFilename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+
+        BinaryDataWriter out(file);
+        out.write(meshCacheMagic, sizeof(meshCacheMagic));
+        out.write(meshCacheVersion);
+        out.write(meshCacheEndianness);
+        out.write(key);
+        out.write((uint32_t)outputs.size());
+        for (std::size_t i = 0; i < outputs.size(); ++i)
+            out.writeData(outputs[i]);
+        if (!out.good())
+        {
+            file.close();
+            std::remove(tmpFilename.c_str());
+            return false;
+        }
+    }
+
+    std::remove(filename.c_str());
+    if (std::rename(tmpFilename.c_str(), filename.c_str()) != 0)
+    {
+        std::remove(tmpFilename.c_str());
+        return false;
+    }
+    return true;
+}
+
 void MeshLoader::updateMesh()
 {
     updateElements();
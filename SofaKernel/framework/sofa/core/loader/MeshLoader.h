@@ -81,6 +81,7 @@ public:
 
 protected:
     MeshLoader();
+    virtual ~MeshLoader();
 public:
     virtual bool canLoad() override;
 
@@ -180,6 +181,10 @@ public:
     Data< Vector3 > d_scale; ///< Scale of the DOFs in 3 dimensions
     Data< defaulttype::Matrix4 > d_transformation; ///< 4x4 Homogeneous matrix to transform the DOFs (when present replace any)
 
+    Data< bool > d_useCache; ///< Store the loaded mesh in a binary file of the cache directory, and read it instead of the source file while it is up to date
+    Data< std::string > d_cacheDirectory; ///< Directory of the cache files, by default the sofa-meshcache directory of the temporary directory of the system
+    Data< bool > d_shareData; ///< Share the loaded mesh with the other loaders of the process loading the same file with the same parameters
+
 
     virtual void updateMesh();
     virtual void updateElements();
@@ -225,6 +230,27 @@ protected:
     void addPyramid(helper::vector< Pyramid>* pPyramids,
                     Topology::ElemID p0, Topology::ElemID p1, Topology::ElemID p2, Topology::ElemID p3, Topology::ElemID p4);
 
+    /// @name Binary cache of the loaded mesh
+    /// The cache stores the Data modified by load(). It is written in a file of the cache directory,
+    /// so that the directory of the loaded file may be read-only (see getCacheFilename()), and is
+    /// only used when its key matches getCacheKey().
+    /// @{
+    /// Call load(), reading the mesh from the cache when it is up to date and updating it otherwise
+    bool loadWithCache();
+    /// Name of the cache file, or an empty string when there is no cache directory
+    std::string getCacheFilename() const;
+    /// Key identifying the loaded file (path, size, modification time) and the loader parameters
+    std::string getCacheKey() const;
+    bool readCache(const std::string& key);
+    bool writeCache(const std::string& key, const helper::vector<objectmodel::BaseData*>& outputs);
+    /// @}
+
+    /// Share the mesh loaded by another loader with the same key (see LoadedDataStorage),
+    /// or load it and make it available to the following loaders
+    bool loadShared();
+    /// Key of the values shared in the LoadedDataStorage, empty if none
+    std::string m_sharedKey;
+
     /// Temporary method that will copy all buffers from a io::Mesh into the corresponding Data. Will be removed as soon as work on unifying meshloader is finished
     void copyMeshToData(helper::io::Mesh* _mesh);
 };
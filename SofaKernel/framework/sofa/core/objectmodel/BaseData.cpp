@@ -297,6 +297,13 @@ bool BaseData::copyValue(const BaseData* parent)
     return false;
 }
 
+bool BaseData::shareValue(const BaseData* source)
+{
+    if (source->getValueTypeInfo() != getValueTypeInfo())
+        return false;
+    return copyValue(source);
+}
+
 bool BaseData::findDataLinkDest(DDGNode*& ptr, const std::string& path, const BaseLink* link)
 {
     return DDGNode::findDataLinkDest(ptr, path, link);
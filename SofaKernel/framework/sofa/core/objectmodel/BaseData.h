@@ -154,6 +154,14 @@ public:
     /// @return true if the copy was successful.
     virtual bool copyValue(const BaseData* parent);
 
+    /// Share the value of another Data of the same type.
+    ///
+    /// For types using copy-on-write, both Data then refer to the same memory until one
+    /// of them is modified, the other types are copied.
+    /// Like copyValue(), this is a one-time operation and not a permanent link.
+    /// @return false if the Data types differ.
+    virtual bool shareValue(const BaseData* source);
+
     /// Copy the value of an aspect into another one.
     virtual void copyAspect(int destAspect, int srcAspect) = 0;
 
@@ -302,6 +302,16 @@ void BaseObject::reset()
 void BaseObject::cleanup()
 { }
 
+bool BaseObject::writeSnapshotState(std::ostream& /*out*/) const
+{
+    return false;
+}
+
+bool BaseObject::readSnapshotState(std::istream& /*in*/)
+{
+    return false;
+}
+
 /// Handle an event
 void BaseObject::handleEvent( Event* /*e*/ )
 {
@@ -123,6 +123,14 @@ public:
     /// so any references this object holds should still be valid.
     virtual void cleanup();
 
+    /// Write the internal state computed by init() which is not stored in Data, so that it can be saved
+    /// in scene snapshots. Return false if this object does not support it (the default).
+    virtual bool writeSnapshotState(std::ostream& out) const;
+
+    /// Restore a state written by writeSnapshotState(). When a scene snapshot is restored, it is called
+    /// before init(), which can then skip the computation of this state.
+    virtual bool readSnapshotState(std::istream& in);
+
     /// @}
 
     /// Render internal data of this object, for debugging purposes.
@@ -509,6 +509,16 @@ public:
     virtual T* virtualBeginEdit() { return beginEdit(); }
     virtual void virtualEndEdit() { endEdit(); }
 
+    virtual bool shareValue(const BaseData* source)
+    {
+        const Data<T>* d = dynamic_cast< const Data<T>* >(source);
+        if (!d)
+            return BaseData::shareValue(source);
+        d->getValue(); // make sure the source is up to date
+        virtualSetLink(*d);
+        return true;
+    }
+
 
     /// @}
 
@@ -0,0 +1,237 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_CORE_TOPOLOGY_ELEMENTSELECTION_H
+#define SOFA_CORE_TOPOLOGY_ELEMENTSELECTION_H
+
+#include <sofa/core/topology/BaseMeshTopology.h>
+
+#include <cstring>
+
+namespace sofa
+{
+
+namespace core
+{
+
+namespace topology
+{
+
+/**
+ * Selection of the points of a mesh by a test on their positions, as computed by the ROI engines.
+ *
+ * The positions of the last test are kept, so that an update only tests again the points which
+ * moved since, and returns them to update the selections of elements.
+ */
+template<class VecCoord>
+class PointSelection
+{
+public:
+    typedef BaseMeshTopology::index_type Index;
+    typedef BaseMeshTopology::SetIndex SetIndex;
+
+    /// Test all the points
+    template<class Test>
+    void select(const VecCoord& x, Test test)
+    {
+        m_positions = x;
+        m_selected.resize(x.size());
+        for (std::size_t i = 0; i < x.size(); ++i)
+            m_selected[i] = test((Index)i);
+    }
+
+    /// Test again the points which moved since the last test, and return them in movedPoints.
+    /// The number of points must not have changed. Return true if the selection changed.
+    template<class Test>
+    bool update(const VecCoord& x, Test test, helper::vector<Index>& movedPoints)
+    {
+        movedPoints.clear();
+        bool changed = false;
+        for (std::size_t i = 0; i < x.size(); ++i)
+        {
+            // exact comparison, the comparison operators of the coordinates use a threshold
+            if (std::memcmp(&x[i], &m_positions[i], sizeof(x[i])) == 0)
+                continue;
+            m_positions[i] = x[i];
+            movedPoints.push_back((Index)i);
+            const bool selected = test((Index)i);
+            if (selected != (bool)m_selected[i])
+            {
+                m_selected[i] = selected;
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    /// Get the indices of the selected points and their positions, in increasing order
+    void getSelection(const VecCoord& x, SetIndex& indices, VecCoord& selected) const
+    {
+        indices.clear();
+        selected.clear();
+        for (std::size_t i = 0; i < m_selected.size(); ++i)
+        {
+            if (m_selected[i])
+            {
+                indices.push_back((Index)i);
+                selected.push_back(x[i]);
+            }
+        }
+    }
+
+    void clear()
+    {
+        m_positions.clear();
+        m_selected.clear();
+    }
+
+    bool isSelected(Index i) const { return m_selected[i] != 0; }
+
+    std::size_t size() const { return m_selected.size(); }
+
+protected:
+    VecCoord m_positions; ///< positions of the last test
+    helper::vector<char> m_selected;
+};
+
+
+/**
+ * Selection of mesh elements (edges, triangles, ...) by a test on the positions of their points,
+ * as computed by the ROI engines.
+ *
+ * When only some points moved, the selection can be updated by testing again only the elements
+ * using these points. The elements around each point are computed at the first such update.
+ */
+template<class Element>
+class ElementSelection
+{
+public:
+    typedef BaseMeshTopology::index_type Index;
+    typedef BaseMeshTopology::SetIndex SetIndex;
+
+    /// Test all the elements
+    template<class Test>
+    void select(const helper::vector<Element>& elements, Test test)
+    {
+        m_selected.resize(elements.size());
+        for (std::size_t i = 0; i < elements.size(); ++i)
+            m_selected[i] = test(elements[i]);
+        m_firstElement.clear();
+        m_elements.clear();
+    }
+
+    /// Test again the elements using one of the given points.
+    /// Return true if the selection changed.
+    template<class Test>
+    bool update(const helper::vector<Element>& elements, const helper::vector<Index>& points, std::size_t nbPoints, Test test)
+    {
+        if (m_firstElement.size() != nbPoints + 1)
+            computeElementsAroundPoints(elements, nbPoints);
+
+        bool changed = false;
+        for (std::size_t i = 0; i < points.size(); ++i)
+        {
+            const Index p = points[i];
+            if (p >= nbPoints)
+                continue;
+            for (Index j = m_firstElement[p]; j < m_firstElement[p + 1]; ++j)
+            {
+                const Index e = m_elements[j];
+                if (m_tested[e])
+                    continue;
+                m_tested[e] = true;
+                m_testedElements.push_back(e);
+                const bool selected = test(elements[e]);
+                if (selected != (bool)m_selected[e])
+                {
+                    m_selected[e] = selected;
+                    changed = true;
+                }
+            }
+        }
+        for (std::size_t i = 0; i < m_testedElements.size(); ++i)
+            m_tested[m_testedElements[i]] = false;
+        m_testedElements.clear();
+        return changed;
+    }
+
+    /// Get the indices of the selected elements and these elements, in increasing order
+    void getSelection(const helper::vector<Element>& elements, SetIndex& indices, helper::vector<Element>& selected) const
+    {
+        indices.clear();
+        selected.clear();
+        for (std::size_t i = 0; i < m_selected.size(); ++i)
+        {
+            if (m_selected[i])
+            {
+                indices.push_back((Index)i);
+                selected.push_back(elements[i]);
+            }
+        }
+    }
+
+    void clear()
+    {
+        m_selected.clear();
+        m_firstElement.clear();
+        m_elements.clear();
+    }
+
+    bool isSelected(Index i) const { return m_selected[i] != 0; }
+
+    std::size_t size() const { return m_selected.size(); }
+
+protected:
+    void computeElementsAroundPoints(const helper::vector<Element>& elements, std::size_t nbPoints)
+    {
+        m_firstElement.assign(nbPoints + 1, 0);
+        for (std::size_t i = 0; i < elements.size(); ++i)
+            for (std::size_t j = 0; j < elements[i].size(); ++j)
+                if (elements[i][j] < nbPoints)
+                    ++m_firstElement[elements[i][j] + 1];
+        for (std::size_t p = 0; p < nbPoints; ++p)
+            m_firstElement[p + 1] += m_firstElement[p];
+
+        m_elements.resize(m_firstElement[nbPoints]);
+        helper::vector<Index> next(m_firstElement.begin(), m_firstElement.end() - 1);
+        for (std::size_t i = 0; i < elements.size(); ++i)
+            for (std::size_t j = 0; j < elements[i].size(); ++j)
+                if (elements[i][j] < nbPoints)
+                    m_elements[next[elements[i][j]]++] = (Index)i;
+
+        m_tested.assign(elements.size(), false);
+        m_testedElements.clear();
+    }
+
+    helper::vector<char> m_selected;
+    helper::vector<Index> m_firstElement; ///< index in m_elements of the first element around each point
+    helper::vector<Index> m_elements;     ///< elements around each point
+    helper::vector<char> m_tested;
+    helper::vector<Index> m_testedElements;
+};
+
+} // namespace topology
+
+} // namespace core
+
+} // namespace sofa
+
+#endif
@@ -32,6 +32,8 @@
 #include <cmath>
 #include <cstdlib>
 #include <stack>
+#include <mutex>
+#include <atomic>
 #include <algorithm>
 #include <cctype>
 
@@ -73,11 +75,14 @@ class TimerData
 {
 public:
     AdvancedTimer::IdTimer id;
+    /// Records of the last iteration, moved from the records of the thread which ended it
     helper::vector<Record> records;
     int nbIter;
-    int interval;
+    std::atomic<int> interval;
     int defaultInterval;
     AdvancedTimer::outputType timerOutputType;
+    /// Protects the records and statistics, as the same timer can be ended by several threads
+    std::mutex mutex;
 
     class StepData
     {
@@ -129,7 +134,7 @@ public:
             interval = atoi(val);
         else
             interval = 0;
-        defaultInterval = (interval != 0) ? interval : DEFAULT_INTERVAL;
+        defaultInterval = (interval != 0) ? interval.load() : DEFAULT_INTERVAL;
         this->timerOutputType = AdvancedTimer::outputType::STDOUT;
     }
     void clear();
@@ -142,10 +147,36 @@ public:
 };
 
 std::map< AdvancedTimer::IdTimer, TimerData > timers;
+/// Protects the insertions in the map of timers, which can be reached by several threads
+/// (e.g. independent simulations run concurrently). Each TimerData has its own mutex.
+std::mutex timersMutex;
+
+TimerData& getTimerData(AdvancedTimer::IdTimer id)
+{
+    std::lock_guard<std::mutex> lock(timersMutex);
+    TimerData& data = timers[id];
+    if (!data.id)
+    {
+        data.init(id);
+    }
+    return data;
+}
+
+/// Same as getTimerData, without creating the timer if it was never used
+TimerData* findTimerData(AdvancedTimer::IdTimer id)
+{
+    std::lock_guard<std::mutex> lock(timersMutex);
+    std::map< AdvancedTimer::IdTimer, TimerData >::iterator it = timers.find(id);
+    return (it == timers.end()) ? NULL : &(it->second);
+}
 
 helper::system::atomic<int> activeTimers;
 SOFA_THREAD_SPECIFIC_PTR(std::stack<AdvancedTimer::IdTimer>, curTimerThread);
 SOFA_THREAD_SPECIFIC_PTR(helper::vector<Record>, curRecordsThread);
+/// The records are written in buffers of the current thread, and only merged in the TimerData
+/// (under its lock) when the timer ends
+typedef std::map<unsigned int, helper::vector<Record> > ThreadRecords;
+SOFA_THREAD_SPECIFIC_PTR(ThreadRecords, threadRecordsThread);
 
 std::stack<AdvancedTimer::IdTimer>& getCurTimer()
 {
@@ -158,6 +189,17 @@ std::stack<AdvancedTimer::IdTimer>& getCurTimer()
     return *ptr;
 }
 
+helper::vector<Record>& getThreadRecords(AdvancedTimer::IdTimer id)
+{
+    ThreadRecords* ptr = threadRecordsThread;
+    if (!ptr)
+    {
+        ptr = new ThreadRecords;
+        threadRecordsThread = ptr;
+    }
+    return (*ptr)[id];
+}
+
 helper::vector<Record>* getCurRecords()
 {
     if (!activeTimers) return NULL;
@@ -193,26 +235,22 @@ void AdvancedTimer::clear()
         while (!ptr->empty())
             ptr->pop();
     if (activeTimers == 0)
+    {
+        std::lock_guard<std::mutex> lock(timersMutex);
         timers.clear();
+    }
 }
 
 bool AdvancedTimer::isEnabled(IdTimer id)
 {
-    TimerData& data = timers[id];
-    if (!data.id)
-    {
-        data.init(id);
-    }
+    TimerData& data = getTimerData(id);
     return (data.interval != 0);
 }
 
 void AdvancedTimer::setEnabled(IdTimer id, bool val)
 {
-    TimerData& data = timers[id];
-    if (!data.id)
-    {
-        data.init(id);
-    }
+    TimerData& data = getTimerData(id);
+    std::lock_guard<std::mutex> lock(data.mutex);
     if (val && data.interval == 0)
         data.interval = data.defaultInterval;
     else if (!val && data.interval != 0)
@@ -221,21 +259,15 @@ void AdvancedTimer::setEnabled(IdTimer id, bool val)
 
 int  AdvancedTimer::getInterval(IdTimer id)
 {
-    TimerData& data = timers[id];
-    if (!data.id)
-    {
-        data.init(id);
-    }
-    return (data.interval ? data.interval : data.defaultInterval);
+    TimerData& data = getTimerData(id);
+    std::lock_guard<std::mutex> lock(data.mutex);
+    return (data.interval ? data.interval.load() : data.defaultInterval);
 }
 
 void AdvancedTimer::setInterval(IdTimer id, int val)
 {
-    TimerData& data = timers[id];
-    if (!data.id)
-    {
-        data.init(id);
-    }
+    TimerData& data = getTimerData(id);
+    std::lock_guard<std::mutex> lock(data.mutex);
     data.defaultInterval = val;
     if (data.interval) data.interval = val;
 }
@@ -244,17 +276,13 @@ void AdvancedTimer::begin(IdTimer id)
 {
     std::stack<AdvancedTimer::IdTimer>& curTimer = getCurTimer();
     curTimer.push(id);
-    TimerData& data = timers[curTimer.top()];
-    if (!data.id)
-    {
-        data.init(id);
-    }
+    TimerData& data = getTimerData(curTimer.top());
     if (data.interval == 0)
     {
         setCurRecords(NULL);
         return;
     }
-    helper::vector<Record>* curRecords = &(data.records);
+    helper::vector<Record>* curRecords = &getThreadRecords(id);
     setCurRecords(curRecords);
     curRecords->clear();
     if (syncCallBack) (*syncCallBack)(syncCallBackData);
@@ -289,7 +317,9 @@ void AdvancedTimer::end(IdTimer id, std::ostream& result)
         r.id = id;
         curRecords->push_back(r);
 
-        TimerData& data = timers[curTimer.top()];
+        TimerData& data = getTimerData(curTimer.top());
+        std::lock_guard<std::mutex> lock(data.mutex);
+        data.records.swap(*curRecords);
         data.process();
         if (data.nbIter == data.interval)
         {
@@ -304,8 +334,8 @@ void AdvancedTimer::end(IdTimer id, std::ostream& result)
     }
     else
     {
-        TimerData& data = timers[curTimer.top()];
-        setCurRecords((data.interval == 0) ? NULL : &(data.records));
+        TimerData& data = getTimerData(curTimer.top());
+        setCurRecords((data.interval == 0) ? NULL : &getThreadRecords(curTimer.top()));
     }
 }
 
@@ -333,7 +363,9 @@ void AdvancedTimer::end(IdTimer id)
         r.id = id;
         curRecords->push_back(r);
 
-        TimerData& data = timers[curTimer.top()];
+        TimerData& data = getTimerData(curTimer.top());
+        std::lock_guard<std::mutex> lock(data.mutex);
+        data.records.swap(*curRecords);
         data.process();
         if (data.nbIter == data.interval)
         {
@@ -348,20 +380,20 @@ void AdvancedTimer::end(IdTimer id)
     }
     else
     {
-        TimerData& data = timers[curTimer.top()];
-        setCurRecords((data.interval == 0) ? NULL : &(data.records));
+        TimerData& data = getTimerData(curTimer.top());
+        setCurRecords((data.interval == 0) ? NULL : &getThreadRecords(curTimer.top()));
     }
 }
 
 std::string AdvancedTimer::end(IdTimer id, simulation::Node* node)
 {
-    TimerData& data = timers[id];
-    if(!data.id)
+    TimerData* data = findTimerData(id);
+    if(!data || !data->id)
     {
         return std::string("");
     }
 
-    switch(data.timerOutputType)
+    switch(getOutputType(id))
     {
         case JSON   : return getTimeAnalysis(id, node);
         case LJSON  : return getTimeAnalysis(id, node);
@@ -930,7 +962,7 @@ void TimerData::print()
             out << std::endl;
         }
     }
-    out << "\n iteration : " << getCurRecords()->size();
+    out << "\n iteration : " << records.size();
     out << "\n==== END ====\n";
     out << std::endl;
 }
@@ -956,18 +988,16 @@ AdvancedTimer::outputType AdvancedTimer::convertOutputType(std::string type)
 void AdvancedTimer::setOutputType(IdTimer id, const std::string& type)
 {
     // Seek for the timer
-    TimerData& data = timers[id];
-    if (!data.id)
-    {
-        data.init(id);
-    }
+    TimerData& data = getTimerData(id);
+    std::lock_guard<std::mutex> lock(data.mutex);
 
 	data.timerOutputType = convertOutputType(type);
 }
 
 AdvancedTimer::outputType AdvancedTimer::getOutputType(IdTimer id)
 {
-	TimerData& data = timers[id];
+	TimerData& data = getTimerData(id);
+	std::lock_guard<std::mutex> lock(data.mutex);
 	return data.timerOutputType;
 }
 
@@ -1432,7 +1462,9 @@ std::string AdvancedTimer::getTimeAnalysis(IdTimer id, simulation::Node* node)
         r.id = id;
         curRecords->push_back(r);
 
-        TimerData& data = timers[curTimer.top()];
+        TimerData& data = getTimerData(curTimer.top());
+        std::lock_guard<std::mutex> lock(data.mutex);
+        data.records.swap(*curRecords);
         data.process();
         if (data.nbIter == data.interval)
         {
@@ -1455,8 +1487,8 @@ std::string AdvancedTimer::getTimeAnalysis(IdTimer id, simulation::Node* node)
     }
     else
     {
-        TimerData& data = timers[curTimer.top()];
-        setCurRecords((data.interval == 0) ? NULL : &(data.records));
+        TimerData& data = getTimerData(curTimer.top());
+        setCurRecords((data.interval == 0) ? NULL : &getThreadRecords(curTimer.top()));
     }
 
     outputStr = outputJson.dump(4);
@@ -28,6 +28,7 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <mutex>
 
 
 namespace sofa
@@ -137,6 +138,9 @@ public:
             /// the list of the id names. the Ids are the indices in the vector
             std::vector<std::string> idsList;
 
+            /// the ids are shared by all the threads, as they key the timers and statistics
+            std::mutex idsMutex;
+
             IdFactory()
             {
                 idsList.push_back(std::string("0")); // ID 0 == "0" or empty string
@@ -153,6 +157,7 @@ public:
                 if (name.empty())
                     return 0;
                 IdFactory& idfac = getInstance();
+                std::lock_guard<std::mutex> lock(idfac.idsMutex);
                 std::vector<std::string>::iterator it = idfac.idsList.begin();
                 unsigned int i = 0;
 
@@ -173,14 +178,18 @@ public:
 
             static std::size_t getLastID()
             {
-                return getInstance().idsList.size()-1;
+                IdFactory& idfac = getInstance();
+                std::lock_guard<std::mutex> lock(idfac.idsMutex);
+                return idfac.idsList.size()-1;
             }
 
             /// return the name corresponding to the id in parameter
             static std::string getName(unsigned int id)
             {
-                if (id < getInstance().idsList.size())
-                    return getInstance().idsList[id];
+                IdFactory& idfac = getInstance();
+                std::lock_guard<std::mutex> lock(idfac.idsMutex);
+                if (id < idfac.idsList.size())
+                    return idfac.idsList[id];
                 else
                     return "";
             }
@@ -188,12 +197,8 @@ public:
             /// return the instance of the factory. Creates it if doesn't exist yet.
             static IdFactory& getInstance()
             {
-                SOFA_THREAD_SPECIFIC_PTR(IdFactory, instance);
-                if (instance == nullptr)
-                {
-                    instance = new IdFactory;
-                }
-                return *instance;
+                static IdFactory instance;
+                return instance;
             }
         };
 
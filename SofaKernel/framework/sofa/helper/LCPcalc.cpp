@@ -1717,6 +1717,13 @@ int nlcp_gaussseidel(int dim, double *dfree, double**W, double *f, double mu, do
 }
 
 int nlcp_gaussseidelTimed(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF, double timeout, bool verbose)
+{
+    // allocation of the inverted systems 3x3
+    std::vector<LocalBlock33> W33(dim/3);
+    return nlcp_gaussseidelTimed(dim, dfree, W, f, mu, tol, numItMax, useInitialF, timeout, W33.empty() ? NULL : &W33[0], verbose);
+}
+
+int nlcp_gaussseidelTimed(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF, double timeout, LocalBlock33* W33, bool verbose)
 {
     double test = dim/3;
     double zero = 0.0;
@@ -1734,9 +1741,6 @@ int nlcp_gaussseidelTimed(int dim, double *dfree, double**W, double *f, double m
     // iterators
     int it,c1,i;
 
-    // memory allocation of vector d
-    double *d;
-    d = (double*)malloc(dim*sizeof(double));
     // put the vector force to zero
     if (!useInitialF)
         memset(f, 0, dim*sizeof(double));
@@ -1745,11 +1749,9 @@ int nlcp_gaussseidelTimed(int dim, double *dfree, double**W, double *f, double m
     double f_1[3];
     double d_1[3];
 
-    // allocation of the inverted system 3x3
-    LocalBlock33 **W33;
-    W33 = (LocalBlock33 **) malloc (dim*sizeof(LocalBlock33));
+    // the inverted systems 3x3 are computed during the first iteration
     for (c1=0; c1<numContacts; c1++)
-        W33[c1] = new LocalBlock33();
+        W33[c1].computed = false;
     /*
     std::vector<listElem> sortedList;
     listElem buf;
@@ -1792,15 +1794,15 @@ int nlcp_gaussseidelTimed(int dim, double *dfree, double**W, double *f, double m
             d_1[1] = dt + W[3*index1+1][3*index1  ]*f_1[0]+W[3*index1+1][3*index1+1]*f_1[1]+W[3*index1+1][3*index1+2]*f_1[2];
             d_1[2] = ds + W[3*index1+2][3*index1  ]*f_1[0]+W[3*index1+2][3*index1+1]*f_1[1]+W[3*index1+2][3*index1+2]*f_1[2];
 
-            if(W33[index1]->computed==false)
+            if(W33[index1].computed==false)
             {
-                W33[index1]->compute(W[3*index1][3*index1],W[3*index1][3*index1+1],W[3*index1][3*index1+2],
+                W33[index1].compute(W[3*index1][3*index1],W[3*index1][3*index1+1],W[3*index1][3*index1+2],
                         W[3*index1+1][3*index1+1], W[3*index1+1][3*index1+2],W[3*index1+2][3*index1+2]);
             }
 
 
             fn=f_1[0]; ft=f_1[1]; fs=f_1[2];
-            W33[index1]->GS_State(mu,dn,dt,ds,fn,ft,fs);
+            W33[index1].GS_State(mu,dn,dt,ds,fn,ft,fs);
             error += absError(dn,dt,ds,d_1[0],d_1[1],d_1[2]);
 
 
@@ -1809,10 +1811,6 @@ int nlcp_gaussseidelTimed(int dim, double *dfree, double**W, double *f, double m
             ctime_t t1 = CTime::getTime();
             if((t1-t0) > tdiff)
             {
-                free(d);
-                for (int i = 0; i < numContacts; i++)
-                    delete W33[i];
-                free(W33);
                 //printf("Convergence after %d iteration(s) with tolerance : %f and error : %f with dim : %d\n",it, tol, error, dim);
                 //afficheLCP(dfree,W,f,dim);
                 return 1;
@@ -1821,10 +1819,6 @@ int nlcp_gaussseidelTimed(int dim, double *dfree, double**W, double *f, double m
 
         if (error < tol)
         {
-            free(d);
-            for (int i = 0; i < numContacts; i++)
-                delete W33[i];
-            free(W33);
             //printf("Convergence after %d iteration(s) with tolerance : %f and error : %f with dim : %d\n",it, tol, error, dim);
             //afficheLCP(dfree,W,f,dim);
             sofa::helper::AdvancedTimer::valSet("GS iterations", it+1);
@@ -1832,10 +1826,6 @@ int nlcp_gaussseidelTimed(int dim, double *dfree, double**W, double *f, double m
         }
     }
     sofa::helper::AdvancedTimer::valSet("GS iterations", it);
-    free(d);
-    for (int i = 0; i < numContacts; i++)
-        delete W33[i];
-    free(W33);
 
     if (verbose)
     {
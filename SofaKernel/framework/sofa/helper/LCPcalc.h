@@ -161,6 +161,8 @@ SOFA_HELPER_API int nlcp_multiGrid_Nlevels(int dim, double *dfree, double**W, do
 SOFA_HELPER_API int nlcp_gaussseidel(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF, bool verbose = false, double minW=0.0, double maxF=0.0, std::vector<double>* residuals = NULL, std::vector<double>* violations = NULL);
 // Timed Gauss-Seidel like algorithm for contacts
 SOFA_HELPER_API int nlcp_gaussseidelTimed(int, double *, double**, double *, double, double, int, bool, double timeout, bool verbose=false);
+// Timed Gauss-Seidel like algorithm for contacts, using the given dim/3 blocks as workspace: it does not allocate (e.g. to be called by an haptic thread)
+SOFA_HELPER_API int nlcp_gaussseidelTimed(int, double *, double**, double *, double, double, int, bool, double timeout, LocalBlock33* W33, bool verbose=false);
 } // namespace helper
 
 } // namespace sofa
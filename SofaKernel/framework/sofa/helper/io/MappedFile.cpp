@@ -0,0 +1,216 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/io/MappedFile.h>
+
+#include <fstream>
+#include <iterator>
+#include <climits>
+#ifdef WIN32
+# include <windows.h>
+#else
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+MappedFile::MappedFile()
+    : m_data(NULL), m_size(0), m_isOpen(false), m_mode(ReadOnly), m_mapping(NULL)
+{
+}
+
+MappedFile::MappedFile(const std::string& filename, Mode mode)
+    : m_data(NULL), m_size(0), m_isOpen(false), m_mode(ReadOnly), m_mapping(NULL)
+{
+    open(filename, mode);
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& filename, Mode mode)
+{
+    close();
+    m_mode = mode;
+
+#ifdef WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize))
+        {
+            fileSize.QuadPart = -1;
+        }
+        else if (fileSize.QuadPart == 0)
+        {
+            m_isOpen = true; // empty file, nothing to map
+        }
+        else
+        {
+            HANDLE mapping = CreateFileMappingA(file, NULL, mode == CopyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+            if (mapping != NULL)
+            {
+                m_mapping = MapViewOfFile(mapping, mode == CopyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+                CloseHandle(mapping);
+                if (m_mapping != NULL)
+                    m_size = (std::size_t)fileSize.QuadPart;
+            }
+        }
+        CloseHandle(file);
+    }
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+        {
+            if (st.st_size > 0)
+            {
+                // private mapping: modified pages are copied, never written back to the file
+                const int protection = mode == CopyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ;
+                void* p = mmap(NULL, (std::size_t)st.st_size, protection, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED)
+                {
+                    m_mapping = p;
+                    m_size = (std::size_t)st.st_size;
+#ifdef MADV_SEQUENTIAL
+                    if (mode == ReadOnly)
+                        madvise(p, m_size, MADV_SEQUENTIAL);
+#endif
+                }
+            }
+            else
+            {
+                m_isOpen = true; // empty file, nothing to map
+            }
+        }
+        ::close(fd);
+    }
+#endif
+
+    if (m_mapping)
+    {
+        m_data = (const char*)m_mapping;
+        m_isOpen = true;
+        return true;
+    }
+    if (m_isOpen)
+        return true;
+
+    // mapping is not possible (special file, unsupported filesystem...): read it
+    std::ifstream file(filename.c_str(), std::ios_base::in | std::ios_base::binary);
+    if (!file.good())
+        return false;
+    m_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    m_data = m_buffer.empty() ? NULL : &m_buffer[0];
+    m_size = m_buffer.size();
+    m_isOpen = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_mapping)
+    {
+#ifdef WIN32
+        UnmapViewOfFile(m_mapping);
+#else
+        munmap(m_mapping, m_size);
+#endif
+        m_mapping = NULL;
+    }
+    std::vector<char>().swap(m_buffer);
+    m_data = NULL;
+    m_size = 0;
+    m_isOpen = false;
+}
+
+
+MemoryStreamBuf::MemoryStreamBuf(const char* begin, const char* end)
+{
+    char* b = const_cast<char*>(begin);
+    setg(b, b, b + (end - begin));
+}
+
+void MemoryStreamBuf::advance(std::size_t n)
+{
+    std::size_t remaining = (std::size_t)(egptr() - gptr());
+    if (n > remaining)
+        n = remaining;
+    while (n > 0)
+    {
+        // gbump only accepts an int
+        const int step = (int)(n < (std::size_t)INT_MAX ? n : (std::size_t)INT_MAX);
+        gbump(step);
+        n -= (std::size_t)step;
+    }
+}
+
+MemoryStreamBuf::pos_type MemoryStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    if (!(which & std::ios_base::in))
+        return pos_type(off_type(-1));
+
+    char* target;
+    switch (dir)
+    {
+    case std::ios_base::beg: target = eback() + off; break;
+    case std::ios_base::cur: target = gptr() + off; break;
+    case std::ios_base::end: target = egptr() + off; break;
+    default: return pos_type(off_type(-1));
+    }
+    if (target < eback() || target > egptr())
+        return pos_type(off_type(-1));
+
+    setg(eback(), target, egptr());
+    return pos_type(off_type(target - eback()));
+}
+
+MemoryStreamBuf::pos_type MemoryStreamBuf::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+std::streamsize MemoryStreamBuf::showmanyc()
+{
+    return egptr() - gptr();
+}
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
@@ -0,0 +1,118 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_HELPER_IO_MAPPEDFILE_H
+#define SOFA_HELPER_IO_MAPPEDFILE_H
+
+#include <sofa/helper/helper.h>
+
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+// \brief View on the whole content of a file.
+//
+// The file is memory-mapped when the platform allows it, so that parsers can
+// tokenize it in place without going through a std::istream. Otherwise the
+// content is read into memory. In both cases the content is NOT null-terminated.
+//
+// In CopyOnWrite mode the content can also be modified in memory, the file
+// itself is never written. This allows large binary data (e.g. image volumes)
+// to be used in place, only the pages actually accessed being loaded.
+class SOFA_HELPER_API MappedFile
+{
+public:
+    enum Mode
+    {
+        ReadOnly,   ///< read-only content, accessed sequentially
+        CopyOnWrite ///< modifiable private copy of the content, accessed in any order
+    };
+
+    MappedFile();
+    explicit MappedFile(const std::string& filename, Mode mode = ReadOnly);
+
+    ~MappedFile();
+
+    bool open(const std::string& filename, Mode mode = ReadOnly);
+    void close();
+
+    bool isOpen() const { return m_isOpen; }
+    bool isMapped() const { return m_mapping != NULL; }
+
+    const char* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+    const char* begin() const { return m_data; }
+    const char* end() const { return m_data + m_size; }
+
+    /// Modifiable content, NULL unless the file was opened in CopyOnWrite mode
+    char* writableData() const { return m_mode == CopyOnWrite ? const_cast<char*>(m_data) : NULL; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* m_data;
+    std::size_t m_size;
+    bool m_isOpen;
+    Mode m_mode;
+    void* m_mapping;            ///< start of the mapped view, NULL when the content was read
+    std::vector<char> m_buffer; ///< fallback storage when the file could not be mapped
+};
+
+// \brief Input stream buffer over a memory range (typically a MappedFile).
+//
+// Allows code written against std::istream to run on mapped memory, while
+// letting specialized parsers access and consume the remaining bytes directly.
+class SOFA_HELPER_API MemoryStreamBuf : public std::streambuf
+{
+public:
+    MemoryStreamBuf(const char* begin, const char* end);
+
+    /// Remaining bytes, from the current read position to the end of the buffer
+    const char* current() const { return gptr(); }
+    const char* end() const { return egptr(); }
+
+    /// Move the read position forward (or to the end of the buffer)
+    void advance(std::size_t n);
+
+protected:
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in) override;
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in) override;
+    virtual std::streamsize showmanyc() override;
+};
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
+
+#endif // SOFA_HELPER_IO_MAPPEDFILE_H
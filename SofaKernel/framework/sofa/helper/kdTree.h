@@ -38,9 +38,14 @@ namespace helper
 *  This class implements classical kd tree for nearest neighbors search
 *  - the tree is rebuild from points by calling build(p)
 *  - N nearest points from point x (in terms of euclidean distance) are retrieved with getNClosest(distance/index_List , x , N)
+*  - points closer than a radius r from x are retrieved with getPointsWithinRadius(distance/index_List , x , r)
 *  - Caching may be used to speed up retrieval: if dx< (d(n)-d(0))/2, then the closest point is in the n-1 cached points (updateCachedDistances is used to update the n-1 distances)
+*  - batches of points are processed in parallel with getClosest(index_List , x_List) and getNClosest(distance/index_Lists , x_List , N)
 *  see for instance: [zhang92] report and [simon96] thesis for more details
 *
+*  The tree is balanced and stored in flat arrays: children of node i are 2i+1 and 2i+2, and leaves are buckets of at most bucketSize points,
+*  copied contiguously at build time. Queries are iterative and only read these arrays, so they must be done with the positions used in build().
+*
 *  @author Benjamin Gilles
 **/
 
@@ -60,18 +65,25 @@ public:
 
     typedef struct
     {
+        Real split;             // coordinate of the splitting plane
         unsigned char splitdir; // 0/1/2 -> x/y/z
-        unsigned int left;	// index of the left node
-        unsigned int right; // index of the right node
     } TREENODE;
 
-    bool isEmpty() const {return tree.size()==0;}
+    enum { bucketSize=8 };  ///< maximum number of points in a leaf
+
+    kdTree() : depth(0) {}
+
+    bool isEmpty() const {return points.size()==0;}
     void build(const VecCoord& positions);       ///< update tree (to be used whenever positions have changed)
     void build(const VecCoord& positions, const vector<unsigned int> &ROI);       ///< update tree based on positions subset (to be used whenever points p have changed)
     void getNClosest(distanceSet &cl, const Coord &x, const VecCoord& positions, const unsigned int n) const;  ///< get an ordered set of n distance/index pairs between positions and x
     unsigned int getClosest(const Coord &x, const VecCoord& positions) const; ///< get the index of the closest point between positions and x
+    void getPointsWithinRadius(distanceSet &cl, const Coord &x, const VecCoord& positions, const Real radius) const;  ///< get an ordered set of distance/index pairs between positions and x, closer than radius
     bool getNClosestCached(distanceSet &cl, distanceToPoint &cacheThresh_max, distanceToPoint &cacheThresh_min, Coord &previous_x, const Coord &x, const VecCoord& positions, const unsigned int n) const;  ///< use distance caching to accelerate closest point computation when positions are fixed (see simon96 thesis)
 
+    void getNClosest(vector<distanceSet> &cl, const VecCoord &x, const VecCoord& positions, const unsigned int n) const;  ///< getNClosest for each point of x, in parallel
+    void getClosest(vector<unsigned int> &closest, const VecCoord &x, const VecCoord& positions) const; ///< getClosest for each point of x, in parallel
+
 
     /// @name To be Data-zable
     /// @{
@@ -82,11 +94,13 @@ public:
 protected :
     void print(const unsigned int index);
 
-    vector< TREENODE > tree; unsigned int firstNode;
+    vector< TREENODE > tree;            // internal nodes
+    unsigned int depth;                 // number of levels of internal nodes
+    vector< Coord > points;             // points sorted by leaf
+    vector< unsigned int > indices;     // indices of sorted points in positions
 
-    unsigned int build(UIlist &list, unsigned char direction, const VecCoord& positions); // recursive function to build the kdtree
-    void closest(distanceSet &cl, const Coord &x, const unsigned int &currentnode, const VecCoord& positions, unsigned N) const;     // recursive function to get closest points
-    void closest(distanceToPoint &cl,const Coord &x, const unsigned int &currentnode, const VecCoord& positions) const;  // recursive function to get closest point
+    void getRange(unsigned int &begin, unsigned int &end, const unsigned int node) const; // range of sorted points below a node
+    template<class Query> void closest(Query &query, const Coord &x) const;  // visit the leaves that may contain points closer than query.bound()
 };
 
 
@@ -27,6 +27,7 @@
 #include <map>
 #include <limits>
 #include <iterator>
+#include <algorithm>
 #include <cmath>
 
 namespace sofa
@@ -38,124 +39,198 @@ template<class Coord>
 void kdTree<Coord>::build(const VecCoord& positions)
 {
     const unsigned int nbp=positions.size();
-    UIlist list;   for(unsigned int i=0; i<nbp; i++) list.push_back(i);
-    tree.resize(nbp);
-    firstNode=build(list,(unsigned char)0, positions);
+    vector<unsigned int> ROI(nbp);   for(unsigned int i=0; i<nbp; i++) ROI[i]=i;
+    build(positions,ROI);
 }
 
 template<class Coord>
 void kdTree<Coord>::build(const VecCoord& positions, const vector<unsigned int> &ROI)
 {
-    const size_t nbp = ROI.size();
-    UIlist list;
-    for(size_t i=0; i<nbp; i++)
-        list.push_back(ROI[i]);
-    tree.resize(positions.size());
-    firstNode=build(list,(unsigned char)0, positions);
+    const unsigned int nbp=ROI.size();
+    indices.assign(ROI.begin(),ROI.end());
+
+    // number of levels so that leaves contain at most bucketSize points
+    depth=0;
+    while( (((size_t)nbp+((size_t)1<<depth)-1)>>depth) > (size_t)bucketSize ) depth++;
+    tree.resize(((size_t)1<<depth)-1);
+
+    struct CoordLess
+    {
+        const VecCoord& p; unsigned char d;
+        CoordLess(const VecCoord& _p, unsigned char _d) : p(_p), d(_d) {}
+        bool operator()(unsigned int i, unsigned int j) const { return p[i][d]<p[j][d]; }
+    };
+
+    // split ranges of points at their median along their largest extent, level by level
+    for(unsigned int level=0; level<depth; level++)
+    {
+        const int first=(1<<level)-1, last=(1<<(level+1))-1;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for(int node=first; node<last; node++)
+        {
+            unsigned int begin,end; getRange(begin,end,node);
+            Coord pmin=positions[indices[begin]], pmax=pmin;
+            for(unsigned int i=begin+1; i<end; i++)
+            {
+                const Coord& p=positions[indices[i]];
+                for(unsigned int d=0; d<dim; d++) { if(p[d]<pmin[d]) pmin[d]=p[d]; else if(p[d]>pmax[d]) pmax[d]=p[d]; }
+            }
+            unsigned char direction=0;
+            for(unsigned char d=1; d<dim; d++) if(pmax[d]-pmin[d]>pmax[direction]-pmin[direction]) direction=d;
+
+            const unsigned int middle=begin+(end-begin)/2;
+            std::nth_element(indices.begin()+begin, indices.begin()+middle, indices.begin()+end, CoordLess(positions,direction));
+            tree[node].splitdir=direction;
+            tree[node].split=positions[indices[middle]][direction];
+        }
+    }
+
+    // copy points contiguously, leaf by leaf
+    points.resize(nbp);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int i=0; i<(int)nbp; i++) points[i]=positions[indices[i]];
 }
 
 template<class Coord>
-void kdTree<Coord>::print(const unsigned int index)
+void kdTree<Coord>::getRange(unsigned int &begin, unsigned int &end, const unsigned int node) const
 {
-    dmsg_info("KDTree") << index<<"["<<(int)tree[index].splitdir<<"] "<<tree[index].left<<" "<<tree[index].right ;
-    if(tree[index].left!=index) print(tree[index].left);
-    if(tree[index].right!=index) print(tree[index].right);
+    // bits of node+1 below the leading one give the path from the root (0=left, 1=right)
+    const unsigned int path=node+1;
+    int level=0; while(path>>(level+1)) level++;
+    begin=0; end=indices.size();
+    for(level--; level>=0; level--)
+    {
+        const unsigned int middle=begin+(end-begin)/2;
+        if((path>>level)&1) begin=middle; else end=middle;
+    }
 }
 
 template<class Coord>
-unsigned int kdTree<Coord>::build(UIlist &list, unsigned char direction, const VecCoord& positions)
+void kdTree<Coord>::print(const unsigned int index)
 {
-    // detect leaf
-    if(list.size()==(unsigned int)1)
+    if(index<tree.size())
+    {
+        dmsg_info("KDTree") << index<<"["<<(int)tree[index].splitdir<<"] "<<tree[index].split ;
+        print(2*index+1);
+        print(2*index+2);
+    }
+    else
     {
-        unsigned int index=list.front(); list.pop_front();
-        tree[index].left=tree[index].right=index;
-        tree[index].splitdir=direction;
-        return index;
+        unsigned int begin,end; getRange(begin,end,index);
+        dmsg_info("KDTree") << index<<" leaf "<<begin<<"-"<<end ;
     }
-    // ordered list of 1D coord
-    distanceSet q;
-    UIlist::iterator it;
-    for(it=list.begin(); it!=list.end(); it++) q.insert( distanceToPoint(positions[*it][direction],*it));
-    it=list.begin();    for(distanceSetIt sit=q.begin(); sit!=q.end(); sit++) {*it=sit->second; it++;}
-    // split list in 2
-    it=list.begin(); advance (it,list.size()/2);
-    UIlist newlist;
-    newlist.splice(newlist.begin(),list,list.begin(),it);
-    // add node
-    unsigned int index=list.front(); list.pop_front();
-    tree[index].splitdir=direction;
-    tree[index].left=tree[index].right=index;
-    // split children recursively
-    unsigned char newdirection=direction+1; if(newdirection==dim) newdirection=0;
-    if(newlist.size()!=0) tree[index].left=build(newlist,newdirection,positions);
-    if(list.size()!=0) tree[index].right=build(list,newdirection,positions);
-    // return child index to parent
-    return index;
 }
 
 
 template<class Coord>
-void kdTree<Coord>::closest(distanceSet &cl,const Coord &x, const unsigned int &currentnode, const VecCoord& positions, unsigned N) const
-// [zhang94] algorithm
+template<class Query>
+void kdTree<Coord>::closest(Query &query, const Coord &x) const
+// depth-first traversal, nearest side first, pruning sides farther than query.bound()
 {
-    Real Dmax;
-    distanceSetIt it=cl.end();
-    if(cl.size()==N) { it--; Dmax=it->first; } else Dmax=std::numeric_limits<Real>::max();
-    unsigned int splitdir=tree[currentnode].splitdir;
-    Coord pos=positions[currentnode];
-    Real c1=x[splitdir],c2=pos[splitdir];
-    if(std::abs(c1-c2)<=Dmax)
+    if(points.empty()) return;
+
+    struct Side { unsigned int node,begin,end; Real d2; };
+    Side stack[8*sizeof(unsigned int)];  // the far sides of one path, at most one per level
+    unsigned int size=0;
+    stack[size].node=0; stack[size].begin=0; stack[size].end=points.size(); stack[size].d2=0; size++;
+
+    const unsigned int nbNodes=tree.size();
+    while(size)
     {
-        Real d=(x-pos).norm();
-        if(d<Dmax)
+        const Side s=stack[--size];
+        if(s.d2>query.bound()) continue;
+        unsigned int node=s.node, begin=s.begin, end=s.end;
+        while(node<nbNodes)
         {
-            Dmax=d;
-            cl.insert(distanceToPoint(d,currentnode));
-            if(cl.size()>N) {it=cl.end(); it--; cl.erase(it);}
+            const TREENODE& t=tree[node];
+            const unsigned int middle=begin+(end-begin)/2;
+            const Real diff=x[t.splitdir]-t.split;
+            Side& far=stack[size];
+            far.d2=std::max(s.d2,diff*diff);
+            if(diff<0) { far.node=2*node+2; far.begin=middle; far.end=end;     node=2*node+1; end=middle; }
+            else       { far.node=2*node+1; far.begin=begin;  far.end=middle;  node=2*node+2; begin=middle; }
+            if(far.d2<=query.bound()) size++;
         }
+        for(unsigned int i=begin; i<end; i++) query.add((points[i]-x).norm2(),indices[i]);
     }
-    if(tree[currentnode].left!=currentnode)     if(c1-Dmax<c2)  closest(cl,x,tree[currentnode].left,positions,N);
-    if(tree[currentnode].right!=currentnode)    if(c2-Dmax<c1)  closest(cl,x,tree[currentnode].right,positions,N);
 }
 
 
-// slightly improved version of the above, for one point
 template<class Coord>
-void kdTree<Coord>::closest(distanceToPoint &cl,const Coord &x, const unsigned int &currentnode, const VecCoord& positions) const
+void kdTree<Coord>::getNClosest(distanceSet &cl, const Coord &x, const VecCoord& /*positions*/, const unsigned int n) const
 {
-    Real Dmax=cl.first;
-    unsigned int splitdir=tree[currentnode].splitdir;
-    Coord pos=positions[currentnode];
-    Real c1=x[splitdir],c2=pos[splitdir];
-    if(std::abs(c1-c2)<=Dmax)
+    // n smallest squared distances, sorted
+    struct NClosest
     {
-        Real d=(x-pos).norm();
-        if(d<Dmax)
+        std::vector<distanceToPoint> d; unsigned int n;
+        Real bound() const { return d.size()<n ? std::numeric_limits<Real>::max() : d.back().first; }
+        void add(Real d2, unsigned int index)
         {
-            Dmax=d;
-            cl.first=d;
-            cl.second=currentnode;
+            const distanceToPoint p(d2,index);
+            if(d.size()==n) { if(p<d.back()) d.pop_back(); else return; }
+            d.insert(std::upper_bound(d.begin(),d.end(),p),p);
         }
-    }
-    if(tree[currentnode].left!=currentnode)     if(c1-Dmax<c2)  closest(cl,x,tree[currentnode].left,positions);
-    if(tree[currentnode].right!=currentnode)    if(c2-Dmax<c1)  closest(cl,x,tree[currentnode].right,positions);
+    } query;
+    query.n=n; query.d.reserve(n);
+    cl.clear();
+    if(!n) return;
+    closest(query,x);
+    for(unsigned int i=0; i<query.d.size(); i++) cl.insert(cl.end(),distanceToPoint(std::sqrt(query.d[i].first),query.d[i].second));
 }
 
+template<class Coord>
+unsigned int kdTree<Coord>::getClosest(const Coord &x, const VecCoord& /*positions*/) const
+{
+    struct Closest
+    {
+        distanceToPoint d;
+        Real bound() const { return d.first; }
+        void add(Real d2, unsigned int index) { const distanceToPoint p(d2,index); if(p<d) d=p; }
+    } query;
+    query.d=distanceToPoint(std::numeric_limits<Real>::max(),0);
+    closest(query,x);
+    return query.d.second;
+}
 
 template<class Coord>
-void kdTree<Coord>::getNClosest(distanceSet &cl, const Coord &x, const VecCoord& positions, const unsigned int n) const
+void kdTree<Coord>::getPointsWithinRadius(distanceSet &cl, const Coord &x, const VecCoord& /*positions*/, const Real radius) const
 {
+    struct WithinRadius
+    {
+        std::vector<distanceToPoint> d; Real r2;
+        Real bound() const { return r2; }
+        void add(Real d2, unsigned int index) { if(d2<=r2) d.push_back(distanceToPoint(d2,index)); }
+    } query;
+    query.r2=radius*radius;
     cl.clear();
-    closest(cl,x,firstNode,positions,n);
+    if(radius<0) return;
+    closest(query,x);
+    std::sort(query.d.begin(),query.d.end());
+    for(unsigned int i=0; i<query.d.size(); i++) cl.insert(cl.end(),distanceToPoint(std::sqrt(query.d[i].first),query.d[i].second));
 }
 
 template<class Coord>
-unsigned int kdTree<Coord>::getClosest(const Coord &x, const VecCoord& positions) const
+void kdTree<Coord>::getNClosest(vector<distanceSet> &cl, const VecCoord &x, const VecCoord& positions, const unsigned int n) const
 {
-    distanceToPoint cl(std::numeric_limits<Real>::max(),firstNode);
-    closest(cl,x,firstNode,positions);
-    return cl.second;
+    cl.resize(x.size());
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int i=0; i<(int)x.size(); i++) getNClosest(cl[i],x[i],positions,n);
+}
+
+template<class Coord>
+void kdTree<Coord>::getClosest(vector<unsigned int> &closest, const VecCoord &x, const VecCoord& positions) const
+{
+    closest.resize(x.size());
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int i=0; i<(int)x.size(); i++) closest[i]=getClosest(x[i],positions);
 }
 
 template<class Coord>
@@ -165,13 +240,14 @@ bool kdTree<Coord>::getNClosestCached(distanceSet &cl,  distanceToPoint &cacheTh
     if(dx>=cacheThresh_max.first || cl.size()<2)
     {
         getNClosest(cl,x,positions,n);
+        previous_x=x;
+        if(cl.size()<2) { cacheThresh_max.first=cacheThresh_min.first=0; return false; } // nothing to cache
         distanceSetIt it0=cl.begin(), it1=it0; it1++;
         typename distanceSet::reverse_iterator itn=cl.rbegin();
         cacheThresh_max.first=((itn->first)-(it0->first))*(Real)0.5; // half distance between first and last closest points
         cacheThresh_max.second=itn->second;
         cacheThresh_min.first=((it1->first)-(it0->first))*(Real)0.5; // half distance between first and second closest points
         cacheThresh_min.second=it0->second;
-        previous_x=x;
         return false;
     }
     else if(dx>=cacheThresh_min.first) // in the cache -> update N-1 distances
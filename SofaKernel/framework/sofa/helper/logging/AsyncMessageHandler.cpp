@@ -0,0 +1,136 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+/*****************************************************************************
+* User of this library should read the documentation
+* in the messaging.h file.
+******************************************************************************/
+#include <sofa/helper/logging/AsyncMessageHandler.h>
+#include <sofa/helper/system/thread/CircularQueue.inl>
+
+#include <cassert>
+#include <chrono>
+
+namespace sofa
+{
+namespace helper
+{
+namespace logging
+{
+namespace asyncmessagehandler
+{
+
+using std::mutex ;
+using std::lock_guard ;
+using std::unique_lock ;
+
+AsyncMessageHandler::AsyncMessageHandler(MessageHandler* handler)
+    : m_handler(handler)
+    , m_pending(0)
+    , m_running(true)
+{
+    assert(handler != nullptr) ;
+    for(int i=0;i<QueueSize;i++)
+        m_freeSlots.push(AtomicInt(i)) ;
+    m_thread = std::thread(&AsyncMessageHandler::run, this) ;
+}
+
+AsyncMessageHandler::~AsyncMessageHandler()
+{
+    {
+        lock_guard<mutex> lock(m_mutex) ;
+        m_running = false ;
+    }
+    m_wakeUp.notify_all() ;
+    m_thread.join() ;
+}
+
+void AsyncMessageHandler::process(Message& m)
+{
+    /// A message emitted by the wrapped handler itself is processed immediately,
+    /// waiting for a free slot could never end.
+    if( std::this_thread::get_id() == m_thread.get_id() )
+    {
+        m_handler->process(m) ;
+        return ;
+    }
+
+    /// pop yields when there is no free slot, so this waits for the background thread.
+    AtomicInt slot ;
+    while( !m_freeSlots.pop(slot) ) {}
+
+    m_slots[slot] = m ;
+    m_pending.inc() ;
+    m_readySlots.push(slot) ; /// never full as there are only QueueSize slots
+    m_wakeUp.notify_one() ;
+
+    if( m.type() == Message::Fatal )
+        flush() ;
+}
+
+bool AsyncMessageHandler::accepts(Message::Type type) const
+{
+    return m_handler->accepts(type) ;
+}
+
+void AsyncMessageHandler::flush()
+{
+    if( std::this_thread::get_id() == m_thread.get_id() )
+        return ;
+
+    unique_lock<mutex> lock(m_mutex) ;
+    m_wakeUp.notify_one() ;
+    m_drained.wait(lock, [this]{ return int(m_pending) == 0 ; }) ;
+}
+
+void AsyncMessageHandler::run()
+{
+    AtomicInt slot ;
+    while(true)
+    {
+        if( m_readySlots.pop(slot) )
+        {
+            m_handler->process(m_slots[slot]) ;
+            m_slots[slot] = Message::emptyMsg ;
+            m_freeSlots.push(slot) ;
+
+            if( m_pending.dec_and_test_null() )
+            {
+                lock_guard<mutex> lock(m_mutex) ;
+                m_drained.notify_all() ;
+            }
+            continue ;
+        }
+
+        unique_lock<mutex> lock(m_mutex) ;
+        if( !m_running && int(m_pending) == 0 )
+            return ;
+
+        /// The producers do not take the lock before notifying, so a notification can be
+        /// missed between the pop and the wait: the timeout bounds the resulting latency.
+        m_wakeUp.wait_for(lock, std::chrono::milliseconds(10)) ;
+    }
+}
+
+} /// namespace asyncmessagehandler
+} /// namespace logging
+} /// namespace helper
+} /// namespace sofa
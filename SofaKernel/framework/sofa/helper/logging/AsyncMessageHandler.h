@@ -0,0 +1,117 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+/*****************************************************************************
+* User of this library should read the documentation
+* in the messaging.h file.
+******************************************************************************/
+#ifndef ASYNCMESSAGEHANDLER_H
+#define ASYNCMESSAGEHANDLER_H
+
+#include <sofa/helper/logging/MessageHandler.h>
+#include <sofa/helper/logging/Message.h>
+#include <sofa/helper/system/atomic.h>
+#include <sofa/helper/system/thread/CircularQueue.h>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace sofa
+{
+namespace helper
+{
+namespace logging
+{
+
+/// I use a per-file namespace so that I can employ the 'using' keywords without
+/// fearing it will leack names into the global namespace.
+/// When closing this namespace selected objects from this per-file namespace
+/// are then imported into their parent namespace for ease of use.
+namespace asyncmessagehandler
+{
+
+///
+/// \brief The AsyncMessageHandler class processes the messages in a background thread
+///
+/// This class is a MessageHandler that can be added to in a MessageDispatcher.
+/// It wraps another MessageHandler (eg: a ConsoleMessageHandler): the messages are
+/// copied into a lock-free queue and the wrapped handler formats and writes them from
+/// a dedicated thread, so that the emitting thread does not wait for the output.
+///
+/// The queue has a fixed size: when it is full the emitting thread waits for a free
+/// place, no message is lost. Fatal messages, and the destruction of this handler,
+/// wait until all the pending messages are processed. Use flush() to do the same
+/// before an exit or an assertion.
+///
+/// As the messages are processed later, the wrapped handler must only use the
+/// information copied in the Message (text, type, file, sender and name of the component)
+/// and not the component itself, which may be already deleted.
+///
+class SOFA_HELPER_API AsyncMessageHandler : public MessageHandler
+{
+public:
+    AsyncMessageHandler(MessageHandler* handler) ;
+    virtual ~AsyncMessageHandler() ;
+
+    /// Wait until all the queued messages are processed by the wrapped handler.
+    void flush() ;
+
+    MessageHandler* getHandler() const { return m_handler; }
+
+    /// Inherited from MessageHandler
+    virtual void process(Message& m) ;
+    virtual bool accepts(Message::Type type) const ;
+
+private:
+    enum { QueueSize = 256 };
+
+    typedef helper::system::atomic<int> AtomicInt;
+    typedef helper::system::thread::CircularQueue<
+        AtomicInt,
+        helper::system::thread::FixedPower2Size<QueueSize>::type,
+        helper::system::thread::ManyThreadsPerEnd>
+    SlotQueue;
+
+    void run() ;
+
+    MessageHandler*         m_handler ;
+    Message                 m_slots[QueueSize] ;
+    SlotQueue               m_freeSlots ;   ///< indices of the unused slots
+    SlotQueue               m_readySlots ;  ///< indices of the slots waiting to be processed
+    AtomicInt               m_pending ;     ///< number of messages not yet processed
+    bool                    m_running ;
+    std::mutex              m_mutex ;
+    std::condition_variable m_wakeUp ;
+    std::condition_variable m_drained ;
+    std::thread             m_thread ;
+} ;
+
+} /// namespace asyncmessagehandler
+
+/// Importing the per-file names into the 'library namespace'
+using asyncmessagehandler::AsyncMessageHandler ;
+
+} /// namespace logging
+} /// namespace helper
+} /// namespace sofa
+
+#endif // ASYNCMESSAGEHANDLER_H
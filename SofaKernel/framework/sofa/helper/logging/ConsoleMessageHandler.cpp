@@ -27,6 +27,7 @@
 #include "Message.h"
 #include "ConsoleMessageHandler.h"
 #include "DefaultStyleMessageFormatter.h"
+#include "MessageDispatcher.h"
 
 namespace sofa
 {
@@ -38,14 +39,30 @@ namespace logging
 {
 
 ConsoleMessageHandler::ConsoleMessageHandler(MessageFormatter* formatter)
+    : m_acceptedTypes(~0u)
 {
     m_formatter = (formatter==0?&DefaultStyleMessageFormatter::getInstance():formatter);
 }
 
 void ConsoleMessageHandler::process(Message &m) {
+    if( !accepts(m.type()) )
+        return ;
     m_formatter->formatMessage(m, m.type()>=Message::Error ? std::cerr : std::cout ) ;
 }
 
+bool ConsoleMessageHandler::accepts(Message::Type type) const
+{
+    return (m_acceptedTypes >> type) & 1u ;
+}
+
+void ConsoleMessageHandler::setAcceptedTypes(const Message::TypeSet& types)
+{
+    m_acceptedTypes = 0 ;
+    for( Message::Type type : types )
+        m_acceptedTypes |= 1u << type ;
+    MessageDispatcher::updateAcceptedTypes() ;
+}
+
 void ConsoleMessageHandler::setMessageFormatter(MessageFormatter* formatter)
 {
     m_formatter = formatter;
@@ -43,6 +43,7 @@ class MessageFormatter;
 /// Print the message on the console using a specified formatter.
 /// The Message::Error, Message::Fatal are going to std:cerr while the others
 /// are going to std::cout.
+/// By default all the types of messages are printed, see setAcceptedTypes.
 class SOFA_HELPER_API ConsoleMessageHandler : public MessageHandler
 {
 public:
@@ -50,10 +51,16 @@ public:
     /// DefaultStyleMessageFormatter object to format the message.
     ConsoleMessageHandler(MessageFormatter* formatter = 0);
     virtual void process(Message &m) ;
+    virtual bool accepts(Message::Type type) const ;
     void setMessageFormatter( MessageFormatter* formatter );
 
+    /// Only print the messages of these types. The other ones are discarded, and
+    /// are not even built if no other handler accepts them.
+    void setAcceptedTypes( const Message::TypeSet& types );
+
 private:
     MessageFormatter    *m_formatter;
+    unsigned int         m_acceptedTypes; ///< one bit per Message::Type
 
 };
 
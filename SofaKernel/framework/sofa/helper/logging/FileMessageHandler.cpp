@@ -28,6 +28,7 @@
 #include "MessageFormatter.h"
 #include "DefaultStyleMessageFormatter.h"
 #include "FileMessageHandler.h"
+#include "MessageDispatcher.h"
 #include "Messaging.h"
 
 
@@ -41,6 +42,7 @@ namespace logging
 {
 
 FileMessageHandler::FileMessageHandler(const char* filename,MessageFormatter *formatter)
+    : m_acceptedTypes(~0u)
 {
     m_formatter = (formatter==0?&DefaultStyleMessageFormatter::getInstance():formatter);
     m_outFile.open(filename,std::ios_base::out | std::ios_base::trunc);
@@ -56,7 +58,7 @@ FileMessageHandler::~FileMessageHandler()
 
 void FileMessageHandler::process(Message& m)
 {
-    if (m_outFile.is_open())
+    if (accepts(m.type()))
     {
         // TODO: formatter ?
         m_formatter->formatMessage(m,m_outFile);
@@ -65,11 +67,24 @@ void FileMessageHandler::process(Message& m)
     }
 }
 
+bool FileMessageHandler::accepts(Message::Type type) const
+{
+    return m_outFile.is_open() && ((m_acceptedTypes >> type) & 1u);
+}
+
 bool FileMessageHandler::isValid()
 {
     return m_outFile.is_open();
 }
 
+void FileMessageHandler::setAcceptedTypes(const Message::TypeSet& types)
+{
+    m_acceptedTypes = 0;
+    for (Message::Type type : types)
+        m_acceptedTypes |= 1u << type;
+    MessageDispatcher::updateAcceptedTypes();
+}
+
 
 } // logging
 } // helper
@@ -42,6 +42,7 @@ class MessageFormatter;
 
 /// A message handle that saves the content message passing by in a file.
 /// The formatting can be customize by passing a different MessageFormatter in the constructor.
+/// By default all the types of messages are saved, see setAcceptedTypes.
 /// Example of use:
 ///     MessageDispatcher::addHandler(new FileMessageHandler("myfile.log"));
 class SOFA_HELPER_API FileMessageHandler : public MessageHandler
@@ -51,12 +52,19 @@ public:
 
     virtual ~FileMessageHandler();
     virtual void process(Message& m) ;
+    /// No message is accepted if the file could not be opened
+    virtual bool accepts(Message::Type type) const ;
 
     bool isValid(); // is output file ok ?
 
+    /// Only save the messages of these types. The other ones are discarded, and
+    /// are not even built if no other handler accepts them.
+    void setAcceptedTypes( const Message::TypeSet& types );
+
 private:
     std::ofstream       m_outFile;
     MessageFormatter    *m_formatter;
+    unsigned int         m_acceptedTypes; ///< one bit per Message::Type
 };
 
 
@@ -70,7 +70,12 @@ Message& Message::operator=( const Message& msg )
     m_componentinfo = msg.componentInfo();
     m_class = msg.context();
     m_type = msg.type();
-    m_stream << msg.message().str();
+    if( &msg != this )
+    {
+        m_stream.str(std::string());
+        m_stream.clear();
+        m_stream << msg.message().str();
+    }
     return *this;
 }
 
@@ -50,6 +50,8 @@ using sofa::helper::logging::DefaultStyleMessageFormatter;
 using std::lock_guard ;
 using std::mutex;
 
+#include <atomic>
+
 namespace sofa
 {
 
@@ -92,6 +94,9 @@ public:
 
     std::vector<MessageHandler*> m_messageHandlers = getDefaultMessageHandlers();
 
+    /// one bit per Message::Type, set if at least one handler accepts it
+    std::atomic<unsigned int> m_acceptedTypes { ~0u } ;
+
     std::vector<MessageHandler*>& getHandlers()
     {
         return m_messageHandlers ;
@@ -102,6 +107,7 @@ public:
         if( std::find(m_messageHandlers.begin(), m_messageHandlers.end(), o) == m_messageHandlers.end())
         {
             m_messageHandlers.push_back(o) ;
+            updateAcceptedTypes() ;
             return (int)(m_messageHandlers.size()-1);
         }
         return -1;
@@ -110,12 +116,31 @@ public:
     int rmHandler(MessageHandler* o)
     {
         m_messageHandlers.erase(remove(m_messageHandlers.begin(), m_messageHandlers.end(), o), m_messageHandlers.end());
+        updateAcceptedTypes() ;
         return (int)(m_messageHandlers.size()-1);
     }
 
     void clearHandlers()
     {
         m_messageHandlers.clear() ;
+        updateAcceptedTypes() ;
+    }
+
+    void updateAcceptedTypes()
+    {
+        unsigned int mask = 0 ;
+        for( size_t i=0 ; i<m_messageHandlers.size() ; i++ ){
+            for( unsigned int t=Message::Info ; t<Message::TypeCount ; t++ ){
+                if( m_messageHandlers[i]->accepts(Message::Type(t)) )
+                    mask |= 1u << t ;
+            }
+        }
+        m_acceptedTypes.store(mask, std::memory_order_relaxed) ;
+    }
+
+    bool isAccepted(Message::Type type) const
+    {
+        return (m_acceptedTypes.load(std::memory_order_relaxed) >> type) & 1u ;
     }
 
     void process(sofa::helper::logging::Message& m)
@@ -157,7 +182,19 @@ void MessageDispatcher::clearHandlers(){
     getMainInstance()->clearHandlers();
 }
 
+bool MessageDispatcher::isAccepted(Message::Type type){
+    return getMainInstance()->isAccepted(type);
+}
+
+void MessageDispatcher::updateAcceptedTypes(){
+    MUTEX_IF_THREADING ;
+    getMainInstance()->updateAcceptedTypes();
+}
+
 void MessageDispatcher::process(sofa::helper::logging::Message& m){
+    /// the messages no handler accepts are dropped without taking the lock
+    if( !isAccepted(m.type()) )
+        return ;
     MUTEX_IF_THREADING ;
     getMainInstance()->process(m);
 }
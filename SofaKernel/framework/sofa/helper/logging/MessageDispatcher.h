@@ -102,6 +102,16 @@ public:
         static void clearHandlers() ; ///< to remove every MessageHandlers
         static std::vector<MessageHandler*>& getHandlers(); ///< the list of MessageHandlers
 
+        /// Return true if at least one of the MessageHandlers accepts the messages of this type.
+        /// This test is cheap (no lock) so that the message macros can skip the construction
+        /// of messages nobody will process.
+        static bool isAccepted(Message::Type type) ;
+
+        /// Recompute the types accepted by the MessageHandlers.
+        /// It is done automatically when handlers are added or removed, it only has to be called
+        /// when the result of MessageHandler::accepts changes for an already registered handler.
+        static void updateAcceptedTypes() ;
+
         static LoggerStream info(Message::Class mclass, const ComponentInfo::SPtr& cinfo, const FileInfo::SPtr& fileInfo = EmptyFileInfo) ;
         static LoggerStream deprecated(Message::Class mclass, const ComponentInfo::SPtr& cinfo, const FileInfo::SPtr& fileInfo = EmptyFileInfo) ;
         static LoggerStream warning(Message::Class mclass, const ComponentInfo::SPtr& cinfo, const FileInfo::SPtr& fileInfo = EmptyFileInfo) ;
@@ -28,6 +28,7 @@
 #include <sstream>
 #include <string>
 #include <sofa/helper/helper.h>
+#include "Message.h"
 
 namespace sofa
 {
@@ -38,13 +39,16 @@ namespace helper
 namespace logging
 {
 
-class Message;
-
 class SOFA_HELPER_API MessageHandler
 {
 public:
     virtual ~MessageHandler(){}
     virtual void process(Message& m) = 0 ;
+
+    /// Return false if the messages of this type are always discarded by this handler.
+    /// When no registered handler accepts a type, the msg_* macros skip the construction
+    /// of the corresponding messages (see MessageDispatcher::isAccepted).
+    virtual bool accepts(Message::Type /*type*/) const { return true; }
 };
 
 
@@ -130,13 +130,16 @@
 
 #define FILEINFO(filename, line) sofa::helper::logging::FileInfo(filename, line)
 
+/// Cheap test used to skip the construction of the messages no MessageHandler would process
+#define MSG_ACCEPTED(type) sofa::helper::logging::MessageDispatcher::isAccepted(sofa::helper::logging::Message::type)
+
 /// THESE MACRO BEASTS ARE FOR AUTOMATIC DETECTION OF MACRO NO or ONE ARGUMENTS
 #define TWO_FUNC_CHOOSER(_f1, _f2 ,...) _f2
 #define TWO_FUNC_RECOMPOSER(argsWithParentheses) TWO_FUNC_CHOOSER argsWithParentheses
 
 /// THE INFO BEAST
-#define MSGINFO_1(x) if( sofa::helper::logging::notMuted(x) ) oldmsg_info(x)
-#define MSGINFO_0()  if( sofa::helper::logging::notMuted(this) ) oldmsg_info(this)
+#define MSGINFO_1(x) if( sofa::helper::logging::notMuted(x) && MSG_ACCEPTED(Info) ) oldmsg_info(x)
+#define MSGINFO_0()  if( sofa::helper::logging::notMuted(this) && MSG_ACCEPTED(Info) ) oldmsg_info(this)
 
 #define MSGINFO_CHOOSE_FROM_ARG_COUNT(...) TWO_FUNC_RECOMPOSER((__VA_ARGS__, MSGINFO_1, ))
 #define MSGINFO_NO_ARG_EXPANDER() ,MSGINFO_0
@@ -154,7 +157,7 @@
 #define MSGWARNING_CHOOSER(...) MSGWARNING_CHOOSE_FROM_ARG_COUNT(MSGWARNING_NO_ARG_EXPANDER __VA_ARGS__ ())
 
 #define msg_warning(...) MSGWARNING_CHOOSER(__VA_ARGS__)(__VA_ARGS__)
-#define msg_warning_when(cond, ...) if(cond) msg_warning(__VA_ARGS__)
+#define msg_warning_when(cond, ...) if((cond) && MSG_ACCEPTED(Warning)) msg_warning(__VA_ARGS__)
 
 
 /// THE ERROR BEAST
@@ -166,7 +169,7 @@
 #define MSGERROR_CHOOSER(...) MSGERROR_CHOOSE_FROM_ARG_COUNT(MSGERROR_NO_ARG_EXPANDER __VA_ARGS__ ())
 
 #define msg_error(...) MSGERROR_CHOOSER(__VA_ARGS__)(__VA_ARGS__)
-#define msg_error_when(cond, ...) if(cond) msg_error(__VA_ARGS__)
+#define msg_error_when(cond, ...) if((cond) && MSG_ACCEPTED(Error)) msg_error(__VA_ARGS__)
 
 
 /// THE FATAL BEAST
@@ -190,12 +193,12 @@
 #define MSGDEPRECATED_CHOOSER(...) MSGDEPRECATED_CHOOSE_FROM_ARG_COUNT(MSGDEPRECATED_NO_ARG_EXPANDER __VA_ARGS__ ())
 
 #define msg_deprecated(...) MSGDEPRECATED_CHOOSER(__VA_ARGS__)(__VA_ARGS__)
-#define msg_deprecated_when(cond, ...) if(cond) msg_deprecated(__VA_ARGS__)
+#define msg_deprecated_when(cond, ...) if((cond) && MSG_ACCEPTED(Deprecated)) msg_deprecated(__VA_ARGS__)
 
 
 /// THE ADVICE BEAST
-#define MSGADVICE_1(x) if( sofa::helper::logging::notMuted(x) ) oldmsg_advice(x)
-#define MSGADVICE_0()  if( sofa::helper::logging::notMuted(this) ) oldmsg_advice(this)
+#define MSGADVICE_1(x) if( sofa::helper::logging::notMuted(x) && MSG_ACCEPTED(Advice) ) oldmsg_advice(x)
+#define MSGADVICE_0()  if( sofa::helper::logging::notMuted(this) && MSG_ACCEPTED(Advice) ) oldmsg_advice(this)
 
 #define MSGADVICE_CHOOSE_FROM_ARG_COUNT(...) TWO_FUNC_RECOMPOSER((__VA_ARGS__, MSGADVICE_1, ))
 #define MSGADVICE_NO_ARG_EXPANDER() ,MSGADVICE_0
@@ -209,8 +212,8 @@
 /// THESE MACRO BEASTS ARE FOR AUTOMATIC DETECTION OF MACRO NO or ONE ARGUMENTS
 
 /// THE INFO BEAST
-#define DMSGINFO_1(x) if( sofa::helper::logging::notMuted(x) ) olddmsg_info(x)
-#define DMSGINFO_0()  if( sofa::helper::logging::notMuted(this) ) olddmsg_info(this)
+#define DMSGINFO_1(x) if( sofa::helper::logging::notMuted(x) && MSG_ACCEPTED(Info) ) olddmsg_info(x)
+#define DMSGINFO_0()  if( sofa::helper::logging::notMuted(this) && MSG_ACCEPTED(Info) ) olddmsg_info(this)
 
 #define DMSGINFO_CHOOSE_FROM_ARG_COUNT(...) TWO_FUNC_RECOMPOSER((__VA_ARGS__, DMSGINFO_1, ))
 #define DMSGINFO_NO_ARG_EXPANDER() ,DMSGINFO_0
@@ -228,7 +231,7 @@
 #define DMSGWARNING_CHOOSER(...) DMSGWARNING_CHOOSE_FROM_ARG_COUNT(DMSGWARNING_NO_ARG_EXPANDER __VA_ARGS__ ())
 
 #define dmsg_warning(...) DMSGWARNING_CHOOSER(__VA_ARGS__)(__VA_ARGS__)
-#define dmsg_warning_when(cond, ...) if(cond) dmsg_warning(__VA_ARGS__)
+#define dmsg_warning_when(cond, ...) if((cond) && MSG_ACCEPTED(Warning)) dmsg_warning(__VA_ARGS__)
 
 
 /// THE ERROR BEAST
@@ -240,7 +243,7 @@
 #define DMSGERROR_CHOOSER(...) DMSGERROR_CHOOSE_FROM_ARG_COUNT(DMSGERROR_NO_ARG_EXPANDER __VA_ARGS__ ())
 
 #define dmsg_error(...) DMSGERROR_CHOOSER(__VA_ARGS__)(__VA_ARGS__)
-#define dmsg_error_when(cond, ...) if(cond) dmsg_error(__VA_ARGS__)
+#define dmsg_error_when(cond, ...) if((cond) && MSG_ACCEPTED(Error)) dmsg_error(__VA_ARGS__)
 
 
 /// THE FATAL BEAST
@@ -264,12 +267,12 @@
 #define DMSGDEPRECATED_CHOOSER(...) DMSGDEPRECATED_CHOOSE_FROM_ARG_COUNT(DMSGDEPRECATED_NO_ARG_EXPANDER __VA_ARGS__ ())
 
 #define dmsg_deprecated(...) DMSGDEPRECATED_CHOOSER(__VA_ARGS__)(__VA_ARGS__)
-#define dmsg_deprecated_when(cond, ...) if(cond) dmsg_deprecated(__VA_ARGS__)
+#define dmsg_deprecated_when(cond, ...) if((cond) && MSG_ACCEPTED(Deprecated)) dmsg_deprecated(__VA_ARGS__)
 
 
 /// THE ADVICE BEAST
-#define DMSGADVICE_1(x) if( sofa::helper::logging::notMuted(x) ) olddmsg_advice(x)
-#define DMSGADVICE_0()  if( sofa::helper::logging::notMuted(this) ) olddmsg_advice(this)
+#define DMSGADVICE_1(x) if( sofa::helper::logging::notMuted(x) && MSG_ACCEPTED(Advice) ) olddmsg_advice(x)
+#define DMSGADVICE_0()  if( sofa::helper::logging::notMuted(this) && MSG_ACCEPTED(Advice) ) olddmsg_advice(this)
 
 #define DMSGADVICE_CHOOSE_FROM_ARG_COUNT(...) TWO_FUNC_RECOMPOSER((__VA_ARGS__, DMSGADVICE_1, ))
 #define DMSGADVICE_NO_ARG_EXPANDER() ,DMSGADVICE_0
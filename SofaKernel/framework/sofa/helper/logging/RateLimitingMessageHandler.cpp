@@ -0,0 +1,127 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+/*****************************************************************************
+* User of this library should read the documentation
+* in the messaging.h file.
+******************************************************************************/
+#include <cassert>
+#include <sofa/helper/logging/RateLimitingMessageHandler.h>
+
+namespace sofa
+{
+namespace helper
+{
+namespace logging
+{
+namespace ratelimitingmessagehandler
+{
+
+using std::mutex ;
+using std::lock_guard ;
+
+RateLimitingMessageHandler::RateLimitingMessageHandler(MessageHandler* handler, unsigned int maxMessages, double period)
+    : m_handler(handler)
+    , m_maxMessages(maxMessages)
+    , m_period(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(period)))
+{
+    assert(handler != nullptr) ;
+}
+
+void RateLimitingMessageHandler::process(Message& m)
+{
+    const FileInfo::SPtr& fileInfo = m.fileInfo() ;
+    if( !fileInfo || fileInfo->filename == nullptr || fileInfo->line == 0 )
+    {
+        m_handler->process(m) ;
+        return ;
+    }
+
+    lock_guard<mutex> lock(m_mutex) ;
+
+    const Clock::time_point now = Clock::now() ;
+    auto found = m_sites.find(std::make_pair(std::string(fileInfo->filename), fileInfo->line)) ;
+    if( found == m_sites.end() )
+    {
+        found = m_sites.insert(std::make_pair(std::make_pair(std::string(fileInfo->filename), fileInfo->line), CallSite())).first ;
+        found->second.m_start = now ;
+    }
+    CallSite& site = found->second ;
+
+    if( now - site.m_start >= m_period )
+    {
+        report(site) ;
+        site.m_start = now ;
+        site.m_count = 0 ;
+    }
+
+    const std::string text = m.messageAsString() ;
+    if( site.m_count < m_maxMessages && (site.m_count == 0 || text != site.m_lastText) )
+    {
+        site.m_count++ ;
+        site.m_lastText = text ;
+        m_handler->process(m) ;
+        return ;
+    }
+
+    site.m_suppressed++ ;
+    m_suppressedCount++ ;
+    site.m_class = m.context() ;
+    site.m_type = m.type() ;
+    site.m_componentInfo = m.componentInfo() ;
+    site.m_fileInfo = fileInfo ;
+}
+
+void RateLimitingMessageHandler::report(CallSite& site)
+{
+    if( site.m_suppressed == 0 )
+        return ;
+
+    Message summary(site.m_class, site.m_type, site.m_componentInfo, site.m_fileInfo) ;
+    summary << site.m_suppressed << " similar message(s) emitted from this line were suppressed (at most "
+            << m_maxMessages << " different messages every "
+            << std::chrono::duration<double>(m_period).count() << "s are reported)." ;
+    site.m_suppressed = 0 ;
+    m_handler->process(summary) ;
+}
+
+void RateLimitingMessageHandler::flush()
+{
+    lock_guard<mutex> lock(m_mutex) ;
+    for(auto& site : m_sites)
+        report(site.second) ;
+}
+
+unsigned int RateLimitingMessageHandler::getSuppressedCount() const
+{
+    lock_guard<mutex> lock(m_mutex) ;
+    return m_suppressedCount ;
+}
+
+bool RateLimitingMessageHandler::accepts(Message::Type type) const
+{
+    return m_handler->accepts(type) ;
+}
+
+} /// namespace ratelimitingmessagehandler
+} /// namespace logging
+} /// namespace helper
+} /// namespace sofa
@@ -0,0 +1,118 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+/*****************************************************************************
+* User of this library should read the documentation
+* in the messaging.h file.
+******************************************************************************/
+#ifndef RATELIMITINGMESSAGEHANDLER_H
+#define RATELIMITINGMESSAGEHANDLER_H
+
+#include <sofa/helper/logging/MessageHandler.h>
+#include <sofa/helper/logging/Message.h>
+
+#include <map>
+#include <string>
+#include <mutex>
+#include <chrono>
+
+namespace sofa
+{
+namespace helper
+{
+namespace logging
+{
+
+/// I use a per-file namespace so that I can employ the 'using' keywords without
+/// fearing it will leack names into the global namespace.
+/// When closing this namespace selected objects from this per-file namespace
+/// are then imported into their parent namespace for ease of use.
+namespace ratelimitingmessagehandler
+{
+
+///
+/// \brief The RateLimitingMessageHandler class limits the number of messages emitted by a same line of code
+///
+/// This class is a MessageHandler that can be added to in a MessageDispatcher.
+/// It wraps another MessageHandler and only forwards to it, for each call site (file and line
+/// where the message was created), the first maxMessages messages of each period of time.
+/// A message having the same text as the previous one of its call site is not forwarded either.
+///
+/// The number of suppressed messages is reported by a single message when the next period
+/// of the call site starts, or when flush() is called.
+/// Messages without file information are always forwarded.
+///
+/// This is intended for the messages emitted in loops (eg: a warning on degenerated
+/// elements at each time step), that otherwise flood the output.
+///
+class SOFA_HELPER_API RateLimitingMessageHandler : public MessageHandler
+{
+public:
+    RateLimitingMessageHandler(MessageHandler* handler, unsigned int maxMessages=10, double period=1.0) ;
+    virtual ~RateLimitingMessageHandler(){}
+
+    /// Forward the reports of the messages suppressed so far.
+    void flush() ;
+
+    /// Total number of messages that were not forwarded.
+    unsigned int getSuppressedCount() const ;
+
+    MessageHandler* getHandler() const { return m_handler; }
+
+    /// Inherited from MessageHandler
+    virtual void process(Message& m) ;
+    virtual bool accepts(Message::Type type) const ;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct CallSite
+    {
+        Clock::time_point   m_start ;       ///< beginning of the current period
+        unsigned int        m_count {0} ;   ///< messages forwarded during the current period
+        unsigned int        m_suppressed {0} ; ///< messages suppressed during the current period
+        std::string         m_lastText ;    ///< text of the last forwarded message
+        Message::Class      m_class ;       ///< origin of the last suppressed message, for the report
+        Message::Type       m_type ;
+        ComponentInfo::SPtr m_componentInfo ;
+        FileInfo::SPtr      m_fileInfo ;
+    };
+
+    void report(CallSite& site) ;
+
+    MessageHandler*         m_handler ;
+    unsigned int            m_maxMessages ;
+    Clock::duration         m_period ;
+    unsigned int            m_suppressedCount {0} ;
+    std::map< std::pair<std::string, int>, CallSite > m_sites ;
+    mutable std::mutex      m_mutex ;
+} ;
+
+} /// namespace ratelimitingmessagehandler
+
+/// Importing the per-file names into the 'library namespace'
+using ratelimitingmessagehandler::RateLimitingMessageHandler ;
+
+} /// namespace logging
+} /// namespace helper
+} /// namespace sofa
+
+#endif // RATELIMITINGMESSAGEHANDLER_H
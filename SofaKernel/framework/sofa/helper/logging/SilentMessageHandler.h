@@ -45,6 +45,7 @@ class SOFA_HELPER_API SilentMessageHandler : public MessageHandler
 {
 public:
     virtual void process(Message& /*m*/);
+    virtual bool accepts(Message::Type /*type*/) const { return false; }
 };
 
 
@@ -27,6 +27,7 @@
 
 #include <fstream>
 #include <iostream>
+#include <ctime>
 #ifdef WIN32
 # include <windows.h>
 # include <winerror.h>
@@ -303,6 +304,20 @@ bool FileSystem::isFile(const std::string &path)
     ;
 }
 
+bool FileSystem::getFileInfo(const std::string& path, unsigned long long& size, long long& lastWriteTime)
+{
+    boost::system::error_code error;
+    const boost::uintmax_t fileSize = boost::filesystem::file_size(path, error);
+    if (error)
+        return false;
+    const std::time_t time = boost::filesystem::last_write_time(path, error);
+    if (error)
+        return false;
+    size = (unsigned long long)fileSize;
+    lastWriteTime = (long long)time;
+    return true;
+}
+
 std::string FileSystem::convertBackSlashesToSlashes(const std::string& path)
 {
     std::string str = path;
@@ -104,6 +104,11 @@ static bool isAbsolute(const std::string& path);
 /// @brief Return true if and only if the given file path is an existing file.
 static bool isFile(const std::string& path);
 
+/// @brief Get the size in bytes and the time of the last modification of a file.
+///
+/// @return false if the information could not be retrieved (e.g. the file does not exist).
+static bool getFileInfo(const std::string& path, unsigned long long& size, long long& lastWriteTime);
+
 /// @brief Replace backslashes with slashes.
 static std::string convertBackSlashesToSlashes(const std::string& path);
 
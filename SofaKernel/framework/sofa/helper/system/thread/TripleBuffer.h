@@ -0,0 +1,98 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_HELPER_SYSTEM_THREAD_TRIPLEBUFFER_H
+#define SOFA_HELPER_SYSTEM_THREAD_TRIPLEBUFFER_H
+
+#include <atomic>
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace system
+{
+
+namespace thread
+{
+
+/**
+ * Lock-free handoff of three buffers (indexed 0, 1 and 2) from one producer thread
+ * to one consumer thread.
+ *
+ * The producer fills backBuffer() then publishes it, and gets another back buffer.
+ * The consumer reads frontBuffer(), and switches to the last published buffer with
+ * acquire(). Each thread only owns its own buffer, and the content of a published
+ * buffer is visible to the consumer once it acquired it.
+ */
+class TripleBuffer
+{
+public:
+    TripleBuffer() : m_next(1), m_front(0), m_back(2) {}
+
+    /// Buffer to be filled by the producer
+    unsigned int backBuffer() const { return m_back; }
+
+    /// Publish the back buffer (producer thread), and get another one, which is
+    /// the previously published buffer if the consumer did not acquire it.
+    /// Return the new back buffer.
+    unsigned int publish()
+    {
+        // the release ordering makes the content of the buffer visible to the consumer
+        m_back = m_next.exchange(m_back | NEW_BUFFER, std::memory_order_acq_rel) & BUFFER_MASK;
+        return m_back;
+    }
+
+    /// Buffer read by the consumer
+    unsigned int frontBuffer() const { return m_front; }
+
+    /// Switch to the last published buffer, if any (consumer thread).
+    /// Return true if the front buffer changed.
+    bool acquire()
+    {
+        if (!(m_next.load(std::memory_order_relaxed) & NEW_BUFFER))
+            return false;
+
+        // give back the front buffer and take the published one, whose content is
+        // visible thanks to the acquire ordering
+        m_front = m_next.exchange(m_front, std::memory_order_acq_rel) & BUFFER_MASK;
+        return true;
+    }
+
+protected:
+    enum { BUFFER_MASK = 0x3, NEW_BUFFER = 0x4 };
+
+    std::atomic<unsigned char> m_next; ///< last published buffer, flagged by NEW_BUFFER until it is acquired
+    unsigned char m_front; ///< buffer of the consumer
+    unsigned char m_back; ///< buffer of the producer
+};
+
+} // namespace thread
+
+} // namespace system
+
+} // namespace helper
+
+} // namespace sofa
+
+#endif
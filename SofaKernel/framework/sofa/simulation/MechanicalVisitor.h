@@ -573,6 +573,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -638,6 +642,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
@@ -683,6 +691,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -770,6 +782,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
     virtual bool readNodeData() const
     {
         return true;
@@ -868,6 +884,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
     virtual bool readNodeData() const
     {
         return true;
@@ -1035,6 +1055,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1074,6 +1098,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1117,6 +1145,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1168,6 +1200,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1210,6 +1246,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1245,6 +1285,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1282,6 +1326,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1320,6 +1368,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1361,6 +1413,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1415,6 +1471,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1475,6 +1535,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1533,6 +1597,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1576,6 +1644,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1622,6 +1694,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1671,6 +1747,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1724,6 +1804,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1765,6 +1849,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1812,6 +1900,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -1854,6 +1946,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -2113,6 +2209,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -2151,6 +2251,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -2189,6 +2293,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -2224,6 +2332,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
@@ -2261,6 +2373,10 @@ public:
     {
         return true;
     }
+    virtual Visitor* clone() const
+    {
+        return cloneAs(this);
+    }
 #ifdef SOFA_DUMP_VISITOR_INFO
     void setReadWriteVectors()
     {
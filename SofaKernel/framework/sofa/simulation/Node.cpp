@@ -69,6 +69,7 @@ Node::Node(const std::string& name)
 
     , animationManager(initLink("animationLoop","The AnimationLoop attached to this node (only valid for root node)"))
     , visualLoop(initLink("visualLoop", "The VisualLoop attached to this node (only valid for root node)"))
+    , visitorScheduler(initLink("visitorScheduler", "The VisitorScheduler executing the visitors started from this node"))
 
     , behaviorModel(initLink("behaviorModel", "The BehaviorModel attached to this node (only valid for root node)"))
     , mapping(initLink("mapping", "The (non-mechanical) Mapping(s) attached to this node (only valid for root node)"))
@@ -782,26 +783,28 @@ void Node::executeVisitor(Visitor* action, bool precomputedOrder)
     }
 
 
-    static int level = 0;
     if(DEBUG_VISITOR)
     {
         std::stringstream tmp;
-        for (int i=0; i<level; ++i)
+        for (int i=0; i<action->traversalDepth; ++i)
             tmp << ' ';
         tmp << ">" << sofa::core::objectmodel::BaseClass::decodeClassName(typeid(*action)) << " on " << this->getPathName();
         if (!action->getInfos().empty())
             tmp << "  : " << action->getInfos();
         dmsg_info () << tmp.str() ;
-        ++level;
+        ++action->traversalDepth;
     }
 
-    doExecuteVisitor(action, precomputedOrder);
+    if (visitorScheduler && !precomputedOrder)
+        visitorScheduler->executeVisitor(this, action);
+    else
+        doExecuteVisitor(action, precomputedOrder);
 
     if(DEBUG_VISITOR)
     {
-        --level;
+        --action->traversalDepth;
         std::stringstream tmp;
-        for (int i=0; i<level; ++i)
+        for (int i=0; i<action->traversalDepth; ++i)
             tmp << ' ';
         tmp  << "<" << sofa::core::objectmodel::BaseClass::decodeClassName(typeid(*action)) << " on " << this->getPathName();
         dmsg_info() << tmp.str() ;
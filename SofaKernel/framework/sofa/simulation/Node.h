@@ -265,6 +265,7 @@ public:
 
     Single<sofa::core::behavior::BaseAnimationLoop> animationManager;
     Single<sofa::core::visual::VisualLoop> visualLoop;
+    Single<VisitorScheduler> visitorScheduler;
 
     Sequence<sofa::core::BehaviorModel> behaviorModel;
     Sequence<sofa::core::BaseMapping> mapping;
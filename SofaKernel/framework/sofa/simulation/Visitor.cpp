@@ -33,6 +33,7 @@ namespace simulation
 
 Visitor::Visitor(const core::ExecParams* p)
     : canAccessSleepingNode(true)
+    , traversalDepth(0)
     , params(p)
 {
     //params = core::MechanicalParams::defaultInstance();
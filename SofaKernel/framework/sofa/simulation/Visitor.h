@@ -31,6 +31,7 @@
 
 #include <sofa/helper/set.h>
 #include <iostream>
+#include <typeinfo>
 
 #ifdef SOFA_DUMP_VISITOR_INFO
 #include <sofa/helper/system/thread/CTime.h>
@@ -184,6 +185,10 @@ public:
     /// Specify whether this visitor can be parallelized.
     virtual bool isThreadSafe() const { return false; }
 
+    /// Return a copy of this visitor, executed concurrently with the original on independent sub-graphs.
+    /// Visitors returning NULL (the default) are executed sequentially.
+    virtual Visitor* clone() const { return NULL; }
+
     /// Callback method called when decending to a new node. Recursion will stop if this method returns RESULT_PRUNE
     /// This version is offered a LocalStorage to store temporary data
     virtual Result processNodeTopDown(simulation::Node* node, LocalStorage*) { return processNodeTopDown(node); }
@@ -205,9 +210,19 @@ public:
 	/// Can the visitor access sleeping nodes?
 	bool canAccessSleepingNode;
 
+    /// Depth of the current node in the traversal, used to indent its debug traces
+    int traversalDepth;
+
 protected:
     const core::ExecParams* params;
 
+    /// Implementation of clone() for the visitor class T, returning NULL for the classes derived from T
+    template<class T>
+    static Visitor* cloneAs(const T* visitor)
+    {
+        return typeid(*visitor) == typeid(T) ? new T(*visitor) : NULL;
+    }
+
 
 #ifdef SOFA_DUMP_VISITOR_INFO
 public:
@@ -34,6 +34,20 @@ void VisitorScheduler::doExecuteVisitor(simulation::Node* node, Visitor* act)
     node->doExecuteVisitor(act);
 }
 
+bool VisitorScheduler::insertInNode( core::objectmodel::BaseNode* node )
+{
+    static_cast<simulation::Node*>(node)->visitorScheduler.add(this);
+    Inherit1::insertInNode(node);
+    return true;
+}
+
+bool VisitorScheduler::removeInNode( core::objectmodel::BaseNode* node )
+{
+    static_cast<simulation::Node*>(node)->visitorScheduler.remove(this);
+    Inherit1::removeInNode(node);
+    return true;
+}
+
 } // namespace simulation
 
 } // namespace sofa
@@ -46,6 +46,10 @@ public:
     /// Specify whether this scheduler is multi-threaded.
     virtual bool isMultiThreaded() const { return false; }
 
+    /// A scheduler executes the visitors started from the node it is attached to.
+    virtual bool insertInNode( core::objectmodel::BaseNode* node ) override;
+    virtual bool removeInNode( core::objectmodel::BaseNode* node ) override;
+
 protected:
 
     VisitorScheduler() {}
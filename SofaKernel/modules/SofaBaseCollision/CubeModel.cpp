@@ -23,8 +23,10 @@
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/simulation/Simulation.h>
 #include <sofa/core/ObjectFactory.h>
+#include <sofa/helper/IndexOpenMP.h>
 #include <algorithm>
 #include <math.h>
+#include <limits>
 
 namespace sofa
 {
@@ -45,6 +47,8 @@ int CubeModelClass = core::RegisterObject("Collision model representing a cube")
         ;
 
 CubeModel::CubeModel()
+    : m_builtTreeCost(0)
+    , d_rebuildRatio(initData(&d_rebuildRatio, (SReal)2, "rebuildRatio", "build the tree again when its cost after a refit exceeds this ratio times its cost when built (0 to never build it again)"))
 {
     enum_type = AABB_TYPE;
 }
@@ -136,10 +140,115 @@ void CubeModel::updateCube(int index)
 
 void CubeModel::updateCubes()
 {
-    for (int i=0; i<size; i++)
+    // the cubes of a level only depend on the cubes of the level below
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (helper::IndexOpenMP<int>::type i=0; i<size; i++)
         updateCube(i);
 }
 
+/// Half of the surface area of a box
+static SReal halfArea(const Vector3& minBBox, const Vector3& maxBBox)
+{
+    const Vector3 l = maxBBox - minBBox;
+    return l[0]*l[1] + l[1]*l[2] + l[2]*l[0];
+}
+
+int CubeModel::computeSplit(const CubeData& cell)
+{
+    const int first = cell.subcells.first.getIndex();
+    const int last = cell.subcells.second.getIndex();
+    const int ncells = last - first;
+    if (ncells <= 4)
+        return -1; // Only split cells with more than 4 childs
+
+    // Find the biggest dimension
+    int splitAxis;
+    Vector3 l = cell.maxBBox-cell.minBBox;
+    if(l[0]>l[1])
+        if (l[0]>l[2])
+            splitAxis = 0;
+        else
+            splitAxis = 2;
+    else if (l[1]>l[2])
+        splitAxis = 1;
+    else
+        splitAxis = 2;
+
+#if defined(__GNUC__) && (__GNUC__ == 4)
+// && (__GNUC_MINOR__ == 1) && (__GNUC_PATCHLEVEL__ == 1)
+    // there is apparently a bug in std::sort with GCC 4.x
+    if (splitAxis == 0)
+        qsort(&(elems[first]), ncells, sizeof(elems[0]), CubeSortPredicate::sortCube<0>);
+    else if (splitAxis == 1)
+        qsort(&(elems[first]), ncells, sizeof(elems[0]), CubeSortPredicate::sortCube<1>);
+    else
+        qsort(&(elems[first]), ncells, sizeof(elems[0]), CubeSortPredicate::sortCube<2>);
+#else
+    CubeSortPredicate sortpred(splitAxis);
+    std::sort(elems.begin()+first,elems.begin()+last, sortpred);
+#endif
+
+    // Surface area heuristic: minimize the sum of the areas of the subcells weighted by their number of elements.
+    // The depth of the tree is limited, so each subcell keeps at least a quarter of the elements.
+    const int minSplit = first + ncells/4;
+    const int maxSplit = last - ncells/4;
+
+    // areas of the boxes of the elements after each possible split
+    std::vector<SReal> rightArea(ncells);
+    Vector3 minBBox = elems[last-1].minBBox;
+    Vector3 maxBBox = elems[last-1].maxBBox;
+    for (int i=last-1; i>=minSplit; --i)
+    {
+        for (int j=0; j<3; j++)
+        {
+            if (elems[i].minBBox[j] < minBBox[j]) minBBox[j] = elems[i].minBBox[j];
+            if (elems[i].maxBBox[j] > maxBBox[j]) maxBBox[j] = elems[i].maxBBox[j];
+        }
+        rightArea[i-first] = halfArea(minBBox, maxBBox);
+    }
+
+    int middle = first+(ncells+1)/2;
+    SReal bestCost = std::numeric_limits<SReal>::max();
+    minBBox = elems[first].minBBox;
+    maxBBox = elems[first].maxBBox;
+    for (int i=first+1; i<=maxSplit; ++i)
+    {
+        const CubeData& e = elems[i-1];
+        for (int j=0; j<3; j++)
+        {
+            if (e.minBBox[j] < minBBox[j]) minBBox[j] = e.minBBox[j];
+            if (e.maxBBox[j] > maxBBox[j]) maxBBox[j] = e.maxBBox[j];
+        }
+        if (i < minSplit)
+            continue;
+        const SReal cost = halfArea(minBBox, maxBBox)*(i-first) + rightArea[i-first]*(last-i);
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            middle = i;
+        }
+    }
+    return middle;
+}
+
+SReal CubeModel::computeTreeCost(const std::list<CubeModel*>& levels)
+{
+    const CubeModel* root = levels.front();
+    if (root->empty())
+        return 0;
+    const SReal rootArea = halfArea(root->elems[0].minBBox, root->elems[0].maxBBox);
+    if (rootArea <= 0)
+        return 0;
+
+    SReal cost = 0;
+    for (std::list<CubeModel*>::const_iterator it = levels.begin(); it != levels.end(); ++it)
+        for (int i=0; i<(*it)->size; i++)
+            cost += halfArea((*it)->elems[i].minBBox, (*it)->elems[i].maxBBox);
+    return cost / rootArea;
+}
+
 void CubeModel::draw(const core::visual::VisualParams* vparams)
 {
     if (!isActive() || !((getNext()==NULL)?vparams->displayFlags().getShowCollisionModels():vparams->displayFlags().getShowBoundingCollisionModels())) return;
@@ -240,7 +349,25 @@ void CubeModel::computeBoundingTree(int maxDepth)
     CubeModel* root = levels.front();
     //if (isStatic() && root->getPrevious() == NULL && !root->empty()) return; // No need to recompute BBox if immobile
 
-    if (root->empty() || root->getPrevious() != NULL)
+    bool rebuild = (root->empty() || root->getPrevious() != NULL);
+    if (!rebuild)
+    {
+        // Simply update the existing tree, starting from the bottom
+        int lvl = 0;
+        for (std::list<CubeModel*>::reverse_iterator it = levels.rbegin(); it != levels.rend(); ++it)
+        {
+            //sout << "CubeModel: update level "<<lvl<<sendl;
+            (*it)->updateCubes();
+            ++lvl;
+        }
+
+        // The tree is built again if the refitted cells became too large compared to the built ones
+        const SReal rebuildRatio = d_rebuildRatio.getValue();
+        if (rebuildRatio > 0 && computeTreeCost(levels) > rebuildRatio * m_builtTreeCost)
+            rebuild = true;
+    }
+
+    if (rebuild)
     {
         // Tree must be reconstructed
         //sout << "Building Tree with depth "<<maxDepth<<" from "<<size<<" elements."<<sendl;
@@ -266,49 +393,27 @@ void CubeModel::computeBoundingTree(int maxDepth)
         CubeModel* level = *it;
         ++it;
         int lvl = 0;
+        std::vector<int> splits;
         while(it != levels.end())
         {
             //sout << "CubeModel: split level "<<lvl<<sendl;
             CubeModel* clevel = *it;
             clevel->elems.reserve(level->size*2);
+
+            // The cells of a level contain separate ranges of elements, they are sorted in parallel
+            splits.resize(level->size);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+            for (helper::IndexOpenMP<int>::type c=0; c<level->size; ++c)
+                splits[c] = computeSplit(level->elems[c]);
+
             for(Cube cell = Cube(level->begin()); level->end() != cell; ++cell)
             {
-                const std::pair<Cube,Cube>& subcells = cell.subcells();
-                int ncells = subcells.second.getIndex() - subcells.first.getIndex();
-                //sout << "CubeModel: level "<<lvl<<" cell "<<cell.getIndex()<<": current subcells "<<subcells.first.getIndex() << " - "<<subcells.second.getIndex()<<sendl;
-                if (ncells > 4)
+                const int middle = splits[cell.getIndex()];
+                if (middle >= 0)
                 {
-                    // Only split cells with more than 4 childs
-                    // Find the biggest dimension
-                    int splitAxis;
-                    Vector3 l = cell.maxVect()-cell.minVect();
-                    int middle = subcells.first.getIndex()+(ncells+1)/2;
-                    if(l[0]>l[1])
-                        if (l[0]>l[2])
-                            splitAxis = 0;
-                        else
-                            splitAxis = 2;
-                    else if (l[1]>l[2])
-                        splitAxis = 1;
-                    else
-                        splitAxis = 2;
-
-                    // Separate cells on each side of the median cell
-
-#if defined(__GNUC__) && (__GNUC__ == 4)
-// && (__GNUC_MINOR__ == 1) && (__GNUC_PATCHLEVEL__ == 1)
-                    // there is apparently a bug in std::sort with GCC 4.x
-                    if (splitAxis == 0)
-                        qsort(&(elems[subcells.first.getIndex()]), subcells.second.getIndex()-subcells.first.getIndex(), sizeof(elems[0]), CubeSortPredicate::sortCube<0>);
-                    else if (splitAxis == 1)
-                        qsort(&(elems[subcells.first.getIndex()]), subcells.second.getIndex()-subcells.first.getIndex(), sizeof(elems[0]), CubeSortPredicate::sortCube<1>);
-                    else
-                        qsort(&(elems[subcells.first.getIndex()]), subcells.second.getIndex()-subcells.first.getIndex(), sizeof(elems[0]), CubeSortPredicate::sortCube<2>);
-#else
-                    CubeSortPredicate sortpred(splitAxis);
-                    //std::nth_element(elems.begin()+subcells.first.getIndex(),elems.begin()+middle,elems.begin()+subcells.second.getIndex(), sortpred);
-                    std::sort(elems.begin()+subcells.first.getIndex(),elems.begin()+subcells.second.getIndex(), sortpred);
-#endif
+                    const std::pair<Cube,Cube>& subcells = cell.subcells();
 
                     // Create the two new subcells
                     Cube cmiddle(this, middle);
@@ -330,17 +435,7 @@ void CubeModel::computeBoundingTree(int maxDepth)
             for (int i=0; i<size; i++)
                 parentOf[elems[i].children.first.getIndex()] = i;
         }
-    }
-    else
-    {
-        // Simply update the existing tree, starting from the bottom
-        int lvl = 0;
-        for (std::list<CubeModel*>::reverse_iterator it = levels.rbegin(); it != levels.rend(); ++it)
-        {
-            //sout << "CubeModel: update level "<<lvl<<sendl;
-            (*it)->updateCubes();
-            ++lvl;
-        }
+        m_builtTreeCost = computeTreeCost(levels);
     }
     //sout << "<CubeModel::computeBoundingTree("<<maxDepth<<")"<<sendl;
 }
@@ -27,6 +27,8 @@
 #include <SofaBaseMechanics/MechanicalObject.h>
 #include <sofa/defaulttype/Vec3Types.h>
 
+#include <list>
+
 namespace sofa
 {
 
@@ -99,13 +101,25 @@ protected:
     sofa::helper::vector<CubeData> elems;
     sofa::helper::vector<int> parentOf; ///< Given the index of a child leaf element, store the index of the parent cube
 
+    /// Sum of the surface areas of the cells of the tree, relative to the one of the root, after its last build
+    SReal m_builtTreeCost;
+
 public:
     typedef core::CollisionElementIterator ChildIterator;
     typedef sofa::defaulttype::Vec3Types DataTypes;
     typedef Cube Element;
     friend class Cube;
+    Data<SReal> d_rebuildRatio; ///< build the tree again when its cost after a refit exceeds this ratio times its cost when built (0 to never build it again)
 protected:
     CubeModel();
+
+    /// Sort the elements of a cell along its largest dimension, and choose where to split them
+    /// using the surface area heuristic. Return the index of the first element of the second subcell,
+    /// or -1 if the cell must not be split.
+    int computeSplit(const CubeData& cell);
+
+    /// Sum of the surface areas of the cells of the given levels, relative to the one of the root cell
+    static SReal computeTreeCost(const std::list<CubeModel*>& levels);
 public:
     virtual void resize(int size) override;
 
@@ -146,6 +160,9 @@ public:
       *These new two boxes inherit from the root box and have depth 1. Then we can do the same operation for the new boxes.
       *The division is done only if the box contains more than 4 final CollisionElements and if the depth doesn't exceed
       *the max depth. The division is made along an axis. This axis corresponds to the biggest dimension of the current bounding box.
+      *The position of the division along this axis minimizes the surface area heuristic, while keeping at least
+      *a quarter of the elements in each box. The boxes of a same depth are divided in parallel.
+      *If the tree already exists, it is only refitted from the bottom, unless its cost became too large (see rebuildRatio).
       *Note : a bounding box is a Cube here.
       */
     virtual void computeBoundingTree(int maxDepth=0) override;
@@ -0,0 +1,168 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaTest/Sofa_test.h>
+
+#include <sofa/simulation/Node.h>
+using sofa::simulation::Node ;
+
+#include <SofaSimulationCommon/SceneLoaderXML.h>
+using sofa::simulation::SceneLoaderXML ;
+
+#include <SofaBaseCollision/CubeModel.h>
+using sofa::component::collision::Cube ;
+using sofa::component::collision::CubeModel ;
+
+#include <SofaBaseCollision/SphereModel.h>
+using sofa::component::collision::SphereModel ;
+
+#include <SofaBaseMechanics/MechanicalObject.h>
+using sofa::component::container::MechanicalObject ;
+
+using sofa::core::ExecParams ;
+using sofa::defaulttype::Vec3Types ;
+using sofa::defaulttype::Vector3 ;
+
+namespace sofa {
+
+struct CubeModel_test : public Sofa_test<>
+{
+    Node::SPtr m_root;
+    SphereModel* m_spheres {nullptr};
+    MechanicalObject<Vec3Types>* m_dofs {nullptr};
+
+    void SetUp() override
+    {
+        // points on a regular grid, in an order unrelated to their positions
+        std::stringstream positions;
+        const int n = 8;
+        for (int i = 0; i < n*n*n; ++i)
+        {
+            const int j = (i * 37) % (n*n*n);
+            positions << j % n << " " << (j / n) % n << " " << j / (n*n) << " ";
+        }
+
+        std::string scene =
+                "<?xml version='1.0'?>"
+                "<Node name='Root' gravity='0 0 0' dt='0.01'>"
+                "   <MechanicalObject name='dofs' position='" + positions.str() + "' />"
+                "   <SphereModel name='spheres' radius='0.1' />"
+                "</Node>";
+        m_root = SceneLoaderXML::loadFromMemory("testscene", scene.c_str(), scene.size());
+        ASSERT_NE(m_root.get(), nullptr);
+        m_root->init(ExecParams::defaultInstance());
+
+        m_root->get(m_spheres);
+        m_root->get(m_dofs);
+        ASSERT_NE(m_spheres, nullptr);
+        ASSERT_NE(m_dofs, nullptr);
+    }
+
+    void TearDown() override
+    {
+        if (m_root)
+            sofa::simulation::getSimulation()->unload(m_root);
+    }
+
+    /// Check that each cell of the tree contains its subcells, and each element its sphere
+    void checkTree()
+    {
+        const Vec3Types::VecCoord& x = m_dofs->read(core::ConstVecCoordId::position())->getValue();
+        CubeModel* leaves = dynamic_cast<CubeModel*>(m_spheres->getPrevious());
+        ASSERT_NE(leaves, nullptr);
+        ASSERT_EQ(leaves->getSize(), (int)x.size());
+
+        std::vector<int> found(x.size(), 0);
+        for (int i = 0; i < leaves->getSize(); ++i)
+        {
+            const int e = leaves->getLeafIndex(i);
+            ++found[e];
+            for (int c = 0; c < 3; ++c)
+            {
+                EXPECT_LE(leaves->getCubeData(i).minBBox[c], x[e][c] - 0.1 + 1e-9);
+                EXPECT_GE(leaves->getCubeData(i).maxBBox[c], x[e][c] + 0.1 - 1e-9);
+            }
+        }
+        for (std::size_t e = 0; e < found.size(); ++e)
+            EXPECT_EQ(found[e], 1) << "element " << e;
+
+        int nbLevels = 0;
+        for (CubeModel* level = dynamic_cast<CubeModel*>(leaves->getPrevious()); level != nullptr; level = dynamic_cast<CubeModel*>(level->getPrevious()))
+        {
+            ++nbLevels;
+            for (int i = 0; i < level->getSize(); ++i)
+            {
+                const Cube cell(level, i);
+                for (Cube sub = cell.subcells().first; sub != cell.subcells().second; ++sub)
+                {
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        EXPECT_LE(cell.minVect()[c], sub.minVect()[c]);
+                        EXPECT_GE(cell.maxVect()[c], sub.maxVect()[c]);
+                    }
+                }
+            }
+        }
+        EXPECT_EQ(nbLevels, 5);
+    }
+
+    void moveDofs(SReal amplitude)
+    {
+        helper::WriteAccessor< Data<Vec3Types::VecCoord> > x = *m_dofs->write(core::VecCoordId::position());
+        for (std::size_t i = 0; i < x.size(); ++i)
+            x[i] += Vector3(amplitude * std::sin((SReal)i), amplitude * std::cos((SReal)i), amplitude * std::sin(2.0*i));
+    }
+};
+
+TEST_F(CubeModel_test, buildTree)
+{
+    m_spheres->computeBoundingTree(4);
+    checkTree();
+}
+
+TEST_F(CubeModel_test, refitTree)
+{
+    m_spheres->computeBoundingTree(4);
+    moveDofs(0.05);
+    m_spheres->computeBoundingTree(4);
+    checkTree();
+}
+
+TEST_F(CubeModel_test, rebuildDegradedTree)
+{
+    m_spheres->computeBoundingTree(4);
+    moveDofs(5);
+    m_spheres->computeBoundingTree(4);
+    checkTree();
+
+    CubeModel* root = dynamic_cast<CubeModel*>(m_spheres->getFirst());
+    ASSERT_NE(root, nullptr);
+    ASSERT_EQ(root->getSize(), 1);
+
+    // without rebuild, the same tree is only refitted
+    CubeModel* leaves = dynamic_cast<CubeModel*>(m_spheres->getPrevious());
+    leaves->d_rebuildRatio.setValue(0);
+    moveDofs(5);
+    m_spheres->computeBoundingTree(4);
+    checkTree();
+}
+
+} // namespace sofa
@@ -80,6 +80,10 @@ template class SOFA_BASE_MECHANICS_API BarycentricMapperTetrahedronSetTopology<
 template class SOFA_BASE_MECHANICS_API BarycentricMapperTetrahedronSetTopology< Vec3dTypes, ExtVec3fTypes >;
 template class SOFA_BASE_MECHANICS_API BarycentricMapperHexahedronSetTopology< Vec3dTypes, Vec3dTypes >;
 template class SOFA_BASE_MECHANICS_API BarycentricMapperHexahedronSetTopology< Vec3dTypes, ExtVec3fTypes >;
+template class SOFA_BASE_MECHANICS_API BarycentricWeights< Vec3dTypes, Vec3dTypes, double >;
+template class SOFA_BASE_MECHANICS_API BarycentricWeights< Vec3dTypes, Vec3dTypes, float >;
+template class SOFA_BASE_MECHANICS_API BarycentricWeights< Vec3dTypes, ExtVec3fTypes, double >;
+template class SOFA_BASE_MECHANICS_API BarycentricWeights< Vec3dTypes, ExtVec3fTypes, float >;
 #endif
 #ifndef SOFA_DOUBLE
 template class SOFA_BASE_MECHANICS_API BarycentricMapping< Vec3fTypes, Vec3fTypes >;
@@ -104,6 +108,8 @@ template class SOFA_BASE_MECHANICS_API BarycentricMapperTetrahedronSetTopology<
 template class SOFA_BASE_MECHANICS_API BarycentricMapperTetrahedronSetTopology< Vec3fTypes, ExtVec3fTypes >;
 template class SOFA_BASE_MECHANICS_API BarycentricMapperHexahedronSetTopology< Vec3fTypes, Vec3fTypes >;
 template class SOFA_BASE_MECHANICS_API BarycentricMapperHexahedronSetTopology< Vec3fTypes, ExtVec3fTypes >;
+template class SOFA_BASE_MECHANICS_API BarycentricWeights< Vec3fTypes, Vec3fTypes, float >;
+template class SOFA_BASE_MECHANICS_API BarycentricWeights< Vec3fTypes, ExtVec3fTypes, float >;
 #endif
 #ifndef SOFA_FLOAT
 #ifndef SOFA_DOUBLE
@@ -129,6 +135,9 @@ template class SOFA_BASE_MECHANICS_API BarycentricMapperTetrahedronSetTopology<
 template class SOFA_BASE_MECHANICS_API BarycentricMapperTetrahedronSetTopology< Vec3fTypes, Vec3dTypes >;
 template class SOFA_BASE_MECHANICS_API BarycentricMapperHexahedronSetTopology< Vec3dTypes, Vec3fTypes >;
 template class SOFA_BASE_MECHANICS_API BarycentricMapperHexahedronSetTopology< Vec3fTypes, Vec3dTypes >;
+template class SOFA_BASE_MECHANICS_API BarycentricWeights< Vec3dTypes, Vec3fTypes, double >;
+template class SOFA_BASE_MECHANICS_API BarycentricWeights< Vec3dTypes, Vec3fTypes, float >;
+template class SOFA_BASE_MECHANICS_API BarycentricWeights< Vec3fTypes, Vec3dTypes, float >;
 #endif
 #endif
 
@@ -201,6 +201,47 @@ public:
 
 
 
+/// Weights of a barycentric mapping in compressed row storage: the mapped point i is the sum of
+/// the input points index[k] weighted by weight[k], for k in [begin[i],begin[i+1]).
+/// The mapping is applied concurrently over the mapped points; its transpose scatters their
+/// contributions to shared input points, so it is applied sequentially.
+template<class In, class Out, class WeightReal>
+class BarycentricWeights
+{
+public:
+    typedef typename core::behavior::BaseMechanicalState::ForceMask ForceMask;
+    typedef typename Out::Real OutReal;
+
+    /// Below this number of points, the weights are applied sequentially
+    enum { ParallelMinSize = 1024 };
+
+    helper::vector<unsigned int> begin;
+    helper::vector<unsigned int> index;
+    helper::vector<WeightReal> weight;
+
+    BarycentricWeights() { clear(); }
+
+    void clear();
+
+    /// Number of mapped points
+    unsigned int size() const { return (unsigned int)begin.size()-1; }
+
+    /// Add an input point to the current mapped point
+    void add(unsigned int inIndex, WeightReal w) { index.push_back(inIndex); weight.push_back(w); }
+    /// Terminate the current mapped point
+    void endPoint() { begin.push_back((unsigned int)index.size()); }
+
+    /// Copy weights stored with another precision
+    template<class W>
+    void assign(const BarycentricWeights<In,Out,W>& w);
+
+    void apply(typename Out::VecCoord& out, const typename In::VecCoord& in) const;
+    void applyJ(typename Out::VecDeriv& out, const typename In::VecDeriv& in, const ForceMask& maskTo) const;
+    void applyJT(typename In::VecDeriv& out, const typename Out::VecDeriv& in, const ForceMask& maskTo, ForceMask& maskFrom) const;
+};
+
+
+
 /// Template class for barycentric mapping topology-specific mappers.
 template<class In, class Out>
 class TopologyBarycentricMapper : public BarycentricMapper<In,Out>
@@ -251,14 +292,42 @@ public:
 
     virtual void resize( core::State<Out>* toModel ) = 0;
 
+    /// Store the weights of the mapping in single precision, to reduce the memory traffic of large mappings.
+    /// Only the mappers applying the mapping from their weights (see updateWeights) use them.
+    void setFloatWeights(bool b) { if (b != useFloatWeights) { useFloatWeights = b; weightsValid = false; } }
+    bool getFloatWeights() const { return useFloatWeights; }
+
 protected:
     TopologyBarycentricMapper(core::topology::BaseMeshTopology* fromTopology, topology::PointSetTopologyContainer* toTopology = NULL)
         : fromTopology(fromTopology), toTopology(toTopology)
+        , useFloatWeights(false), weightsValid(false), weightsRevision(-1), weightsMapRevision(-1)
     {}
 
+    typedef BarycentricWeights<In,Out,Real> Weights;
+    typedef BarycentricWeights<In,Out,float> FloatWeights;
+
+    /// Fill the weights of the mapped points, in their order, for the mappers applying the mapping from them
+    virtual void fillWeights(Weights& /*w*/) {}
+
+    /// Compute the weights again if the mapping changed since the last call, which is detected by
+    /// weightsValid, the revision of the input topology and the given revision of the mapping data
+    void updateWeights(int mapRevision = 0);
+
+    /// Apply the mapping from its weights (see updateWeights)
+    void applyWeights( typename Out::VecCoord& out, const typename In::VecCoord& in );
+    void applyJWeights( typename Out::VecDeriv& out, const typename In::VecDeriv& in );
+    void applyJTWeights( typename In::VecDeriv& out, const typename Out::VecDeriv& in );
+
 protected:
     core::topology::BaseMeshTopology* fromTopology;
     topology::PointSetTopologyContainer* toTopology;
+
+    Weights weights;
+    FloatWeights floatWeights;
+    bool useFloatWeights;
+    bool weightsValid;      ///< false when the mapped points changed
+    int weightsRevision;    ///< revision of the input topology when the weights were computed
+    int weightsMapRevision; ///< revision of the mapping data when the weights were computed
 };
 
 
@@ -343,6 +412,7 @@ public:
 
     inline friend std::istream& operator >> ( std::istream& in, BarycentricMapperMeshTopology<In, Out> &b )
     {
+        b.weightsValid = false;
         unsigned int size_vec;
         in >> size_vec;
         b.map1d.clear();
@@ -391,6 +461,9 @@ public:
         return out;
     }
 
+protected:
+    void fillWeights(typename Inherit::Weights& w) override;
+
 private:
     void clear1d(int reserve=0);
     void clear2d(int reserve=0);
@@ -543,6 +616,7 @@ public:
 
     inline friend std::istream& operator >> ( std::istream& in, BarycentricMapperSparseGridTopology<In, Out> &b )
     {
+        b.weightsValid = false;
         in >> b.map;
         return in;
     }
@@ -553,6 +627,9 @@ public:
         return out;
     }
 
+protected:
+    void fillWeights(typename Inherit::Weights& w) override;
+
 };
 
 /// Class allowing barycentric mapping computation on a EdgeSetTopology
@@ -889,7 +966,11 @@ public:
     void draw(const core::visual::VisualParams*,const typename Out::VecCoord& out, const typename In::VecCoord& in) override;
     virtual void resize( core::State<Out>* toModel ) override;
 
+protected:
+    void fillWeights(typename Inherit::Weights& w) override;
 
+    /// Revision of the mapped points and of the tetrahedra they are mapped on
+    int getMapRevision();
 };
 
 
@@ -1039,6 +1120,7 @@ protected:
 public:
 
     Data< bool > useRestPosition; ///< Use the rest position of the input and output models to initialize the mapping
+    Data< bool > d_floatWeights; ///< Store the weights of the mapping in single precision (only used by the mesh, sparse grid and tetrahedron mappers)
 
 #ifdef SOFA_DEV
     //--- partial mapping test
@@ -1129,6 +1211,10 @@ extern template class SOFA_BASE_MECHANICS_API BarycentricMapperTetrahedronSetTop
 extern template class SOFA_BASE_MECHANICS_API BarycentricMapperTetrahedronSetTopology< sofa::defaulttype::Vec3dTypes, sofa::defaulttype::ExtVec3fTypes >;
 extern template class SOFA_BASE_MECHANICS_API BarycentricMapperHexahedronSetTopology< sofa::defaulttype::Vec3dTypes, sofa::defaulttype::Vec3dTypes >;
 extern template class SOFA_BASE_MECHANICS_API BarycentricMapperHexahedronSetTopology< sofa::defaulttype::Vec3dTypes, sofa::defaulttype::ExtVec3fTypes >;
+extern template class SOFA_BASE_MECHANICS_API BarycentricWeights< sofa::defaulttype::Vec3dTypes, sofa::defaulttype::Vec3dTypes, double >;
+extern template class SOFA_BASE_MECHANICS_API BarycentricWeights< sofa::defaulttype::Vec3dTypes, sofa::defaulttype::Vec3dTypes, float >;
+extern template class SOFA_BASE_MECHANICS_API BarycentricWeights< sofa::defaulttype::Vec3dTypes, sofa::defaulttype::ExtVec3fTypes, double >;
+extern template class SOFA_BASE_MECHANICS_API BarycentricWeights< sofa::defaulttype::Vec3dTypes, sofa::defaulttype::ExtVec3fTypes, float >;
 #endif
 #ifndef SOFA_DOUBLE
 extern template class SOFA_BASE_MECHANICS_API BarycentricMapping< sofa::defaulttype::Vec3fTypes, sofa::defaulttype::Vec3fTypes >;
@@ -1153,6 +1239,8 @@ extern template class SOFA_BASE_MECHANICS_API BarycentricMapperTetrahedronSetTop
 extern template class SOFA_BASE_MECHANICS_API BarycentricMapperTetrahedronSetTopology< sofa::defaulttype::Vec3fTypes, sofa::defaulttype::ExtVec3fTypes >;
 extern template class SOFA_BASE_MECHANICS_API BarycentricMapperHexahedronSetTopology< sofa::defaulttype::Vec3fTypes, sofa::defaulttype::Vec3fTypes >;
 extern template class SOFA_BASE_MECHANICS_API BarycentricMapperHexahedronSetTopology< sofa::defaulttype::Vec3fTypes, sofa::defaulttype::ExtVec3fTypes >;
+extern template class SOFA_BASE_MECHANICS_API BarycentricWeights< sofa::defaulttype::Vec3fTypes, sofa::defaulttype::Vec3fTypes, float >;
+extern template class SOFA_BASE_MECHANICS_API BarycentricWeights< sofa::defaulttype::Vec3fTypes, sofa::defaulttype::ExtVec3fTypes, float >;
 #endif
 #ifndef SOFA_FLOAT
 #ifndef SOFA_DOUBLE
@@ -1178,6 +1266,9 @@ extern template class SOFA_BASE_MECHANICS_API BarycentricMapperTetrahedronSetTop
 extern template class SOFA_BASE_MECHANICS_API BarycentricMapperTetrahedronSetTopology< sofa::defaulttype::Vec3fTypes, sofa::defaulttype::Vec3dTypes >;
 extern template class SOFA_BASE_MECHANICS_API BarycentricMapperHexahedronSetTopology< sofa::defaulttype::Vec3dTypes, sofa::defaulttype::Vec3fTypes >;
 extern template class SOFA_BASE_MECHANICS_API BarycentricMapperHexahedronSetTopology< sofa::defaulttype::Vec3fTypes, sofa::defaulttype::Vec3dTypes >;
+extern template class SOFA_BASE_MECHANICS_API BarycentricWeights< sofa::defaulttype::Vec3dTypes, sofa::defaulttype::Vec3fTypes, double >;
+extern template class SOFA_BASE_MECHANICS_API BarycentricWeights< sofa::defaulttype::Vec3dTypes, sofa::defaulttype::Vec3fTypes, float >;
+extern template class SOFA_BASE_MECHANICS_API BarycentricWeights< sofa::defaulttype::Vec3fTypes, sofa::defaulttype::Vec3dTypes, float >;
 #endif
 #endif
 #endif
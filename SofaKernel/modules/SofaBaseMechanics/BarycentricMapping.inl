@@ -44,6 +44,8 @@
 
 #include <sofa/helper/vector.h>
 #include <sofa/helper/system/config.h>
+#include <sofa/helper/IndexOpenMP.h>
+#include <SofaBaseMechanics/TetrahedronLocator.h>
 
 #include <sofa/simulation/Simulation.h>
 
@@ -59,11 +61,143 @@ namespace component
 namespace mapping
 {
 
+template <class In, class Out, class WeightReal>
+void BarycentricWeights<In,Out,WeightReal>::clear()
+{
+    begin.assign(1, 0);
+    index.clear();
+    weight.clear();
+}
+
+template <class In, class Out, class WeightReal>
+template <class W>
+void BarycentricWeights<In,Out,WeightReal>::assign(const BarycentricWeights<In,Out,W>& w)
+{
+    begin = w.begin;
+    index = w.index;
+    weight.resize(w.weight.size());
+    for (std::size_t k=0; k<w.weight.size(); ++k)
+        weight[k] = (WeightReal)w.weight[k];
+}
+
+template <class In, class Out, class WeightReal>
+void BarycentricWeights<In,Out,WeightReal>::apply(typename Out::VecCoord& out, const typename In::VecCoord& in) const
+{
+    typedef typename In::Real InReal;
+    const unsigned int n = std::min(size(), (unsigned int)out.size());
+
+#ifdef _OPENMP
+#pragma omp parallel for if(n >= ParallelMinSize)
+#endif
+    for (helper::IndexOpenMP<unsigned int>::type i=0; i<n; ++i)
+    {
+        const unsigned int b = begin[i], e = begin[i+1];
+        if (b == e) continue;
+        typename In::Coord p = in[index[b]] * (InReal)weight[b];
+        for (unsigned int k=b+1; k<e; ++k)
+            p += in[index[k]] * (InReal)weight[k];
+        Out::setCPos(out[i], p);
+    }
+}
+
+template <class In, class Out, class WeightReal>
+void BarycentricWeights<In,Out,WeightReal>::applyJ(typename Out::VecDeriv& out, const typename In::VecDeriv& in, const ForceMask& maskTo) const
+{
+    typedef typename In::Real InReal;
+    const unsigned int n = std::min(size(), std::min((unsigned int)out.size(), (unsigned int)maskTo.size()));
+    const bool masked = maskTo.isActivated();
+
+#ifdef _OPENMP
+#pragma omp parallel for if(n >= ParallelMinSize)
+#endif
+    for (helper::IndexOpenMP<unsigned int>::type i=0; i<n; ++i)
+    {
+        if (masked && !maskTo.getEntry(i)) continue;
+        const unsigned int b = begin[i], e = begin[i+1];
+        if (b == e) continue;
+        typename In::Deriv v = in[index[b]] * (InReal)weight[b];
+        for (unsigned int k=b+1; k<e; ++k)
+            v += in[index[k]] * (InReal)weight[k];
+        Out::setDPos(out[i], v);
+    }
+}
+
+template <class In, class Out, class WeightReal>
+void BarycentricWeights<In,Out,WeightReal>::applyJT(typename In::VecDeriv& out, const typename Out::VecDeriv& in, const ForceMask& maskTo, ForceMask& maskFrom) const
+{
+    const unsigned int n = std::min(size(), std::min((unsigned int)in.size(), (unsigned int)maskTo.size()));
+    const bool masked = maskTo.isActivated();
+
+    // the mapped points share their input points, so their contributions are accumulated sequentially
+    for (unsigned int i=0; i<n; ++i)
+    {
+        if (masked && !maskTo.getEntry(i)) continue;
+        const typename Out::DPos v = Out::getDPos(in[i]);
+        for (unsigned int k=begin[i]; k<begin[i+1]; ++k)
+        {
+            const unsigned int j = index[k];
+            if (j >= out.size()) continue;
+            out[j] += v * (OutReal)weight[k];
+            maskFrom.insertEntry(j);
+        }
+    }
+}
+
+template <class In, class Out>
+void TopologyBarycentricMapper<In,Out>::updateWeights(int mapRevision)
+{
+    const int revision = fromTopology ? fromTopology->getRevision() : 0;
+    if (weightsValid && revision == weightsRevision && mapRevision == weightsMapRevision)
+        return;
+
+    weights.clear();
+    fillWeights(weights);
+    if (useFloatWeights)
+    {
+        floatWeights.assign(weights);
+        weights = Weights(); // release the double precision copy
+    }
+    else
+        floatWeights = FloatWeights();
+
+    weightsValid = true;
+    weightsRevision = revision;
+    weightsMapRevision = mapRevision;
+}
+
+template <class In, class Out>
+void TopologyBarycentricMapper<In,Out>::applyWeights( typename Out::VecCoord& out, const typename In::VecCoord& in )
+{
+    if (useFloatWeights)
+        floatWeights.apply(out, in);
+    else
+        weights.apply(out, in);
+}
+
+template <class In, class Out>
+void TopologyBarycentricMapper<In,Out>::applyJWeights( typename Out::VecDeriv& out, const typename In::VecDeriv& in )
+{
+    if (useFloatWeights)
+        floatWeights.applyJ(out, in, *maskTo);
+    else
+        weights.applyJ(out, in, *maskTo);
+}
+
+template <class In, class Out>
+void TopologyBarycentricMapper<In,Out>::applyJTWeights( typename In::VecDeriv& out, const typename Out::VecDeriv& in )
+{
+    if (useFloatWeights)
+        floatWeights.applyJT(out, in, *maskTo, *maskFrom);
+    else
+        weights.applyJT(out, in, *maskTo, *maskFrom);
+}
+
 template <class TIn, class TOut>
 BarycentricMapping<TIn, TOut>::BarycentricMapping()
     : Inherit()
     , mapper(initLink("mapper","Internal mapper created depending on the type of topology"))
     , useRestPosition(core::objectmodel::Base::initData(&useRestPosition, false, "useRestPosition", "Use the rest position of the input and output models to initialize the mapping"))
+    , d_floatWeights(core::objectmodel::Base::initData(&d_floatWeights, false, "floatWeights", "Store the weights of the mapping in single precision (only used by the mesh, sparse grid and tetrahedron mappers)"))
 #ifdef SOFA_DEV
     , sleeping(core::objectmodel::Base::initData(&sleeping, false, "sleeping", "is the mapping sleeping (not computed)"))
 #endif
@@ -74,6 +208,7 @@ template <class TIn, class TOut>
 BarycentricMapping<TIn, TOut>::BarycentricMapping(core::State<In>* from, core::State<Out>* to, typename Mapper::SPtr mapper)
     : Inherit ( from, to )
     , mapper(initLink("mapper","Internal mapper created depending on the type of topology"), mapper)
+    , d_floatWeights(core::objectmodel::Base::initData(&d_floatWeights, false, "floatWeights", "Store the weights of the mapping in single precision (only used by the mesh, sparse grid and tetrahedron mappers)"))
 #ifdef SOFA_DEV
     , sleeping(core::objectmodel::Base::initData(&sleeping, false, "sleeping", "is the mapping sleeping (not computed)"))
 #endif
@@ -86,6 +221,7 @@ template <class TIn, class TOut>
 BarycentricMapping<TIn, TOut>::BarycentricMapping (core::State<In>* from, core::State<Out>* to, BaseMeshTopology * topology )
     : Inherit ( from, to )
     , mapper (initLink("mapper","Internal mapper created depending on the type of topology"))
+    , d_floatWeights(core::objectmodel::Base::initData(&d_floatWeights, false, "floatWeights", "Store the weights of the mapping in single precision (only used by the mesh, sparse grid and tetrahedron mappers)"))
 #ifdef SOFA_DEV
     , sleeping(core::objectmodel::Base::initData(&sleeping, false, "sleeping", "is the mapping sleeping (not computed)"))
 #endif
@@ -150,6 +286,7 @@ template <class In, class Out>
 void BarycentricMapperSparseGridTopology<In,Out>::clear ( int reserve )
 {
     updateJ = true;
+    this->weightsValid = false;
     map.clear();
     if ( reserve>0 ) map.reserve ( reserve );
 }
@@ -157,6 +294,7 @@ void BarycentricMapperSparseGridTopology<In,Out>::clear ( int reserve )
 template <class In, class Out>
 int BarycentricMapperSparseGridTopology<In,Out>::addPointInCube ( const int cubeIndex, const SReal* baryCoords )
 {
+    this->weightsValid = false;
     map.resize ( map.size() +1 );
     CubeData& data = *map.rbegin();
     data.in_index = cubeIndex;
@@ -195,6 +333,7 @@ template <class In, class Out>
 void BarycentricMapperMeshTopology<In,Out>::clear1d ( int reserve )
 {
     updateJ = true;
+    this->weightsValid = false;
     map1d.clear(); if ( reserve>0 ) map1d.reserve ( reserve );
 }
 
@@ -202,6 +341,7 @@ template <class In, class Out>
 void BarycentricMapperMeshTopology<In,Out>::clear2d ( int reserve )
 {
     updateJ = true;
+    this->weightsValid = false;
     map2d.clear(); if ( reserve>0 ) map2d.reserve ( reserve );
 }
 
@@ -209,6 +349,7 @@ template <class In, class Out>
 void BarycentricMapperMeshTopology<In,Out>::clear3d ( int reserve )
 {
     updateJ = true;
+    this->weightsValid = false;
     map3d.clear(); if ( reserve>0 ) map3d.reserve ( reserve );
 }
 
@@ -216,6 +357,7 @@ template <class In, class Out>
 void BarycentricMapperMeshTopology<In,Out>::clear ( int reserve )
 {
     updateJ = true;
+    this->weightsValid = false;
     map1d.clear(); if ( reserve>0 ) map1d.reserve ( reserve );
     map2d.clear(); if ( reserve>0 ) map2d.reserve ( reserve );
     map3d.clear(); if ( reserve>0 ) map3d.reserve ( reserve );
@@ -224,6 +366,7 @@ void BarycentricMapperMeshTopology<In,Out>::clear ( int reserve )
 template <class In, class Out>
 int BarycentricMapperMeshTopology<In,Out>::addPointInLine ( const int lineIndex, const SReal* baryCoords )
 {
+    this->weightsValid = false;
     map1d.resize ( map1d.size() +1 );
     MappingData1D& data = *map1d.rbegin();
     data.in_index = lineIndex;
@@ -234,6 +377,7 @@ int BarycentricMapperMeshTopology<In,Out>::addPointInLine ( const int lineIndex,
 template <class In, class Out>
 int BarycentricMapperMeshTopology<In,Out>::addPointInTriangle ( const int triangleIndex, const SReal* baryCoords )
 {
+    this->weightsValid = false;
     map2d.resize ( map2d.size() +1 );
     MappingData2D& data = *map2d.rbegin();
     data.in_index = triangleIndex;
@@ -245,6 +389,7 @@ int BarycentricMapperMeshTopology<In,Out>::addPointInTriangle ( const int triang
 template <class In, class Out>
 int BarycentricMapperMeshTopology<In,Out>::addPointInQuad ( const int quadIndex, const SReal* baryCoords )
 {
+    this->weightsValid = false;
     map2d.resize ( map2d.size() +1 );
     MappingData2D& data = *map2d.rbegin();
     data.in_index = quadIndex + this->fromTopology->getNbTriangles();
@@ -256,6 +401,7 @@ int BarycentricMapperMeshTopology<In,Out>::addPointInQuad ( const int quadIndex,
 template <class In, class Out>
 int BarycentricMapperMeshTopology<In,Out>::addPointInTetra ( const int tetraIndex, const SReal* baryCoords )
 {
+    this->weightsValid = false;
     map3d.resize ( map3d.size() +1 );
     MappingData3D& data = *map3d.rbegin();
     data.in_index = tetraIndex;
@@ -268,6 +414,7 @@ int BarycentricMapperMeshTopology<In,Out>::addPointInTetra ( const int tetraInde
 template <class In, class Out>
 int BarycentricMapperMeshTopology<In,Out>::addPointInCube ( const int cubeIndex, const SReal* baryCoords )
 {
+    this->weightsValid = false;
     map3d.resize ( map3d.size() +1 );
     MappingData3D& data = *map3d.rbegin();
     data.in_index = cubeIndex + this->fromTopology->getNbTetrahedra();
@@ -806,6 +953,7 @@ void BarycentricMapperQuadSetTopology<In,Out>::init ( const typename Out::VecCoo
 template <class In, class Out>
 void BarycentricMapperTetrahedronSetTopology<In,Out>::clear ( int reserve )
 {
+    this->weightsValid = false;
     helper::vector<MappingData>& vectorData = *(map.beginEdit());
     vectorData.clear(); if ( reserve>0 ) vectorData.reserve ( reserve );
     map.endEdit();
@@ -814,6 +962,7 @@ void BarycentricMapperTetrahedronSetTopology<In,Out>::clear ( int reserve )
 template <class In, class Out>
 int BarycentricMapperTetrahedronSetTopology<In,Out>::addPointInTetra ( const int tetraIndex, const SReal* baryCoords )
 {
+    this->weightsValid = false;
     helper::vector<MappingData>& vectorData = *(map.beginEdit());
     vectorData.resize ( map.getValue().size() +1 );
     MappingData& data = *vectorData.rbegin();
@@ -845,42 +994,47 @@ void BarycentricMapperTetrahedronSetTopology<In,Out>::init ( const typename Out:
     int outside = 0;
     const sofa::helper::vector<core::topology::BaseMeshTopology::Tetrahedron>& tetrahedra = this->fromTopology->getTetrahedra();
 
-    sofa::helper::vector< sofa::defaulttype::Matrix3> bases;
-    sofa::helper::vector< sofa::defaulttype::Vector3> centers;
+    // the tetrahedron of each point is searched in a grid instead of testing all of them, with the same result
+    TetrahedronLocator locator;
+    const unsigned int nbTetrahedra = (unsigned int)tetrahedra.size();
+    locator.resize ( nbTetrahedra );
 
     clear ( (int)out.size() );
-    bases.resize ( tetrahedra.size() );
-    centers.resize ( tetrahedra.size() );
-    for ( unsigned int t = 0; t < tetrahedra.size(); t++ )
+#ifdef _OPENMP
+#pragma omp parallel for if(nbTetrahedra >= Inherit::Weights::ParallelMinSize)
+#endif
+    for ( helper::IndexOpenMP<unsigned int>::type t = 0; t < nbTetrahedra; t++ )
     {
         sofa::defaulttype::Mat3x3d m,mt;
+        sofa::defaulttype::Matrix3 base;
         m[0] = in[tetrahedra[t][1]]-in[tetrahedra[t][0]];
         m[1] = in[tetrahedra[t][2]]-in[tetrahedra[t][0]];
         m[2] = in[tetrahedra[t][3]]-in[tetrahedra[t][0]];
         mt.transpose ( m );
-        bases[t].invert ( mt );
-        centers[t] = ( in[tetrahedra[t][0]]+in[tetrahedra[t][1]]+in[tetrahedra[t][2]]+in[tetrahedra[t][3]] ) *0.25;
+        const bool invertible = base.invert ( mt );
+        locator.setTetrahedron ( t, in[tetrahedra[t][0]], m, base, invertible,
+                                 ( in[tetrahedra[t][0]]+in[tetrahedra[t][1]]+in[tetrahedra[t][2]]+in[tetrahedra[t][3]] ) *0.25 );
     }
+    locator.build();
 
-    for ( unsigned int i=0; i<out.size(); i++ )
+    const unsigned int nbPoints = (unsigned int)out.size();
+    sofa::helper::vector< int > indices ( nbPoints );
+    sofa::helper::vector< sofa::defaulttype::Vector3 > coefs ( nbPoints );
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:outside) if(nbPoints >= Inherit::Weights::ParallelMinSize)
+#endif
+    for ( helper::IndexOpenMP<unsigned int>::type i=0; i<nbPoints; i++ )
     {
-        sofa::defaulttype::Vec3d pos = Out::getCPos(out[i]);
-        sofa::defaulttype::Vector3 coefs;
-        int index = -1;
-        double distance = 1e10;
-        for ( unsigned int t = 0; t < tetrahedra.size(); t++ )
-        {
-            sofa::defaulttype::Vec3d v = bases[t] * ( pos - in[tetrahedra[t][0]] );
-            double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( -v[2],v[0]+v[1]+v[2]-1 ) );
-            if ( d>0 ) d = ( pos-centers[t] ).norm2();
-            if ( d<distance ) { coefs = v; distance = d; index = t; }
-        }
+        double distance;
+        indices[i] = locator.find ( Out::getCPos(out[i]), coefs[i], distance );
         if ( distance>0 )
         {
             ++outside;
         }
-        addPointInTetra ( index, coefs.ptr() );
     }
+
+    for ( unsigned int i=0; i<nbPoints; i++ )
+        addPointInTetra ( indices[i], coefs[i].ptr() );
 }
 
 
@@ -1102,6 +1256,7 @@ void BarycentricMapping<TIn, TOut>::init()
 
     if ( mapper != NULL )
     {
+        mapper->setFloatWeights(d_floatWeights.getValue());
         if (useRestPosition.getValue())
             mapper->init ( ((const core::State<Out> *)this->toModel)->read(core::ConstVecCoordId::restPosition())->getValue(), ((const core::State<In> *)this->fromModel)->read(core::ConstVecCoordId::restPosition())->getValue() );
         else
@@ -1120,6 +1275,7 @@ void BarycentricMapping<TIn, TOut>::reinit()
     if ( mapper != NULL )
     {
         mapper->clear();
+        mapper->setFloatWeights(d_floatWeights.getValue());
         mapper->init (((const core::State<Out> *)this->toModel)->read(core::ConstVecCoordId::position())->getValue(), ((const core::State<In> *)this->fromModel)->read(core::ConstVecCoordId::position())->getValue() );
     }
 }
@@ -1141,16 +1297,8 @@ void BarycentricMapping<TIn, TOut>::apply(const core::MechanicalParams * /*mpara
 
 
 template <class In, class Out>
-void BarycentricMapperMeshTopology<In,Out>::resize( core::State<Out>* toModel )
+void BarycentricMapperMeshTopology<In,Out>::fillWeights ( typename Inherit::Weights& w )
 {
-    toModel->resize(map1d.size() +map2d.size() +map3d.size());
-}
-
-template <class In, class Out>
-void BarycentricMapperMeshTopology<In,Out>::apply ( typename Out::VecCoord& out, const typename In::VecCoord& in )
-{
-    out.resize( map1d.size() +map2d.size() +map3d.size() );
-
     const sofa::core::topology::BaseMeshTopology::SeqLines& lines = this->fromTopology->getLines();
     const sofa::core::topology::BaseMeshTopology::SeqTriangles& triangles = this->fromTopology->getTriangles();
     const sofa::core::topology::BaseMeshTopology::SeqQuads& quads = this->fromTopology->getQuads();
@@ -1158,82 +1306,84 @@ void BarycentricMapperMeshTopology<In,Out>::apply ( typename Out::VecCoord& out,
     const sofa::core::topology::BaseMeshTopology::SeqHexahedra& cubes = this->fromTopology->getHexahedra();
 
     // 1D elements
+    for ( unsigned int i=0; i<map1d.size(); i++ )
     {
-        for ( unsigned int i=0; i<map1d.size(); i++ )
-        {
-            const Real fx = map1d[i].baryCoords[0];
-            int index = map1d[i].in_index;
-            {
-                const sofa::core::topology::BaseMeshTopology::Line& line = lines[index];
-                Out::setCPos(out[i] , in[line[0]] * ( 1-fx )
-                        + in[line[1]] * fx );
-            }
-        }
+        const Real fx = map1d[i].baryCoords[0];
+        const sofa::core::topology::BaseMeshTopology::Line& line = lines[map1d[i].in_index];
+        w.add( line[0], ( 1-fx ) );
+        w.add( line[1], fx );
+        w.endPoint();
     }
     // 2D elements
+    const int c2 = triangles.size();
+    for ( unsigned int i=0; i<map2d.size(); i++ )
     {
-        const int i0 = map1d.size();
-        const int c0 = triangles.size();
-        for ( unsigned int i=0; i<map2d.size(); i++ )
+        const Real fx = map2d[i].baryCoords[0];
+        const Real fy = map2d[i].baryCoords[1];
+        int index = map2d[i].in_index;
+        if ( index<c2 )
         {
-            const Real fx = map2d[i].baryCoords[0];
-            const Real fy = map2d[i].baryCoords[1];
-            int index = map2d[i].in_index;
-            if ( index<c0 )
-            {
-                const sofa::core::topology::BaseMeshTopology::Triangle& triangle = triangles[index];
-                Out::setCPos(out[i+i0] , in[triangle[0]] * ( 1-fx-fy )
-                        + in[triangle[1]] * fx
-                        + in[triangle[2]] * fy );
-            }
-            else
-            {
-                if (quads.size())
-                {
-                    const sofa::core::topology::BaseMeshTopology::Quad& quad = quads[index-c0];
-                    Out::setCPos(out[i+i0] , in[quad[0]] * ( ( 1-fx ) * ( 1-fy ) )
-                            + in[quad[1]] * ( ( fx ) * ( 1-fy ) )
-                            + in[quad[3]] * ( ( 1-fx ) * ( fy ) )
-                            + in[quad[2]] * ( ( fx ) * ( fy ) ) );
-                }
-            }
+            const sofa::core::topology::BaseMeshTopology::Triangle& triangle = triangles[index];
+            w.add( triangle[0], ( 1-fx-fy ) );
+            w.add( triangle[1], fx );
+            w.add( triangle[2], fy );
         }
+        else if (quads.size())
+        {
+            const sofa::core::topology::BaseMeshTopology::Quad& quad = quads[index-c2];
+            w.add( quad[0], ( ( 1-fx ) * ( 1-fy ) ) );
+            w.add( quad[1], ( ( fx ) * ( 1-fy ) ) );
+            w.add( quad[3], ( ( 1-fx ) * ( fy ) ) );
+            w.add( quad[2], ( ( fx ) * ( fy ) ) );
+        }
+        w.endPoint();
     }
     // 3D elements
-    {
-        const int i0 = map1d.size() + map2d.size();
-        const int c0 = tetrahedra.size();
-        for ( unsigned int i=0; i<map3d.size(); i++ )
+    const int c3 = tetrahedra.size();
+    for ( unsigned int i=0; i<map3d.size(); i++ )
+    {
+        const Real fx = map3d[i].baryCoords[0];
+        const Real fy = map3d[i].baryCoords[1];
+        const Real fz = map3d[i].baryCoords[2];
+        int index = map3d[i].in_index;
+        if ( index<c3 )
         {
-            const Real fx = map3d[i].baryCoords[0];
-            const Real fy = map3d[i].baryCoords[1];
-            const Real fz = map3d[i].baryCoords[2];
-            int index = map3d[i].in_index;
-            if ( index<c0 )
-            {
-                const sofa::core::topology::BaseMeshTopology::Tetra& tetra = tetrahedra[index];
-                Out::setCPos(out[i+i0] , in[tetra[0]] * ( 1-fx-fy-fz )
-                        + in[tetra[1]] * fx
-                        + in[tetra[2]] * fy
-                        + in[tetra[3]] * fz );
-            }
-            else
-            {
-                const sofa::core::topology::BaseMeshTopology::Hexa& cube = cubes[index-c0];
-
-                Out::setCPos(out[i+i0] , in[cube[0]] * ( ( 1-fx ) * ( 1-fy ) * ( 1-fz ) )
-                        + in[cube[1]] * ( ( fx ) * ( 1-fy ) * ( 1-fz ) )
-                        + in[cube[3]] * ( ( 1-fx ) * ( fy ) * ( 1-fz ) )
-                        + in[cube[2]] * ( ( fx ) * ( fy ) * ( 1-fz ) )
-                        + in[cube[4]] * ( ( 1-fx ) * ( 1-fy ) * ( fz ) )
-                        + in[cube[5]] * ( ( fx ) * ( 1-fy ) * ( fz ) )
-                        + in[cube[7]] * ( ( 1-fx ) * ( fy ) * ( fz ) )
-                        + in[cube[6]] * ( ( fx ) * ( fy ) * ( fz ) ) );
-            }
+            const sofa::core::topology::BaseMeshTopology::Tetra& tetra = tetrahedra[index];
+            w.add( tetra[0], ( 1-fx-fy-fz ) );
+            w.add( tetra[1], fx );
+            w.add( tetra[2], fy );
+            w.add( tetra[3], fz );
         }
+        else
+        {
+            const sofa::core::topology::BaseMeshTopology::Hexa& cube = cubes[index-c3];
+            w.add( cube[0], ( ( 1-fx ) * ( 1-fy ) * ( 1-fz ) ) );
+            w.add( cube[1], ( ( fx ) * ( 1-fy ) * ( 1-fz ) ) );
+            w.add( cube[3], ( ( 1-fx ) * ( fy ) * ( 1-fz ) ) );
+            w.add( cube[2], ( ( fx ) * ( fy ) * ( 1-fz ) ) );
+            w.add( cube[4], ( ( 1-fx ) * ( 1-fy ) * ( fz ) ) );
+            w.add( cube[5], ( ( fx ) * ( 1-fy ) * ( fz ) ) );
+            w.add( cube[7], ( ( 1-fx ) * ( fy ) * ( fz ) ) );
+            w.add( cube[6], ( ( fx ) * ( fy ) * ( fz ) ) );
+        }
+        w.endPoint();
     }
 }
 
+template <class In, class Out>
+void BarycentricMapperMeshTopology<In,Out>::resize( core::State<Out>* toModel )
+{
+    toModel->resize(map1d.size() +map2d.size() +map3d.size());
+}
+
+template <class In, class Out>
+void BarycentricMapperMeshTopology<In,Out>::apply ( typename Out::VecCoord& out, const typename In::VecCoord& in )
+{
+    out.resize( map1d.size() +map2d.size() +map3d.size() );
+    this->updateWeights();
+    this->applyWeights(out, in);
+}
+
 
 template <class In, class Out>
 void BarycentricMapperRegularGridTopology<In,Out>::resize( core::State<Out>* toModel )
@@ -1265,6 +1415,28 @@ void BarycentricMapperRegularGridTopology<In,Out>::apply ( typename Out::VecCoor
     }
 }
 
+template <class In, class Out>
+void BarycentricMapperSparseGridTopology<In,Out>::fillWeights ( typename Inherit::Weights& w )
+{
+    for ( unsigned int i=0; i<map.size(); i++ )
+    {
+        const topology::SparseGridTopology::Hexa cube = this->fromTopology->getHexahedron( map[i].in_index );
+
+        const Real fx = map[i].baryCoords[0];
+        const Real fy = map[i].baryCoords[1];
+        const Real fz = map[i].baryCoords[2];
+        w.add( cube[0], ( ( 1-fx ) * ( 1-fy ) * ( 1-fz ) ) );
+        w.add( cube[1], ( ( fx ) * ( 1-fy ) * ( 1-fz ) ) );
+        w.add( cube[3], ( ( 1-fx ) * ( fy ) * ( 1-fz ) ) );
+        w.add( cube[2], ( ( fx ) * ( fy ) * ( 1-fz ) ) );
+        w.add( cube[4], ( ( 1-fx ) * ( 1-fy ) * ( fz ) ) );
+        w.add( cube[5], ( ( fx ) * ( 1-fy ) * ( fz ) ) );
+        w.add( cube[7], ( ( 1-fx ) * ( fy ) * ( fz ) ) );
+        w.add( cube[6], ( ( fx ) * ( fy ) * ( fz ) ) );
+        w.endPoint();
+    }
+}
+
 template <class In, class Out>
 void BarycentricMapperSparseGridTopology<In,Out>::resize( core::State<Out>* toModel )
 {
@@ -1275,35 +1447,8 @@ template <class In, class Out>
 void BarycentricMapperSparseGridTopology<In,Out>::apply ( typename Out::VecCoord& out, const typename In::VecCoord& in )
 {
     out.resize( map.size() );
-
-    typedef sofa::helper::vector< CubeData > CubeDataVector;
-    typedef typename CubeDataVector::const_iterator CubeDataVectorIt;
-
-    CubeDataVectorIt it = map.begin();
-    CubeDataVectorIt itEnd = map.end();
-
-    unsigned int i = 0;
-
-    while (it != itEnd)
-    {
-        const topology::SparseGridTopology::Hexa cube = this->fromTopology->getHexahedron( it->in_index );
-
-        const Real fx = it->baryCoords[0];
-        const Real fy = it->baryCoords[1];
-        const Real fz = it->baryCoords[2];
-
-        Out::setCPos(out[i] , in[cube[0]] * ( ( 1-fx ) * ( 1-fy ) * ( 1-fz ) )
-                + in[cube[1]] * ( ( fx ) * ( 1-fy ) * ( 1-fz ) )
-                + in[cube[3]] * ( ( 1-fx ) * ( fy ) * ( 1-fz ) )
-                + in[cube[2]] * ( ( fx ) * ( fy ) * ( 1-fz ) )
-                + in[cube[4]] * ( ( 1-fx ) * ( 1-fy ) * ( fz ) )
-                + in[cube[5]] * ( ( fx ) * ( 1-fy ) * ( fz ) )
-                + in[cube[7]] * ( ( 1-fx ) * ( fy ) * ( fz ) )
-                + in[cube[6]] * ( ( fx ) * ( fy ) * ( fz ) ) );
-
-        ++it;
-        ++i;
-    }
+    this->updateWeights();
+    this->applyWeights(out, in);
 }
 
 template <class In, class Out>
@@ -1380,6 +1525,31 @@ void BarycentricMapperQuadSetTopology<In,Out>::apply ( typename Out::VecCoord& o
     }
 }
 
+template <class In, class Out>
+int BarycentricMapperTetrahedronSetTopology<In,Out>::getMapRevision()
+{
+    return map.getCounter() + _fromContainer->getTetrahedronDataArray().getCounter();
+}
+
+template <class In, class Out>
+void BarycentricMapperTetrahedronSetTopology<In,Out>::fillWeights ( typename Inherit::Weights& w )
+{
+    const sofa::helper::vector<MappingData>& vectorData = map.getValue();
+    const sofa::helper::vector<core::topology::BaseMeshTopology::Tetrahedron>& tetrahedra = this->fromTopology->getTetrahedra();
+    for ( unsigned int i=0; i<vectorData.size(); i++ )
+    {
+        const Real fx = vectorData[i].baryCoords[0];
+        const Real fy = vectorData[i].baryCoords[1];
+        const Real fz = vectorData[i].baryCoords[2];
+        const core::topology::BaseMeshTopology::Tetrahedron& tetra = tetrahedra[vectorData[i].in_index];
+        w.add( tetra[0], ( 1-fx-fy-fz ) );
+        w.add( tetra[1], fx );
+        w.add( tetra[2], fy );
+        w.add( tetra[3], fz );
+        w.endPoint();
+    }
+}
+
 template <class In, class Out>
 void BarycentricMapperTetrahedronSetTopology<In,Out>::resize( core::State<Out>* toModel )
 {
@@ -1390,22 +1560,8 @@ template <class In, class Out>
 void BarycentricMapperTetrahedronSetTopology<In,Out>::apply ( typename Out::VecCoord& out, const typename In::VecCoord& in )
 {
     out.resize( map.getValue().size() );
-
-    const sofa::helper::vector<core::topology::BaseMeshTopology::Tetrahedron>& tetrahedra = this->fromTopology->getTetrahedra();
-    for ( unsigned int i=0; i<map.getValue().size(); i++ )
-    {
-        const Real fx = map.getValue()[i].baryCoords[0];
-        const Real fy = map.getValue()[i].baryCoords[1];
-        const Real fz = map.getValue()[i].baryCoords[2];
-        int index = map.getValue()[i].in_index;
-        const core::topology::BaseMeshTopology::Tetrahedron& tetra = tetrahedra[index];
-        Out::setCPos(out[i] , in[tetra[0]] * ( 1-fx-fy-fz )
-                + in[tetra[1]] * fx
-                + in[tetra[2]] * fy
-                + in[tetra[3]] * fz );
-    }
-    //serr<<"BarycentricMapperTetrahedronSetTopology<In,Out>::apply, in = "<<in<<sendl;
-    //serr<<"BarycentricMapperTetrahedronSetTopology<In,Out>::apply, out = "<<out<<sendl;
+    this->updateWeights(getMapRevision());
+    this->applyWeights(out, in);
 }
 
 template <class In, class Out>
@@ -1482,99 +1638,8 @@ template <class In, class Out>
 void BarycentricMapperMeshTopology<In,Out>::applyJ ( typename Out::VecDeriv& out, const typename In::VecDeriv& in )
 {
     out.resize( map1d.size() +map2d.size() +map3d.size() );
-
-    const sofa::core::topology::BaseMeshTopology::SeqLines& lines = this->fromTopology->getLines();
-    const sofa::core::topology::BaseMeshTopology::SeqTriangles& triangles = this->fromTopology->getTriangles();
-    const sofa::core::topology::BaseMeshTopology::SeqQuads& quads = this->fromTopology->getQuads();
-    const sofa::core::topology::BaseMeshTopology::SeqTetrahedra& tetrahedra = this->fromTopology->getTetrahedra();
-    const sofa::core::topology::BaseMeshTopology::SeqHexahedra& cubes = this->fromTopology->getHexahedra();
-
-
-
-    //std::cout << "BarycentricMapper: applyJ with masks" << std::endl;
-
-    const size_t sizeMap1d=map1d.size();
-    const size_t sizeMap2d=map2d.size();
-    const size_t sizeMap3d=map3d.size();
-
-    const size_t idxStart1=sizeMap1d;
-    const size_t idxStart2=sizeMap1d+sizeMap2d;
-    const size_t idxStart3=sizeMap1d+sizeMap2d+sizeMap3d;
-
-    for( size_t i=0 ; i<this->maskTo->size() ; ++i)
-    {
-        if( this->maskTo->isActivated() && !this->maskTo->getEntry(i) ) continue;
-
-        // 1D elements
-        if (i < idxStart1)
-        {
-            const Real fx = map1d[i].baryCoords[0];
-            int index = map1d[i].in_index;
-            {
-                const sofa::core::topology::BaseMeshTopology::Line& line = lines[index];
-                Out::setDPos(out[i] , in[line[0]] * ( 1-fx )
-                        + in[line[1]] * fx );
-            }
-        }
-        // 2D elements
-        else if (i < idxStart2)
-        {
-            const size_t i0 = idxStart1;
-            const size_t c0 = triangles.size();
-
-            const Real fx = map2d[i-i0].baryCoords[0];
-            const Real fy = map2d[i-i0].baryCoords[1];
-            size_t index = map2d[i-i0].in_index;
-
-            if ( index<c0 )
-            {
-                const sofa::core::topology::BaseMeshTopology::Triangle& triangle = triangles[index];
-                Out::setDPos(out[i] , in[triangle[0]] * ( 1-fx-fy )
-                        + in[triangle[1]] * fx
-                        + in[triangle[2]] * fy );
-            }
-            else
-            {
-                const sofa::core::topology::BaseMeshTopology::Quad& quad = quads[index-c0];
-                Out::setDPos(out[i] , in[quad[0]] * ( ( 1-fx ) * ( 1-fy ) )
-                        + in[quad[1]] * ( ( fx ) * ( 1-fy ) )
-                        + in[quad[3]] * ( ( 1-fx ) * ( fy ) )
-                        + in[quad[2]] * ( ( fx ) * ( fy ) ) );
-            }
-        }
-        // 3D elements
-        else if (i < idxStart3)
-        {
-            const size_t i0 = idxStart2;
-            const size_t c0 = tetrahedra.size();
-            const Real fx = map3d[i-i0].baryCoords[0];
-            const Real fy = map3d[i-i0].baryCoords[1];
-            const Real fz = map3d[i-i0].baryCoords[2];
-            size_t index = map3d[i-i0].in_index;
-            if ( index<c0 )
-            {
-                const sofa::core::topology::BaseMeshTopology::Tetra& tetra = tetrahedra[index];
-                Out::setDPos(out[i] , in[tetra[0]] * ( 1-fx-fy-fz )
-                        + in[tetra[1]] * fx
-                        + in[tetra[2]] * fy
-                        + in[tetra[3]] * fz );
-            }
-            else
-            {
-                const sofa::core::topology::BaseMeshTopology::Hexa& cube = cubes[index-c0];
-
-                Out::setDPos(out[i] , in[cube[0]] * ( ( 1-fx ) * ( 1-fy ) * ( 1-fz ) )
-                        + in[cube[1]] * ( ( fx ) * ( 1-fy ) * ( 1-fz ) )
-                        + in[cube[3]] * ( ( 1-fx ) * ( fy ) * ( 1-fz ) )
-                        + in[cube[2]] * ( ( fx ) * ( fy ) * ( 1-fz ) )
-                        + in[cube[4]] * ( ( 1-fx ) * ( 1-fy ) * ( fz ) )
-                        + in[cube[5]] * ( ( fx ) * ( 1-fy ) * ( fz ) )
-                        + in[cube[7]] * ( ( 1-fx ) * ( fy ) * ( fz ) )
-                        + in[cube[6]] * ( ( fx ) * ( fy ) * ( fz ) ) );
-            }
-        }
-    }
-
+    this->updateWeights();
+    this->applyJWeights(out, in);
 }
 
 template <class In, class Out>
@@ -1606,26 +1671,8 @@ template <class In, class Out>
 void BarycentricMapperSparseGridTopology<In,Out>::applyJ ( typename Out::VecDeriv& out, const typename In::VecDeriv& in )
 {
     out.resize( map.size() );
-
-    for( size_t index=0 ; index<this->maskTo->size() ; ++index)
-    {
-        if( this->maskTo->isActivated() && !this->maskTo->getEntry(index) ) continue;
-
-        const topology::SparseGridTopology::Hexa cube = this->fromTopology->getHexahedron ( this->map[index].in_index );
-
-        const Real fx = map[index].baryCoords[0];
-        const Real fy = map[index].baryCoords[1];
-        const Real fz = map[index].baryCoords[2];
-        Out::setDPos(out[index] , in[cube[0]] * ( ( 1-fx ) * ( 1-fy ) * ( 1-fz ) )
-                + in[cube[1]] * ( ( fx ) * ( 1-fy ) * ( 1-fz ) )
-                + in[cube[3]] * ( ( 1-fx ) * ( fy ) * ( 1-fz ) )
-                + in[cube[2]] * ( ( fx ) * ( fy ) * ( 1-fz ) )
-                + in[cube[4]] * ( ( 1-fx ) * ( 1-fy ) * ( fz ) )
-                + in[cube[5]] * ( ( fx ) * ( 1-fy ) * ( fz ) )
-                + in[cube[7]] * ( ( 1-fx ) * ( fy ) * ( fz ) )
-                + in[cube[6]] * ( ( fx ) * ( fy ) * ( fz ) ) );
-    }
-
+    this->updateWeights();
+    this->applyJWeights(out, in);
 }
 
 template <class In, class Out>
@@ -1694,24 +1741,8 @@ template <class In, class Out>
 void BarycentricMapperTetrahedronSetTopology<In,Out>::applyJ ( typename Out::VecDeriv& out, const typename In::VecDeriv& in )
 {
     out.resize( map.getValue().size() );
-
-    const sofa::helper::vector<core::topology::BaseMeshTopology::Tetrahedron>& tetrahedra = this->fromTopology->getTetrahedra();
-
-
-    for( size_t i=0 ; i<this->maskTo->size() ; ++i)
-    {
-        if( this->maskTo->isActivated() && !this->maskTo->getEntry(i) ) continue;
-
-        const Real fx = map.getValue()[i].baryCoords[0];
-        const Real fy = map.getValue()[i].baryCoords[1];
-        const Real fz = map.getValue()[i].baryCoords[2];
-        int index = map.getValue()[i].in_index;
-        const core::topology::BaseMeshTopology::Tetrahedron& tetra = tetrahedra[index];
-        Out::setDPos(out[i] , in[tetra[0]] * ( 1-fx-fy-fz )
-                + in[tetra[1]] * fx
-                + in[tetra[2]] * fy
-                + in[tetra[3]] * fz );
-    }
+    this->updateWeights(getMapRevision());
+    this->applyJWeights(out, in);
 }
 
 template <class In, class Out>
@@ -1759,119 +1790,8 @@ void BarycentricMapping<TIn, TOut>::applyJT (const core::MechanicalParams * /*mp
 template <class In, class Out>
 void BarycentricMapperMeshTopology<In,Out>::applyJT ( typename In::VecDeriv& out, const typename Out::VecDeriv& in )
 {
-    const sofa::core::topology::BaseMeshTopology::SeqLines& lines = this->fromTopology->getLines();
-    const sofa::core::topology::BaseMeshTopology::SeqTriangles& triangles = this->fromTopology->getTriangles();
-    const sofa::core::topology::BaseMeshTopology::SeqQuads& quads = this->fromTopology->getQuads();
-    const sofa::core::topology::BaseMeshTopology::SeqTetrahedra& tetrahedra = this->fromTopology->getTetrahedra();
-    const sofa::core::topology::BaseMeshTopology::SeqHexahedra& cubes = this->fromTopology->getHexahedra();
-
-    const size_t i1d = map1d.size();
-    const size_t i2d = map2d.size();
-    const size_t i3d = map3d.size();
-
-    ForceMask& mask = *this->maskFrom;
-
-    for( size_t i=0 ; i<this->maskTo->size() ; ++i)
-    {
-        if( !this->maskTo->getEntry(i) ) continue;
-
-        // 1D elements
-        if (i < i1d)
-        {
-            const typename Out::DPos v = Out::getDPos(in[i]);
-            const OutReal fx = ( OutReal ) map1d[i].baryCoords[0];
-            size_t index = map1d[i].in_index;
-            {
-                const sofa::core::topology::BaseMeshTopology::Line& line = lines[index];
-                out[line[0]] += v * ( 1-fx );
-                out[line[1]] += v * fx;
-                mask.insertEntry(line[0]);
-                mask.insertEntry(line[1]);
-            }
-        }
-        // 2D elements
-        else if (i < i1d+i2d)
-        {
-            const size_t i0 = map1d.size();
-            const size_t c0 = triangles.size();
-            const typename Out::DPos v = Out::getDPos(in[i]);
-            const OutReal fx = ( OutReal ) map2d[i-i0].baryCoords[0];
-            const OutReal fy = ( OutReal ) map2d[i-i0].baryCoords[1];
-            size_t index = map2d[i-i0].in_index;
-            if ( index<c0 )
-            {
-                const sofa::core::topology::BaseMeshTopology::Triangle& triangle = triangles[index];
-                out[triangle[0]] += v * ( 1-fx-fy );
-                out[triangle[1]] += v * fx;
-                out[triangle[2]] += v * fy;
-                mask.insertEntry(triangle[0]);
-                mask.insertEntry(triangle[1]);
-                mask.insertEntry(triangle[2]);
-            }
-            else
-            {
-                const sofa::core::topology::BaseMeshTopology::Quad& quad = quads[index-c0];
-                out[quad[0]] += v * ( ( 1-fx ) * ( 1-fy ) );
-                out[quad[1]] += v * ( ( fx ) * ( 1-fy ) );
-                out[quad[3]] += v * ( ( 1-fx ) * ( fy ) );
-                out[quad[2]] += v * ( ( fx ) * ( fy ) );
-                mask.insertEntry(quad[0]);
-                mask.insertEntry(quad[1]);
-                mask.insertEntry(quad[2]);
-                mask.insertEntry(quad[3]);
-            }
-        }
-        // 3D elements
-        else if (i < i1d+i2d+i3d)
-        {
-            const size_t i0 = map1d.size() + map2d.size();
-            const size_t c0 = tetrahedra.size();
-            const typename Out::DPos v = Out::getDPos(in[i]);
-            const OutReal fx = ( OutReal ) map3d[i-i0].baryCoords[0];
-            const OutReal fy = ( OutReal ) map3d[i-i0].baryCoords[1];
-            const OutReal fz = ( OutReal ) map3d[i-i0].baryCoords[2];
-            size_t index = map3d[i-i0].in_index;
-            if ( index<c0 )
-            {
-                const sofa::core::topology::BaseMeshTopology::Tetra& tetra = tetrahedra[index];
-                out[tetra[0]] += v * ( 1-fx-fy-fz );
-                out[tetra[1]] += v * fx;
-                out[tetra[2]] += v * fy;
-                out[tetra[3]] += v * fz;
-                mask.insertEntry(tetra[0]);
-                mask.insertEntry(tetra[1]);
-                mask.insertEntry(tetra[2]);
-                mask.insertEntry(tetra[3]);
-            }
-            else
-            {
-
-                const sofa::core::topology::BaseMeshTopology::Hexa& cube = cubes[index-c0];
-
-                out[cube[0]] += v * ( ( 1-fx ) * ( 1-fy ) * ( 1-fz ) );
-                out[cube[1]] += v * ( ( fx ) * ( 1-fy ) * ( 1-fz ) );
-
-                out[cube[3]] += v * ( ( 1-fx ) * ( fy ) * ( 1-fz ) );
-                out[cube[2]] += v * ( ( fx ) * ( fy ) * ( 1-fz ) );
-
-                out[cube[4]] += v * ( ( 1-fx ) * ( 1-fy ) * ( fz ) );
-                out[cube[5]] += v * ( ( fx ) * ( 1-fy ) * ( fz ) );
-
-                out[cube[7]] += v * ( ( 1-fx ) * ( fy ) * ( fz ) );
-                out[cube[6]] += v * ( ( fx ) * ( fy ) * ( fz ) );
-
-
-                mask.insertEntry(cube[0]);
-                mask.insertEntry(cube[1]);
-                mask.insertEntry(cube[2]);
-                mask.insertEntry(cube[3]);
-                mask.insertEntry(cube[4]);
-                mask.insertEntry(cube[5]);
-                mask.insertEntry(cube[6]);
-                mask.insertEntry(cube[7]);
-            }
-        }
-    }
+    this->updateWeights();
+    this->applyJTWeights(out, in);
 }
 
 
@@ -1919,40 +1839,8 @@ void BarycentricMapperRegularGridTopology<In,Out>::applyJT ( typename In::VecDer
 template <class In, class Out>
 void BarycentricMapperSparseGridTopology<In,Out>::applyJT ( typename In::VecDeriv& out, const typename Out::VecDeriv& in )
 {
-    ForceMask& mask = *this->maskFrom;
-
-    for( size_t index=0 ; index<this->maskTo->size() ; ++index)
-    {
-        if( !this->maskTo->getEntry(index) ) continue;
-
-        const typename Out::DPos v = Out::getDPos(in[index]);
-
-        const topology::SparseGridTopology::Hexa cube = this->fromTopology->getHexahedron ( this->map[index].in_index );
-
-        const OutReal fx = ( OutReal ) map[index].baryCoords[0];
-        const OutReal fy = ( OutReal ) map[index].baryCoords[1];
-        const OutReal fz = ( OutReal ) map[index].baryCoords[2];
-        out[cube[0]] += v * ( ( 1-fx ) * ( 1-fy ) * ( 1-fz ) );
-        out[cube[1]] += v * ( ( fx ) * ( 1-fy ) * ( 1-fz ) );
-
-        out[cube[3]] += v * ( ( 1-fx ) * ( fy ) * ( 1-fz ) );
-        out[cube[2]] += v * ( ( fx ) * ( fy ) * ( 1-fz ) );
-
-        out[cube[4]] += v * ( ( 1-fx ) * ( 1-fy ) * ( fz ) );
-        out[cube[5]] += v * ( ( fx ) * ( 1-fy ) * ( fz ) );
-
-        out[cube[7]] += v * ( ( 1-fx ) * ( fy ) * ( fz ) );
-        out[cube[6]] += v * ( ( fx ) * ( fy ) * ( fz ) );
-
-        mask.insertEntry(cube[0]);
-        mask.insertEntry(cube[1]);
-        mask.insertEntry(cube[2]);
-        mask.insertEntry(cube[3]);
-        mask.insertEntry(cube[4]);
-        mask.insertEntry(cube[5]);
-        mask.insertEntry(cube[6]);
-        mask.insertEntry(cube[7]);
-    }
+    this->updateWeights();
+    this->applyJTWeights(out, in);
 }
 
 template <class In, class Out>
@@ -2035,29 +1923,8 @@ void BarycentricMapperQuadSetTopology<In,Out>::applyJT ( typename In::VecDeriv&
 template <class In, class Out>
 void BarycentricMapperTetrahedronSetTopology<In,Out>::applyJT ( typename In::VecDeriv& out, const typename Out::VecDeriv& in )
 {
-    const sofa::helper::vector<core::topology::BaseMeshTopology::Tetrahedron>& tetrahedra = this->fromTopology->getTetrahedra();
-
-    ForceMask& mask = *this->maskFrom;
-
-    for( size_t i=0 ; i<this->maskTo->size() ; ++i)
-    {
-        if( !this->maskTo->getEntry(i) ) continue;
-
-        const typename Out::DPos v = Out::getDPos(in[i]);
-        const OutReal fx = ( OutReal ) map.getValue()[i].baryCoords[0];
-        const OutReal fy = ( OutReal ) map.getValue()[i].baryCoords[1];
-        const OutReal fz = ( OutReal ) map.getValue()[i].baryCoords[2];
-        int index = map.getValue()[i].in_index;
-        const core::topology::BaseMeshTopology::Tetrahedron& tetra = tetrahedra[index];
-        out[tetra[0]] += v * ( 1-fx-fy-fz );
-        out[tetra[1]] += v * fx;
-        out[tetra[2]] += v * fy;
-        out[tetra[3]] += v * fz;
-        mask.insertEntry(tetra[0]);
-        mask.insertEntry(tetra[1]);
-        mask.insertEntry(tetra[2]);
-        mask.insertEntry(tetra[3]);
-    }
+    this->updateWeights(getMapRevision());
+    this->applyJTWeights(out, in);
 }
 
 template <class In, class Out>
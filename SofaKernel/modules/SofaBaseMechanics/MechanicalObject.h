@@ -156,6 +156,8 @@ public:
 
     Data< bool >  d_useTopology; ///< Shall this object rely on any active topology to initialize its size and positions
 
+    Data< bool >  d_compensatedDot; ///< Use compensated sums in the dot products of the state vectors, more accurate but slower
+
     Data< bool >  showObject; ///< Show objects. (default=false)
     Data< float > showObjectScale; ///< Scale for object display. (default=0.1)
     Data< bool >  showIndices; ///< Show indices. (default=false)
@@ -173,6 +175,11 @@ public:
 
     virtual void reset() override;
 
+    /// The position, velocity and rest position computed by init(), which skips their computation
+    /// when they are restored from a scene snapshot
+    virtual bool writeSnapshotState(std::ostream& out) const override;
+    virtual bool readSnapshotState(std::istream& in) override;
+
     virtual void writeVec(core::ConstVecId v, std::ostream &out) override;
     virtual void readVec(core::VecId v, std::istream &in) override;
     virtual SReal compareVec(core::ConstVecId v, std::istream &in) override;
@@ -418,6 +425,7 @@ protected :
     Data< int > f_reserve; ///< Size to reserve when creating vectors. (default=0)
 
     bool m_initialized;
+    bool m_snapshotStateRestored; ///< the state vectors of init() were restored by readSnapshotState()
 
     /// @name Integration-related data
     /// @{
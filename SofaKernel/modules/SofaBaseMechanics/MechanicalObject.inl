@@ -40,6 +40,10 @@
 
 #include <assert.h>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
 
 #ifdef SOFA_HAVE_NEW_TOPOLOGYCHANGES
 #include <SofaBaseTopology/TopologyData.inl>
@@ -62,6 +66,349 @@ void renumber(V* v, V* tmp, const sofa::helper::vector< unsigned int > &index )
         (*v)[i] = (*tmp)[index[i]];
 }
 
+
+/// @name Kernels of the vector operations
+/// Vectors whose elements are made of Reals on which the operators act
+/// independently (Vec types, and the derivatives of rigids) are processed as flat
+/// arrays of Reals: the loops can then be vectorized by the compiler, and they
+/// are split among threads for large states. The other ones are processed
+/// element by element with the operators of their type.
+/// @{
+
+/// Minimum number of Reals from which the operations are split among threads
+enum { VecOpParallelMinSize = 1<<15 };
+/// Number of terms of the blocks of the reductions. The blocks are always
+/// accumulated in the same order, so that the results of the reductions do not
+/// depend on the number of threads.
+enum { VecOpBlockSize = 1<<12 };
+
+/// True if a vector of T can be processed as a flat array of Reals
+template<class T, class Real>
+struct FlatVecOp
+{
+    enum { value = sizeof(T) == T::total_size*sizeof(Real) };
+};
+
+template<class Real, class V>
+Real* flatData(V& v)
+{
+    return v.empty() ? NULL : reinterpret_cast<Real*>(&v[0]);
+}
+
+template<class Real, class V>
+const Real* flatData(const V& v)
+{
+    return v.empty() ? NULL : reinterpret_cast<const Real*>(&v[0]);
+}
+
+/// Number of Reals of the n first elements of v
+template<class Real, class V>
+int flatSize(const V&, std::size_t n)
+{
+    return (int)(n * (sizeof(typename V::value_type) / sizeof(Real)));
+}
+
+/// v = a + b*f on n Reals, where a and b may be NULL (zero) or v itself
+template<class Real>
+void flatVecOp(Real* v, const Real* a, const Real* b, Real f, int n)
+{
+    if (a && b)
+    {
+        if (f == (Real)1)
+        {
+#ifdef _OPENMP
+#pragma omp parallel for if(n >= VecOpParallelMinSize)
+#endif
+            for (int i=0; i<n; ++i)
+                v[i] = a[i] + b[i];
+        }
+        else
+        {
+#ifdef _OPENMP
+#pragma omp parallel for if(n >= VecOpParallelMinSize)
+#endif
+            for (int i=0; i<n; ++i)
+                v[i] = a[i] + b[i]*f;
+        }
+    }
+    else if (b)
+    {
+#ifdef _OPENMP
+#pragma omp parallel for if(n >= VecOpParallelMinSize)
+#endif
+        for (int i=0; i<n; ++i)
+            v[i] = b[i]*f;
+    }
+    else if (a)
+    {
+        if (a != v)
+            std::copy(a, a+n, v);
+    }
+    else
+        std::fill(v, v+n, (Real)0);
+}
+
+/// v = 0
+template<bool Flat, class Real, class VV>
+void vecClear(VV& v, std::size_t n)
+{
+    if (Flat)
+        flatVecOp<Real>(flatData<Real>(v), NULL, NULL, (Real)0, flatSize<Real>(v,n));
+    else for (std::size_t i=0; i<n; i++)
+        v[i] = typename VV::value_type();
+}
+
+/// v *= f
+template<bool Flat, class Real, class VV>
+void vecScale(VV& v, std::size_t n, Real f)
+{
+    if (Flat)
+        flatVecOp<Real>(flatData<Real>(v), NULL, flatData<Real>(v), f, flatSize<Real>(v,n));
+    else for (std::size_t i=0; i<n; i++)
+        v[i] *= f;
+}
+
+/// v = b*f
+template<bool Flat, class Real, class VV, class VB>
+void vecEqScaled(VV& v, const VB& b, std::size_t n, Real f)
+{
+    if (Flat)
+        flatVecOp<Real>(flatData<Real>(v), NULL, flatData<Real>(b), f, flatSize<Real>(v,n));
+    else for (std::size_t i=0; i<n; i++)
+        v[i] = b[i] * f;
+}
+
+/// v = a
+template<bool Flat, class Real, class VV, class VA>
+void vecEq(VV& v, const VA& a, std::size_t n)
+{
+    if (Flat)
+        flatVecOp<Real>(flatData<Real>(v), flatData<Real>(a), NULL, (Real)0, flatSize<Real>(v,n));
+    else for (std::size_t i=0; i<n; i++)
+        v[i] = a[i];
+}
+
+/// v += b*f
+template<bool Flat, class Real, class VV, class VB>
+void vecPeq(VV& v, const VB& b, std::size_t n, Real f)
+{
+    if (Flat)
+        flatVecOp<Real>(flatData<Real>(v), flatData<Real>(v), flatData<Real>(b), f, flatSize<Real>(v,n));
+    else if (f == (Real)1) for (std::size_t i=0; i<n; i++)
+        v[i] += b[i];
+    else for (std::size_t i=0; i<n; i++)
+        v[i] += b[i]*f;
+}
+
+/// v = a + v*f
+template<bool Flat, class Real, class VV, class VA>
+void vecEqPlusScaledSelf(VV& v, const VA& a, std::size_t n, Real f)
+{
+    if (Flat)
+        flatVecOp<Real>(flatData<Real>(v), flatData<Real>(a), flatData<Real>(v), f, flatSize<Real>(v,n));
+    else for (std::size_t i=0; i<n; i++)
+    {
+        v[i] *= f;
+        v[i] += a[i];
+    }
+}
+
+/// v = a + b*f
+template<bool Flat, class Real, class VV, class VA, class VB>
+void vecEqPlusScaled(VV& v, const VA& a, const VB& b, std::size_t n, Real f)
+{
+    if (Flat)
+        flatVecOp<Real>(flatData<Real>(v), flatData<Real>(a), flatData<Real>(b), f, flatSize<Real>(v,n));
+    else if (f == (Real)1) for (std::size_t i=0; i<n; i++)
+    {
+        v[i] = a[i];
+        v[i] += b[i];
+    }
+    else for (std::size_t i=0; i<n; i++)
+    {
+        v[i] = a[i];
+        v[i] += b[i]*f;
+    }
+}
+
+/// Integration step of vMultiOp on n Reals: v = v*f_v_v + a*f_v_a, x = x*f_x_x + v*f_x_v
+template<class Real>
+void flatIntegrate(Real* v, const Real* a, Real* x, Real f_v_v, Real f_v_a, Real f_x_x, Real f_x_v, int n)
+{
+    if (f_v_v == 1.0 && f_x_x == 1.0) // very common case
+    {
+        if (f_v_a == 1.0) // used by euler implicit and other integrators that directly computes a*dt
+        {
+#ifdef _OPENMP
+#pragma omp parallel for if(n >= VecOpParallelMinSize)
+#endif
+            for (int i=0; i<n; ++i)
+            {
+                v[i] += a[i];
+                x[i] += v[i]*f_x_v;
+            }
+        }
+        else
+        {
+#ifdef _OPENMP
+#pragma omp parallel for if(n >= VecOpParallelMinSize)
+#endif
+            for (int i=0; i<n; ++i)
+            {
+                v[i] += a[i]*f_v_a;
+                x[i] += v[i]*f_x_v;
+            }
+        }
+    }
+    else if (f_x_x == 1.0) // some damping is applied to v
+    {
+#ifdef _OPENMP
+#pragma omp parallel for if(n >= VecOpParallelMinSize)
+#endif
+        for (int i=0; i<n; ++i)
+        {
+            v[i] *= f_v_v;
+            v[i] += a[i];
+            x[i] += v[i]*f_x_v;
+        }
+    }
+    else // general case
+    {
+#ifdef _OPENMP
+#pragma omp parallel for if(n >= VecOpParallelMinSize)
+#endif
+        for (int i=0; i<n; ++i)
+        {
+            v[i] *= f_v_v;
+            v[i] += a[i]*f_v_a;
+            x[i] *= f_x_x;
+            x[i] += v[i]*f_x_v;
+        }
+    }
+}
+
+/// Accumulates the sums of the blocks, with a Neumaier compensated sum if compensated
+template<class Real>
+struct BlockSumAccumulator
+{
+    Real sum, c;
+    bool compensated;
+    BlockSumAccumulator(bool compensated) : sum(0), c(0), compensated(compensated) {}
+    void add(Real x)
+    {
+        if (!compensated)
+        {
+            sum += x;
+            return;
+        }
+        const Real t = sum + x;
+        if (std::abs(sum) >= std::abs(x)) c += (sum - t) + x;
+        else c += (x - t) + sum;
+        sum = t;
+    }
+    Real get() const { return sum + c; }
+};
+
+/// Accumulates the maxima of the blocks
+template<class Real>
+struct BlockMaxAccumulator
+{
+    Real max;
+    BlockMaxAccumulator() : max(0) {}
+    void add(Real x) { if (x > max) max = x; }
+    Real get() const { return max; }
+};
+
+/// Reduction of n terms by blocks of VecOpBlockSize: block(begin,end) computes the
+/// value of a block, and the blocks are accumulated in their order into acc
+template<class Real, class Accumulator, class BlockFunction>
+Real reduceBlocks(int n, const BlockFunction& block, Accumulator acc)
+{
+    const int nbBlocks = (n + VecOpBlockSize - 1) / VecOpBlockSize;
+#ifdef _OPENMP
+    if (n >= VecOpParallelMinSize)
+    {
+        std::vector<Real> blockValues(nbBlocks);
+#pragma omp parallel for
+        for (int k=0; k<nbBlocks; ++k)
+            blockValues[k] = block(k*VecOpBlockSize, std::min(n, (k+1)*VecOpBlockSize));
+        for (int k=0; k<nbBlocks; ++k)
+            acc.add(blockValues[k]);
+        return acc.get();
+    }
+#endif
+    for (int k=0; k<nbBlocks; ++k)
+        acc.add(block(k*VecOpBlockSize, std::min(n, (k+1)*VecOpBlockSize)));
+    return acc.get();
+}
+
+/// Sum of term(i) for i in [begin,end), with four interleaved accumulators so that
+/// the loop can be vectorized, compensated (Kahan) if compensated
+template<class Real, class Term>
+Real blockSum(const Term& term, int begin, int end, bool compensated)
+{
+    Real s[4] = { 0, 0, 0, 0 };
+    int i = begin;
+    if (!compensated)
+    {
+        for (; i+4 <= end; i+=4)
+            for (int k=0; k<4; ++k)
+                s[k] += term(i+k);
+        for (; i < end; ++i)
+            s[0] += term(i);
+        return (s[0] + s[1]) + (s[2] + s[3]);
+    }
+    Real c[4] = { 0, 0, 0, 0 };
+    for (; i+4 <= end; i+=4)
+        for (int k=0; k<4; ++k)
+        {
+            const Real y = term(i+k) - c[k];
+            const Real t = s[k] + y;
+            c[k] = (t - s[k]) - y;
+            s[k] = t;
+        }
+    for (; i < end; ++i)
+    {
+        const Real y = term(i) - c[0];
+        const Real t = s[0] + y;
+        c[0] = (t - s[0]) - y;
+        s[0] = t;
+    }
+    BlockSumAccumulator<Real> acc(true);
+    for (int k=0; k<4; ++k)
+    {
+        acc.add(s[k]);
+        acc.add(-c[k]);
+    }
+    return acc.get();
+}
+
+/// Sum of term(i) for i<n
+template<class Real, class Term>
+Real reduceSum(const Term& term, int n, bool compensated)
+{
+    return reduceBlocks<Real>(n, [&term, compensated](int begin, int end) { return blockSum<Real>(term, begin, end, compensated); },
+                              BlockSumAccumulator<Real>(compensated));
+}
+
+/// Maximum of the absolute values of n Reals
+template<class Real>
+Real flatMaxAbs(const Real* a, int n)
+{
+    return reduceBlocks<Real>(n, [a](int begin, int end)
+    {
+        Real r = 0;
+        for (int i=begin; i<end; ++i)
+        {
+            const Real x = std::abs(a[i]);
+            r = x > r ? x : r;
+        }
+        return r;
+    }, BlockMaxAccumulator<Real>());
+}
+
+/// @}
+
 } // anonymous namespace
 
 
@@ -90,6 +437,7 @@ MechanicalObject<DataTypes>::MechanicalObject()
     , reset_velocity(initData(&reset_velocity, "reset_velocity", "reset velocity coordinates of the degrees of freedom"))
     , restScale(initData(&restScale, (SReal)1.0, "restScale", "optional scaling of rest position coordinates (to simulated pre-existing internal tension).(default = 1.0)"))
     , d_useTopology(initData(&d_useTopology, true, "useTopology", "Shall this object rely on any active topology to initialize its size and positions"))
+    , d_compensatedDot(initData(&d_compensatedDot, false, "compensatedDot", "Use compensated sums in the dot products of the state vectors, more accurate but slower. (default=false)"))
     , showObject(initData(&showObject, (bool) false, "showObject", "Show objects. (default=false)"))
     , showObjectScale(initData(&showObjectScale, (float) 0.1, "showObjectScale", "Scale for object display. (default=0.1)"))
     , showIndices(initData(&showIndices, (bool) false, "showIndices", "Show indices. (default=false)"))
@@ -111,6 +459,7 @@ MechanicalObject<DataTypes>::MechanicalObject()
     , m_gnuplotFileV(NULL)
 {
     m_initialized = false;
+    m_snapshotStateRestored = false;
 
     data = MechanicalObjectInternalData<DataTypes>(this);
 
@@ -1085,6 +1434,10 @@ void MechanicalObject<DataTypes>::init()
     {
         msg_info() << "Initialization with topology " << l_topology->getTypeName() << " " << l_topology->getName() ;
     }
+
+    // the vectors restored from a snapshot already hold the transformations and the topology positions
+    const bool stateRestored = m_snapshotStateRestored;
+    m_snapshotStateRestored = false;
   
     // Make sure the sizes of the vectors and the arguments of the scene matches
     const std::vector<std::pair<const std::string, const size_t>> vector_sizes = {
@@ -1148,7 +1501,7 @@ void MechanicalObject<DataTypes>::init()
 
     // the given position and velocity vectors are empty
     // note that when a vector is not  explicitly specified, its size won't change (1 by default)
-    if( x_wA.size() <= 1 && v_wA.size() <= 1 )
+    if( !stateRestored && x_wA.size() <= 1 && v_wA.size() <= 1 )
     {
         // if a topology is present, implicitly copy position from it
         if (l_topology && l_topology->hasPos() )
@@ -1201,7 +1554,8 @@ void MechanicalObject<DataTypes>::init()
     x_wAData->endEdit();
     v_wAData->endEdit();
 
-    reinit();
+    if( !stateRestored )
+        reinit();
 
     // storing X0 must be done after reinit() that possibly applies transformations
     if( read(core::ConstVecCoordId::restPosition())->getValue().size()!=x_wA.size() )
@@ -1238,12 +1592,12 @@ void MechanicalObject<DataTypes>::init()
 
 
 
-    if (rotation2.getValue()[0]!=0.0 || rotation2.getValue()[1]!=0.0 || rotation2.getValue()[2]!=0.0)
+    if (!stateRestored && (rotation2.getValue()[0]!=0.0 || rotation2.getValue()[1]!=0.0 || rotation2.getValue()[2]!=0.0))
     {
         this->applyRotation(rotation2.getValue()[0],rotation2.getValue()[1],rotation2.getValue()[2]);
     }
 
-    if (translation2.getValue()[0]!=0.0 || translation2.getValue()[1]!=0.0 || translation2.getValue()[2]!=0.0)
+    if (!stateRestored && (translation2.getValue()[0]!=0.0 || translation2.getValue()[1]!=0.0 || translation2.getValue()[2]!=0.0))
     {
         this->applyTranslation( translation2.getValue()[0],translation2.getValue()[1],translation2.getValue()[2]);
     }
@@ -1278,6 +1632,51 @@ void MechanicalObject<DataTypes>::reinit()
         this->applyTranslation( translation.getValue()[0],translation.getValue()[1],translation.getValue()[2]);
 }
 
+template <class DataTypes>
+bool MechanicalObject<DataTypes>::writeSnapshotState(std::ostream& out) const
+{
+    const VecCoord& pos = x.getValue();
+    const VecDeriv& vel = v.getValue();
+    const VecCoord& restPos = x0.getValue();
+
+    // enough digits for the values to be read back exactly
+    out.precision(std::numeric_limits<Real>::max_digits10);
+    out << pos.size() << ' ' << vel.size() << ' ' << restPos.size() << '\n';
+    for (std::size_t i = 0; i < pos.size(); ++i)
+        out << pos[i] << '\n';
+    for (std::size_t i = 0; i < vel.size(); ++i)
+        out << vel[i] << '\n';
+    for (std::size_t i = 0; i < restPos.size(); ++i)
+        out << restPos[i] << '\n';
+    return !out.fail();
+}
+
+template <class DataTypes>
+bool MechanicalObject<DataTypes>::readSnapshotState(std::istream& in)
+{
+    std::size_t nbPos = 0, nbVel = 0, nbRestPos = 0;
+    if (!(in >> nbPos >> nbVel >> nbRestPos))
+        return false;
+
+    VecCoord pos(nbPos), restPos(nbRestPos);
+    VecDeriv vel(nbVel);
+    for (std::size_t i = 0; i < nbPos; ++i)
+        in >> pos[i];
+    for (std::size_t i = 0; i < nbVel; ++i)
+        in >> vel[i];
+    for (std::size_t i = 0; i < nbRestPos; ++i)
+        in >> restPos[i];
+    if (in.fail())
+        return false;
+
+    resize(std::max(nbPos, nbVel));
+    x.setValue(pos);
+    v.setValue(vel);
+    x0.setValue(restPos);
+    m_snapshotStateRestored = true;
+    return true;
+}
+
 template <class DataTypes>
 void MechanicalObject<DataTypes>::storeResetState()
 {
@@ -1806,7 +2205,9 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                                       core::ConstVecId a,
                                       core::ConstVecId b, SReal f)
 {
-
+    // coordinates are processed as flat arrays only if their operators are the ones of their derivatives
+    enum { FlatDeriv = FlatVecOp<Deriv,Real>::value };
+    enum { FlatCoord = FlatDeriv && std::is_same<Coord,Deriv>::value };
 
     if(v.isNull())
     {
@@ -1823,15 +2224,13 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
             {
                 helper::WriteOnlyAccessor< Data<VecCoord> > vv( params, *this->write(core::VecCoordId(v)) );
                 vv.resize(d_size.getValue());
-                for (unsigned int i=0; i<vv.size(); i++)
-                    vv[i] = Coord();
+                vecClear<FlatCoord,Real>(vv.wref(), vv.size());
             }
             else
             {
                 helper::WriteOnlyAccessor< Data<VecDeriv> > vv( params, *this->write(core::VecDerivId(v)) );
                 vv.resize(d_size.getValue());
-                for (unsigned int i=0; i<vv.size(); i++)
-                    vv[i] = Deriv();
+                vecClear<FlatDeriv,Real>(vv.wref(), vv.size());
             }
         }
         else
@@ -1848,14 +2247,12 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                 if (v.type == sofa::core::V_COORD)
                 {
                     helper::WriteAccessor< Data<VecCoord> > vv( params, *this->write(core::VecCoordId(v)) );
-                    for (unsigned int i=0; i<vv.size(); i++)
-                        vv[i] *= (Real)f;
+                    vecScale<FlatCoord>(vv.wref(), vv.size(), (Real)f);
                 }
                 else
                 {
                     helper::WriteAccessor< Data<VecDeriv> > vv( params, *this->write(core::VecDerivId(v)) );
-                    for (unsigned int i=0; i<vv.size(); i++)
-                        vv[i] *= (Real)f;
+                    vecScale<FlatDeriv>(vv.wref(), vv.size(), (Real)f);
                 }
             }
             else
@@ -1866,16 +2263,14 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                     helper::WriteAccessor< Data<VecCoord> > vv( params, *this->write(core::VecCoordId(v)) );
                     helper::ReadAccessor< Data<VecCoord> > vb( params, *this->read(core::ConstVecCoordId(b)) );
                     vv.resize(vb.size());
-                    for (unsigned int i=0; i<vv.size(); i++)
-                        vv[i] = vb[i] * (Real)f;
+                    vecEqScaled<FlatCoord>(vv.wref(), vb.ref(), vv.size(), (Real)f);
                 }
                 else
                 {
                     helper::WriteAccessor< Data<VecDeriv> > vv( params, *this->write(core::VecDerivId(v)) );
                     helper::ReadAccessor< Data<VecDeriv> > vb( params, *this->read(core::ConstVecDerivId(b)) );
                     vv.resize(vb.size());
-                    for (unsigned int i=0; i<vv.size(); i++)
-                        vv[i] = vb[i] * (Real)f;
+                    vecEqScaled<FlatDeriv>(vv.wref(), vb.ref(), vv.size(), (Real)f);
                 }
             }
         }
@@ -1896,16 +2291,14 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                 helper::WriteOnlyAccessor< Data<VecCoord> > vv( params, *this->write(core::VecCoordId(v)) );
                 helper::ReadAccessor< Data<VecCoord> > va( params, *this->read(core::ConstVecCoordId(a)) );
                 vv.resize(va.size());
-                for (unsigned int i=0; i<vv.size(); i++)
-                    vv[i] = va[i];
+                vecEq<FlatCoord,Real>(vv.wref(), va.ref(), vv.size());
             }
             else
             {
                 helper::WriteOnlyAccessor< Data<VecDeriv> > vv( params, *this->write(core::VecDerivId(v)) );
                 helper::ReadAccessor< Data<VecDeriv> > va( params, *this->read(core::ConstVecDerivId(a)) );
                 vv.resize(va.size());
-                for (unsigned int i=0; i<vv.size(); i++)
-                    vv[i] = va[i];
+                vecEq<FlatDeriv,Real>(vv.wref(), va.ref(), vv.size());
             }
         }
         else
@@ -1925,8 +2318,7 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                             if (vb.size() > vv.size())
                                 vv.resize(vb.size());
 
-                            for (unsigned int i=0; i<vb.size(); i++)
-                                vv[i] += vb[i];
+                            vecPeq<FlatCoord>(vv.wref(), vb.ref(), vb.size(), (Real)1);
                         }
                         else
                         {
@@ -1935,8 +2327,7 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                             if (vb.size() > vv.size())
                                 vv.resize(vb.size());
 
-                            for (unsigned int i=0; i<vb.size(); i++)
-                                vv[i] += vb[i];
+                            vecPeq<FlatCoord>(vv.wref(), vb.ref(), vb.size(), (Real)1);
                         }
                     }
                     else if (b.type == sofa::core::V_DERIV)
@@ -1947,8 +2338,7 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                         if (vb.size() > vv.size())
                             vv.resize(vb.size());
 
-                        for (unsigned int i=0; i<vb.size(); i++)
-                            vv[i] += vb[i];
+                        vecPeq<FlatDeriv>(vv.wref(), vb.ref(), vb.size(), (Real)1);
                     }
                     else
                     {
@@ -1970,8 +2360,7 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                             if (vb.size() > vv.size())
                                 vv.resize(vb.size());
 
-                            for (unsigned int i=0; i<vb.size(); i++)
-                                vv[i] += vb[i]*(Real)f;
+                            vecPeq<FlatCoord>(vv.wref(), vb.ref(), vb.size(), (Real)f);
                         }
                         else
                         {
@@ -1980,8 +2369,7 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                             if (vb.size() > vv.size())
                                 vv.resize(vb.size());
 
-                            for (unsigned int i=0; i<vb.size(); i++)
-                                vv[i] += vb[i]*(Real)f;
+                            vecPeq<FlatCoord>(vv.wref(), vb.ref(), vb.size(), (Real)f);
                         }
                     }
                     else if (b.type == sofa::core::V_DERIV)
@@ -1992,8 +2380,7 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                         if (vb.size() > vv.size())
                             vv.resize(vb.size());
 
-                        for (unsigned int i=0; i<vb.size(); i++)
-                            vv[i] += vb[i]*(Real)f;
+                        vecPeq<FlatDeriv>(vv.wref(), vb.ref(), vb.size(), (Real)f);
                     }
                     else
                     {
@@ -2018,8 +2405,7 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                             if (va.size() > vv.size())
                                 vv.resize(va.size());
 
-                            for (unsigned int i=0; i<va.size(); i++)
-                                vv[i] += va[i];
+                            vecPeq<FlatCoord>(vv.wref(), va.ref(), va.size(), (Real)1);
                         }
                         else
                         {
@@ -2028,8 +2414,7 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                             if (va.size() > vv.size())
                                 vv.resize(va.size());
 
-                            for (unsigned int i=0; i<va.size(); i++)
-                                vv[i] += va[i];
+                            vecPeq<FlatCoord>(vv.wref(), va.ref(), va.size(), (Real)1);
                         }
                     }
                     else if (a.type == sofa::core::V_DERIV)
@@ -2040,8 +2425,7 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                         if (va.size() > vv.size())
                             vv.resize(va.size());
 
-                        for (unsigned int i=0; i<va.size(); i++)
-                            vv[i] += va[i];
+                        vecPeq<FlatDeriv>(vv.wref(), va.ref(), va.size(), (Real)1);
                     }
                     else
                     {
@@ -2058,22 +2442,14 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                         helper::WriteOnlyAccessor< Data<VecCoord> > vv( params, *this->write(core::VecCoordId(v)) );
                         helper::ReadAccessor< Data<VecCoord> > va( params, *this->read(core::ConstVecCoordId(a)) );
                         vv.resize(va.size());
-                        for (unsigned int i=0; i<vv.size(); i++)
-                        {
-                            vv[i] *= (Real)f;
-                            vv[i] += va[i];
-                        }
+                        vecEqPlusScaledSelf<FlatCoord>(vv.wref(), va.ref(), vv.size(), (Real)f);
                     }
                     else
                     {
                         helper::WriteOnlyAccessor< Data<VecDeriv> > vv( params, *this->write(core::VecDerivId(v)) );
                         helper::ReadAccessor< Data<VecDeriv> > va( params, *this->read(core::ConstVecDerivId(a)) );
                         vv.resize(va.size());
-                        for (unsigned int i=0; i<vv.size(); i++)
-                        {
-                            vv[i] *= (Real)f;
-                            vv[i] += va[i];
-                        }
+                        vecEqPlusScaledSelf<FlatDeriv>(vv.wref(), va.ref(), vv.size(), (Real)f);
                     }
                 }
             }
@@ -2090,20 +2466,12 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                         if (b.type == sofa::core::V_COORD)
                         {
                             helper::ReadAccessor< Data<VecCoord> > vb( params, *this->read(core::ConstVecCoordId(b)) );
-                            for (unsigned int i=0; i<vv.size(); i++)
-                            {
-                                vv[i] = va[i];
-                                vv[i] += vb[i];
-                            }
+                            vecEqPlusScaled<FlatCoord>(vv.wref(), va.ref(), vb.ref(), vv.size(), (Real)1);
                         }
                         else
                         {
                             helper::ReadAccessor< Data<VecDeriv> > vb( params, *this->read(core::ConstVecDerivId(b)) );
-                            for (unsigned int i=0; i<vv.size(); i++)
-                            {
-                                vv[i] = va[i];
-                                vv[i] += vb[i];
-                            }
+                            vecEqPlusScaled<FlatCoord>(vv.wref(), va.ref(), vb.ref(), vv.size(), (Real)1);
                         }
                     }
                     else if (b.type == sofa::core::V_DERIV)
@@ -2112,11 +2480,7 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                         helper::ReadAccessor< Data<VecDeriv> > va( params, *this->read(core::ConstVecDerivId(a)) );
                         helper::ReadAccessor< Data<VecDeriv> > vb( params, *this->read(core::ConstVecDerivId(b)) );
                         vv.resize(va.size());
-                        for (unsigned int i=0; i<vv.size(); i++)
-                        {
-                            vv[i] = va[i];
-                            vv[i] += vb[i];
-                        }
+                        vecEqPlusScaled<FlatDeriv>(vv.wref(), va.ref(), vb.ref(), vv.size(), (Real)1);
                     }
                     else
                     {
@@ -2136,20 +2500,12 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                         if (b.type == sofa::core::V_COORD)
                         {
                             helper::ReadAccessor< Data<VecCoord> > vb( params, *this->read(core::ConstVecCoordId(b)) );
-                            for (unsigned int i=0; i<vv.size(); i++)
-                            {
-                                vv[i] = va[i];
-                                vv[i] += vb[i]*(Real)f;
-                            }
+                            vecEqPlusScaled<FlatCoord>(vv.wref(), va.ref(), vb.ref(), vv.size(), (Real)f);
                         }
                         else
                         {
                             helper::ReadAccessor< Data<VecDeriv> > vb( params, *this->read(core::ConstVecDerivId(b)) );
-                            for (unsigned int i=0; i<vv.size(); i++)
-                            {
-                                vv[i] = va[i];
-                                vv[i] += vb[i]*(Real)f;
-                            }
+                            vecEqPlusScaled<FlatCoord>(vv.wref(), va.ref(), vb.ref(), vv.size(), (Real)f);
                         }
                     }
                     else if (b.type == sofa::core::V_DERIV)
@@ -2158,11 +2514,7 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                         helper::ReadAccessor< Data<VecDeriv> > va( params, *this->read(core::ConstVecDerivId(a)) );
                         helper::ReadAccessor< Data<VecDeriv> > vb( params, *this->read(core::ConstVecDerivId(b)) );
                         vv.resize(va.size());
-                        for (unsigned int i=0; i<vv.size(); i++)
-                        {
-                            vv[i] = va[i];
-                            vv[i] += vb[i]*(Real)f;
-                        }
+                        vecEqPlusScaled<FlatDeriv>(vv.wref(), va.ref(), vb.ref(), vv.size(), (Real)f);
                     }
                     else
                     {
@@ -2201,7 +2553,12 @@ void MechanicalObject<DataTypes>::vMultiOp(const core::ExecParams* params, const
         const Real f_x_x = (Real)(ops[1].second[0].second);
         const Real f_x_v = (Real)(ops[1].second[1].second);
 
-        if (f_v_v == 1.0 && f_x_x == 1.0) // very common case
+        if (FlatVecOp<Deriv,Real>::value && std::is_same<Coord,Deriv>::value)
+        {
+            flatIntegrate<Real>(flatData<Real>(vv.wref()), flatData<Real>(va.ref()), flatData<Real>(vx.wref()),
+                                f_v_v, f_v_a, f_x_x, f_x_v, flatSize<Real>(vx.ref(), n));
+        }
+        else if (f_v_v == 1.0 && f_x_x == 1.0) // very common case
         {
             if (f_v_a == 1.0) // used by euler implicit and other integrators that directly computes a*dt
             {
@@ -2309,15 +2666,22 @@ template <class DataTypes>
 SReal MechanicalObject<DataTypes>::vDot(const core::ExecParams* params, core::ConstVecId a, core::ConstVecId b)
 {
     Real r = 0.0;
+    const bool compensated = d_compensatedDot.getValue();
 
     if (a.type == sofa::core::V_COORD && b.type == sofa::core::V_COORD)
     {
         const VecCoord &va = this->read(core::ConstVecCoordId(a))->getValue(params);
         const VecCoord &vb = this->read(core::ConstVecCoordId(b))->getValue(params);
 
-        for (unsigned int i=0; i<va.size(); i++)
+        if (FlatVecOp<Deriv,Real>::value && std::is_same<Coord,Deriv>::value)
         {
-            r += va[i] * vb[i];
+            const Real* pa = flatData<Real>(va);
+            const Real* pb = flatData<Real>(vb);
+            r = reduceSum<Real>([pa,pb](int i) { return pa[i]*pb[i]; }, flatSize<Real>(va, va.size()), compensated);
+        }
+        else
+        {
+            r = reduceSum<Real>([&va,&vb](int i) { return (Real)(va[i]*vb[i]); }, (int)va.size(), compensated);
         }
     }
     else if (a.type == sofa::core::V_DERIV && b.type == sofa::core::V_DERIV)
@@ -2325,9 +2689,15 @@ SReal MechanicalObject<DataTypes>::vDot(const core::ExecParams* params, core::Co
         const VecDeriv &va = this->read(core::ConstVecDerivId(a))->getValue(params);
         const VecDeriv &vb = this->read(core::ConstVecDerivId(b))->getValue(params);
 
-        for (unsigned int i=0; i<va.size(); i++)
+        if (FlatVecOp<Deriv,Real>::value)
         {
-            r += va[i] * vb[i];
+            const Real* pa = flatData<Real>(va);
+            const Real* pb = flatData<Real>(vb);
+            r = reduceSum<Real>([pa,pb](int i) { return pa[i]*pb[i]; }, flatSize<Real>(va, va.size()), compensated);
+        }
+        else
+        {
+            r = reduceSum<Real>([&va,&vb](int i) { return (Real)(va[i]*vb[i]); }, (int)va.size(), compensated);
         }
     }
     else
@@ -2353,7 +2723,16 @@ SReal MechanicalObject<DataTypes>::vSum(const core::ExecParams* params, core::Co
     {
         const VecDeriv &va = this->read(core::ConstVecDerivId(a))->getValue(params);
 
-        if( l==0 ) for (nat i=0; i<va.size(); i++)
+        if (FlatVecOp<Deriv,Real>::value)
+        {
+            const Real* pa = flatData<Real>(va);
+            const int n = flatSize<Real>(va, va.size());
+            if( l==0 )
+                r = flatMaxAbs(pa, n);
+            else
+                r = reduceSum<Real>([pa,l](int i) { return (Real) exp(pa[i]/l); }, n, d_compensatedDot.getValue());
+        }
+        else if( l==0 ) for (nat i=0; i<va.size(); i++)
         {
             for(unsigned j=0; j<DataTypes::deriv_total_size; j++)
                 if ( fabs(va[i][j])>r) r=fabs(va[i][j]);
@@ -2381,7 +2760,11 @@ SReal MechanicalObject<DataTypes>::vMax(const core::ExecParams* params, core::Co
     {
         const VecCoord &va = this->read(core::ConstVecCoordId(a))->getValue(params);
 
-        for (nat i=0; i<va.size(); i++)
+        if (FlatVecOp<Coord,Real>::value)
+        {
+            r = flatMaxAbs(flatData<Real>(va), flatSize<Real>(va, va.size()));
+        }
+        else for (nat i=0; i<va.size(); i++)
         {
             for(unsigned j=0; j<DataTypes::coord_total_size; j++)
                 if (fabs(va[i][j])>r) r=fabs(va[i][j]);
@@ -2391,7 +2774,11 @@ SReal MechanicalObject<DataTypes>::vMax(const core::ExecParams* params, core::Co
     {
         const VecDeriv &va = this->read(core::ConstVecDerivId(a))->getValue(params);
 
-        for (nat i=0; i<va.size(); i++)
+        if (FlatVecOp<Deriv,Real>::value)
+        {
+            r = flatMaxAbs(flatData<Real>(va), flatSize<Real>(va, va.size()));
+        }
+        else for (nat i=0; i<va.size(); i++)
         {
             for(unsigned j=0; j<DataTypes::deriv_total_size; j++)
                 if (fabs(va[i][j])>r) r=fabs(va[i][j]);
@@ -110,6 +110,90 @@ TYPED_TEST(MechanicalObject_test, checkThatPositionDefaultValueIsAVectorOfValueI
     TestHelpers::CheckPosition(this->mechanicalObject);
 }
 
+TYPED_TEST(MechanicalObject_test, checkThatVOpComputesLinearCombinationsOfLargeVectors)
+{
+    typedef typename TestFixture::Real Real;
+    typedef typename StubMechanicalObject<TypeParam>::Deriv Deriv;
+    const size_t n = 50000;
+    this->mechanicalObject.resize(n);
+    {
+        typename StubMechanicalObject<TypeParam>::WriteVecDeriv v = this->mechanicalObject.writeVelocities();
+        typename StubMechanicalObject<TypeParam>::WriteVecDeriv f = this->mechanicalObject.writeForces();
+        for (size_t i=0; i<n; ++i)
+            for (unsigned int j=0; j<Deriv::total_size; ++j)
+            {
+                v[i][j] = (Real)(i%7) - (Real)j;
+                f[i][j] = (Real)(i%5) + (Real)j;
+            }
+    }
+
+    // f = v + f*2
+    this->mechanicalObject.vOp(core::ExecParams::defaultInstance(), core::VecDerivId::force(), core::ConstVecDerivId::velocity(), core::ConstVecDerivId::force(), 2.0);
+
+    typename StubMechanicalObject<TypeParam>::ReadVecDeriv f = this->mechanicalObject.readForces();
+    ASSERT_EQ(n, f.size());
+    for (size_t i=0; i<n; ++i)
+        for (unsigned int j=0; j<Deriv::total_size; ++j)
+            ASSERT_EQ((Real)(i%7) - (Real)j + ((Real)(i%5) + (Real)j)*2, f[i][j]);
+}
+
+TYPED_TEST(MechanicalObject_test, checkThatVDotAndVMaxOfLargeVectorsAreExact)
+{
+    typedef typename TestFixture::Real Real;
+    typedef typename StubMechanicalObject<TypeParam>::Deriv Deriv;
+    const size_t n = 50000;
+    this->mechanicalObject.resize(n);
+    {
+        typename StubMechanicalObject<TypeParam>::WriteVecDeriv v = this->mechanicalObject.writeVelocities();
+        for (size_t i=0; i<n; ++i)
+            for (unsigned int j=0; j<Deriv::total_size; ++j)
+                v[i][j] = (Real)((i+j)%3) - 1; // -1, 0 or 1: the sums are exact
+    }
+    // sum of the squares of the entries: 2 entries out of 3 are +-1
+    const size_t nbEntries = n*Deriv::total_size;
+    size_t nbNonZeros = 0;
+    for (size_t i=0; i<n; ++i)
+        for (unsigned int j=0; j<Deriv::total_size; ++j)
+            if ((i+j)%3 != 1) ++nbNonZeros;
+    ASSERT_LT(nbNonZeros, nbEntries);
+
+    const core::ExecParams* params = core::ExecParams::defaultInstance();
+    EXPECT_EQ((SReal)nbNonZeros, this->mechanicalObject.vDot(params, core::ConstVecDerivId::velocity(), core::ConstVecDerivId::velocity()));
+    EXPECT_EQ((SReal)1, this->mechanicalObject.vMax(params, core::ConstVecDerivId::velocity()));
+}
+
+TYPED_TEST(MechanicalObject_test, checkThatCompensatedVDotCancelsLargeTerms)
+{
+    typedef typename TestFixture::Real Real;
+    typedef typename StubMechanicalObject<TypeParam>::Deriv Deriv;
+    const size_t n = 50000;
+    this->mechanicalObject.resize(n);
+    {
+        typename StubMechanicalObject<TypeParam>::WriteVecDeriv v = this->mechanicalObject.writeVelocities();
+        typename StubMechanicalObject<TypeParam>::WriteVecDeriv f = this->mechanicalObject.writeForces();
+        for (size_t i=0; i<n; ++i)
+        {
+            v[i].clear();
+            f[i].clear();
+        }
+        // a large term, many small ones, and the opposite of the large term
+        const Real big = (Real)1 / std::numeric_limits<Real>::epsilon();
+        v[0][0] = big;
+        f[0][0] = 1;
+        for (size_t i=1; i+1<n; ++i)
+        {
+            v[i][0] = (Real)0.25;
+            f[i][0] = 1;
+        }
+        v[n-1][0] = -big;
+        f[n-1][0] = 1;
+    }
+    this->mechanicalObject.findData("compensatedDot")->read("1");
+
+    const SReal expected = (SReal)(n-2) * 0.25;
+    EXPECT_NEAR(expected, this->mechanicalObject.vDot(core::ExecParams::defaultInstance(), core::ConstVecDerivId::velocity(), core::ConstVecDerivId::force()), expected*1e-3);
+}
+
 } // namespace
 
 } // namespace sofa
@@ -0,0 +1,164 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaBaseMechanics/TetrahedronLocator.h>
+using sofa::component::mapping::TetrahedronLocator ;
+
+#include <gtest/gtest.h>
+
+#include <sofa/helper/fixed_array.h>
+using namespace sofa::defaulttype ;
+
+#include <cstdlib>
+
+namespace
+{
+
+typedef sofa::helper::fixed_array<unsigned int,4> Tetra;
+
+struct TetrahedronLocator_test : public ::testing::Test
+{
+    sofa::helper::vector<Vec3d> points;
+    sofa::helper::vector<Tetra> tetrahedra;
+    sofa::helper::vector<Matrix3> bases;
+    sofa::helper::vector<Vector3> centers;
+    TetrahedronLocator locator;
+
+    static double random() { return (double)std::rand() / RAND_MAX; }
+
+    /// Perturbed grid of n^3 cubes of size 0.1 cut in 6 tetrahedra
+    void createMesh(int n)
+    {
+        std::srand(1);
+        for (int z=0; z<=n; ++z)
+            for (int y=0; y<=n; ++y)
+                for (int x=0; x<=n; ++x)
+                {
+                    const bool border = !(x%n && y%n && z%n);
+                    points.push_back(Vec3d(x,y,z)*0.1 + (border ? Vec3d() : Vec3d(random(),random(),random())*0.02));
+                }
+        const int cubeTetra[6][4] = {{0,5,1,6},{0,1,2,6},{0,2,3,6},{0,3,7,6},{0,7,4,6},{0,4,5,6}};
+        for (int z=0; z<n; ++z)
+            for (int y=0; y<n; ++y)
+                for (int x=0; x<n; ++x)
+                {
+                    const unsigned int c[8] = { index(n,x,y,z), index(n,x+1,y,z), index(n,x+1,y+1,z), index(n,x,y+1,z),
+                                                index(n,x,y,z+1), index(n,x+1,y,z+1), index(n,x+1,y+1,z+1), index(n,x,y+1,z+1) };
+                    for (int t=0; t<6; ++t)
+                        tetrahedra.push_back(Tetra(c[cubeTetra[t][0]], c[cubeTetra[t][1]], c[cubeTetra[t][2]], c[cubeTetra[t][3]]));
+                }
+    }
+
+    static unsigned int index(int n, int x, int y, int z) { return x + (n+1) * (y + (n+1) * z); }
+
+    void buildLocator()
+    {
+        bases.resize(tetrahedra.size());
+        centers.resize(tetrahedra.size());
+        locator.resize(tetrahedra.size());
+        for (unsigned int t=0; t<tetrahedra.size(); ++t)
+        {
+            const Tetra& e = tetrahedra[t];
+            Mat3x3d m, mt;
+            m[0] = points[e[1]]-points[e[0]];
+            m[1] = points[e[2]]-points[e[0]];
+            m[2] = points[e[3]]-points[e[0]];
+            mt.transpose(m);
+            const bool invertible = bases[t].invert(mt);
+            centers[t] = (points[e[0]]+points[e[1]]+points[e[2]]+points[e[3]])*0.25;
+            locator.setTetrahedron(t, points[e[0]], m, bases[t], invertible, centers[t]);
+        }
+        locator.build();
+    }
+
+    /// Exhaustive search done by BarycentricMapperTetrahedronSetTopology before the locator
+    int bruteForce(const Vec3d& pos, Vector3& coefs, double& distance) const
+    {
+        int index = -1;
+        distance = 1e10;
+        for (unsigned int t=0; t<tetrahedra.size(); t++)
+        {
+            Vec3d v = bases[t] * ( pos - points[tetrahedra[t][0]] );
+            double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( -v[2],v[0]+v[1]+v[2]-1 ) );
+            if ( d>0 ) d = ( pos-centers[t] ).norm2();
+            if ( d<distance ) { coefs = v; distance = d; index = t; }
+        }
+        return index;
+    }
+
+    void checkPoints(const sofa::helper::vector<Vec3d>& queries)
+    {
+        for (unsigned int i=0; i<queries.size(); ++i)
+        {
+            Vector3 expectedCoefs, coefs;
+            double expectedDistance, distance;
+            const int expected = bruteForce(queries[i], expectedCoefs, expectedDistance);
+            const int found = locator.find(queries[i], coefs, distance);
+            ASSERT_EQ(expected, found) << "point " << queries[i];
+            ASSERT_EQ(expectedCoefs, coefs) << "point " << queries[i];
+            ASSERT_EQ(expectedDistance, distance) << "point " << queries[i];
+        }
+    }
+
+    sofa::helper::vector<Vec3d> queries()
+    {
+        sofa::helper::vector<Vec3d> q(points); // vertices, on the faces of several tetrahedra
+        for (int i=0; i<5000; ++i) // inside and around the mesh
+            q.push_back(Vec3d(random(),random(),random())*1.6 - Vec3d(0.2,0.2,0.2));
+        for (int i=0; i<500; ++i) // far from the mesh
+            q.push_back(Vec3d(random(),random(),random())*20 - Vec3d(10,10,10));
+        for (int i=0; i<500; ++i) // on the faces of the border
+            q.push_back(Vec3d((int)(random()*10)*0.1, (int)(random()*10)*0.1, random()));
+        return q;
+    }
+};
+
+TEST_F(TetrahedronLocator_test, sameAsExhaustiveSearch)
+{
+    createMesh(10);
+    buildLocator();
+    checkPoints(queries());
+}
+
+TEST_F(TetrahedronLocator_test, sameAsExhaustiveSearchWithDegenerateTetrahedra)
+{
+    createMesh(10);
+    // a flat tetrahedron, and an isolated one far from the mesh
+    tetrahedra.push_back(Tetra(index(10,0,0,0), index(10,1,0,0), index(10,2,0,0), index(10,3,0,0)));
+    const unsigned int n = points.size();
+    points.push_back(Vec3d(5,5,5));
+    points.push_back(Vec3d(5.1,5,5));
+    points.push_back(Vec3d(5,5.1,5));
+    points.push_back(Vec3d(5,5,5.1));
+    tetrahedra.push_back(Tetra(n, n+1, n+2, n+3));
+    buildLocator();
+    checkPoints(queries());
+}
+
+TEST_F(TetrahedronLocator_test, empty)
+{
+    buildLocator();
+    Vector3 coefs;
+    double distance;
+    ASSERT_EQ(-1, locator.find(Vec3d(1,2,3), coefs, distance));
+}
+
+}
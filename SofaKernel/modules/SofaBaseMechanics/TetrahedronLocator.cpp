@@ -0,0 +1,316 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaBaseMechanics/TetrahedronLocator.h>
+#include <sofa/helper/IndexOpenMP.h>
+
+#include <cmath>
+#include <limits>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace mapping
+{
+
+namespace
+{
+
+/// Below this number of tetrahedra, the bounding boxes are computed sequentially
+enum { ParallelMinSize = 1024 };
+
+/// Relative precision of the barycentric coordinates, scaled by the conditioning of the tetrahedra
+const double RoundingTolerance = 1e-12;
+
+bool isFinite(const defaulttype::Vec3d& v)
+{
+    return std::isfinite(v[0]) && std::isfinite(v[1]) && std::isfinite(v[2]);
+}
+
+template<class M>
+double frobeniusNorm(const M& m)
+{
+    double n = 0;
+    for (int i=0; i<3; ++i)
+        for (int j=0; j<3; ++j)
+            n += (double)m[i][j]*(double)m[i][j];
+    return std::sqrt(n);
+}
+
+} // namespace
+
+void TetrahedronLocator::resize(unsigned int nbTetrahedra)
+{
+    origins.resize(nbTetrahedra);
+    edges.resize(nbTetrahedra);
+    bases.resize(nbTetrahedra);
+    invertibles.resize(nbTetrahedra);
+    centers.resize(nbTetrahedra);
+}
+
+void TetrahedronLocator::setTetrahedron(unsigned int t, const Vec3d& origin, const defaulttype::Mat3x3d& edge,
+                                        const Matrix3& base, bool invertible, const Vector3& center)
+{
+    origins[t] = origin;
+    edges[t] = edge;
+    bases[t] = base;
+    invertibles[t] = invertible;
+    centers[t] = center;
+}
+
+void TetrahedronLocator::cellCoord(const Vec3d& p, int* c) const
+{
+    for (int a=0; a<3; ++a)
+    {
+        const double x = std::floor((p[a] - gridMin[a]) / cellSize[a]);
+        c[a] = (x < 0 || !(x == x)) ? 0 : (x >= dims[a] ? dims[a]-1 : (int)x);
+    }
+}
+
+void TetrahedronLocator::build()
+{
+    const unsigned int n = (unsigned int)origins.size();
+    bboxMin.resize(n);
+    bboxMax.resize(n);
+    helper::vector<char> bounded(n);
+
+    // bounding boxes of the points for which the barycentric coordinates can be inside the tetrahedra
+#ifdef _OPENMP
+#pragma omp parallel for if(n >= ParallelMinSize)
+#endif
+    for (helper::IndexOpenMP<unsigned int>::type t=0; t<n; ++t)
+    {
+        Vec3d& bmin = bboxMin[t];
+        Vec3d& bmax = bboxMax[t];
+        bmin = bmax = origins[t];
+        for (int k=0; k<3; ++k)
+        {
+            const Vec3d p = origins[t] + edges[t][k];
+            for (int a=0; a<3; ++a)
+            {
+                bmin[a] = std::min(bmin[a], p[a]);
+                bmax[a] = std::max(bmax[a], p[a]);
+            }
+        }
+        const double tolerance = RoundingTolerance * frobeniusNorm(edges[t]) * frobeniusNorm(bases[t]);
+        const double margin = tolerance * (bmax-bmin).norm();
+        bmin -= Vec3d(margin, margin, margin);
+        bmax += Vec3d(margin, margin, margin);
+        bounded[t] = invertibles[t] && tolerance < 1e-3 && isFinite(bmin) && isFinite(bmax);
+    }
+
+    unbounded.clear();
+    bool empty = true;
+    for (unsigned int t=0; t<n; ++t)
+    {
+        if (!bounded[t])
+        {
+            unbounded.push_back(t);
+            continue;
+        }
+        if (empty) { gridMin = bboxMin[t]; gridMax = bboxMax[t]; empty = false; }
+        for (int a=0; a<3; ++a)
+        {
+            gridMin[a] = std::min(gridMin[a], bboxMin[t][a]);
+            gridMax[a] = std::max(gridMax[a], bboxMax[t][a]);
+        }
+    }
+    for (unsigned int t=0; t<n; ++t)
+    {
+        const Vec3d c = centers[t];
+        if (!isFinite(c)) continue;
+        if (empty) { gridMin = gridMax = c; empty = false; }
+        for (int a=0; a<3; ++a)
+        {
+            gridMin[a] = std::min(gridMin[a], c[a]);
+            gridMax[a] = std::max(gridMax[a], c[a]);
+        }
+    }
+
+    // about one cell per tetrahedron
+    const Vec3d extent = gridMax - gridMin;
+    const double maxExtent = std::max(extent[0], std::max(extent[1], extent[2]));
+    dims[0] = dims[1] = dims[2] = 1;
+    cellSize = Vec3d(1,1,1);
+    if (!empty && maxExtent > 0)
+    {
+        double volume = 1;
+        for (int a=0; a<3; ++a)
+            volume *= std::max(extent[a], maxExtent*1e-3);
+        const double h = std::cbrt(volume / std::max(n, 1u));
+        for (int a=0; a<3; ++a)
+        {
+            if (extent[a] <= 0) continue;
+            dims[a] = (int)std::min(1024.0, std::max(1.0, std::ceil(extent[a] / h)));
+            cellSize[a] = extent[a] / dims[a];
+        }
+    }
+    const unsigned int nbCells = (unsigned int)(dims[0]*dims[1]*dims[2]);
+
+    // tetrahedra overlapping each cell, filled in increasing order
+    cellBegin.assign(nbCells+1, 0);
+    for (int pass=0; pass<2; ++pass)
+    {
+        helper::vector<unsigned int> pos;
+        if (pass == 1)
+        {
+            for (unsigned int c=0; c<nbCells; ++c)
+                cellBegin[c+1] += cellBegin[c];
+            cellTetrahedra.resize(cellBegin[nbCells]);
+            pos.assign(cellBegin.begin(), cellBegin.end()-1);
+        }
+        for (unsigned int t=0; t<n; ++t)
+        {
+            if (!bounded[t]) continue;
+            int cmin[3], cmax[3];
+            cellCoord(bboxMin[t], cmin);
+            cellCoord(bboxMax[t], cmax);
+            for (int z=cmin[2]; z<=cmax[2]; ++z)
+                for (int y=cmin[1]; y<=cmax[1]; ++y)
+                    for (int x=cmin[0]; x<=cmax[0]; ++x)
+                    {
+                        const int c = cellIndex(x,y,z);
+                        if (pass == 0) ++cellBegin[c+1];
+                        else cellTetrahedra[pos[c]++] = t;
+                    }
+        }
+    }
+
+    // centers of the tetrahedra in each cell, filled in increasing order
+    centerBegin.assign(nbCells+1, 0);
+    helper::vector<int> centerCell((std::size_t)n, -1);
+    for (unsigned int t=0; t<n; ++t)
+    {
+        if (!isFinite(centers[t])) continue;
+        int c[3];
+        cellCoord(centers[t], c);
+        centerCell[t] = cellIndex(c[0],c[1],c[2]);
+        ++centerBegin[centerCell[t]+1];
+    }
+    for (unsigned int c=0; c<nbCells; ++c)
+        centerBegin[c+1] += centerBegin[c];
+    centerTetrahedra.resize(centerBegin[nbCells]);
+    helper::vector<unsigned int> pos(centerBegin.begin(), centerBegin.end()-1);
+    for (unsigned int t=0; t<n; ++t)
+        if (centerCell[t] >= 0)
+            centerTetrahedra[pos[centerCell[t]]++] = t;
+}
+
+int TetrahedronLocator::find(const Vec3d& pos, Vector3& coefs, double& distance) const
+{
+    int index = -1;
+    distance = 1e10;
+    coefs = Vector3();
+    if (origins.empty())
+        return index;
+
+    int c[3];
+    cellCoord(pos, c);
+
+    // tetrahedra containing the point: they overlap its cell or are not localized in the grid
+    {
+        const unsigned int cell = (unsigned int)cellIndex(c[0],c[1],c[2]);
+        const unsigned int* it = cellTetrahedra.data() + cellBegin[cell];
+        const unsigned int* itEnd = cellTetrahedra.data() + cellBegin[cell+1];
+        helper::vector<unsigned int>::const_iterator itUnbounded = unbounded.begin();
+        while (it != itEnd || itUnbounded != unbounded.end())
+        {
+            unsigned int t;
+            if (itUnbounded == unbounded.end() || (it != itEnd && *it < *itUnbounded)) t = *it++;
+            else t = *itUnbounded++;
+            Vec3d v;
+            const double d = depth(t, pos, v);
+            if (d <= 0 && d < distance) { coefs = v; distance = d; index = (int)t; }
+        }
+        if (index >= 0)
+            return index;
+    }
+
+    // closest center, searched in layers of cells of increasing distance
+    const Vec3d extent = gridMax - gridMin;
+    const double tolerance = 1e-9 * (extent.norm() + gridMin.norm() + pos.norm());
+    for (int r=0; ; ++r)
+    {
+        int lo[3], hi[3];
+        for (int a=0; a<3; ++a)
+        {
+            lo[a] = std::max(0, c[a]-r);
+            hi[a] = std::min(dims[a]-1, c[a]+r);
+        }
+        for (int z=lo[2]; z<=hi[2]; ++z)
+            for (int y=lo[1]; y<=hi[1]; ++y)
+                for (int x=lo[0]; x<=hi[0]; ++x)
+                {
+                    if (std::abs(x-c[0]) < r && std::abs(y-c[1]) < r && std::abs(z-c[2]) < r)
+                        continue; // visited in a previous layer
+                    const unsigned int cell = (unsigned int)cellIndex(x,y,z);
+                    for (unsigned int k=centerBegin[cell]; k<centerBegin[cell+1]; ++k)
+                    {
+                        const unsigned int t = centerTetrahedra[k];
+                        const double d = ( pos-centers[t] ).norm2();
+                        if (d < distance || (d == distance && index >= 0 && (int)t < index))
+                        {
+                            distance = d;
+                            index = (int)t;
+                        }
+                    }
+                }
+
+        // distance from the point to the cells not visited yet
+        double bound = std::numeric_limits<double>::max();
+        bool covered = true;
+        for (int a=0; a<3; ++a)
+        {
+            if (lo[a] > 0)
+            {
+                covered = false;
+                bound = std::min(bound, pos[a] - (gridMin[a] + lo[a]*cellSize[a]));
+            }
+            if (hi[a] < dims[a]-1)
+            {
+                covered = false;
+                bound = std::min(bound, (gridMin[a] + (hi[a]+1)*cellSize[a]) - pos[a]);
+            }
+        }
+        if (covered)
+            break;
+        bound -= tolerance;
+        if (index >= 0 && bound > 0 && bound*bound > distance)
+            break;
+    }
+
+    if (index >= 0)
+    {
+        Vec3d v;
+        depth((unsigned int)index, pos, v);
+        coefs = v;
+    }
+    return index;
+}
+
+} // namespace mapping
+
+} // namespace component
+
+} // namespace sofa
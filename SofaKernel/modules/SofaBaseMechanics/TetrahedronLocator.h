@@ -0,0 +1,106 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_MAPPING_TETRAHEDRONLOCATOR_H
+#define SOFA_COMPONENT_MAPPING_TETRAHEDRONLOCATOR_H
+#include "config.h"
+
+#include <sofa/defaulttype/Vec.h>
+#include <sofa/defaulttype/Mat.h>
+#include <sofa/helper/vector.h>
+
+#include <algorithm>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace mapping
+{
+
+/// Find the tetrahedron a point is mapped on by BarycentricMapperTetrahedronSetTopology::init.
+///
+/// The result is the one of the exhaustive search: the tetrahedron containing the point with the
+/// largest depth, or the one with the closest center if no tetrahedron contains the point, the
+/// tetrahedron with the smallest index being chosen in case of equality.
+/// A regular grid registers each tetrahedron in the cells overlapped by its bounding box, and the
+/// centers of the tetrahedra in a second grid searched by increasing distance, so that only a few
+/// tetrahedra are tested per point. find() is const and can be called concurrently.
+class SOFA_BASE_MECHANICS_API TetrahedronLocator
+{
+public:
+    typedef defaulttype::Vec3d Vec3d;
+    typedef defaulttype::Vector3 Vector3;
+    typedef defaulttype::Matrix3 Matrix3;
+
+    /// Set the number of tetrahedra, before setTetrahedron
+    void resize(unsigned int nbTetrahedra);
+
+    /// Set the tetrahedron t from its first point, the matrix of its edges from this point (one per row),
+    /// the inverse of the transposed edge matrix (null if not invertible) and its center
+    void setTetrahedron(unsigned int t, const Vec3d& origin, const defaulttype::Mat3x3d& edges,
+                        const Matrix3& base, bool invertible, const Vector3& center);
+
+    /// Build the grids, once all the tetrahedra are set
+    void build();
+
+    /// Return the index of the tetrahedron the point is mapped on (-1 if none), its barycentric
+    /// coordinates in coefs and the criterion of the exhaustive search in distance (negative depth
+    /// inside the tetrahedron, squared distance to its center outside)
+    int find(const Vec3d& pos, Vector3& coefs, double& distance) const;
+
+protected:
+    /// Depth of the point in the tetrahedron t (positive outside), and its barycentric coordinates
+    double depth(unsigned int t, const Vec3d& pos, Vec3d& v) const
+    {
+        v = bases[t] * ( pos - origins[t] );
+        return std::max ( std::max ( -v[0],-v[1] ),std::max ( -v[2],v[0]+v[1]+v[2]-1 ) );
+    }
+
+    int cellIndex(int x, int y, int z) const { return x + dims[0] * (y + dims[1] * z); }
+    void cellCoord(const Vec3d& p, int* c) const;
+
+    helper::vector<Vec3d> origins;
+    helper::vector<Matrix3> bases;
+    helper::vector<Vector3> centers;
+    helper::vector<defaulttype::Mat3x3d> edges;
+    helper::vector<char> invertibles;
+    helper::vector<Vec3d> bboxMin, bboxMax; ///< bounding boxes of the tetrahedra, including the rounding errors
+    helper::vector<unsigned int> unbounded; ///< tetrahedra that cannot be localized in the grid (not invertible)
+
+    Vec3d gridMin, gridMax, cellSize;
+    int dims[3];
+
+    /// tetrahedra overlapping each cell, in increasing order
+    helper::vector<unsigned int> cellBegin, cellTetrahedra;
+    /// tetrahedra with their center in each cell, in increasing order
+    helper::vector<unsigned int> centerBegin, centerTetrahedra;
+};
+
+} // namespace mapping
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
@@ -0,0 +1,102 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <SofaBaseTopology/TopologyData.inl>
+#include <sofa/core/objectmodel/BaseObject.h>
+
+using namespace sofa::component::topology;
+
+
+namespace
+{
+
+typedef sofa::helper::vector<int> VecInt;
+
+class ValueObject : public sofa::core::objectmodel::BaseObject
+{
+public:
+    SOFA_CLASS(ValueObject, sofa::core::objectmodel::BaseObject);
+
+    PointData<VecInt> d_values;
+
+protected:
+    ValueObject()
+        : d_values(initData(&d_values, "values", "values stored per point"))
+    {}
+};
+
+/// Handler counting the swaps done through its hook
+class CountingHandler : public TopologyDataHandler<sofa::core::topology::BaseMeshTopology::Point, VecInt>
+{
+public:
+    typedef TopologyDataHandler<sofa::core::topology::BaseMeshTopology::Point, VecInt> Inherit;
+
+    CountingHandler(PointData<VecInt>* data) : Inherit(data), nbSwaps(0), nbDestroyed(0) {}
+
+    using Inherit::remove;
+
+    void applyDestroyFunction(unsigned int, int&) override { ++nbDestroyed; }
+
+    unsigned int nbSwaps;
+    unsigned int nbDestroyed;
+
+protected:
+    void swap(VecInt& data, unsigned int i1, unsigned int i2) override
+    {
+        ++nbSwaps;
+        Inherit::swap(data, i1, i2);
+    }
+};
+
+TEST( TopologyDataHandler_test, removeCompactsThroughSwapHook )
+{
+    ValueObject::SPtr object = sofa::core::objectmodel::New<ValueObject>();
+    VecInt values;
+    for (int i=0; i<10; ++i)
+        values.push_back(i);
+    object->d_values.setValue(values);
+
+    CountingHandler handler(&object->d_values);
+    const int counter = object->d_values.getCounter();
+
+    // the modifiers give the removed indices in decreasing order
+    sofa::helper::vector<unsigned int> removed;
+    removed.push_back(7);
+    removed.push_back(3);
+    removed.push_back(1);
+    handler.remove(removed);
+
+    EXPECT_EQ( 3u, handler.nbSwaps );
+    EXPECT_EQ( 3u, handler.nbDestroyed );
+    // a single edition of the Data
+    EXPECT_EQ( counter+1, object->d_values.getCounter() );
+
+    // each removed value is replaced by the last kept one, as the container does with its elements
+    const int expected[] = { 0, 9, 2, 8, 4, 5, 6 };
+    const VecInt& result = object->d_values.getValue();
+    ASSERT_EQ( 7u, result.size() );
+    for (std::size_t i=0; i<result.size(); ++i)
+        EXPECT_EQ( expected[i], result[i] );
+}
+
+}
@@ -117,6 +117,9 @@ protected:
     /// Swaps values at indices i1 and i2.
     virtual void swap( unsigned int i1, unsigned int i2 );
 
+    /// Swaps values at indices i1 and i2 of data, already opened for edition.
+    virtual void swap( container_type& data, unsigned int i1, unsigned int i2 );
+
     /// Add some values. Values are added at the end of the vector.
     /// This (new) version gives more information for element indices and ancestry
     virtual void add( const sofa::helper::vector<unsigned int> & index,
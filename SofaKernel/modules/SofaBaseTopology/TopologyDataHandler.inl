@@ -25,6 +25,8 @@
 #include <SofaBaseTopology/TopologyDataHandler.h>
 //#include <sofa/core/topology/TopologyHandler.inl>
 
+#include <utility>
+
 namespace sofa
 {
 
@@ -39,12 +41,16 @@ template <typename TopologyElementType, typename VecT>
 void TopologyDataHandler <TopologyElementType, VecT>::swap( unsigned int i1, unsigned int i2 )
 {
     container_type& data = *(m_topologyData->beginEdit());
-    value_type tmp = data[i1];
-    data[i1] = data[i2];
-    data[i2] = tmp;
+    this->swap( data, i1, i2 );
     m_topologyData->endEdit();
 }
 
+template <typename TopologyElementType, typename VecT>
+void TopologyDataHandler <TopologyElementType, VecT>::swap( container_type& data, unsigned int i1, unsigned int i2 )
+{
+    std::swap( data[i1], data[i2] );
+}
+
 
 template <typename TopologyElementType, typename VecT>
 void TopologyDataHandler <TopologyElementType, VecT>::add(const sofa::helper::vector<unsigned int> & index,
@@ -109,10 +115,14 @@ void TopologyDataHandler <TopologyElementType, VecT>::remove( const sofa::helper
 	if (data.size()>0) {
 		unsigned int last = (unsigned)data.size() -1;
 
+		// each removed value is swapped with the last kept one, as the container does with
+		// its elements. The modifiers sort the removed indices in decreasing order, so this
+		// is a single compaction pass where every kept value moves at most once, all within
+		// this single edition of the Data
 		for (unsigned int i = 0; i < index.size(); ++i)
 		{
 			this->applyDestroyFunction( index[i], data[index[i]] );
-			this->swap( index[i], last );
+			this->swap( data, index[i], last );
 			--last;
 		}
 
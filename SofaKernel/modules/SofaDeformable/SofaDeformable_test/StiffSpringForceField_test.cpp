@@ -198,6 +198,46 @@ struct StiffSpringForceField_test : public ForceField_test<_StiffSpringForceFiel
         ASSERT_TRUE( this->vectorMaxDiff(fc,actualfc)< this->errorMax*this->epsilon() );
     }
 
+    /** A stretched square grid of particles, with springs between the neighbours.
+        The springs are numerous enough to be processed concurrently when OpenMP is enabled.
+    */
+    void test_grid( Real stiffness, unsigned n, Real stretch )
+    {
+        VecCoord x(n*n);
+        VecDeriv v(n*n), f(n*n);
+        helper::vector<Vec3> p(n*n), expected(n*n);
+        for( unsigned i=0; i<n; i++ )
+            for( unsigned j=0; j<n; j++ )
+                p[i*n+j] = Vec3(i*stretch, j*stretch, 0);
+
+        for( unsigned i=0; i<n; i++ )
+        {
+            for( unsigned j=0; j<n; j++ )
+            {
+                const unsigned a = i*n+j;
+                for( unsigned k=0; k<2; k++ )
+                {
+                    const unsigned ni = i+k, nj = j+1-k;
+                    if( ni>=n || nj>=n ) continue;
+                    const unsigned b = ni*n+nj;
+                    this->force->addSpring(a,b,stiffness,0,1);
+                    // the force of a spring of unit rest length, aligned with an axis
+                    const Vec3 force = (p[b]-p[a]) * (stiffness*(stretch-1)/stretch);
+                    expected[a] += force;
+                    expected[b] -= force;
+                }
+            }
+        }
+
+        for( unsigned i=0; i<n*n; i++ )
+        {
+            DataTypes::set( x[i], p[i][0],p[i][1],p[i][2]);
+            DataTypes::set( f[i], expected[i][0],expected[i][1],expected[i][2]);
+        }
+
+        this->run_test( x, v, f );
+    }
+
     ///@}
 };
 
@@ -285,5 +325,13 @@ TYPED_TEST( StiffSpringForceField_test , extension_in_parent_and_child )
     this->test_2particles_in_parent_and_child(k,d,l0, x0,v0, x1,v1, f0);
 }
 
+// many springs sharing their extremities
+TYPED_TEST( StiffSpringForceField_test , grid )
+{
+    this->debug = false;
+    // slightly stretched, so that the rounding errors on the energy of the many springs stay below the tolerance on its change
+    this->test_grid(1.0, 40, 1.01);
+}
+
 
 } // namespace sofa
@@ -72,6 +72,18 @@ public:
 protected:
     sofa::helper::vector<Mat>  dfdx;
 
+    /// Indices of the springs sorted by color: the springs of a color do not share any extremity,
+    /// so that their forces can be accumulated concurrently.
+    sofa::helper::vector<unsigned int> springOrder;
+    /// First index in springOrder of each color, followed by the beginning of the remaining springs,
+    /// which are too few per color to be worth processing in parallel.
+    sofa::helper::vector<unsigned int> colorBegin;
+    /// Counter of the springs Data when the colors were computed
+    int colorsCounter;
+
+    /// Sort the springs by color if they changed since the last call
+    void updateSpringColors();
+
     /// Accumulate the spring force and compute and store its stiffness
     virtual void addSpringForce(Real& potentialEnergy, VecDeriv& f1,const  VecCoord& p1,const VecDeriv& v1, VecDeriv& f2,const  VecCoord& p2,const  VecDeriv& v2, int i, const Spring& spring) override;
 
@@ -81,11 +93,13 @@ protected:
 
     StiffSpringForceField(MechanicalState* object1, MechanicalState* object2, double ks=100.0, double kd=5.0)
         : SpringForceField<DataTypes>(object1, object2, ks, kd)
+        , colorsCounter(-1)
     {
     }
 
     StiffSpringForceField(double ks=100.0, double kd=5.0)
         : SpringForceField<DataTypes>(ks, kd)
+        , colorsCounter(-1)
     {
     }
 public:
@@ -27,6 +27,7 @@
 
 #include <SofaDeformable/StiffSpringForceField.h>
 #include <sofa/helper/AdvancedTimer.h>
+#include <sofa/helper/IndexOpenMP.h>
 
 #include <sofa/core/visual/VisualParams.h>
 
@@ -44,6 +45,76 @@ template<class DataTypes>
 void StiffSpringForceField<DataTypes>::init()
 {
     this->SpringForceField<DataTypes>::init();
+    colorsCounter = -1;
+}
+
+template<class DataTypes>
+void StiffSpringForceField<DataTypes>::updateSpringColors()
+{
+    // below this number of springs, a color is not worth a parallel loop
+    enum { MinColorSize = 256 };
+
+    if (colorsCounter == this->springs.getCounter())
+        return;
+    colorsCounter = this->springs.getCounter();
+
+    const helper::vector<Spring>& springs = this->springs.getValue();
+    const unsigned int nbSprings = (unsigned int)springs.size();
+
+    // the extremities in the second state are numbered after the ones in the first state,
+    // unless both states are the same
+    int nbNodes1 = 0, nbNodes2 = 0;
+    for (unsigned int i=0; i<nbSprings; i++)
+    {
+        nbNodes1 = std::max(nbNodes1, springs[i].m1+1);
+        nbNodes2 = std::max(nbNodes2, springs[i].m2+1);
+    }
+    const bool sameState = (this->mstate1 == this->mstate2);
+    const int offset2 = sameState ? 0 : nbNodes1;
+    const int nbNodes = sameState ? std::max(nbNodes1, nbNodes2) : nbNodes1 + nbNodes2;
+
+    // greedy coloring: each color takes the remaining springs which do not share an extremity
+    // with a spring taken before it, in the order of the springs to keep the accesses local
+    helper::vector<unsigned int> nodeColor(nbNodes, 0);
+    helper::vector<unsigned int> remaining(nbSprings);
+    helper::vector<unsigned int> next;
+    for (unsigned int i=0; i<nbSprings; i++)
+        remaining[i] = i;
+
+    springOrder.clear();
+    springOrder.reserve(nbSprings);
+    colorBegin.clear();
+    unsigned int color = 0;
+    while (!remaining.empty())
+    {
+        ++color;
+        const unsigned int begin = (unsigned int)springOrder.size();
+        next.clear();
+        for (unsigned int j=0; j<remaining.size(); j++)
+        {
+            const unsigned int i = remaining[j];
+            const int n1 = springs[i].m1;
+            const int n2 = offset2 + springs[i].m2;
+            if (n1 >= 0 && n2 >= offset2 && nodeColor[n1] != color && nodeColor[n2] != color)
+            {
+                nodeColor[n1] = color;
+                nodeColor[n2] = color;
+                springOrder.push_back(i);
+            }
+            else
+                next.push_back(i);
+        }
+        if (springOrder.size() - begin < (unsigned int)MinColorSize)
+        {
+            // the remaining springs are processed sequentially
+            springOrder.resize(begin);
+            break;
+        }
+        colorBegin.push_back(begin);
+        remaining.swap(next);
+    }
+    colorBegin.push_back((unsigned int)springOrder.size());
+    springOrder.insert(springOrder.end(), remaining.begin(), remaining.end());
 }
 
 template<class DataTypes>
@@ -136,10 +207,31 @@ void StiffSpringForceField<DataTypes>::addForce(const core::MechanicalParams* /*
     f1.resize(x1.size());
     f2.resize(x2.size());
     this->m_potentialEnergy = 0;
+#ifdef _OPENMP
+    updateSpringColors();
+    for (unsigned int c=0; c+1<colorBegin.size(); c++)
+    {
+        const helper::IndexOpenMP<unsigned int>::type begin = colorBegin[c], end = colorBegin[c+1];
+        Real potentialEnergy = 0;
+#pragma omp parallel for reduction(+:potentialEnergy)
+        for (helper::IndexOpenMP<unsigned int>::type k=begin; k<end; k++)
+        {
+            const unsigned int i = springOrder[k];
+            this->addSpringForce(potentialEnergy,f1,x1,v1,f2,x2,v2, i, springs[i]);
+        }
+        this->m_potentialEnergy += potentialEnergy;
+    }
+    for (unsigned int k=colorBegin.back(); k<springOrder.size(); k++)
+    {
+        const unsigned int i = springOrder[k];
+        this->addSpringForce(this->m_potentialEnergy,f1,x1,v1,f2,x2,v2, i, springs[i]);
+    }
+#else
     for (unsigned int i=0; i<springs.size(); i++)
     {
         this->addSpringForce(this->m_potentialEnergy,f1,x1,v1,f2,x2,v2, i, springs[i]);
     }
+#endif
     data_f1.endEdit();
     data_f2.endEdit();
 }
@@ -158,10 +250,29 @@ void StiffSpringForceField<DataTypes>::addDForce(const core::MechanicalParams* m
     df1.resize(dx1.size());
     df2.resize(dx2.size());
 
+#ifdef _OPENMP
+    updateSpringColors();
+    for (unsigned int c=0; c+1<colorBegin.size(); c++)
+    {
+        const helper::IndexOpenMP<unsigned int>::type begin = colorBegin[c], end = colorBegin[c+1];
+#pragma omp parallel for
+        for (helper::IndexOpenMP<unsigned int>::type k=begin; k<end; k++)
+        {
+            const unsigned int i = springOrder[k];
+            this->addSpringDForce(df1,dx1,df2,dx2, i, springs[i], kFactor, bFactor);
+        }
+    }
+    for (unsigned int k=colorBegin.back(); k<springOrder.size(); k++)
+    {
+        const unsigned int i = springOrder[k];
+        this->addSpringDForce(df1,dx1,df2,dx2, i, springs[i], kFactor, bFactor);
+    }
+#else
     for (unsigned int i=0; i<springs.size(); i++)
     {
         this->addSpringDForce(df1,dx1,df2,dx2, i, springs[i], kFactor, bFactor);
     }
+#endif
 
     data_df1.endEdit();
     data_df2.endEdit();
@@ -32,6 +32,7 @@
 #include <sofa/core/objectmodel/BaseObject.h>
 #include <sofa/core/behavior/MechanicalState.h>
 #include <sofa/core/topology/BaseMeshTopology.h>
+#include <sofa/core/topology/ElementSelection.h>
 #include <sofa/core/loader/MeshLoader.h>
 #include <sofa/defaulttype/RigidTypes.h>
 #include <sofa/core/visual/VisualParams.h>
@@ -213,6 +214,28 @@ protected:
     bool isQuadInBoxes(const Quad& q);
 
     void getPointsFromOrientedBox(const Vec10& box, vector<Vec3> &points);
+
+    /// Return false if the selection must be computed again from scratch, i.e. if not only the
+    /// positions changed since the last update
+    bool canUpdateSelection();
+    void computeSelection();
+    /// Test again the points which moved since the last update and the elements using them
+    void updateSelection();
+    template <class Element, class Test>
+    void updateElementSelection(core::topology::ElementSelection<Element>& selection,
+                                const Data<vector<Element> >& elements,
+                                Data<SetIndex>& indices, Data<vector<Element> >& elementsInROI,
+                                const vector<PointID>& movedPoints, std::size_t nbPoints, Test test);
+
+    /// Current selection, used to update it incrementally
+    /// @{
+    core::topology::PointSelection<VecCoord> m_pointSelection;
+    core::topology::ElementSelection<Edge> m_edgeSelection;
+    core::topology::ElementSelection<Triangle> m_triangleSelection;
+    core::topology::ElementSelection<Tetra> m_tetrahedronSelection;
+    core::topology::ElementSelection<Quad> m_quadSelection;
+    bool m_isSelectionValid;
+    /// @}
 };
 
 #if defined(SOFA_EXTERN_TEMPLATE) && !defined(SOFA_COMPONENT_ENGINE_BOXROI_CPP)
@@ -30,6 +30,7 @@
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/defaulttype/BoundingBox.h>
 #include <limits>
+#include <algorithm>
 #include <sofa/core/topology/BaseTopology.h>
 #include <sofa/simulation/AnimateBeginEvent.h>
 
@@ -57,6 +58,7 @@ using defaulttype::TBoundingBox ;
 using defaulttype::Vector3 ;
 using defaulttype::Vec4f ;
 using helper::WriteOnlyAccessor ;
+using helper::WriteAccessor ;
 using helper::ReadAccessor ;
 using helper::vector ;
 
@@ -111,6 +113,7 @@ BoxROI<DataTypes>::BoxROI()
     /// Deprecated input attributes
     , d_deprecatedX0( initData (&d_deprecatedX0, "rest_position", "(deprecated) Replaced with the attribute 'position'") )
     , d_deprecatedIsVisible( initData(&d_deprecatedIsVisible, false, "isVisible","(deprecated)Replaced with the attribute 'drawBoxes'") )
+    , m_isSelectionValid(false)
 {
     //Adding alias to handle old BoxROI outputs
     addAlias(&d_pointsInROI,"pointsInBox");
@@ -287,6 +290,13 @@ void BoxROI<DataTypes>::init()
     addInput(&d_hexahedra);
     addInput(&d_quad);
 
+    m_dataTracker.trackData(d_X0);
+    m_dataTracker.trackData(d_edges);
+    m_dataTracker.trackData(d_triangles);
+    m_dataTracker.trackData(d_tetrahedra);
+    m_dataTracker.trackData(d_hexahedra);
+    m_dataTracker.trackData(d_quad);
+
     addOutput(&d_indices);
     addOutput(&d_edgeIndices);
     addOutput(&d_triangleIndices);
@@ -334,6 +344,8 @@ void BoxROI<DataTypes>::reinit()
 
     computeOrientedBoxes();
 
+    // the boxes or the options may have changed
+    m_isSelectionValid = false;
     update();
 }
 
@@ -510,26 +522,37 @@ bool BoxROI<DataTypes>::isQuadInBoxes(const Quad& q)
 
 }
 
-// The update method is called when the engine is marked as dirty.
 template <class DataTypes>
-void BoxROI<DataTypes>::update()
+bool BoxROI<DataTypes>::canUpdateSelection()
 {
-    if(m_componentstate==ComponentState::Invalid){
-        cleanDirty() ;
-        return ;
-    }
+    if (!m_isSelectionValid)
+        return false;
 
-    if(!d_doUpdate.getValue()){
-        cleanDirty() ;
-        return ;
-    }
+    // the topology must be the same, only some positions may have changed
+    if (m_dataTracker.isDirty(d_edges) || m_dataTracker.isDirty(d_triangles) || m_dataTracker.isDirty(d_tetrahedra)
+            || m_dataTracker.isDirty(d_hexahedra) || m_dataTracker.isDirty(d_quad))
+        return false;
 
-    const vector<Vec6>&  alignedBoxes  = d_alignedBoxes.getValue();
-    const vector<Vec10>& orientedBoxes = d_orientedBoxes.getValue();
+    // the hexahedra selection is always computed from scratch
+    if (d_computeHexahedra.getValue() && !d_hexahedra.getValue().empty())
+        return false;
 
-    if (alignedBoxes.empty() && orientedBoxes.empty()) { cleanDirty(); return; }
+    if (d_X0.getValue().size() != m_pointSelection.size())
+        return false;
 
+    // the selections of elements must have been computed
+    if ((d_computeEdges.getValue() && m_edgeSelection.size() != d_edges.getValue().size())
+            || (d_computeTriangles.getValue() && m_triangleSelection.size() != d_triangles.getValue().size())
+            || (d_computeTetrahedra.getValue() && m_tetrahedronSelection.size() != d_tetrahedra.getValue().size())
+            || (d_computeQuad.getValue() && m_quadSelection.size() != d_quad.getValue().size()))
+        return false;
 
+    return true;
+}
+
+template <class DataTypes>
+void BoxROI<DataTypes>::computeSelection()
+{
     // Read accessor for input topology
     ReadAccessor< Data<vector<Edge> > > edges = d_edges;
     ReadAccessor< Data<vector<Triangle> > > triangles = d_triangles;
@@ -539,8 +562,6 @@ void BoxROI<DataTypes>::update()
 
     const VecCoord& x0 = d_X0.getValue();
 
-    cleanDirty();
-
     // Write accessor for topological element indices in BOX
     SetIndex& indices = *d_indices.beginWriteOnly();
     SetIndex& edgeIndices = *d_edgeIndices.beginWriteOnly();
@@ -576,55 +597,33 @@ void BoxROI<DataTypes>::update()
 
 
     //Points
-    for( unsigned i=0; i<x0.size(); ++i )
-    {
-        if (isPointInBoxes(i))
-        {
-            indices.push_back(i);
-            pointsInROI.push_back(x0[i]);
-        }
-    }
+    m_pointSelection.select(x0, [this](PointID i) { return isPointInBoxes(i); });
+    m_pointSelection.getSelection(x0, indices, pointsInROI.wref());
+
+    m_edgeSelection.clear();
+    m_triangleSelection.clear();
+    m_tetrahedronSelection.clear();
+    m_quadSelection.clear();
 
     //Edges
     if (d_computeEdges.getValue())
     {
-        for(unsigned int i=0 ; i<edges.size() ; i++)
-        {
-            Edge e = edges[i];
-            if (isEdgeInBoxes(e))
-            {
-                edgeIndices.push_back(i);
-                edgesInROI.push_back(e);
-            }
-        }
+        m_edgeSelection.select(edges.ref(), [this](const Edge& e) { return isEdgeInBoxes(e); });
+        m_edgeSelection.getSelection(edges.ref(), edgeIndices, edgesInROI.wref());
     }
 
     //Triangles
     if (d_computeTriangles.getValue())
     {
-        for(unsigned int i=0 ; i<triangles.size() ; i++)
-        {
-            Triangle t = triangles[i];
-            if (isTriangleInBoxes(t))
-            {
-                triangleIndices.push_back(i);
-                trianglesInROI.push_back(t);
-            }
-        }
+        m_triangleSelection.select(triangles.ref(), [this](const Triangle& t) { return isTriangleInBoxes(t); });
+        m_triangleSelection.getSelection(triangles.ref(), triangleIndices, trianglesInROI.wref());
     }
 
     //Tetrahedra
     if (d_computeTetrahedra.getValue())
     {
-        for(unsigned int i=0 ; i<tetrahedra.size() ; i++)
-        {
-            Tetra t = tetrahedra[i];
-            if (isTetrahedronInBoxes(t))
-            {
-                tetrahedronIndices.push_back(i);
-                tetrahedraInROI.push_back(t);
-            }
-        }
+        m_tetrahedronSelection.select(tetrahedra.ref(), [this](const Tetra& t) { return isTetrahedronInBoxes(t); });
+        m_tetrahedronSelection.getSelection(tetrahedra.ref(), tetrahedronIndices, tetrahedraInROI.wref());
     }
 
     //Hexahedra
@@ -645,15 +644,8 @@ void BoxROI<DataTypes>::update()
     //Quads
     if (d_computeQuad.getValue())
     {
-        for(unsigned int i=0 ; i<quad.size() ; i++)
-        {
-            Quad q = quad[i];
-            if (isQuadInBoxes(q))
-            {
-                quadIndices.push_back(i);
-                quadInROI.push_back(q);
-            }
-        }
+        m_quadSelection.select(quad.ref(), [this](const Quad& q) { return isQuadInBoxes(q); });
+        m_quadSelection.getSelection(quad.ref(), quadIndices, quadInROI.wref());
     }
 
 
@@ -665,7 +657,112 @@ void BoxROI<DataTypes>::update()
     d_tetrahedronIndices.endEdit();
     d_hexahedronIndices.endEdit();
     d_quadIndices.endEdit();
+}
+
+template <class DataTypes>
+void BoxROI<DataTypes>::updateSelection()
+{
+    const VecCoord& x0 = d_X0.getValue();
 
+    //Points
+    vector<PointID> movedPoints;
+    if (m_pointSelection.update(x0, [this](PointID i) { return isPointInBoxes(i); }, movedPoints))
+    {
+        m_pointSelection.getSelection(x0, *d_indices.beginWriteOnly(), *d_pointsInROI.beginWriteOnly());
+        d_nbIndices.setValue(d_indices.getValue().size());
+        d_indices.endEdit();
+        d_pointsInROI.endEdit();
+    }
+    else
+    {
+        // same points in the ROI, only the positions of the moved ones are copied
+        const SetIndex& indices = d_indices.getValue();
+        vector<PointID> ranks;
+        for (unsigned int i=0; i<movedPoints.size(); ++i)
+            if (m_pointSelection.isSelected(movedPoints[i]))
+                ranks.push_back((PointID)(std::lower_bound(indices.begin(), indices.end(), movedPoints[i]) - indices.begin()));
+
+        if (!ranks.empty())
+        {
+            WriteAccessor< Data<VecCoord > > pointsInROI = d_pointsInROI;
+            for (unsigned int i=0; i<ranks.size(); ++i)
+                pointsInROI[ranks[i]] = x0[indices[ranks[i]]];
+        }
+    }
+
+    if (movedPoints.empty())
+        return;
+
+    const std::size_t nbPoints = x0.size();
+
+    //Edges
+    if (d_computeEdges.getValue())
+        updateElementSelection(m_edgeSelection, d_edges, d_edgeIndices, d_edgesInROI, movedPoints, nbPoints,
+                               [this](const Edge& e) { return isEdgeInBoxes(e); });
+
+    //Triangles
+    if (d_computeTriangles.getValue())
+        updateElementSelection(m_triangleSelection, d_triangles, d_triangleIndices, d_trianglesInROI, movedPoints, nbPoints,
+                               [this](const Triangle& t) { return isTriangleInBoxes(t); });
+
+    //Tetrahedra
+    if (d_computeTetrahedra.getValue())
+        updateElementSelection(m_tetrahedronSelection, d_tetrahedra, d_tetrahedronIndices, d_tetrahedraInROI, movedPoints, nbPoints,
+                               [this](const Tetra& t) { return isTetrahedronInBoxes(t); });
+
+    //Quads
+    if (d_computeQuad.getValue())
+        updateElementSelection(m_quadSelection, d_quad, d_quadIndices, d_quadInROI, movedPoints, nbPoints,
+                               [this](const Quad& q) { return isQuadInBoxes(q); });
+}
+
+template <class DataTypes> template <class Element, class Test>
+void BoxROI<DataTypes>::updateElementSelection(core::topology::ElementSelection<Element>& selection,
+                                               const Data<vector<Element> >& elements,
+                                               Data<SetIndex>& indices, Data<vector<Element> >& elementsInROI,
+                                               const vector<PointID>& movedPoints, std::size_t nbPoints, Test test)
+{
+    const vector<Element>& e = elements.getValue();
+    if (selection.update(e, movedPoints, nbPoints, test))
+    {
+        selection.getSelection(e, *indices.beginWriteOnly(), *elementsInROI.beginWriteOnly());
+        indices.endEdit();
+        elementsInROI.endEdit();
+    }
+}
+
+// The update method is called when the engine is marked as dirty.
+template <class DataTypes>
+void BoxROI<DataTypes>::update()
+{
+    if(m_componentstate==ComponentState::Invalid){
+        cleanDirty() ;
+        m_isSelectionValid = false;
+        return ;
+    }
+
+    if(!d_doUpdate.getValue()){
+        cleanDirty() ;
+        m_isSelectionValid = false;
+        return ;
+    }
+
+    const vector<Vec6>&  alignedBoxes  = d_alignedBoxes.getValue();
+    const vector<Vec10>& orientedBoxes = d_orientedBoxes.getValue();
+
+    if (alignedBoxes.empty() && orientedBoxes.empty()) { cleanDirty(); m_isSelectionValid = false; return; }
+
+    // When only some positions were modified since the last update, only the moved points and the
+    // elements using them are tested again.
+    const bool isIncremental = canUpdateSelection();
+
+    cleanDirty();
+
+    if (isIncremental)
+        updateSelection();
+    else
+        computeSelection();
+    m_isSelectionValid = true;
 }
 
 
@@ -353,6 +353,54 @@ struct BoxROITest :  public ::testing::Test
     }
 
 
+    /// Test the update of the selection when only some positions are modified
+    void incrementalUpdateTest()
+    {
+        typedef typename TheBoxROI::VecCoord VecCoord;
+        m_boxroi->findData("box")->read("0. 0. 0. 1. 1. 1.");
+        m_boxroi->findData("position")->read("0. 0. 0. 1. 0. 0. 2. 0. 0. 3. 0. 0.");
+        m_boxroi->findData("edges")->read("0 1 1 2 2 3");
+        m_boxroi->init();
+
+        EXPECT_EQ(m_boxroi->findData("indices")->getValueString(),"0 1");
+        EXPECT_EQ(m_boxroi->findData("edgeIndices")->getValueString(),"0");
+
+        // move the point 2 in the box
+        {
+            sofa::helper::WriteAccessor< sofa::core::objectmodel::Data<VecCoord> > x = m_boxroi->d_X0;
+            x[2][0] = 0.5;
+        }
+        m_boxroi->update();
+
+        EXPECT_EQ(m_boxroi->findData("indices")->getValueString(),"0 1 2");
+        EXPECT_EQ(m_boxroi->findData("pointsInROI")->getValueString(),"0 0 0 1 0 0 0.5 0 0");
+        EXPECT_EQ(m_boxroi->findData("edgeIndices")->getValueString(),"0 1");
+        EXPECT_EQ(m_boxroi->findData("edgesInROI")->getValueString(),"0 1 1 2");
+
+        // move the point 1 inside the box: the selections are not modified, only the position in the ROI
+        const int indicesCounter = m_boxroi->d_indices.getCounter();
+        const int edgeIndicesCounter = m_boxroi->d_edgeIndices.getCounter();
+        {
+            sofa::helper::WriteAccessor< sofa::core::objectmodel::Data<VecCoord> > x = m_boxroi->d_X0;
+            x[1][1] = 0.5;
+        }
+        m_boxroi->update();
+
+        EXPECT_EQ(m_boxroi->findData("indices")->getValueString(),"0 1 2");
+        EXPECT_EQ(m_boxroi->findData("pointsInROI")->getValueString(),"0 0 0 1 0.5 0 0.5 0 0");
+        EXPECT_EQ(m_boxroi->d_indices.getCounter(), indicesCounter);
+        EXPECT_EQ(m_boxroi->d_edgeIndices.getCounter(), edgeIndicesCounter);
+
+        // a change of the topology computes the selection from scratch
+        m_boxroi->findData("position")->read("2. 0. 0. 1. 0. 0. 2. 0. 0. 0.5 0. 0.");
+        m_boxroi->findData("edges")->read("0 1 1 3");
+        m_boxroi->update();
+
+        EXPECT_EQ(m_boxroi->findData("indices")->getValueString(),"1 3");
+        EXPECT_EQ(m_boxroi->findData("edgeIndices")->getValueString(),"1");
+    }
+
+
     /// Test computeBBox computation with a simple example
     void computeBBoxTest()
     {
@@ -451,6 +499,10 @@ TYPED_TEST(BoxROITest, isPointInBoxesTest) {
     ASSERT_NO_THROW(this->isPointInBoxesTest()) ;
 }
 
+TYPED_TEST(BoxROITest, incrementalUpdateTest) {
+    ASSERT_NO_THROW(this->incrementalUpdateTest()) ;
+}
+
 TYPED_TEST(BoxROITest, computeBBoxTest) {
     ASSERT_NO_THROW(this->computeBBoxTest()) ;
 }
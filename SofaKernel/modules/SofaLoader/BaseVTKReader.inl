@@ -22,10 +22,15 @@
 #ifndef SOFA_COMPONENT_LOADER_BASEVTKREADER_INL
 #define SOFA_COMPONENT_LOADER_BASEVTKREADER_INL
 #include <SofaLoader/BaseVTKReader.h>
+#include <sofa/helper/io/MappedFile.h>
 
 #include <string>
 #include <istream>
 #include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <limits>
 
 
 namespace sofa
@@ -43,6 +48,136 @@ namespace basevtkreader
 using std::istringstream ;
 using sofa::defaulttype::Vec ;
 
+/// Parsing of ASCII values directly from memory, with the same result as 'stream >> value'.
+/// Only numerical types are supported: reading a char from a stream does not parse a number.
+template<class T>
+struct VTKAsciiValue
+{
+    enum { supported = 0 };
+    static bool read(const char*&, const char*, T&) { return false; }
+};
+
+template<class T>
+struct VTKAsciiInteger
+{
+    enum { supported = 1 };
+
+    static bool read(const char*& p, const char* end, T& value)
+    {
+        const char* c = p;
+        while (c != end && (*c == ' ' || *c == '\t' || *c == '\v' || *c == '\f' || *c == '\r')) ++c;
+        bool negative = false;
+        if (c != end && (*c == '-' || *c == '+'))
+        {
+            negative = (*c == '-');
+            ++c;
+        }
+        if (c == end || *c < '0' || *c > '9')
+            return false;
+        unsigned long long v = 0;
+        bool overflow = false;
+        for (; c != end && *c >= '0' && *c <= '9'; ++c)
+        {
+            const unsigned long long next = v * 10 + (unsigned long long)(*c - '0');
+            if (next / 10 != v) overflow = true;
+            v = next;
+        }
+        p = c;
+        if (std::numeric_limits<T>::is_signed)
+        {
+            const unsigned long long limit = negative ? (unsigned long long)std::numeric_limits<T>::max() + 1ull
+                                                      : (unsigned long long)std::numeric_limits<T>::max();
+            if (overflow || v > limit)
+                return false;
+            value = negative ? (T)(0 - (long long)(v - 1) - 1) : (T)v;
+        }
+        else
+        {
+            if (overflow || v > (unsigned long long)std::numeric_limits<T>::max())
+                return false;
+            value = negative ? (T)(0 - (T)v) : (T)v;
+        }
+        return true;
+    }
+};
+
+template<class T>
+struct VTKAsciiReal
+{
+    enum { supported = 1 };
+
+    static double convert(const char* s, char** stop, double) { return std::strtod(s, stop); }
+    static float convert(const char* s, char** stop, float) { return std::strtof(s, stop); }
+
+    static bool read(const char*& p, const char* end, T& value)
+    {
+        const char* c = p;
+        while (c != end && (*c == ' ' || *c == '\t' || *c == '\v' || *c == '\f' || *c == '\r')) ++c;
+        // same accepted characters as std::num_get: [sign] digits [. digits] [e [sign] digits]
+        const char* start = c;
+        if (c != end && (*c == '-' || *c == '+')) ++c;
+        while (c != end && *c >= '0' && *c <= '9') ++c;
+        if (c != end && *c == '.')
+        {
+            ++c;
+            while (c != end && *c >= '0' && *c <= '9') ++c;
+        }
+        if (c != end && (*c == 'e' || *c == 'E'))
+        {
+            ++c;
+            if (c != end && (*c == '-' || *c == '+')) ++c;
+            while (c != end && *c >= '0' && *c <= '9') ++c;
+        }
+        const std::size_t length = (std::size_t)(c - start);
+        if (length == 0)
+            return false;
+
+        char buffer[128];
+        std::string longNumber;
+        char* s = buffer;
+        if (length < sizeof(buffer))
+        {
+            std::memcpy(buffer, start, length);
+            buffer[length] = '\0';
+        }
+        else
+        {
+            longNumber.assign(start, c);
+            s = &longNumber[0];
+        }
+        char* stop = NULL;
+        const T v = (T)convert(s, &stop, T());
+        p = c;
+        if (stop != s + length)
+            return false;
+        value = v;
+        return true;
+    }
+};
+
+template<> struct VTKAsciiValue<std::int16_t> : public VTKAsciiInteger<std::int16_t> {};
+template<> struct VTKAsciiValue<std::uint16_t> : public VTKAsciiInteger<std::uint16_t> {};
+template<> struct VTKAsciiValue<std::int32_t> : public VTKAsciiInteger<std::int32_t> {};
+template<> struct VTKAsciiValue<std::uint32_t> : public VTKAsciiInteger<std::uint32_t> {};
+template<> struct VTKAsciiValue<std::int64_t> : public VTKAsciiInteger<std::int64_t> {};
+template<> struct VTKAsciiValue<std::uint64_t> : public VTKAsciiInteger<std::uint64_t> {};
+template<> struct VTKAsciiValue<float> : public VTKAsciiReal<float> {};
+template<> struct VTKAsciiValue<double> : public VTKAsciiReal<double> {};
+
+template<int N, class Real>
+struct VTKAsciiValue< Vec<N, Real> >
+{
+    enum { supported = VTKAsciiValue<Real>::supported };
+
+    static bool read(const char*& p, const char* end, Vec<N, Real>& value)
+    {
+        for (int i = 0; i < N; ++i)
+            if (!VTKAsciiValue<Real>::read(p, end, value[i]))
+                return false;
+        return true;
+    }
+};
+
 template<class T>
 const void* BaseVTKReader::VTKDataIO<T>::getData()
 {
@@ -133,6 +268,66 @@ template<class T>
 bool BaseVTKReader::VTKDataIO<T>::read(istream& in, int n, int binary)
 {
     resize(n);
+
+    helper::io::MemoryStreamBuf* memory = dynamic_cast<helper::io::MemoryStreamBuf*>(in.rdbuf());
+    if (memory && binary)
+    {
+        // the data is already in memory (i.e. mapped), copy it without going through the stream
+        const std::size_t nbBytes = (std::size_t)n * sizeof(T);
+        const std::size_t available = (std::size_t)(memory->end() - memory->current());
+        if (available < nbBytes)
+        {
+            memory->advance(available);
+            in.setstate(std::ios_base::eofbit | std::ios_base::failbit);
+            resize(0);
+            return false;
+        }
+        if (nbBytes > 0)
+            std::memcpy((void*)data, memory->current(), nbBytes);
+        memory->advance(nbBytes);
+        if (binary == 2) // swap bytes
+        {
+            for (int i=0; i<n; ++i)
+            {
+                data[i] = swapT(data[i], nestedDataSize);
+            }
+        }
+        return true;
+    }
+    if (memory && VTKAsciiValue<T>::supported)
+    {
+        // parse the values in place, line by line as below:
+        // the values remaining on the line of the last one are skipped
+        int i = 0;
+        const char* p = memory->current();
+        const char* end = memory->end();
+        while (i < n && !in.eof() && !in.bad())
+        {
+            if (p == end)
+            {
+                in.setstate(std::ios_base::eofbit | std::ios_base::failbit);
+                break;
+            }
+            const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', (std::size_t)(end - p)));
+            const char* nextLine = lineEnd ? lineEnd + 1 : end;
+            if (!lineEnd)
+            {
+                lineEnd = end;
+                in.setstate(std::ios_base::eofbit);
+            }
+            while (i < n && VTKAsciiValue<T>::read(p, lineEnd, data[i]))
+                ++i;
+            p = nextLine;
+        }
+        memory->advance((std::size_t)(p - memory->current()));
+        if (i < n)
+        {
+            resize(0);
+            return false;
+        }
+        return true;
+    }
+
     if (binary)
     {
         in.read((char*)data, n *sizeof(T));
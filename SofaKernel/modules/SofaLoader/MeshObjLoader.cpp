@@ -23,7 +23,18 @@
 #include <SofaLoader/MeshObjLoader.h>
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/helper/system/SetDirectory.h>
+#include <sofa/helper/system/Locale.h>
+#include <sofa/helper/io/MappedFile.h>
+#include <sofa/helper/IndexOpenMP.h>
 #include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
 
 namespace sofa
 {
@@ -102,23 +113,18 @@ bool MeshObjLoader::load()
 {
     dmsg_info() << "Loading OBJ file: " << m_filename;
 
-    bool fileRead = false;
-
     // -- Loading file
     const char* filename = m_filename.getFullPath().c_str();
-    std::ifstream file(filename);
+    helper::io::MappedFile file(filename);
 
-    if (!file.good())
+    if (!file.isOpen())
     {
         msg_error() << "Error: MeshObjLoader: Cannot read file '" << m_filename << "'.";
         return false;
     }
 
     // -- Reading file
-    fileRead = this->readOBJ (file,filename);
-    file.close();
-
-    return fileRead;
+    return this->readOBJ (file.begin(), file.end(), filename);
 }
 
 
@@ -147,9 +153,212 @@ void MeshObjLoader::addGroup (const PrimitiveGroup& g)
     d_quadsGroups.endEdit();
 }
 
+namespace
+{
+
+/// The file is tokenized in place, with the same rules as reading it word by word
+/// from a std::istream (i.e. the ranges are not null-terminated).
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+inline const char* skipBlanks(const char* p, const char* end)
+{
+    while (p != end && isBlank(*p)) ++p;
+    return p;
+}
+
+inline const char* skipWord(const char* p, const char* end)
+{
+    while (p != end && !isBlank(*p)) ++p;
+    return p;
+}
+
+inline bool wordIs(const char* word, const char* wordEnd, const char* keyword)
+{
+    const std::size_t length = std::strlen(keyword);
+    return (std::size_t)(wordEnd - word) == length && std::strncmp(word, keyword, length) == 0;
+}
+
+inline double toReal(const char* s, double) { return std::strtod(s, NULL); }
+inline float toReal(const char* s, float) { return std::strtof(s, NULL); }
+
+inline bool isDecimalChar(char c)
+{
+    return (c >= '0' && c <= '9') || c == '.' || c == '-' || c == '+' || c == 'e' || c == 'E';
+}
+
+/// Read the next real value of the line, a missing value is read as 0.
+/// Only the leading decimal characters of the word are converted, so that the infinities,
+/// NaNs and hexadecimal floats accepted by strtod are rejected as by a stream.
+inline SReal readReal(const char*& p, const char* end)
+{
+    const char* word = skipBlanks(p, end);
+    p = skipWord(word, end);
+    std::size_t length = 0;
+    while (word + length != p && isDecimalChar(word[length])) ++length;
+    if (length == 0)
+        return 0;
+
+    char buffer[64];
+    if (length < sizeof(buffer))
+    {
+        std::memcpy(buffer, word, length);
+        buffer[length] = '\0';
+        return toReal(buffer, SReal());
+    }
+    return toReal(std::string(word, word + length).c_str(), SReal());
+}
+
+/// Same as atoi, on a range
+inline int readIndex(const char* p, const char* end)
+{
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+'))
+    {
+        negative = (*p == '-');
+        ++p;
+    }
+    long long value = 0;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p)
+        value = value * 10 + (*p - '0');
+    return (int)(negative ? -value : value);
+}
+
+/// Split the end of a line as successive 'stream >> word' until the end of the stream,
+/// i.e. trailing blanks produce a last empty word
+void readWords(const char* p, const char* end, std::vector<std::string>& words)
+{
+    words.clear();
+    while (p != end)
+    {
+        const char* word = skipBlanks(p, end);
+        p = skipWord(word, end);
+        words.push_back(std::string(word, p));
+    }
+}
+
+/// Content of a range of lines of an OBJ file, which can be parsed independently from the
+/// rest of the file. Lines depending on the previous ones (materials and groups) are only
+/// located, and interpreted when the chunks are merged in order.
+struct ObjChunk
+{
+    struct Statement
+    {
+        std::size_t nbFacesBefore;
+        const char* keyword;
+        const char* keywordEnd;
+        const char* lineEnd;
+    };
+
+    helper::vector<Vector3> positions;
+    helper::vector<Vector3> normals;
+    helper::vector<Vector2> texCoords;
+
+    std::vector<int> faceSizes;                 ///< number of corners of each face
+    std::vector<int> faceIndices;               ///< position, texcoord and normal index of each corner
+    std::vector<std::size_t> relativeIndices;   ///< faceIndices given relatively to the end of the lists, which must be shifted by the size of the previous chunks
+    std::vector<std::string> invalidIndices;
+    std::vector<Statement> statements;
+};
+
+void parseOBJChunk(const char* begin, const char* end, ObjChunk& chunk)
+{
+    const char* line = begin;
+    while (line != end)
+    {
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', (std::size_t)(end - line)));
+        const char* nextLine = lineEnd ? lineEnd + 1 : end;
+        if (!lineEnd)
+            lineEnd = end;
+
+        const char* keyword = skipBlanks(line, lineEnd);
+        const char* p = skipWord(keyword, lineEnd);
+
+        if (wordIs(keyword, p, "v"))
+        {
+            Vector3 position;
+            position[0] = readReal(p, lineEnd);
+            position[1] = readReal(p, lineEnd);
+            position[2] = readReal(p, lineEnd);
+            chunk.positions.push_back(position);
+        }
+        else if (wordIs(keyword, p, "vn"))
+        {
+            Vector3 normal;
+            normal[0] = readReal(p, lineEnd);
+            normal[1] = readReal(p, lineEnd);
+            normal[2] = readReal(p, lineEnd);
+            chunk.normals.push_back(normal);
+        }
+        else if (wordIs(keyword, p, "vt"))
+        {
+            Vector2 texCoord;
+            texCoord[0] = readReal(p, lineEnd);
+            texCoord[1] = readReal(p, lineEnd);
+            chunk.texCoords.push_back(texCoord);
+        }
+        else if (wordIs(keyword, p, "l") || wordIs(keyword, p, "f"))
+        {
+            int nbCorners = 0;
+            for (const char* corner = skipBlanks(p, lineEnd); corner != lineEnd; corner = skipBlanks(p, lineEnd))
+            {
+                p = skipWord(corner, lineEnd);
+                // position/texcoord/normal
+                const char* field = corner;
+                for (int j = 0; j < 3; j++)
+                {
+                    const char* fieldEnd = field;
+                    while (fieldEnd != p && *fieldEnd != '/') ++fieldEnd;
+
+                    int index = -1;
+                    if (fieldEnd != field)
+                    {
+                        index = readIndex(field, fieldEnd);
+                        if (index >= 1)
+                            index -= 1; // -1 because the numerotation begins at 1 and a vector begins at 0
+                        else if (index < 0)
+                        {
+                            index += (int)((j==0) ? chunk.positions.size() : (j==1) ? chunk.texCoords.size() : chunk.normals.size());
+                            chunk.relativeIndices.push_back(chunk.faceIndices.size());
+                        }
+                        else
+                        {
+                            chunk.invalidIndices.push_back(std::string(field, fieldEnd));
+                            index = -1;
+                        }
+                    }
+                    chunk.faceIndices.push_back(index);
+                    field = (fieldEnd == p) ? p : fieldEnd + 1;
+                }
+                ++nbCorners;
+            }
+            chunk.faceSizes.push_back(nbCorners);
+        }
+        else if (wordIs(keyword, p, "mtllib") || wordIs(keyword, p, "usemtl") || wordIs(keyword, p, "g"))
+        {
+            ObjChunk::Statement statement = { chunk.faceSizes.size(), keyword, p, lineEnd };
+            chunk.statements.push_back(statement);
+        }
+
+        line = nextLine;
+    }
+}
+
+} // namespace
+
 bool MeshObjLoader::readOBJ (std::ifstream &file, const char* filename)
 {
- 
+    const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return readOBJ(content.data(), content.data() + content.size(), filename);
+}
+
+bool MeshObjLoader::readOBJ (const char* begin, const char* end, const char* filename)
+{
+    helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
     const bool handleSeams = d_handleSeams.getValue();
     helper::vector<sofa::defaulttype::Vector3>& my_positions = *(d_positions.beginEdit());
     helper::vector<sofa::defaulttype::Vector2>& my_texCoords = *(texCoordsList.beginEdit());
@@ -182,8 +391,6 @@ bool MeshObjLoader::readOBJ (std::ifstream &file, const char* filename)
     d_trianglesGroups.beginEdit()->clear(); d_trianglesGroups.endEdit();
     d_quadsGroups.beginEdit()->clear(); d_quadsGroups.endEdit();
 
-    int vtn[3];
-    Vector3 result;
     helper::WriteAccessor<Data<helper::vector< PrimitiveGroup> > > my_faceGroups[NBFACETYPE] =
     {
         d_edgesGroups,
@@ -195,129 +402,124 @@ bool MeshObjLoader::readOBJ (std::ifstream &file, const char* filename)
     int curMaterialId = -1;
     int nbFaces[NBFACETYPE] = {0}; // number of edges, triangles, quads
     int groupF0[NBFACETYPE] = {0}; // first primitives indices in current group for edges, triangles, quads
-    std::string line;
-    while( std::getline(file,line) )
+    // Split the file in chunks of whole lines, which are parsed concurrently
+    std::size_t nbChunks = 1;
+#ifdef _OPENMP
+    const std::size_t minChunkSize = 1 << 20;
+    nbChunks = std::max<std::size_t>(1, std::min<std::size_t>((std::size_t)omp_get_max_threads(), (std::size_t)(end - begin) / minChunkSize));
+#endif
+    std::vector<const char*> chunkBegin(nbChunks + 1, end);
+    chunkBegin[0] = begin;
+    for (std::size_t c = 1; c < nbChunks; ++c)
     {
-        if (line.empty()) continue;
-        std::istringstream values(line);
-        std::string token;
-        values >> token;
+        const char* p = std::max(chunkBegin[c-1], begin + (std::size_t)(end - begin) * c / nbChunks);
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', (std::size_t)(end - p)));
+        chunkBegin[c] = lineEnd ? lineEnd + 1 : end;
+    }
 
-        if (token == "#")
-        {
-            // comment
-        }
-        else if (token == "v")
-        {
-            // vertex
-            values >> result[0] >> result[1] >> result[2];
-            my_positions.push_back(Vector3(result[0],result[1], result[2]));
-        }
-        else if (token == "vn")
+    std::vector<ObjChunk> chunks(nbChunks);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (helper::IndexOpenMP<std::size_t>::type c = 0; c < nbChunks; ++c)
+    {
+        parseOBJChunk(chunkBegin[c], chunkBegin[c+1], chunks[c]);
+    }
+
+    // Merge the chunks in file order
+    std::vector<std::string> words;
+    for (std::size_t c = 0; c < nbChunks; ++c)
+    {
+        ObjChunk& chunk = chunks[c];
+
+        const int sizeBefore[3] = { (int)my_positions.size(), (int)my_texCoords.size(), (int)my_normals.size() };
+        for (std::size_t i = 0; i < chunk.relativeIndices.size(); ++i)
         {
-            // normal 
-            values >> result[0] >> result[1] >> result[2];
-            my_normals.push_back(Vector3(result[0],result[1], result[2]));
+            const std::size_t k = chunk.relativeIndices[i];
+            chunk.faceIndices[k] += sizeBefore[k % 3];
         }
-        else if (token == "vt")
+        for (std::size_t i = 0; i < chunk.invalidIndices.size(); ++i)
         {
-            // texcoord
-            values >> result[0] >> result[1];
-            my_texCoords.push_back(Vector2(result[0],result[1]));
+            msg_error() << "Invalid index " << chunk.invalidIndices[i];
         }
-        else if ((token == "mtllib") && loadMaterial.getValue())
+
+        my_positions.insert(my_positions.end(), chunk.positions.begin(), chunk.positions.end());
+        my_normals.insert(my_normals.end(), chunk.normals.begin(), chunk.normals.end());
+        my_texCoords.insert(my_texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+        helper::vector<Vector3>().swap(chunk.positions);
+        helper::vector<Vector3>().swap(chunk.normals);
+        helper::vector<Vector2>().swap(chunk.texCoords);
+
+        std::size_t corner = 0;
+        std::size_t s = 0;
+        for (std::size_t f = 0; f <= chunk.faceSizes.size(); ++f)
         {
-            while (!values.eof())
+            for (; s < chunk.statements.size() && chunk.statements[s].nbFacesBefore == f; ++s)
             {
-                std::string materialLibaryName;
-                values >> materialLibaryName;
-                std::string mtlfile = sofa::helper::system::SetDirectory::GetRelativeFromFile(materialLibaryName.c_str(), filename);
-                this->readMTL(mtlfile.c_str(), my_materials);
-            }
-        }
-        else if (token == "usemtl" || token == "g")
-        {
-            // end of current group
-            //curGroup.nbp = nbf - curGroup.p0;
-            for (int ft = 0; ft < NBFACETYPE; ++ft)
-                if (nbFaces[ft] > groupF0[ft])
+                const ObjChunk::Statement& statement = chunk.statements[s];
+                readWords(statement.keywordEnd, statement.lineEnd, words);
+
+                if (wordIs(statement.keyword, statement.keywordEnd, "mtllib"))
                 {
-                    my_faceGroups[ft].push_back(PrimitiveGroup(groupF0[ft], nbFaces[ft]-groupF0[ft], curMaterialName, curGroupName, curMaterialId));
-                    groupF0[ft] = nbFaces[ft];
+                    if (!loadMaterial.getValue())
+                        continue;
+                    for (std::size_t w = 0; w < words.size(); ++w)
+                    {
+                        std::string mtlfile = sofa::helper::system::SetDirectory::GetRelativeFromFile(words[w].c_str(), filename);
+                        this->readMTL(mtlfile.c_str(), my_materials);
+                    }
+                    continue;
                 }
-            if (token == "usemtl")
-            {
-                values >> curMaterialName;
-                curMaterialId = -1;
-                helper::vector<Material>::iterator it = my_materials.begin();
-                helper::vector<Material>::iterator itEnd = my_materials.end();
-                for (; it != itEnd; ++it)
+
+                // usemtl or g: end of current group
+                for (int ft = 0; ft < NBFACETYPE; ++ft)
+                    if (nbFaces[ft] > groupF0[ft])
+                    {
+                        my_faceGroups[ft].push_back(PrimitiveGroup(groupF0[ft], nbFaces[ft]-groupF0[ft], curMaterialName, curGroupName, curMaterialId));
+                        groupF0[ft] = nbFaces[ft];
+                    }
+                if (wordIs(statement.keyword, statement.keywordEnd, "usemtl"))
                 {
-                    if (it->name == curMaterialName)
+                    if (!words.empty() && !words[0].empty())
+                        curMaterialName = words[0];
+                    curMaterialId = -1;
+                    helper::vector<Material>::iterator it = my_materials.begin();
+                    helper::vector<Material>::iterator itEnd = my_materials.end();
+                    for (; it != itEnd; ++it)
                     {
-                        (*it).activated = true;
-                        if (!material.activated)
-                            material = *it;
-                        curMaterialId = it - my_materials.begin();
-                        break;
+                        if (it->name == curMaterialName)
+                        {
+                            (*it).activated = true;
+                            if (!material.activated)
+                                material = *it;
+                            curMaterialId = it - my_materials.begin();
+                            break;
+                        }
                     }
                 }
-            }
-            else if (token == "g")
-            {
-                curGroupName.clear();
-                while (!values.eof())
+                else
                 {
-                    std::string g;
-                    values >> g;
-                    if (!curGroupName.empty())
-                        curGroupName += " ";
-                    curGroupName += g;
+                    curGroupName.clear();
+                    for (std::size_t w = 0; w < words.size(); ++w)
+                    {
+                        if (!curGroupName.empty())
+                            curGroupName += " ";
+                        curGroupName += words[w];
+                    }
                 }
             }
-        }
-        else if (token == "l" || token == "f")
-        {
+            if (f == chunk.faceSizes.size())
+                break;
+
             // face
             nodes.clear();
             nIndices.clear();
             tIndices.clear();
-
-            while (!values.eof())
+            for (int i = 0; i < chunk.faceSizes[f]; ++i, corner += 3)
             {
-                std::string face;
-                values >> face;
-                if (face.empty()) continue;
-                for (int j = 0; j < 3; j++)
-                {
-                    vtn[j] = -1;
-                    std::string::size_type pos = face.find('/');
-                    std::string tmp = face.substr(0, pos);
-                    if (pos == std::string::npos)
-                        face = "";
-                    else
-                    {
-                        face = face.substr(pos + 1);
-                    }
-
-                    if (!tmp.empty())
-                    {
-                        vtn[j] = atoi(tmp.c_str());
-                        if (vtn[j] >= 1)
-                            vtn[j] -=1; // -1 because the numerotation begins at 1 and a vector begins at 0
-                        else if (vtn[j] < 0)
-                            vtn[j] += (j==0) ? my_positions.size() : (j==1) ? my_texCoords.size() : my_normals.size();
-                        else
-                        {
-                            msg_error() << "Invalid index " << tmp;
-                            vtn[j] = -1;
-                        }
-                    }
-                }
-
-                nodes.push_back(vtn[0]);
-                tIndices.push_back(vtn[1]);
-                nIndices.push_back(vtn[2]);
+                nodes.push_back(chunk.faceIndices[corner]);
+                tIndices.push_back(chunk.faceIndices[corner+1]);
+                nIndices.push_back(chunk.faceIndices[corner+2]);
             }
 
             my_faceList.push_back(nodes);
@@ -355,11 +557,6 @@ bool MeshObjLoader::readOBJ (std::ifstream &file, const char* filename)
                 ++nbFaces[MeshObjLoader::TRIANGLE];
                 faceType = MeshObjLoader::TRIANGLE;
             }
-
-        }
-        else
-        {
-            // std::cerr << "readObj : Unknown token for line " << line << std::endl;
         }
     }
 
@@ -57,6 +57,9 @@ public:
 
 protected:
     bool readOBJ (std::ifstream &file, const char* filename);
+    /// Parse the content of an OBJ file held in memory (not necessarily null-terminated).
+    /// When OpenMP is enabled, large files are split in chunks of lines parsed concurrently.
+    bool readOBJ (const char* begin, const char* end, const char* filename);
     bool readMTL (const char* filename, helper::vector <sofa::helper::types::Material>& materials);
     void addGroup (const sofa::core::loader::PrimitiveGroup& g);
 
@@ -26,6 +26,7 @@
 #include <sofa/core/ObjectFactory.h>
 #include <SofaLoader/MeshVTKLoader.h>
 #include <sofa/core/visual/VisualParams.h>
+#include <sofa/helper/io/MappedFile.h>
 
 #include <SofaLoader/BaseVTKReader.h>
 using sofa::component::loader::BaseVTKReader ;
@@ -569,11 +570,15 @@ bool MeshVTKLoader::setInputsData()
 //Legacy VTK Loader
 bool LegacyVTKReader::readFile(const char* filename)
 {
-    std::ifstream inVTKFile(filename, std::ifstream::in | std::ifstream::binary);
-    if( !inVTKFile.is_open() )
+    // The file is mapped in memory, so that the data arrays can be read in place
+    // (see VTKDataIO::read)
+    helper::io::MappedFile mappedFile(filename);
+    if( !mappedFile.isOpen() )
     {
         return false;
     }
+    helper::io::MemoryStreamBuf buffer(mappedFile.begin(), mappedFile.end());
+    std::istream inVTKFile(&buffer);
 
     string line;
 
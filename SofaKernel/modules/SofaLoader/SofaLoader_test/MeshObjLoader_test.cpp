@@ -21,9 +21,14 @@
 ******************************************************************************/
 
 #include <sofa/helper/system/FileRepository.h>
+#include <sofa/helper/system/FileSystem.h>
 #include <SofaTest/Sofa_test.h>
 
+#include <boost/filesystem.hpp>
+#include <fstream>
+
 #include <SofaLoader/MeshObjLoader.h>
+#include <sofa/core/loader/LoadedDataStorage.h>
 
 #include <sofa/helper/BackTrace.h>
 using sofa::helper::BackTrace ;
@@ -97,5 +102,166 @@ TEST_F(MeshObjLoader_test, LoadCall)
     loadTest("mesh/torus.obj", 800, 0, 1600,  0, 0, 0, 0, 0, 0, 861, 0);
 }
 
+/** MeshObjLoader::readOBJ()
+ * Parse a file held in memory, with relative indices, groups and mixed line endings
+ */
+TEST_F(MeshObjLoader_test, ReadFromMemory)
+{
+    const std::string content =
+            "# comment\n"
+            "v 0 0 0\r\n"
+            "v 1 0 0\r\n"
+            "v 1 1 0\n"
+            "v 0 1 0\n"
+            "vt 0.5 0.25\n"
+            "g first group\n"
+            "f 1/1 2/1 3/1\r\n"
+            "f -4 -2 -1\n"
+            "\n"
+            "g second\n"
+            "f 1 2 3 4\n"
+            "l 2 1";
+
+    EXPECT_TRUE(this->readOBJ(content.data(), content.data() + content.size(), ""));
+
+    ASSERT_EQ(4u, this->d_positions.getValue().size());
+    EXPECT_EQ(defaulttype::Vector3(1, 1, 0), this->d_positions.getValue()[2]);
+    ASSERT_EQ(1u, this->texCoordsList.getValue().size());
+    EXPECT_EQ(defaulttype::Vector2(0.5, 0.25), this->texCoordsList.getValue()[0]);
+
+    ASSERT_EQ(2u, this->d_triangles.getValue().size());
+    EXPECT_EQ(0u, this->d_triangles.getValue()[1][0]);
+    EXPECT_EQ(2u, this->d_triangles.getValue()[1][1]);
+    EXPECT_EQ(3u, this->d_triangles.getValue()[1][2]);
+    ASSERT_EQ(1u, this->d_quads.getValue().size());
+    EXPECT_EQ(3u, this->d_quads.getValue()[0][3]);
+    ASSERT_EQ(1u, this->d_edges.getValue().size());
+    EXPECT_EQ(0u, this->d_edges.getValue()[0][0]);
+    EXPECT_EQ(1u, this->d_edges.getValue()[0][1]);
+
+    ASSERT_EQ(1u, this->d_trianglesGroups.getValue().size());
+    EXPECT_EQ("first group", this->d_trianglesGroups.getValue()[0].groupName);
+    ASSERT_EQ(1u, this->d_quadsGroups.getValue().size());
+    EXPECT_EQ("second", this->d_quadsGroups.getValue()[0].groupName);
+}
+
+/** MeshObjLoader::readOBJ()
+ * The infinities, NaNs and hexadecimal floats accepted by strtod are not read as numbers
+ */
+TEST_F(MeshObjLoader_test, ReadNonDecimalReals)
+{
+    const std::string content =
+            "v inf -nan 0x1p3\n"
+            "v 1.5 -2e1 +.25\n";
+
+    EXPECT_TRUE(this->readOBJ(content.data(), content.data() + content.size(), ""));
+
+    ASSERT_EQ(2u, this->d_positions.getValue().size());
+    EXPECT_EQ(defaulttype::Vector3(0, 0, 0), this->d_positions.getValue()[0]);
+    EXPECT_EQ(defaulttype::Vector3(1.5, -20, 0.25), this->d_positions.getValue()[1]);
+}
+
+/** MeshLoader::loadWithCache()
+ * Check that the mesh read back from the binary cache is the one loaded from the file
+ */
+TEST_F(MeshObjLoader_test, BinaryCache)
+{
+    using sofa::helper::system::FileSystem;
+    const std::string filename = boost::filesystem::temp_directory_path().string() + "/MeshObjLoader_test_cache.obj";
+    {
+        std::ofstream file(filename.c_str());
+        file << "v 0 0 0\n" "v 1 0 0\n" "v 1 1 0\n" "v 0 1 0\n"
+             << "g first group\n" "f 1 2 3\n" "f 1 3 4\n"
+             << "g second\n" "f 1 2 3 4\n";
+    }
+    // the cache is written in its own directory, created if needed
+    const std::string cacheDirectory = boost::filesystem::temp_directory_path().string() + "/MeshObjLoader_test_cache";
+    FileSystem::removeAll(cacheDirectory);
+    this->setFilename(filename);
+    this->d_useCache.setValue(true);
+    this->d_cacheDirectory.setValue(cacheDirectory);
+    const std::string key = this->getCacheKey();
+
+    ASSERT_TRUE(this->loadWithCache());
+    ASSERT_TRUE(FileSystem::exists(this->getCacheFilename()));
+    EXPECT_EQ(cacheDirectory, FileSystem::getParentDirectory(this->getCacheFilename()));
+    const helper::vector<defaulttype::Vector3> positions = this->d_positions.getValue();
+    const helper::vector<Triangle> triangles = this->d_triangles.getValue();
+
+    this->d_positions.setValue(helper::vector<defaulttype::Vector3>());
+    this->d_triangles.setValue(helper::vector<Triangle>());
+    this->d_quads.setValue(helper::vector<Quad>());
+    this->d_trianglesGroups.setValue(helper::vector<core::loader::PrimitiveGroup>());
+
+    EXPECT_FALSE(this->readCache("another key"));
+    ASSERT_TRUE(this->readCache(key));
+    EXPECT_EQ(positions, this->d_positions.getValue());
+    ASSERT_EQ(triangles.size(), this->d_triangles.getValue().size());
+    for (std::size_t i = 0; i < triangles.size(); ++i)
+        for (std::size_t j = 0; j < 3; ++j)
+            EXPECT_EQ(triangles[i][j], this->d_triangles.getValue()[i][j]);
+    EXPECT_EQ(1u, this->d_quads.getValue().size());
+    ASSERT_EQ(1u, this->d_trianglesGroups.getValue().size());
+    EXPECT_EQ("first group", this->d_trianglesGroups.getValue()[0].groupName);
+    EXPECT_EQ(2, this->d_trianglesGroups.getValue()[0].nbp);
+
+    FileSystem::removeAll(cacheDirectory);
+    FileSystem::removeAll(filename);
+}
+
+/** MeshLoader::loadShared()
+ * Check that loaders of the same file share their values, until one of them modifies them
+ */
+TEST_F(MeshObjLoader_test, SharedData)
+{
+    using sofa::helper::system::FileSystem;
+    using sofa::core::loader::LoadedDataStorage;
+    using sofa::core::objectmodel::BaseObjectDescription;
+    const std::string filename = boost::filesystem::temp_directory_path().string() + "/MeshObjLoader_test_shared.obj";
+    {
+        std::ofstream file(filename.c_str());
+        file << "v 0 0 0\n" "v 1 0 0\n" "v 1 1 0\n" "v 0 1 0\n" "f 1 2 3\n" "f 1 3 4\n";
+    }
+    const std::size_t nbEntries = LoadedDataStorage::getInstance().size();
+
+    BaseObjectDescription desc("loader", "MeshObjLoader");
+    desc.setAttribute("filename", filename.c_str());
+    desc.setAttribute("shareData", "true");
+
+    MeshObjLoader::SPtr first = sofa::core::objectmodel::New<MeshObjLoader>();
+    MeshObjLoader::SPtr second = sofa::core::objectmodel::New<MeshObjLoader>();
+    first->parse(&desc);
+    second->parse(&desc);
+    EXPECT_EQ(nbEntries + 1, LoadedDataStorage::getInstance().size());
+
+    ASSERT_EQ(4u, first->d_positions.getValue().size());
+    ASSERT_EQ(2u, second->d_triangles.getValue().size());
+    EXPECT_EQ(&first->d_positions.getValue(), &second->d_positions.getValue());
+    EXPECT_EQ(&first->d_triangles.getValue(), &second->d_triangles.getValue());
+
+    // a loader with other parameters does not share the values
+    desc.setAttribute("flipNormals", "true");
+    MeshObjLoader::SPtr flipped = sofa::core::objectmodel::New<MeshObjLoader>();
+    flipped->parse(&desc);
+    EXPECT_NE(&first->d_triangles.getValue(), &flipped->d_triangles.getValue());
+    EXPECT_EQ(nbEntries + 2, LoadedDataStorage::getInstance().size());
+
+    // copy on write
+    {
+        helper::WriteAccessor< Data< helper::vector<defaulttype::Vector3> > > positions = second->d_positions;
+        positions[0] = defaulttype::Vector3(2, 2, 2);
+    }
+    EXPECT_NE(&first->d_positions.getValue(), &second->d_positions.getValue());
+    EXPECT_EQ(defaulttype::Vector3(0, 0, 0), first->d_positions.getValue()[0]);
+    EXPECT_EQ(defaulttype::Vector3(2, 2, 2), second->d_positions.getValue()[0]);
+
+    first.reset();
+    second.reset();
+    flipped.reset();
+    EXPECT_EQ(nbEntries, LoadedDataStorage::getInstance().size());
+
+    FileSystem::removeAll(filename);
+}
+
 } // namespace meshobjloader_test
 } // namespace sofa
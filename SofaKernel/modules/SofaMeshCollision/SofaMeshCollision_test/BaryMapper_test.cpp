@@ -41,6 +41,7 @@ struct BaryMapperTest  : public ::testing::Test{
 
     bool test_inside(SReal alpha,SReal beta);
     bool test_outside(int index);
+    bool test_manyPoints(bool floatWeights);
     void initTriPts();
 
     VecCoord triPts;
@@ -137,12 +138,67 @@ bool BaryMapperTest::test_outside(int index){
     return equal(triPts[index],res[0]);
 }
 
+bool BaryMapperTest::test_manyPoints(bool floatWeights){
+    initTriPts();
+    sofa::simulation::Node::SPtr father = New<sofa::simulation::tree::GNode>();
+    MeshTopology * topo = initMesh(father);
+    component::mapping::BarycentricMapperMeshTopology<DataTypes, DataTypes>::SPtr mapper = sofa::core::objectmodel::New<component::mapping::BarycentricMapperMeshTopology<DataTypes, DataTypes> >(topo,(component::topology::PointSetTopologyContainer*)0x0);
+
+    helper::StateMask maskFrom, maskTo;
+    maskFrom.assign( triPts.size(), true );
+
+    mapper->maskFrom = &maskFrom;
+    mapper->maskTo = &maskTo;
+    mapper->setFloatWeights(floatWeights);
+
+    // enough points to apply the mapping concurrently when OpenMP is enabled
+    const unsigned int n = 3000;
+    VecCoord points(n), forces(n);
+    Vector3 expectedJT[3];
+    for (unsigned int i=0; i<n; ++i)
+    {
+        const SReal alpha = (SReal)(i%50)/100, beta = (SReal)(i/50)/200; // inside the triangle
+        points[i] = ((SReal)(1.0) - alpha - beta) * triPts[0] + alpha * triPts[1] + beta * triPts[2];
+        forces[i] = Vector3((SReal)i, (SReal)1, -(SReal)(i%7));
+        expectedJT[0] += forces[i] * ((SReal)(1.0) - alpha - beta);
+        expectedJT[1] += forces[i] * alpha;
+        expectedJT[2] += forces[i] * beta;
+        mapper->createPointInTriangle( points[i], 0, &triPts );
+    }
+    maskTo.assign( n, true );
+
+    const SReal t = floatWeights ? (SReal)1e-5 : tol;
+
+    VecCoord res;
+    mapper->apply ( res, triPts );
+    if (res.size() != n) return false;
+    for (unsigned int i=0; i<n; ++i)
+        if ((points[i]-res[i]).norm() > t) return false;
+
+    VecCoord dx(n);
+    mapper->applyJ ( dx, triPts );
+    for (unsigned int i=0; i<n; ++i)
+        if ((points[i]-dx[i]).norm() > t) return false;
+
+    VecCoord f(3);
+    mapper->applyJT ( f, forces );
+    for (unsigned int j=0; j<3; ++j)
+        if ((expectedJT[j]-f[j]).norm() > t * expectedJT[j].norm()) return false;
+
+    // the weights are updated when points are added
+    mapper->createPointInTriangle( triPts[1], 0, &triPts );
+    mapper->apply ( res, triPts );
+    return res.size() == n+1 && equal(triPts[1],res[n]);
+}
+
 TEST_F(BaryMapperTest, alpha0dot3_beta0dot2 ) { ASSERT_TRUE( test_inside((SReal)(0.3),(SReal)(0.2))); }
 TEST_F(BaryMapperTest, alpha0dot4_beta0dot6 ) { ASSERT_TRUE( test_inside((SReal)(0.4),(SReal)(0.6))); }
 TEST_F(BaryMapperTest, alpha0_beta0 ) { ASSERT_TRUE( test_inside((SReal)(0),(SReal)(0))); }
 TEST_F(BaryMapperTest, out_0 ) { ASSERT_TRUE( test_outside(0)); }
 TEST_F(BaryMapperTest, out_1 ) { ASSERT_TRUE( test_outside(1)); }
 TEST_F(BaryMapperTest, out_2 ) { ASSERT_TRUE( test_outside(2)); }
+TEST_F(BaryMapperTest, manyPoints ) { ASSERT_TRUE( test_manyPoints(false)); }
+TEST_F(BaryMapperTest, manyPoints_floatWeights ) { ASSERT_TRUE( test_manyPoints(true)); }
 
 
 }
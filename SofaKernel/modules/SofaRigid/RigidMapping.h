@@ -110,6 +110,8 @@ protected:
     virtual ~RigidMapping() {}
 
     unsigned int getRigidIndex( unsigned int pointIndex ) const;
+    /// The index of the rigid of each mapped point, or NULL if all the points are mapped from getRigidIndex(0)
+    const unsigned int* getRigidIndices() const;
 
 public:
     int addPoint(const Coord& c);
@@ -160,6 +162,14 @@ protected:
     std::unique_ptr<MatrixType> matrixJ;
     bool updateJ;
 
+    /// Below this number of mapped points, the mapping is applied sequentially
+    enum { ParallelMinSize = 1024 };
+
+    typedef defaulttype::Mat<N, N, InReal> InRotation;
+    helper::vector<InRotation> rotations;         ///< rotation matrices of the input frames, updated by apply
+    helper::vector<InVecDeriv> threadForces;      ///< partial sums of applyJT computed by each thread
+    helper::vector<helper::vector<char> > threadMasks; ///< input frames receiving a partial sum of each thread
+
     typedef linearsolver::EigenSparseMatrix<In,Out> SparseMatrixEigen;
     SparseMatrixEigen eigenJacobian;                      ///< Jacobian of the mapping used by getJs
     helper::vector<sofa::defaulttype::BaseMatrix*> eigenJacobians; /// used by getJs
@@ -35,6 +35,7 @@
 #include <sofa/helper/io/SphereLoader.h>
 #include <sofa/helper/io/Mesh.h>
 #include <sofa/helper/decompose.h>
+#include <sofa/helper/IndexOpenMP.h>
 
 #include <sofa/simulation/Simulation.h>
 
@@ -44,6 +45,10 @@
 #include <numeric>
 #include <istream>
 
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
 namespace sofa
 {
 
@@ -153,6 +158,14 @@ unsigned int RigidMapping<TIn, TOut>::getRigidIndex( unsigned int pointIndex ) c
     }
 }
 
+template <class TIn, class TOut>
+const unsigned int* RigidMapping<TIn, TOut>::getRigidIndices() const
+{
+    const helper::vector<unsigned int>& indices = rigidIndexPerPoint.getValue();
+    if( !indices.empty() && points.getValue().size() == indices.size() ) return &indices[0];
+    return NULL;
+}
+
 template <class TIn, class TOut>
 int RigidMapping<TIn, TOut>::addPoint(const Coord& c)
 {
@@ -343,12 +356,38 @@ void RigidMapping<TIn, TOut>::apply(const core::MechanicalParams * /*mparams*/,
     rotatedPoints.resize(pts.size());
     out.resize(pts.size());
 
-    for (unsigned int i = 0; i < pts.size(); i++)
+    const unsigned int* rigidIndices = getRigidIndices();
+    const unsigned int constantIndex = rigidIndices ? 0 : getRigidIndex(0);
+    const helper::IndexOpenMP<unsigned int>::type size = (unsigned int)pts.size();
+
+    // the rotations are computed once per frame, so that the mapping of a point
+    // is a matrix product (the same operations as Quater::rotate)
+    rotations.resize(in.size());
+    if( rigidIndices )
     {
-        unsigned int rigidIndex = getRigidIndex(i);
+        for (unsigned int r = 0; r < in.size(); r++)
+            in[r].writeRotationMatrix( rotations[r] );
+    }
+    else if( size > 0 )
+        in[constantIndex].writeRotationMatrix( rotations[constantIndex] );
 
-        rotatedPoints[i] = in[rigidIndex].rotate( pts[i] );
-        out[i] = in[rigidIndex].translate( rotatedPoints[i] );
+#ifdef _OPENMP
+#pragma omp parallel for if(size >= ParallelMinSize)
+#endif
+    for (helper::IndexOpenMP<unsigned int>::type i = 0; i < size; i++)
+    {
+        const unsigned int rigidIndex = rigidIndices ? rigidIndices[i] : constantIndex;
+        const InRotation& m = rotations[rigidIndex];
+        const Coord& p = pts[i];
+        Coord& r = rotatedPoints[i];
+        for (int k = 0; k < N; k++)
+        {
+            InReal v = m[k][0]*p[0];
+            for (int j = 1; j < N; j++)
+                v += m[k][j]*p[j];
+            r[k] = (Real)v;
+        }
+        out[i] = in[rigidIndex].translate( r );
     }
 
     //    cerr<<"RigidMapping<TIn, TOut>::apply, " << this->getName() << endl;
@@ -366,11 +405,20 @@ void RigidMapping<TIn, TOut>::applyJ(const core::MechanicalParams * /*mparams*/,
     const VecCoord& pts = this->getPoints();
     out.resize(pts.size());
 
-    for( size_t i=0 ; i<this->maskTo->size() ; ++i)
+    const unsigned int* rigidIndices = getRigidIndices();
+    const unsigned int constantIndex = rigidIndices ? 0 : getRigidIndex(0);
+    const ForceMask& mask = *this->maskTo;
+    const bool masked = mask.isActivated();
+    const helper::IndexOpenMP<unsigned int>::type size = (unsigned int)mask.size();
+
+#ifdef _OPENMP
+#pragma omp parallel for if(size >= ParallelMinSize)
+#endif
+    for( helper::IndexOpenMP<unsigned int>::type i=0 ; i<size ; ++i)
     {
-        if( this->maskTo->isActivated() && !this->maskTo->getEntry(i) ) continue;
+        if( masked && !mask.getEntry(i) ) continue;
 
-        unsigned int rigidIndex = getRigidIndex(i);
+        const unsigned int rigidIndex = rigidIndices ? rigidIndices[i] : constantIndex;
         out[i] = velocityAtRotatedPoint( in[rigidIndex], rotatedPoints[i] );
     }
 }
@@ -382,12 +430,59 @@ void RigidMapping<TIn, TOut>::applyJT(const core::MechanicalParams * /*mparams*/
     helper::ReadAccessor< Data<VecDeriv> > in = dIn;
 
     ForceMask &mask = *this->maskFrom;
+    const ForceMask& maskTo = *this->maskTo;
 
-    for( size_t i=0 ; i<this->maskTo->size() ; ++i)
+    const unsigned int* rigidIndices = getRigidIndices();
+    const unsigned int constantIndex = rigidIndices ? 0 : getRigidIndex(0);
+    const unsigned int size = (unsigned int)maskTo.size();
+
+#ifdef _OPENMP
+    const unsigned int nbThreads = (unsigned int)omp_get_max_threads();
+    if( size >= ParallelMinSize && nbThreads > 1 )
     {
-        if( !this->maskTo->getEntry(i) ) continue;
+        // each thread accumulates the forces of a range of points, then the sums are reduced per frame
+        threadForces.resize(nbThreads);
+        threadMasks.resize(nbThreads);
+#pragma omp parallel
+        {
+            const unsigned int t = (unsigned int)omp_get_thread_num();
+            InVecDeriv& forces = threadForces[t];
+            helper::vector<char>& touched = threadMasks[t];
+            forces.assign(out.size(), InDeriv());
+            touched.assign(out.size(), 0);
+#pragma omp for
+            for( helper::IndexOpenMP<unsigned int>::type i=0 ; i<(helper::IndexOpenMP<unsigned int>::type)size ; ++i)
+            {
+                if( !maskTo.getEntry(i) ) continue;
 
-        unsigned int rigidIndex = getRigidIndex(i);
+                const unsigned int rigidIndex = rigidIndices ? rigidIndices[i] : constantIndex;
+
+                getVCenter(forces[rigidIndex]) += in[i];
+                getVOrientation(forces[rigidIndex]) += (typename InDeriv::Rot)cross(rotatedPoints[i], in[i]);
+                touched[rigidIndex] = 1;
+            }
+        }
+        for( unsigned int t=0 ; t<nbThreads ; ++t)
+        {
+            // the threads of the team may be less than the maximum
+            if( threadMasks[t].size() != out.size() ) continue;
+            for( unsigned int r=0 ; r<out.size() ; ++r)
+            {
+                if( !threadMasks[t][r] ) continue;
+                out[r] += threadForces[t][r];
+                mask.insertEntry(r);
+            }
+            threadMasks[t].clear();
+        }
+        return;
+    }
+#endif
+
+    for( unsigned int i=0 ; i<size ; ++i)
+    {
+        if( !maskTo.getEntry(i) ) continue;
+
+        const unsigned int rigidIndex = rigidIndices ? rigidIndices[i] : constantIndex;
 
         getVCenter(out[rigidIndex]) += in[i];
         getVOrientation(out[rigidIndex]) += (typename InDeriv::Rot)cross(rotatedPoints[i], in[i]);
@@ -680,6 +775,9 @@ void RigidMapping<TIn, TOut>::updateK( const core::MechanicalParams* mparams, co
     for(unsigned i = 0, n = rotatedPoints.size(); i < n; ++i)
         in_out[ getRigidIndex(i) ].push_back(i);
 
+    // the rows must all be started in order, including the empty ones
+    unsigned nextRow = 0;
+
     for( in_out_type::const_iterator it = in_out.begin(), end = in_out.end() ; it != end; ++it )
     {
         const unsigned rigidIdx = it->first;
@@ -705,7 +803,7 @@ void RigidMapping<TIn, TOut>::updateK( const core::MechanicalParams* mparams, co
 
             const unsigned row = TIn::deriv_total_size * rigidIdx + TIn::spatial_dimensions + j;
 
-            dJ.startVec( row );
+            for( ; nextRow <= row; ++nextRow ) dJ.startVec( nextRow );
 
             for(unsigned k = 0; k < rotation_dimension; ++k) {
                 const unsigned col = TIn::deriv_total_size * rigidIdx + TIn::spatial_dimensions + k;
@@ -715,6 +813,7 @@ void RigidMapping<TIn, TOut>::updateK( const core::MechanicalParams* mparams, co
         }
     }
 
+    for( ; nextRow < insize; ++nextRow ) dJ.startVec( nextRow );
     dJ.finalize();
 }
 
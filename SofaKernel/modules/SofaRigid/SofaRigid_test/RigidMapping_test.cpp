@@ -181,7 +181,44 @@ struct RigidMappingTest : public Mapping_test<_RigidMapping>
         return this->runTest(xin_init,xout,xin,expectedChildCoords);
     }
 
-    /// @todo test with several frames
+    /** Many frames, with many particles given in local coordinates.
+     * The particles are numerous enough to be mapped concurrently when OpenMP is enabled,
+     * and few enough per frame for the sums of their forces to stay accurate.
+    */
+    bool test_manyRigids_manyParticles_localCoords()
+    {
+        const int Nin=64, Nout=2048;
+        this->inDofs->resize(Nin);
+        this->outDofs->resize(Nout);
+
+        rigidMapping->globalToLocalCoords.setValue(false); // initial child positions are given in local coordinates
+        rigidMapping->geometricStiffness.setValue(1); // full unsymmetrized geometric stiffness
+
+        // parent positions
+        InVecCoord xin(Nin);
+        helper::vector<RotationMatrix> m(Nin);
+        for(int r=0; r<Nin; r++ )
+        {
+            InDataTypes::set( xin[r], 0.01*r,-0.02*r,0.3 );
+            InDataTypes::setCRot( xin[r], InDataTypes::rotationEuler(-1.+0.1*r,2.,-0.3*r) );
+            xin[r].writeRotationMatrix(m[r]);
+        }
+
+        // child positions, the particles being interleaved between the frames
+        OutVecCoord xout(Nout), expectedChildCoords(Nout);
+        helper::WriteAccessor<Data<helper::vector<unsigned int> > > rigidIndices = rigidMapping->rigidIndexPerPoint;
+        rigidIndices.resize(Nout);
+        for(int i=0; i<Nout; i++ )
+        {
+            const int r = i%Nin;
+            rigidIndices[i] = r;
+            OutDataTypes::set( xout[i], 0.0005*i, 1.-0.001*i, 0.5 );
+            expectedChildCoords[i] = xin[r].getCenter() + m[r] * xout[i];
+        }
+
+        return this->runTest(xin,xout,xin,expectedChildCoords);
+    }
+
 
 
     ///@}
@@ -211,6 +248,11 @@ TYPED_TEST( RigidMappingTest , oneRigid_fourParticles_worldCoords )
     this->errorMax = 100.; // a larger error occurs, probably due to the world to local mapping at init:
     ASSERT_TRUE(this->test_oneRigid_fourParticles_worldCoords());
 }
+TYPED_TEST( RigidMappingTest , manyRigids_manyParticles_localCoords )
+{
+    this->errorMax = 100.; // the forces of about thirty particles are summed on each frame, with the corresponding rounding errors
+    ASSERT_TRUE(this->test_manyRigids_manyParticles_localCoords());
+}
 
 }//anonymous namespace
 } // namespace sofa
@@ -0,0 +1,472 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include "SceneLoaderSnapshot.h"
+
+#include <sofa/core/BinaryDataIO.h>
+#include <sofa/core/ObjectFactory.h>
+#include <sofa/core/behavior/BaseMechanicalState.h>
+#include <sofa/simulation/Simulation.h>
+#include <sofa/helper/io/MappedFile.h>
+#include <sofa/helper/system/SetDirectory.h>
+#include <sofa/helper/system/Locale.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cstring>
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+// register the loader in the factory
+const SceneLoader* loaderSnapshot = SceneLoaderFactory::getInstance()->addEntry(new SceneLoaderSnapshot());
+
+namespace
+{
+
+using core::BinaryDataWriter;
+using core::BinaryDataReader;
+using core::BinaryDataValue;
+using core::objectmodel::Base;
+using core::objectmodel::BaseData;
+using core::objectmodel::BaseLink;
+using core::objectmodel::BaseObject;
+
+const char snapshotMagic[8] = { 'S', 'O', 'F', 'A', 'S', 'N', 'A', 'P' };
+const uint32_t snapshotVersion = 1;
+const uint32_t snapshotEndianness = 0x01020304;
+
+enum SnapshotChildKind
+{
+    SNAPSHOT_CHILD_NODE = 0,  ///< child node written in place
+    SNAPSHOT_CHILD_PATH = 1   ///< child node with several parents, written under its first parent
+};
+
+/// Same selection as Base::writeDatas(), except that the Data which are not persistent are also
+/// written, as they are typically computed while parsing the scene (e.g. loaded meshes)
+void writeFields(BinaryDataWriter& out, Base* base)
+{
+    const Base::VecData& fields = base->getDataFields();
+    std::vector<const BaseData*> values;
+    std::vector<const BaseData*> parents;
+    for (std::size_t i = 0; i < fields.size(); ++i)
+    {
+        if (!fields[i]->getLinkPath().empty())
+            parents.push_back(fields[i]);
+        else if (fields[i]->isSet())
+            values.push_back(fields[i]);
+    }
+
+    out.write((uint32_t)values.size());
+    for (std::size_t i = 0; i < values.size(); ++i)
+        out.writeData(values[i]);
+
+    out.write((uint32_t)parents.size());
+    for (std::size_t i = 0; i < parents.size(); ++i)
+    {
+        out.write(parents[i]->getName());
+        out.write(parents[i]->getLinkPath());
+    }
+
+    const Base::VecLink& links = base->getLinks();
+    std::vector<const BaseLink*> storedLinks;
+    for (std::size_t i = 0; i < links.size(); ++i)
+        if (links[i]->storePath() && !links[i]->getValueString().empty())
+            storedLinks.push_back(links[i]);
+
+    out.write((uint32_t)storedLinks.size());
+    for (std::size_t i = 0; i < storedLinks.size(); ++i)
+    {
+        out.write(storedLinks[i]->getName());
+        out.write(storedLinks[i]->getValueString());
+    }
+}
+
+void writeNode(BinaryDataWriter& out, Node* node, std::vector<BaseObject::SPtr>& objects)
+{
+    writeFields(out, node);
+
+    out.write((uint32_t)node->object.size());
+    for (Node::ObjectIterator it = node->object.begin(); it != node->object.end(); ++it)
+    {
+        BaseObject* object = it->get();
+        out.write(object->getClassName());
+        out.write(object->getTemplateName());
+        writeFields(out, object);
+        objects.push_back(*it);
+    }
+
+    out.write((uint32_t)node->child.size());
+    for (Node::ChildIterator it = node->child.begin(); it != node->child.end(); ++it)
+    {
+        Node* child = it->get();
+        if (child->getFirstParent() == node)
+        {
+            out.write((uint8_t)SNAPSHOT_CHILD_NODE);
+            writeNode(out, child, objects);
+        }
+        else
+        {
+            out.write((uint8_t)SNAPSHOT_CHILD_PATH);
+            out.write(child->getPathName());
+        }
+    }
+}
+
+bool readFields(BinaryDataReader& in, Base* base)
+{
+    uint32_t nbValues = 0;
+    if (!in.read(nbValues))
+        return false;
+    for (uint32_t i = 0; i < nbValues; ++i)
+    {
+        BinaryDataValue value;
+        if (!in.readData(value))
+            return false;
+        BaseData* data = base->findData(value.name);
+        if (!value.assign(data))
+            msg_warning(base) << "Data " << value.name << " could not be restored from the snapshot.";
+    }
+
+    uint32_t nbParents = 0;
+    if (!in.read(nbParents))
+        return false;
+    for (uint32_t i = 0; i < nbParents; ++i)
+    {
+        std::string name, path;
+        if (!in.read(name) || !in.read(path))
+            return false;
+        BaseData* data = base->findData(name);
+        if (!data || !data->setParent(path))
+            msg_warning(base) << "Data " << name << " could not be linked to " << path;
+    }
+
+    uint32_t nbLinks = 0;
+    if (!in.read(nbLinks))
+        return false;
+    for (uint32_t i = 0; i < nbLinks; ++i)
+    {
+        std::string name, path;
+        if (!in.read(name) || !in.read(path))
+            return false;
+        BaseLink* link = base->findLink(name);
+        if (!link || !link->read(path))
+            msg_warning(base) << "Link " << name << " could not be restored to " << path;
+    }
+    return true;
+}
+
+/// Create an object without parsing any description, its Data are restored afterwards
+BaseObject::SPtr createObject(Node* node, const std::string& className, const std::string& templateName)
+{
+    core::ObjectFactory* factory = core::ObjectFactory::getInstance();
+    if (!factory->hasCreator(className))
+        return NULL;
+
+    core::ObjectFactory::CreatorMap& creators = factory->getEntry(className).creatorMap;
+    core::ObjectFactory::CreatorMap::iterator it = creators.find(templateName);
+    if (it == creators.end())
+    {
+        for (it = creators.begin(); it != creators.end(); ++it)
+            if (it->second->getClass()->templateName == templateName)
+                break;
+    }
+    if (it == creators.end())
+        return NULL;
+    return it->second->createInstance(node, NULL);
+}
+
+struct NodePath
+{
+    Node* parent;
+    std::string path;
+};
+
+bool readNode(BinaryDataReader& in, Node* node, std::vector<BaseObject::SPtr>& objects, std::vector<NodePath>& paths)
+{
+    if (!readFields(in, node))
+        return false;
+
+    uint32_t nbObjects = 0;
+    if (!in.read(nbObjects))
+        return false;
+    for (uint32_t i = 0; i < nbObjects; ++i)
+    {
+        std::string className, templateName;
+        if (!in.read(className) || !in.read(templateName))
+            return false;
+        BaseObject::SPtr object = createObject(node, className, templateName);
+        if (!object)
+        {
+            msg_error("SceneLoaderSnapshot") << "Object type " << className << "<" << templateName << "> was not created";
+            return false;
+        }
+        if (!readFields(in, object.get()))
+            return false;
+        objects.push_back(object);
+    }
+
+    uint32_t nbChildren = 0;
+    if (!in.read(nbChildren))
+        return false;
+    for (uint32_t i = 0; i < nbChildren; ++i)
+    {
+        uint8_t kind = 0;
+        if (!in.read(kind))
+            return false;
+        if (kind == SNAPSHOT_CHILD_NODE)
+        {
+            Node::SPtr child = node->createChild("");
+            if (!readNode(in, child.get(), objects, paths))
+                return false;
+        }
+        else
+        {
+            NodePath nodePath;
+            nodePath.parent = node;
+            if (!in.read(nodePath.path))
+                return false;
+            paths.push_back(nodePath);
+        }
+    }
+    return true;
+}
+
+/// Largest difference between the values of two Data, or infinity if their sizes differ
+double maxDifference(const BaseData* data1, const BaseData* data2)
+{
+    const defaulttype::AbstractTypeInfo* info1 = data1->getValueTypeInfo();
+    const defaulttype::AbstractTypeInfo* info2 = data2->getValueTypeInfo();
+    const void* value1 = data1->getValueVoidPtr();
+    const void* value2 = data2->getValueVoidPtr();
+    const std::size_t size = info1->size(value1);
+    if (size != info2->size(value2))
+        return HUGE_VAL;
+    double diff = 0;
+    for (std::size_t i = 0; i < size; ++i)
+        diff = std::max(diff, std::abs(info1->getScalarValue(value1, i) - info2->getScalarValue(value2, i)));
+    return diff;
+}
+
+} // anonymous namespace
+
+bool SceneLoaderSnapshot::canLoadFileExtension(const char *extension)
+{
+    std::string ext = extension;
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return (ext=="snapshot");
+}
+
+/// get the file type description
+std::string SceneLoaderSnapshot::getFileTypeDesc()
+{
+    return "Scene snapshots";
+}
+
+/// get the list of file extensions
+void SceneLoaderSnapshot::getExtensionList(ExtensionList* list)
+{
+    list->clear();
+    list->push_back("snapshot");
+}
+
+sofa::simulation::Node::SPtr SceneLoaderSnapshot::load(const char *filename)
+{
+    if (!canLoadFileName(filename))
+        return NULL;
+
+    helper::io::MappedFile file;
+    if (!file.open(filename))
+    {
+        msg_error("SceneLoaderSnapshot") << "Cannot read file '" << filename << "'";
+        return NULL;
+    }
+
+    BinaryDataReader in(file.begin(), file.end());
+    const char* magic = in.readBytes(sizeof(snapshotMagic));
+    uint32_t version = 0, endianness = 0;
+    std::string sceneFilename;
+    if (!magic || std::memcmp(magic, snapshotMagic, sizeof(snapshotMagic)) != 0
+            || !in.read(version) || version != snapshotVersion
+            || !in.read(endianness) || endianness != snapshotEndianness
+            || !in.read(sceneFilename))
+    {
+        msg_error("SceneLoaderSnapshot") << "'" << filename << "' is not a snapshot created by this version of SOFA";
+        return NULL;
+    }
+
+    notifyLoadingScene();
+
+    // the file names stored in the Data are relative to the scene file
+    helper::system::SetDirectory chdir(sceneFilename.c_str());
+    helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+    Node::SPtr root = getSimulation()->createNewGraph("");
+    std::vector<BaseObject::SPtr> objects;
+    std::vector<NodePath> paths;
+    bool success = readNode(in, root.get(), objects, paths);
+
+    for (std::size_t i = 0; success && i < paths.size(); ++i)
+    {
+        Node* child = NULL;
+        if (!root->findLinkDest(child, "@" + paths[i].path, NULL) || !child)
+        {
+            msg_error("SceneLoaderSnapshot") << "Node " << paths[i].path << " not found";
+            success = false;
+        }
+        else
+            paths[i].parent->addChild(child);
+    }
+
+    // internal states restored before init()
+    uint32_t nbStates = 0;
+    success = success && in.read(nbStates);
+    for (uint32_t i = 0; success && i < nbStates; ++i)
+    {
+        uint32_t index = 0;
+        std::string state;
+        success = in.read(index) && in.read(state) && index < objects.size();
+        if (success)
+        {
+            std::istringstream stateStream(state);
+            if (!objects[index]->readSnapshotState(stateStream))
+                msg_warning(objects[index].get()) << "Internal state could not be restored from the snapshot.";
+        }
+    }
+
+    if (!success)
+    {
+        msg_error("SceneLoaderSnapshot") << "Snapshot '" << filename << "' is corrupted";
+        getSimulation()->unload(root);
+        return NULL;
+    }
+    return root;
+}
+
+Node::SPtr SceneLoaderSnapshot::createSnapshot(const std::string& sceneFilename, const std::string& snapshotFilename)
+{
+    Node::SPtr root = getSimulation()->load(sceneFilename.c_str());
+    if (!root)
+        return NULL;
+
+    std::ofstream file(snapshotFilename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        msg_error("SceneLoaderSnapshot") << "Cannot write file '" << snapshotFilename << "'";
+        getSimulation()->init(root.get());
+        return root;
+    }
+
+    // the Data values are saved as they are before init(), which is applied again on restored snapshots
+    BinaryDataWriter out(file);
+    out.write(snapshotMagic, sizeof(snapshotMagic));
+    out.write(snapshotVersion);
+    out.write(snapshotEndianness);
+    // absolute path of the scene, so that the snapshot can be loaded from any working directory
+    out.write(helper::system::SetDirectory::GetRelativeFromDir(sceneFilename.c_str(), helper::system::SetDirectory::GetCurrentDir().c_str()));
+    std::vector<BaseObject::SPtr> objects;
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+        writeNode(out, root.get(), objects);
+    }
+
+    getSimulation()->init(root.get());
+
+    std::vector<std::pair<uint32_t, std::string> > states;
+    for (std::size_t i = 0; i < objects.size(); ++i)
+    {
+        std::ostringstream state;
+        if (objects[i]->writeSnapshotState(state))
+            states.push_back(std::make_pair((uint32_t)i, state.str()));
+    }
+    out.write((uint32_t)states.size());
+    for (std::size_t i = 0; i < states.size(); ++i)
+    {
+        out.write(states[i].first);
+        out.write(states[i].second);
+    }
+
+    if (!out.good())
+        msg_error("SceneLoaderSnapshot") << "Error while writing file '" << snapshotFilename << "'";
+    return root;
+}
+
+bool SceneLoaderSnapshot::verifySnapshot(const std::string& sceneFilename, const std::string& snapshotFilename,
+                                         unsigned int nbSteps, SReal tolerance)
+{
+    Node::SPtr scene = getSimulation()->load(sceneFilename.c_str());
+    SceneLoaderSnapshot loader;
+    Node::SPtr restored = loader.load(snapshotFilename.c_str());
+    if (!scene || !restored)
+    {
+        if (scene) getSimulation()->unload(scene);
+        if (restored) getSimulation()->unload(restored);
+        return false;
+    }
+
+    getSimulation()->init(scene.get());
+    getSimulation()->init(restored.get());
+    for (unsigned int i = 0; i < nbSteps; ++i)
+    {
+        getSimulation()->animate(scene.get());
+        getSimulation()->animate(restored.get());
+    }
+
+    std::vector<core::behavior::BaseMechanicalState*> sceneStates, restoredStates;
+    scene->getTreeObjects<core::behavior::BaseMechanicalState>(&sceneStates);
+    restored->getTreeObjects<core::behavior::BaseMechanicalState>(&restoredStates);
+
+    bool success = (sceneStates.size() == restoredStates.size());
+    if (!success)
+        msg_error("SceneLoaderSnapshot") << "The snapshot has " << restoredStates.size() << " mechanical states instead of " << sceneStates.size();
+
+    const char* compared[] = { "position", "velocity" };
+    for (std::size_t i = 0; success && i < sceneStates.size(); ++i)
+    {
+        for (std::size_t j = 0; j < sizeof(compared) / sizeof(compared[0]); ++j)
+        {
+            const BaseData* sceneData = sceneStates[i]->findData(compared[j]);
+            const BaseData* restoredData = restoredStates[i]->findData(compared[j]);
+            if (!sceneData || !restoredData)
+                continue;
+            const double diff = maxDifference(sceneData, restoredData);
+            if (diff > tolerance)
+            {
+                msg_error("SceneLoaderSnapshot") << "Different " << compared[j] << " in " << sceneStates[i]->getPathName()
+                                                 << " after " << nbSteps << " steps: difference " << diff;
+                success = false;
+            }
+        }
+    }
+
+    getSimulation()->unload(scene);
+    getSimulation()->unload(restored);
+    return success;
+}
+
+} // namespace simulation
+
+} // namespace sofa
@@ -0,0 +1,71 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_SIMULATION_SCENELOADERSNAPSHOT_H
+#define SOFA_SIMULATION_SCENELOADERSNAPSHOT_H
+
+#include <sofa/simulation/SceneLoaderFactory.h>
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+/// Scene snapshots: binary files storing a whole scene graph, which is restored without parsing a scene
+/// file nor reading the files loaded by its components (meshes, images...).
+///
+/// A snapshot stores the nodes, the components, their links and the values of their Data as they are
+/// before the initialization of the scene, as init() is applied again on the restored graph. It also
+/// stores the internal state computed by init() of the components supporting it (see
+/// BaseObject::writeSnapshotState()), so that they skip its computation when they are restored (e.g. the
+/// transformations of the positions of a MechanicalObject).
+class SOFA_SIMULATION_COMMON_API SceneLoaderSnapshot : public SceneLoader
+{
+public:
+    /// Pre-loading check
+    virtual bool canLoadFileExtension(const char *extension) override;
+
+    /// load the file (the returned graph is not initialized)
+    virtual sofa::simulation::Node::SPtr load(const char *filename) override;
+
+    /// get the file type description
+    virtual std::string getFileTypeDesc() override;
+
+    /// get the list of file extensions
+    virtual void getExtensionList(ExtensionList* list) override;
+
+    /// Load and initialize a scene, and write its snapshot.
+    /// @return the initialized scene, or NULL if it could not be loaded.
+    static Node::SPtr createSnapshot(const std::string& sceneFilename, const std::string& snapshotFilename);
+
+    /// Run the given number of steps on a scene and on its restored snapshot, and compare the positions
+    /// and velocities of their mechanical states.
+    /// @return true if the largest difference is not greater than the tolerance.
+    static bool verifySnapshot(const std::string& sceneFilename, const std::string& snapshotFilename,
+                               unsigned int nbSteps = 1, SReal tolerance = 0);
+};
+
+} // namespace simulation
+
+} // namespace sofa
+
+#endif // SOFA_SIMULATION_SCENELOADERSNAPSHOT_H
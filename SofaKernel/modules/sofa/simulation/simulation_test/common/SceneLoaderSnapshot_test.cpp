@@ -0,0 +1,145 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/testing/BaseTest.h>
+using sofa::helper::testing::BaseTest ;
+
+#include <SofaComponentBase/initComponentBase.h>
+#include <SofaExplicitOdeSolver/initExplicitODESolver.h>
+#include <SofaDeformable/initDeformable.h>
+#include <SofaSimulationGraph/DAGSimulation.h>
+#include <SofaSimulationCommon/SceneLoaderSnapshot.h>
+using sofa::simulation::SceneLoaderSnapshot ;
+using sofa::simulation::Node ;
+
+#include <sofa/core/behavior/BaseMechanicalState.h>
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+namespace
+{
+
+/// A falling triangle, one of its points being thrown so that its springs are stretched
+const char* sceneText =
+        "<Node name='root' dt='0.01' gravity='0 -9.81 0'>                                       \n"
+        "   <Node name='child'>                                                                 \n"
+        "       <EulerExplicitSolver name='solver'/>                                            \n"
+        "       <MeshTopology name='topology' position='0 0 0  1 0 0  0 1 0' triangles='0 1 2'/> \n"
+        "       <MechanicalObject name='dofs' position='@topology.position' translation='1 2 3'  \n"
+        "                         velocity='0 0 0  0 0 0  1 0 0'/>                              \n"
+        "       <UniformMass name='mass' totalMass='2'/>                                        \n"
+        "       <MeshSpringForceField name='springs' trianglesStiffness='100'/>                 \n"
+        "   </Node>                                                                             \n"
+        "</Node>                                                                                \n" ;
+
+struct SceneLoaderSnapshot_test : public BaseTest
+{
+    std::string sceneFilename;
+    std::string snapshotFilename;
+
+    void SetUp()
+    {
+        sofa::component::initComponentBase();
+        sofa::component::initExplicitODESolver();
+        sofa::component::initDeformable();
+        sofa::simulation::setSimulation(new sofa::simulation::graph::DAGSimulation());
+
+        const boost::filesystem::path dir = boost::filesystem::temp_directory_path();
+        sceneFilename = (dir / "SceneLoaderSnapshot_test.scn").string();
+        snapshotFilename = (dir / "SceneLoaderSnapshot_test.snapshot").string();
+        std::ofstream file(sceneFilename.c_str());
+        file << sceneText;
+    }
+
+    void TearDown()
+    {
+        boost::system::error_code error;
+        boost::filesystem::remove(sceneFilename, error);
+        boost::filesystem::remove(snapshotFilename, error);
+    }
+
+    void checkRestoredScene()
+    {
+        Node::SPtr scene = SceneLoaderSnapshot::createSnapshot(sceneFilename, snapshotFilename);
+        ASSERT_NE(scene, nullptr);
+
+        SceneLoaderSnapshot loader;
+        ASSERT_TRUE(loader.canLoadFileName(snapshotFilename.c_str()));
+        Node::SPtr restored = loader.load(snapshotFilename.c_str());
+        ASSERT_NE(restored, nullptr);
+        sofa::simulation::getSimulation()->init(restored.get());
+
+        EXPECT_EQ(restored->findData("dt")->getValueString(), scene->findData("dt")->getValueString());
+        Node* child = restored->getChild("child");
+        ASSERT_NE(child, nullptr);
+        ASSERT_EQ(child->object.size(), 5u);
+
+        // the translation must not be applied twice, and the link to the topology is kept
+        sofa::core::behavior::BaseMechanicalState* dofs = child->get<sofa::core::behavior::BaseMechanicalState>();
+        ASSERT_NE(dofs, nullptr);
+        EXPECT_EQ(dofs->findData("position")->getValueString(), "1 2 3 2 2 3 1 3 3");
+        EXPECT_EQ(dofs->findData("position")->getLinkPath(), "@topology.position");
+        EXPECT_EQ(child->getObject("mass")->findData("totalMass")->getValueString(), "2");
+
+        // both scenes move the same way
+        sofa::core::behavior::BaseMechanicalState* sceneDofs = scene->getChild("child")->get<sofa::core::behavior::BaseMechanicalState>();
+        ASSERT_NE(sceneDofs, nullptr);
+        for (int i = 0; i < 10; ++i)
+        {
+            sofa::simulation::getSimulation()->animate(scene.get());
+            sofa::simulation::getSimulation()->animate(restored.get());
+        }
+        EXPECT_NE(dofs->findData("position")->getValueString(), "1 2 3 2 2 3 1 3 3");
+        EXPECT_EQ(dofs->findData("position")->getValueString(), sceneDofs->findData("position")->getValueString());
+        EXPECT_EQ(dofs->findData("velocity")->getValueString(), sceneDofs->findData("velocity")->getValueString());
+
+        sofa::simulation::getSimulation()->unload(scene);
+        sofa::simulation::getSimulation()->unload(restored);
+    }
+};
+
+TEST_F(SceneLoaderSnapshot_test, restoredScene)
+{
+    checkRestoredScene();
+}
+
+TEST_F(SceneLoaderSnapshot_test, verifySnapshot)
+{
+    Node::SPtr scene = SceneLoaderSnapshot::createSnapshot(sceneFilename, snapshotFilename);
+    ASSERT_NE(scene, nullptr);
+    sofa::simulation::getSimulation()->unload(scene);
+
+    EXPECT_TRUE(SceneLoaderSnapshot::verifySnapshot(sceneFilename, snapshotFilename, 10));
+}
+
+TEST_F(SceneLoaderSnapshot_test, invalidFile)
+{
+    {
+        std::ofstream file(snapshotFilename.c_str(), std::ios::binary);
+        file << "not a snapshot";
+    }
+    SceneLoaderSnapshot loader;
+    EXPECT_MSG_EMIT(Error);
+    EXPECT_EQ(loader.load(snapshotFilename.c_str()), nullptr);
+}
+
+}
@@ -127,17 +127,20 @@ bool save_metaimage(const CImgList<T>& img,const char *const headerFilename, con
 }
 
 
+/// Reads the header of a metaimage: the name of the raw file, the 4 dimensions (3 spatial dims + time),
+/// the number of channels and the element type (as a cimg type string) of the voxels stored in the raw file
 template<typename T,typename F>
-CImgList<T> load_metaimage(const char *const  headerFilename, F *const scale=0, F *const translation=0, F *const affine=0, F *const offsetT=0, F *const scaleT=0, int *const isPerspective=0)
+bool load_metaimage_header(const char *const  headerFilename, std::string& imageFilename, unsigned int dim[4], unsigned int& nbchannels, std::string& inputType, F *const scale=0, F *const translation=0, F *const affine=0, F *const offsetT=0, F *const scaleT=0, int *const isPerspective=0)
 {
-    CImgList<T> ret;
-
     std::ifstream fileStream(headerFilename, std::ifstream::in);
-    if (!fileStream.is_open())	{	std::cout << "Can not open " << headerFilename << std::endl;	return ret; }
+    if (!fileStream.is_open())	{	std::cout << "Can not open " << headerFilename << std::endl;	return false; }
 
-    std::string str,str2,imageFilename;
-    unsigned int nbchannels=1,nbdims=4,dim[] = {1,1,1,1}; // 3 spatial dimas + time
-    std::string inputType(cimg::type<T>::string());
+    std::string str,str2;
+    unsigned int nbdims=4;
+    nbchannels=1;
+    for(unsigned int i=0;i<4;i++) dim[i]=1;
+    imageFilename.clear();
+    inputType=cimg::type<T>::string();
     while(!fileStream.eof())
     {
         fileStream >> str;
@@ -146,7 +149,7 @@ CImgList<T> load_metaimage(const char *const  headerFilename, F *const scale=0,
         {
             fileStream >> str2; // '='
             fileStream >> str2;
-            if(str2.compare("Image")) { std::cout << "MetaImageReader: not an image ObjectType "<<std::endl; return ret;}
+            if(str2.compare("Image")) { std::cout << "MetaImageReader: not an image ObjectType "<<std::endl; return false;}
         }
         else if(!str.compare("ElementDataFile"))
         {
@@ -157,7 +160,7 @@ CImgList<T> load_metaimage(const char *const  headerFilename, F *const scale=0,
         {
             fileStream >> str2;  // '='
             fileStream >> nbdims;
-            if(nbdims>4) { std::cout << "MetaImageReader: dimensions > 4 not supported  "<<std::endl; return ret;}
+            if(nbdims>4) { std::cout << "MetaImageReader: dimensions > 4 not supported  "<<std::endl; return false;}
         }
         else if(!str.compare("ElementNumberOfChannels"))
         {
@@ -229,6 +232,18 @@ CImgList<T> load_metaimage(const char *const  headerFilename, F *const scale=0,
         std::size_t pos = (posSlash==std::string::npos) ? posAslash : ( (posAslash==std::string::npos) ? posSlash : std::max(posSlash, posAslash) );
         if(pos!=std::string::npos) {tmp.erase(pos+1); imageFilename.insert(0,tmp);}
     }
+    return true;
+}
+
+
+template<typename T,typename F>
+CImgList<T> load_metaimage(const char *const  headerFilename, F *const scale=0, F *const translation=0, F *const affine=0, F *const offsetT=0, F *const scaleT=0, int *const isPerspective=0)
+{
+    CImgList<T> ret;
+
+    std::string imageFilename,inputType;
+    unsigned int nbchannels,dim[4];
+    if(!load_metaimage_header<T,F>(headerFilename,imageFilename,dim,nbchannels,inputType,scale,translation,affine,offsetT,scaleT,isPerspective)) return ret;
 
     ret.assign(dim[3],dim[0],dim[1],dim[2],nbchannels);
     unsigned int nb = dim[0]*dim[1]*dim[2]*nbchannels;
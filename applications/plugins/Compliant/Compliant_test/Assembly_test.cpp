@@ -52,6 +52,15 @@ struct Assembly_test : public CompliantSolver_test
         return sys.H;
     }
 
+    /// assembling the whole system, with a cache or not
+    /// @warning the scene must be initialized
+    static void assemble( component::linearsolver::AssembledSystem& sys, Node::SPtr node, const core::MechanicalParams* mparams, simulation::AssemblyCache* cache=NULL )
+    {
+        simulation::AssemblyVisitor assemblyVisitor(mparams,cache);
+        node->getContext()->executeVisitor( &assemblyVisitor );
+        assemblyVisitor.assemble(sys);
+    }
+
     /// assembling the mass matrix alone
     /// @warning the scene must be initialized
     static SparseMatrix getAssembledMassMatrix( Node::SPtr node, core::MechanicalParams mparams=*core::MechanicalParams::defaultInstance() )
@@ -1168,6 +1177,77 @@ TEST_F( Assembly_test, testRigidConnectedToString )
 
     //    cout<<"all tests done" << endl;
 }
+TEST_F( Assembly_test, testCachedAssembly )
+{
+    unsigned numParticles=3;
+    ::testing::Message() << "Assembly_test: swinging hard string of " << numParticles << " particles connected to a rigid, assembled with a cache";
+    testRigidConnectedToString(numParticles);
+
+    // the string swings, so that the values of the mappings change at each step
+    Node::SPtr root = static_cast<simulation::Node*>(complianceSolver->getContext());
+    root->setGravity( Vec3(10,10,0) );
+
+    Node* pointPair = root->getChild("rigid")->getChild("particleOnRigid")->getChild("pointPair");
+    Node* extension = pointPair->getChild("extension");
+    ASSERT_TRUE( extension != NULL );
+    SubsetMultiMapping3_to_3* pointPairMapping = pointPair->get<SubsetMultiMapping3_to_3>();
+    ASSERT_TRUE( pointPairMapping != NULL );
+
+    core::MechanicalParams mparams = *core::MechanicalParams::defaultInstance();
+    mparams.setMFactor( 1 );
+    mparams.setBFactor( 0 );
+    mparams.setKFactor( 0.1 );
+
+    // the cache is kept along the steps, as in the solver
+    simulation::AssemblyCache cache;
+    cache.listen( root.get(), NULL );
+
+    for( unsigned i=0; i<6; i++ )
+    {
+        std::size_t revision = cache.revision;
+
+        if( i==2 )
+        {
+            // mapping change: the pair is connected to another particle of
+            // the string, which changes the sparsity of the mapping and not
+            // the graph
+            {
+                helper::WriteAccessor< Data< helper::vector<unsigned> > > indexPairs( pointPairMapping->indexPairs );
+                indexPairs[1] = numParticles-2;
+            }
+            pointPairMapping->init();
+        }
+
+        if( i==4 )
+        {
+            // graph change: the distance mapping is replaced
+            DistanceMapping31::SPtr previousMapping = extension->get<DistanceMapping31>();
+            extension->removeObject( previousMapping );
+
+            DistanceMapping31::SPtr extensionMapping = addNew<DistanceMapping31>(extension);
+            extensionMapping->setModels( pointPair->get<MechanicalObject3>(), extension->get<MechanicalObject1>() );
+            extensionMapping->init();
+        }
+
+        sofa::simulation::getSimulation()->animate(root.get(),0.1);
+
+        component::linearsolver::AssembledSystem cached, uncached;
+        assemble( cached, root, &mparams, &cache );
+        assemble( uncached, root, &mparams );
+
+        if( i==4 ) EXPECT_NE( revision, cache.revision );
+        else EXPECT_EQ( revision, cache.revision );
+
+        EXPECT_EQ( uncached.m, cached.m );
+        EXPECT_EQ( uncached.n, cached.n );
+        EXPECT_TRUE(matricesAreEqual( uncached.H, cached.H ));
+        EXPECT_TRUE(matricesAreEqual( uncached.J, cached.J ));
+        EXPECT_TRUE(matricesAreEqual( uncached.C, cached.C ));
+        EXPECT_TRUE(matricesAreEqual( uncached.P, cached.P ));
+    }
+
+    cache.unlisten();
+}
 TEST_F( Assembly_test, testDecomposedString )
 {
     testDecomposedString();
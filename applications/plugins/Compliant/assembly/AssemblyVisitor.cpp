@@ -22,11 +22,12 @@ using namespace component::linearsolver;
 using namespace core::behavior;
 
 
-AssemblyVisitor::AssemblyVisitor(const core::MechanicalParams* mparams)
+AssemblyVisitor::AssemblyVisitor(const core::MechanicalParams* mparams, AssemblyCache* cache)
 	: base( mparams ),
       mparams( mparams ),
 	  start_node(0),
-	  _processed(0)
+	  _processed(0),
+      cache(cache)
 {
     mparamsWithoutStiffness = *mparams;
     mparamsWithoutStiffness.setKFactor(0);
@@ -35,7 +36,7 @@ AssemblyVisitor::AssemblyVisitor(const core::MechanicalParams* mparams)
 
 AssemblyVisitor::~AssemblyVisitor()
 {
-	if( _processed ) delete _processed;
+	if( _processed && !cache ) delete _processed; // otherwise owned by the cache
 }
 
 
@@ -481,7 +482,40 @@ struct AssemblyVisitor::prefix_helper {
 AssemblyVisitor::process_type* AssemblyVisitor::process() const {
     scoped::timer step("assembly: mapping processing");
 
-    process_type* res = new process_type();
+    if( cache ) {
+        // the products kept in the cache are only valid for the same graph:
+        // the same objects (the revision of the cache changes when objects
+        // are added or removed), traversed in the same order and connected
+        // the same way
+        cache->update();
+        std::vector<std::size_t> signature;
+        signature.push_back( cache->revision );
+
+        for(unsigned i = 0, n = prefix.size(); i < n; ++i) {
+            const chunk* c = graph[ prefix[i] ].data;
+
+            signature.push_back( prefix[i] );
+            signature.push_back( c->size );
+            signature.push_back( c->mechanical + 2 * c->master() + 4 * notempty(c->Ktilde) );
+
+            for( graph_type::out_edge_range e = boost::out_edges(prefix[i], graph); e.first != e.second; ++e.first) {
+                signature.push_back( boost::target(*e.first, graph) );
+            }
+            signature.push_back( std::size_t(-1) ); // end of parents
+        }
+
+        for( InteractionForceFieldList::const_iterator it=interactionForceFieldList.begin(),itend=interactionForceFieldList.end();it!=itend;++it)
+        {
+            signature.push_back( it->H.rows() );
+        }
+
+        if( signature != cache->signature ) {
+            cache->clear();
+            cache->signature.swap( signature );
+        }
+    }
+
+    process_type* res = cache ? &cache->processed : new process_type();
 
     unsigned& size_m = res->size_m;
     unsigned& size_c = res->size_c;
@@ -510,12 +544,59 @@ AssemblyVisitor::process_type* AssemblyVisitor::process() const {
 	size_m = off_m;
 	size_c = off_c;
 
-    // prefix mapping concatenation and stuff
-    std::for_each(prefix.begin(), prefix.end(), process_helper(*res, graph) ); 	// TODO merge with offsets computation ?
+    fullmapping_type& full = res->fullmapping;
+
+    // mapped dofs sorted by depth in the graph: the full mappings at a
+    // given depth only depend on the ones of their parents
+    std::vector<unsigned> depth( boost::num_vertices(graph), 0 );
+    std::vector< std::vector<unsigned> > levels;
+
+    for(unsigned i = 0, n = prefix.size(); i < n; ++i) {
+
+        const unsigned v = prefix[i];
+        const chunk* c = graph[v].data;
+
+        if( !c->mechanical ) continue;
+
+        rmat& Jc = full[ c->dofs ];
+
+        // parent is not mapped: we put a shift matrix with the
+        // correct offset as its full mapping matrix, so that its
+        // children will get the right place on multiplication
+        if( c->master() ) {
+            if( empty(Jc) ) Jc = shift_right<rmat>( find(offsets, c->dofs), c->size, size_m);
+            continue;
+        }
+
+        if( boost::out_degree(v, graph) > 1 && notempty(c->Ktilde) ) res->fullmappinggeometricstiffness[ c->dofs ];
+
+        unsigned d = 0;
+        for( graph_type::out_edge_range e = boost::out_edges(v, graph); e.first != e.second; ++e.first) {
+            d = std::max( d, depth[ boost::target(*e.first, graph) ] );
+        }
+        depth[v] = d + 1;
+
+        if( levels.size() < depth[v] ) levels.resize( depth[v] );
+        levels[ depth[v] - 1 ].push_back( v );
+    }
+
+    // prefix mapping concatenation and stuff, concurrently for the dofs at the same depth
+    const process_helper helper(*res, graph);
+
+    for(unsigned l = 0, nl = levels.size(); l < nl; ++l) {
+        const std::vector<unsigned>& level = levels[l];
+        const int n = level.size();
+
+#ifdef _OPENMP
+#pragma omp parallel for if( n > 1 )
+#endif
+        for(int i = 0; i < n; ++i) {
+            helper( level[i] );
+        }
+    }
 
 
     // special treatment for interaction forcefields
-    fullmapping_type& full = res->fullmapping;
     for( InteractionForceFieldList::iterator it=interactionForceFieldList.begin(),itend=interactionForceFieldList.end();it!=itend;++it)
     {
 
@@ -543,29 +624,16 @@ AssemblyVisitor::process_type* AssemblyVisitor::process() const {
 
 
 // this is meant to optimize L^T D L products
-inline const AssemblyVisitor::rmat& AssemblyVisitor::ltdl(const rmat& l, const rmat& d) const
-{
-    scoped::timer advancedTimer("assembly: ltdl");
-
-//#ifdef _OPENMP
-//    return component::linearsolver::mul_EigenSparseMatrix_MT( l.transpose(), component::linearsolver::mul_EigenSparseMatrix_MT( d, l ) );
-//#else
-    sparse::fast_prod(tmp1, d, l);
-    tmp3 = l.transpose();
-    sparse::fast_prod(tmp2, tmp3, tmp1);
-    
-    return tmp2;
-//#endif
-}
-
-
-inline void AssemblyVisitor::add_ltdl(rmat& res, const rmat& l, const rmat& d)  const
+void AssemblyVisitor::ltdl_type::compute(const rmat& l, const rmat& d)
 {
-    scoped::timer advancedTimer("assembly: ltdl");
-
-    sparse::fast_prod(tmp1, d, l);
-    tmp3 = l.transpose();
-    sparse::fast_add_prod(res, tmp3, tmp1);
+    if( sparse::fast_prod_values(DL, d, l) &&
+        sparse::transpose_values(LT, l) &&
+        sparse::fast_prod_values(LTDL, LT, DL) ) return;
+
+    sparse::fast_prod(DL, d, l);
+    LT = l.transpose();
+    LT.makeCompressed();
+    sparse::fast_prod(LTDL, LT, DL);
 }
 
 
@@ -706,6 +774,19 @@ void AssemblyVisitor::assemble(system_type& res) const {
 
 
 
+    // L^T D L products, kept in the cache if any
+    ltdl_map_type localResponse, localGeometricStiffness;
+    std::vector<ltdl_type> localInteraction;
+
+    ltdl_map_type& response = cache ? cache->response : localResponse;
+    ltdl_map_type& geometricStiffness = cache ? cache->geometricStiffness : localGeometricStiffness;
+    std::vector<ltdl_type>& interaction = cache ? cache->interaction : localInteraction;
+
+    // the products are independent, they are gathered to be computed concurrently
+    std::vector<ltdl_task> tasks;
+    std::vector<const ltdl_type*> geometricStiffnessProducts;
+    std::list<rmat> scaledKtilde;
+
     // Geometric Stiffness must be processed first, from mapped dofs to master dofs
     // warning, inverse order is important, to treat mapped dofs before master dofs
     // so mapped dofs can transfer their geometric stiffness to master dofs that will add it to the assembled matrix
@@ -724,43 +805,67 @@ void AssemblyVisitor::assemble(system_type& res) const {
 
         if( boost::out_degree(prefix[i],graph) == 1 ) // simple mapping
         {
-//            std::cerr<<"simple mapping "<<c.dofs->getName()<<std::endl;
             // add the geometric stiffness to its only parent that will map it to the master level
             graph_type::out_edge_iterator parentIterator = boost::out_edges(prefix[i],graph).first;
             chunk* p = graph[ boost::target(*parentIterator, graph) ].data;
             add(p->H, mparams->kFactor() * *Ktilde ); // todo how to include rayleigh damping for geometric stiffness?
-
-//            std::cerr<<"Assembly: "<<c.Ktilde<<std::endl;
         }
         else // multimapping
         {
             // directly add the geometric stiffness to the assembled level
             // by mapping with the specific jacobian from master to the (current-1) level
 
-
-//            std::cerr<<"multimapping "<<c.dofs->getName()<<std::endl;
-
             // full mapping chunk for geometric stiffness
             const rmat& geometricStiffnessJc = _processed->fullmappinggeometricstiffness[ c.dofs ];
 
+            scaledKtilde.push_back( mparams->kFactor() * *Ktilde );
+
+            ltdl_type& product = geometricStiffness[ c.dofs ];
+            tasks.push_back( ltdl_task( &product, &geometricStiffnessJc, &scaledKtilde.back() ) );
+            geometricStiffnessProducts.push_back( &product );
+        }
+
+    }
+
+    // Then interaction forcefields
+    interaction.resize( interactionForceFieldList.size() );
+    unsigned interactionIndex = 0;
+    for( InteractionForceFieldList::iterator it=interactionForceFieldList.begin(),itend=interactionForceFieldList.end();it!=itend;++it)
+    {
+        tasks.push_back( ltdl_task( &interaction[interactionIndex++], &it->J, &it->H ) );
+    }
 
+    // And the response matrices of the mapped dofs
+    for( unsigned i = 0, n = prefix.size() ; i < n ; ++i ) {
 
-            //std::cerr<<geometricStiffnessJc<<std::endl;
-//            std::cerr<<*Ktilde<<std::endl;
-//            std::cerr<<Ktilde->nonZeros()<<std::endl;
+        const chunk& c = *graph[ prefix[i] ].data;
 
-//            std::cerr<<res.H.rows()<<" "<<geometricStiffnessJc.rows()<<std::endl;
+        if( !c.mechanical || c.master() || zero(c.H) ) continue;
 
-            add_ltdl(res.H, geometricStiffnessJc, mparams->kFactor() * *Ktilde);
-        }
+        const rmat& Jc = _processed->fullmapping[ c.dofs ];
 
+        if( !zero(Jc) ) tasks.push_back( ltdl_task( &response[ c.dofs ], &Jc, &c.H ) );
     }
 
-
-    // Then add interaction forcefields
-    for( InteractionForceFieldList::iterator it=interactionForceFieldList.begin(),itend=interactionForceFieldList.end();it!=itend;++it)
     {
-        add_ltdl(res.H, it->J, it->H);
+        scoped::timer advancedTimer("assembly: ltdl");
+
+        const int n = tasks.size();
+
+#ifdef _OPENMP
+#pragma omp parallel for if( n > 1 )
+#endif
+        for( int i = 0; i < n; ++i ) {
+            tasks[i].product->compute( *tasks[i].l, *tasks[i].d );
+        }
+    }
+
+    for( unsigned i = 0, n = geometricStiffnessProducts.size() ; i < n ; ++i ) {
+        add( res.H, geometricStiffnessProducts[i]->LTDL );
+    }
+
+    for( unsigned i = 0, n = interaction.size() ; i < n ; ++i ) {
+        add( res.H, interaction[i].LTDL );
     }
 
 
@@ -806,7 +911,7 @@ void AssemblyVisitor::assemble(system_type& res) const {
                 assert( Jc.cols() == int(_processed->size_m) );
 
                 // actual response matrix mapping
-                if( !zero(c.H) ) add_H(ltdl(Jc, c.H), 0);
+                if( !zero(c.H) ) add_H(find(response, c.dofs).LTDL, 0);
             }
 
 
@@ -882,6 +987,99 @@ bool AssemblyVisitor::chunk::check() const {
 }
 
 
+AssemblyCache::AssemblyCache()
+    : revision(0),
+      root(NULL),
+      owner(NULL),
+      ownerRemoved(false),
+      childrenChanged(false)
+{
+}
+
+
+AssemblyCache::~AssemblyCache() {
+    // unless the owner was removed from it, the root is being destroyed
+    // with the owner and must not be left
+    if( root && !ownerRemoved ) root = NULL;
+    unlisten();
+}
+
+
+void AssemblyCache::listen(Node* root, core::objectmodel::BaseObject* owner) {
+    unlisten();
+    this->root = root;
+    this->owner = owner;
+    ownerRemoved = false;
+    root->addListener( this );
+    listenChildren( root );
+    childrenChanged = false;
+    ++revision;
+}
+
+
+void AssemblyCache::unlisten() {
+    unlistenChildren();
+    if( root ) root->removeListener( this );
+    root = NULL;
+    owner = NULL;
+}
+
+
+void AssemblyCache::update() {
+    // the listeners are not changed during the notifications, which
+    // iterate on them
+    if( !childrenChanged || !root || ownerRemoved ) return;
+    unlistenChildren();
+    listenChildren( root );
+    childrenChanged = false;
+}
+
+
+void AssemblyCache::listenChildren(Node* node) {
+    for( Node::ChildIterator it = node->child.begin(), end = node->child.end(); it != end; ++it ) {
+        Node* child = it->get();
+        bool listened = false;
+        for( unsigned i = 0, n = children.size(); i < n && !listened; ++i ) listened = ( children[i] == child );
+        if( listened ) continue; // several parents
+
+        child->addListener( this );
+        children.push_back( child );
+        listenChildren( child );
+    }
+}
+
+
+void AssemblyCache::unlistenChildren() {
+    for( unsigned i = 0, n = children.size(); i < n; ++i ) {
+        children[i]->removeListener( this );
+    }
+    children.clear();
+}
+
+
+void AssemblyCache::addChild(Node*, Node*) { changed(); }
+void AssemblyCache::removeChild(Node*, Node*) { changed(); }
+void AssemblyCache::moveChild(Node*, Node*, Node*) { changed(); }
+void AssemblyCache::addObject(Node*, core::objectmodel::BaseObject*) { changed(); }
+void AssemblyCache::moveObject(Node*, Node*, core::objectmodel::BaseObject*) { changed(); }
+
+void AssemblyCache::removeObject(Node* parent, core::objectmodel::BaseObject* object) {
+    if( parent == root && object == owner ) ownerRemoved = true;
+    changed();
+}
+
+
+void AssemblyCache::clear() {
+
+    signature.clear();
+    processed = AssemblyVisitor::process_type();
+    response.clear();
+    geometricStiffness.clear();
+    interaction.clear();
+
+}
+
+
 void AssemblyVisitor::clear() {
 
 	chunks.clear();
@@ -3,8 +3,10 @@
 
 #include <Compliant/config.h>
 #include <sofa/simulation/MechanicalVisitor.h>
+#include <sofa/simulation/MutationListener.h>
 #include <SofaEigen2Solver/EigenSparseMatrix.h>
 #include <map>
+#include <vector>
 
 #include "../utils/graph.h"
 #include "../utils/find.h"
@@ -15,6 +17,8 @@
 namespace sofa {
 namespace simulation {
 
+class AssemblyCache;
+
 // a visitor for system assembly: sending the visitor will fetch
 // data, and actual system assembly is performed using
 // ::assemble(), yielding an AssembledSystem
@@ -45,7 +49,9 @@ public:
     // default: row-major
 	typedef Eigen::Matrix<real, Eigen::Dynamic, 1> vec;
 			
-    AssemblyVisitor(const core::MechanicalParams* mparams);
+    // if a cache is given, the products computed during assembly are
+    // kept in it to be reused by the next visitors (see AssemblyCache)
+    AssemblyVisitor(const core::MechanicalParams* mparams, AssemblyCache* cache = NULL);
     virtual ~AssemblyVisitor();
 
 //protected:
@@ -176,6 +182,24 @@ public:
 	// max: wtf is this ?
 	mutable process_type *_processed;
 
+    /// L^T D L product, with its intermediate products D L and L^T
+    struct ltdl_type {
+        rmat DL, LT, LTDL;
+
+        // only the values are computed when the previous sparsity
+        // patterns still hold, otherwise the products are rebuilt
+        void compute(const rmat& l, const rmat& d);
+    };
+    typedef std::map<dofs_type*, ltdl_type> ltdl_map_type;
+
+    // a product to compute: L^T D L
+    struct ltdl_task {
+        ltdl_task(ltdl_type* product, const rmat* l, const rmat* d) : product(product), l(l), d(d) {}
+        ltdl_type* product;
+        const rmat* l;
+        const rmat* d;
+    };
+
 	// builds global mapping / full stiffness matrices + sizes
     virtual process_type* process() const;
 			
@@ -229,13 +253,8 @@ private:
     //simulation::Node* start_node;
 
 
-    // keep temporaries allocated
-    mutable rmat tmp1, tmp2, tmp3;
-
-
-    // this is meant to optimize L^T D L products
-    const rmat& ltdl(const rmat& l, const rmat& d) const;
-    void add_ltdl(rmat& res, const rmat& l, const rmat& d) const;
+    // products kept between assemblies (may be NULL)
+    AssemblyCache* cache;
 
 };
 
@@ -245,6 +264,9 @@ private:
 
 /// Computing the full jacobian matrices from masters to every mapped dofs
 /// ie multiplies mapping matrices together for everyone in the graph
+/// The full mappings of the dofs and of their parents must already be in
+/// the maps (possibly empty), so that the dofs at the same depth in the
+/// graph can be processed concurrently.
 // TODO why is this here?
 // -> because we need an access to it when deriving AssemblyVisitor
 // -> could be moved in AssemblyHelper?
@@ -264,24 +286,37 @@ struct AssemblyVisitor::process_helper {
         chunk* c = g[v].data;
         dofs_type* curr = c->dofs;
 
-        const unsigned& size_m = res.size_m;
-        fullmapping_type& full = res.fullmapping;
-        offset_type& offsets = res.offset.master;
-
         if( c->master() || !c->mechanical ) return;
 
-        rmat& Jc = full[ curr ]; // (output) full mapping from independent dofs to mapped dofs c
-        assert( empty(Jc) );
-
+        rmat& Jc = find( res.fullmapping, curr ); // (output) full mapping from independent dofs to mapped dofs c
 
         // full jacobian for multimapping's geometric stiffness
         rmat* geometricStiffnessJc = NULL;
-        unsigned localOffsetParentInMapped = 0; // only used for multimappings
         if( boost::out_degree(v,g)>1 && notempty(c->Ktilde) )
         {
-            geometricStiffnessJc = &res.fullmappinggeometricstiffness[ curr ];
+            geometricStiffnessJc = &find( res.fullmappinggeometricstiffness, curr );
+        }
+
+        // products kept from a previous assembly: only update their values
+        if( !empty(Jc) && (!geometricStiffnessJc || !empty(*geometricStiffnessJc)) )
+        {
+            if( accumulate(v, Jc, geometricStiffnessJc, true) ) return;
         }
 
+        Jc = rmat();
+        if( geometricStiffnessJc ) *geometricStiffnessJc = rmat();
+        accumulate(v, Jc, geometricStiffnessJc, false);
+    }
+
+    // sums the products of the mapping blocks with the full mappings of the parents
+    // when values is true, the sparsity patterns of Jc and geometricStiffnessJc
+    // are kept and false is returned if they do not hold anymore
+    bool accumulate(unsigned v, rmat& Jc, rmat* geometricStiffnessJc, bool values) const {
+
+        const chunk* c = g[v].data;
+
+        unsigned localOffsetParentInMapped = 0; // only used for multimappings
+        bool first = true;
 
         for( graph_type::out_edge_range e = boost::out_edges(v, g); e.first != e.second; ++e.first) {
 
@@ -289,76 +324,124 @@ struct AssemblyVisitor::process_helper {
 
             // parent data chunk/mapping matrix
             const chunk* p = vp.data;
-            dofs_type* pdofs = p->dofs;
 
-            rmat& Jp = full[ pdofs ]; // (input) full mapping from independent dofs to parent p of dofs c
+            fullmapping_type::const_iterator itp = res.fullmapping.find( p->dofs );
+            if( itp == res.fullmapping.end() ) continue;
+
+            const rmat& Jp = itp->second; // (input) full mapping from independent dofs to parent p of dofs c
+
+            // mapping blocks
+            helper::OwnershipSPtr<rmat> jc( convertSPtr<rmat>( g[*e.first].data->J ) );
+
+            // Note a Jacobian can be null in a multimapping (child only mapped from one parent)
+            // or when the corresponding mask is empty
+            if( zero( *jc ) ) continue;
+
+            // Jp can be empty for multinodes, when a child is mapped only from a subset of its parents
+            if( empty(Jp) ) continue;
+
+            // TODO optimize this, it is the most costly part
+            if( !product(Jc, *jc, Jp, !first, values) ) return false; // full mapping
+
+            if( geometricStiffnessJc )
             {
-                // mapping blocks
-                helper::OwnershipSPtr<rmat> jc( convertSPtr<rmat>( g[*e.first].data->J ) );
-
-                if( zero( *jc ) )
-                {
-                    continue;
-
-                    // Note a Jacobian can be null in a multimapping (child only mapped from one parent)
-                    // or when the corresponding mask is empty
-//                    MAINLOGGER( Info, "Empty Jacobian for mapping: "<<((simulation::Node*)curr->getContext())->mechanicalMapping->getPathName()
-//                                              << std::endl << "mask=\""<<curr->forceMask <<"\"", "AssemblyVisitor" )
-                }
-
-
-                // parent is not mapped: we put a shift matrix with the
-                // correct offset as its full mapping matrix, so that its
-                // children will get the right place on multiplication
-                if( p->master() && empty(Jp) ) {
-                    Jp = shift_right<rmat>( find(offsets, pdofs), p->size, size_m);
-                }
-
-                // Jp can be empty for multinodes, when a child is mapped only from a subset of its parents
-                if(!empty(Jp) ){
-                    // scoped::timer step("mapping matrix product");
-
-                    // TODO optimize this, it is the most costly part
-                    add_prod(Jc, *jc, Jp ); // full mapping
-
-                    if( geometricStiffnessJc )
-                    {
-                        // mapping for geometric stiffness
-                        add_prod( *geometricStiffnessJc,
-                                  shift_left<rmat>( localOffsetParentInMapped,
-                                                   p->size,
-                                                   c->Ktilde->rows() ),
-                                  Jp );
-                        localOffsetParentInMapped += p->size;
-                    }
-                }
+                // mapping for geometric stiffness
+                if( !product( *geometricStiffnessJc,
+                              shift_left<rmat>( localOffsetParentInMapped,
+                                                p->size,
+                                                c->Ktilde->rows() ),
+                              Jp, !first, values ) ) return false;
+                localOffsetParentInMapped += p->size;
             }
 
-//            std::cerr<<"Assembly::geometricStiffnessJc "<<geometricStiffnessJc<<" "<<curr->getName()<<std::endl;
+            first = false;
         }
 
-//        if( zero(Jc) && curr->getSize() !=0 )  {
-//            // If the dof size is null, let's consider it is not a big deal.
-//            // Indeed, having null dof is useful when setting up a static graph that is filled in dynamically
-
-//            using namespace std;
-//            MAINLOGGER( Warning,
-//                        "Houston we have a problem. Null full Jacobian for dof \""<< c->dofs->getPathName()<<"\""<< endl
-//                        << "master=" << c->master() << ", "
-//       //                 << "mapped: " << (c->map.empty() ? string("nope") : p->dofs->getName() )<< endl
-//       //                 << "p mechanical ? " << p->mechanical << endl
-//       //                 << "empty Jp " << empty(Jp) << endl
-//                        << "empty Jc=" << empty(Jc) << ", "
-//                        , "AssemblyVisitor" )
-
-//            assert( false );
-//        }
-//        else
-//            MAINLOGGER( Info, ((simulation::Node*)c->dofs->getContext())->mechanicalMapping->getPathName()<<" "<<Jc.nonZeros() , "AssemblyVisitor" )
+        // no product: the previous patterns are not the ones of an empty mapping
+        return !( values && first );
+    }
+
+    static bool product(rmat& res, const rmat& lhs, const rmat& rhs, bool accumulate, bool values) {
+        if( values ) return sparse::fast_prod_values(res, lhs, rhs, accumulate);
 
+        if( accumulate ) sparse::fast_add_prod(res, lhs, rhs);
+        else sparse::fast_prod(res, lhs, rhs);
+        return true;
     }
 
+};
+
+
+/// The products of an assembly (full mappings and L^T D L products) kept
+/// for the next ones. While the mechanical graph (dofs, sizes, mappings,
+/// interaction forcefields) is unchanged, only the values of the products
+/// are computed again, in their sparsity patterns, which avoids most of
+/// the allocations and sorting of the sparse products.
+/// It is owned by the caller (e.g. an ode solver) and given to the
+/// successive AssemblyVisitor.
+/// The cache listens to the changes of the graph it is used for (see
+/// listen): any added, removed or moved node or object increments its
+/// revision, and the products are not reused across revisions.
+class SOFA_Compliant_API AssemblyCache : public MutationListener {
+public:
+
+    typedef AssemblyVisitor::dofs_type dofs_type;
+    typedef AssemblyVisitor::ltdl_type ltdl_type;
+
+    AssemblyCache();
+    virtual ~AssemblyCache();
+
+    /// listen to the changes of the graph below root, where owner (e.g. the
+    /// solver owning this cache) is
+    void listen(Node* root, core::objectmodel::BaseObject* owner);
+
+    /// stop listening, root must still exist
+    void unlisten();
+
+    /// listen to the nodes added below root since the last call
+    void update();
+
+    /// incremented at each change of the listened graph
+    std::size_t revision;
+
+    /// structure of the graph the products were computed for
+    std::vector<std::size_t> signature;
+
+    /// full mappings
+    AssemblyVisitor::process_type processed;
+
+    /// J^T H J of the mapped dofs, and of their geometric stiffness for multimappings
+    AssemblyVisitor::ltdl_map_type response, geometricStiffness;
+
+    /// J^T H J of the interaction forcefields, in the order of the visitor's list
+    std::vector<ltdl_type> interaction;
+
+    void clear();
+
+protected:
+
+    void listenChildren(Node* node);
+    void unlistenChildren();
+
+    void changed() { ++revision; childrenChanged = true; }
+
+    virtual void addChild(Node* parent, Node* child);
+    virtual void removeChild(Node* parent, Node* child);
+    virtual void moveChild(Node* previous, Node* parent, Node* child);
+    virtual void addObject(Node* parent, core::objectmodel::BaseObject* object);
+    virtual void removeObject(Node* parent, core::objectmodel::BaseObject* object);
+    virtual void moveObject(Node* previous, Node* parent, core::objectmodel::BaseObject* object);
+
+    // the root is not owned, as it owns the owner of the cache: it is only
+    // left when the owner was removed from it, otherwise it is being
+    // destroyed along with its objects
+    Node* root;
+    core::objectmodel::BaseObject* owner;
+    bool ownerRemoved;
 
+    // the listened nodes below the root, kept alive to be left
+    std::vector< Node::SPtr > children;
+    bool childrenChanged;
 };
 
 }
@@ -61,9 +61,15 @@ using namespace core::behavior;
             true,
             "neglecting_compliance_forces_in_geometric_stiffness",
             "isn't the name clear enough?"))
+
+          , cache_assembly(initData(&cache_assembly,
+            false,
+            "cache_assembly",
+            "keep the sparsity patterns of the assembly products while the mechanical graph is unchanged, only their values are computed again at each step"))
     {
         storeDSol = false;
         assemblyVisitor = NULL;
+        assemblyCache = NULL;
 
         helper::OptionsGroup stabilizationOptions;
         stabilizationOptions.setNbItems( NB_STABILIZATION );
@@ -141,6 +147,7 @@ using namespace core::behavior;
 
     CompliantImplicitSolver::~CompliantImplicitSolver() {
         if( assemblyVisitor ) delete assemblyVisitor;
+        if( assemblyCache ) delete assemblyCache;
     }
 
     void CompliantImplicitSolver::reset() {
@@ -505,7 +512,19 @@ using namespace core::behavior;
 
         // max: il ya des smart ptr pour ca.
         if( assemblyVisitor ) delete assemblyVisitor;
-        assemblyVisitor = new simulation::AssemblyVisitor(mparams);
+
+        if( cache_assembly.getValue() ) {
+            if( !assemblyCache ) {
+                assemblyCache = new simulation::AssemblyCache();
+                assemblyCache->listen( static_cast<simulation::Node*>(getContext()), this );
+            }
+        } else if( assemblyCache ) {
+            assemblyCache->unlisten();
+            delete assemblyCache;
+            assemblyCache = NULL;
+        }
+
+        assemblyVisitor = new simulation::AssemblyVisitor(mparams, assemblyCache);
 
         // fetch nodes/data
         {
@@ -21,6 +21,7 @@ namespace sofa {
 
 namespace simulation {
 class AssemblyVisitor;
+class AssemblyCache;
 
 namespace common {
 class MechanicalOperations;
@@ -201,12 +202,17 @@ class SOFA_Compliant_API CompliantImplicitSolver : public sofa::core::behavior::
 
     Data<bool> neglecting_compliance_forces_in_geometric_stiffness; ///< isn't the name clear enough?
 
+    Data<bool> cache_assembly; ///< keep the sparsity patterns of the assembly products from one step to the next
+
 
   protected:
 
     // keep a pointer on the visitor used to assemble
     simulation::AssemblyVisitor *assemblyVisitor;
 
+    // products kept between assemblies when cache_assembly is set
+    simulation::AssemblyCache *assemblyCache;
+
     /// a derivable function creating and calling the assembly visitor to create an AssembledSystem
     virtual void perform_assembly( const core::MechanicalParams *mparams, system_type& sys );
 				
@@ -2,6 +2,8 @@
 #define COMPLIANT_SPARSE_H
 
 #include <Eigen/Sparse>
+#include <vector>
+#include <algorithm>
 
 
 // easily restore default behavior
@@ -125,6 +127,55 @@ static void fast_prod_impl(ResultType& res, const Lhs& lhs, const Rhs& rhs, bool
 
 }
 
+// prototype for col-major res/lhs/rhs: accumulates lhs * rhs in the values of res,
+// whose (compressed) sparsity pattern is kept. returns false as soon as an entry of
+// the product is not in the pattern, the values of res are then meaningless.
+template<typename Lhs, typename Rhs, typename ResultType>
+static bool fast_add_prod_values_impl(ResultType& res, const Lhs& lhs, const Rhs& rhs)
+{
+    using namespace Eigen;
+    using namespace internal;
+
+    typedef typename remove_all<Lhs>::type::Scalar Scalar;
+    typedef typename remove_all<Lhs>::type::Index Index;
+
+    const Index inner = lhs.innerSize();
+    const Index outer = rhs.outerSize();
+    eigen_assert(lhs.outerSize() == rhs.innerSize());
+
+    // position in res values of the entries of the current column
+    Matrix<Index,Dynamic,1> position; position.setConstant(inner, -1);
+
+    const Index* outerIndex = res.outerIndexPtr();
+    const Index* innerIndex = res.innerIndexPtr();
+    Scalar* values = res.valuePtr();
+
+    for (Index j = 0; j < outer; ++j){
+
+        for(Index p = outerIndex[j]; p < outerIndex[j+1]; ++p) position[innerIndex[p]] = p;
+
+        bool inPattern = true;
+        for (typename Rhs::InnerIterator rhsIt(rhs, j); inPattern && rhsIt; ++rhsIt){
+            const Scalar y = rhsIt.value();
+            const Index k = rhsIt.index();
+            for (typename Lhs::InnerIterator lhsIt(lhs, k); lhsIt; ++lhsIt){
+                const Index p = position[lhsIt.index()];
+                if( p < 0 ) {
+                    inPattern = false;
+                    break;
+                }
+                values[p] += lhsIt.value() * y;
+            }
+        }
+
+        for(Index p = outerIndex[j]; p < outerIndex[j+1]; ++p) position[innerIndex[p]] = -1;
+
+        if( !inPattern ) return false;
+    }
+
+    return true;
+}
+
 template<int A, int B, int C> struct requires_equal;
 
 template<int I> struct requires_equal<I, I, I> { };
@@ -149,6 +200,11 @@ template<> struct row_bit<0> {
     static void fast_prod(ResultType& res, const Lhs& lhs, const Rhs& rhs, bool accumulate) {
         fast_prod_impl(res, lhs, rhs, accumulate);
     }
+
+    template<typename Lhs, typename Rhs, typename ResultType>
+    static bool fast_add_prod_values(ResultType& res, const Lhs& lhs, const Rhs& rhs) {
+        return fast_add_prod_values_impl(res, lhs, rhs);
+    }
    
 };
 
@@ -160,6 +216,11 @@ template<> struct row_bit<1> {
         fast_prod_impl(res, rhs, lhs, accumulate);
     }
 
+    template<typename Lhs, typename Rhs, typename ResultType>
+    static bool fast_add_prod_values(ResultType& res, const Lhs& lhs, const Rhs& rhs) {
+        return fast_add_prod_values_impl(res, rhs, lhs);
+    }
+
 };
 
 
@@ -195,6 +256,57 @@ static void fast_add_prod(ResultType& res, const Lhs& lhs, const Rhs& rhs) {
 }
 
 
+// same as fast_prod, only updating the values of res: its sparsity pattern
+// (e.g. from a previous fast_prod with the same structure) is kept. returns
+// false if the pattern does not contain the product, res must then be
+// computed again with fast_prod.
+template<typename Lhs, typename Rhs, typename ResultType>
+static bool fast_prod_values(ResultType& res, const Lhs& lhs, const Rhs& rhs, bool accumulate = false) {
+    typedef impl::row_bit< impl::check_row_major_bit<ResultType, Lhs, Rhs>::value > select;
+
+    if( res.rows() != lhs.rows() || res.cols() != rhs.cols() || !res.isCompressed() ) return false;
+
+    if( !accumulate ) std::fill(res.valuePtr(), res.valuePtr() + res.nonZeros(), 0);
+
+    return select::fast_add_prod_values(res, lhs, rhs);
+}
+
+// convenience
+template<typename Lhs, typename Rhs, typename ResultType>
+static bool fast_add_prod_values(ResultType& res, const Lhs& lhs, const Rhs& rhs) {
+    return fast_prod_values(res, lhs, rhs, true);
+}
+
+// res = m^T, only updating the values of res whose sparsity pattern must
+// be exactly the one of m^T. returns false otherwise.
+template<class Matrix>
+static bool transpose_values(Matrix& res, const Matrix& m) {
+    typedef typename Matrix::Index Index;
+
+    if( res.rows() != m.cols() || res.cols() != m.rows() || !res.isCompressed() ) return false;
+
+    const Index* outerIndex = res.outerIndexPtr();
+    const Index* innerIndex = res.innerIndexPtr();
+
+    // next entry to fill in each outer vector of res
+    std::vector<Index> next( outerIndex, outerIndex + res.outerSize() );
+
+    for( Index k = 0; k < m.outerSize(); ++k ) {
+        for( typename Matrix::InnerIterator it(m, k); it; ++it ) {
+            Index& p = next[ it.index() ];
+            if( p == outerIndex[ it.index() + 1 ] || innerIndex[p] != k ) return false;
+            res.valuePtr()[p++] = it.value();
+        }
+    }
+
+    for( Index i = 0; i < res.outerSize(); ++i ) {
+        if( next[i] != outerIndex[i + 1] ) return false;
+    }
+
+    return true;
+}
+
+
 }
 
 
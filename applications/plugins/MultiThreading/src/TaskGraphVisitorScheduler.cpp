@@ -0,0 +1,349 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include "TaskGraphVisitorScheduler.h"
+#include "TaskScheduler.h"
+
+#include <sofa/core/ObjectFactory.h>
+#include <sofa/core/BaseMapping.h>
+#include <sofa/core/behavior/BaseInteractionForceField.h>
+#include <sofa/core/behavior/BaseInteractionConstraint.h>
+#include <sofa/core/behavior/BaseInteractionProjectiveConstraintSet.h>
+#include <sofa/simulation/MechanicalVisitor.h>
+
+#include <algorithm>
+
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+SOFA_DECL_CLASS(TaskGraphVisitorScheduler)
+
+int TaskGraphVisitorSchedulerClass = core::RegisterObject("Execute the mechanical visitors of a solver on its independent child nodes in parallel")
+        .add< TaskGraphVisitorScheduler >()
+        ;
+
+
+namespace
+{
+
+void addState(helper::vector<core::behavior::BaseMechanicalState*>& states, core::behavior::BaseMechanicalState* state)
+{
+    if (state)
+        states.push_back(state);
+}
+
+/// Both vectors are sorted
+bool intersect(const helper::vector<core::behavior::BaseMechanicalState*>& a, const helper::vector<core::behavior::BaseMechanicalState*>& b)
+{
+    helper::vector<core::behavior::BaseMechanicalState*>::const_iterator ia = a.begin(), ib = b.begin();
+    while (ia != a.end() && ib != b.end())
+    {
+        if (*ia < *ib) ++ia;
+        else if (*ib < *ia) ++ib;
+        else return true;
+    }
+    return false;
+}
+
+} // anonymous namespace
+
+
+TaskGraphVisitorScheduler::TaskGraphVisitorScheduler()
+    : ParallelVisitorScheduler(false)
+    , d_threadNumber(initData(&d_threadNumber, (unsigned int)0, "threadNumber", "number of threads (0 to keep the current setting of the task scheduler)"))
+    , m_taskScheduler(nullptr)
+    , m_graphNode(nullptr)
+    , m_graphChanged(true)
+    , m_isTree(false)
+    , m_detached(false)
+{
+}
+
+TaskGraphVisitorScheduler::~TaskGraphVisitorScheduler()
+{
+    // without cleanup(), the scheduler is destroyed either with its node, whose listeners are already
+    // destroyed but whose descendants are still alive, or after having been removed from it
+    if (!m_detached)
+        m_listenedNodes.erase(std::remove(m_listenedNodes.begin(), m_listenedNodes.end(), m_graphNode), m_listenedNodes.end());
+    clearListeners();
+}
+
+void TaskGraphVisitorScheduler::init()
+{
+    m_taskScheduler = TaskScheduler::getInstance();
+    if (d_threadNumber.getValue())
+        m_taskScheduler->init(d_threadNumber.getValue());
+    m_graphChanged = true;
+}
+
+void TaskGraphVisitorScheduler::reinit()
+{
+    if (d_threadNumber.getValue() && d_threadNumber.getValue() != m_taskScheduler->getThreadCount())
+        m_taskScheduler->init(d_threadNumber.getValue());
+    m_graphChanged = true;
+}
+
+void TaskGraphVisitorScheduler::cleanup()
+{
+    clearListeners();
+    m_waves.clear();
+    m_graphNode = nullptr;
+    m_graphChanged = true;
+}
+
+ParallelVisitorScheduler* TaskGraphVisitorScheduler::clone()
+{
+    return new TaskGraphVisitorScheduler();
+}
+
+const TaskGraphVisitorScheduler::Waves& TaskGraphVisitorScheduler::getWaves(Node* node) const
+{
+    static const Waves noWaves;
+    std::map<Node*, Waves>::const_iterator it = m_waves.find(node);
+    return it != m_waves.end() ? it->second : noWaves;
+}
+
+// The nodes leaving the graph may be destroyed before the next rebuild: stop listening to them now.
+// The node sending the notification is iterating over its listeners and is kept.
+void TaskGraphVisitorScheduler::addChild(Node*, Node*) { m_graphChanged = true; }
+void TaskGraphVisitorScheduler::removeChild(Node*, Node* child) { removeListeners(child); m_graphChanged = true; }
+void TaskGraphVisitorScheduler::moveChild(Node*, Node*, Node* child) { removeListeners(child); m_graphChanged = true; }
+void TaskGraphVisitorScheduler::addObject(Node*, core::objectmodel::BaseObject*) { m_graphChanged = true; }
+void TaskGraphVisitorScheduler::moveObject(Node*, Node*, core::objectmodel::BaseObject*) { m_graphChanged = true; }
+
+void TaskGraphVisitorScheduler::removeObject(Node* parent, core::objectmodel::BaseObject* object)
+{
+    if (object == this && parent == m_graphNode)
+        m_detached = true;
+    m_graphChanged = true;
+}
+
+void TaskGraphVisitorScheduler::removeListeners(Node* node)
+{
+    helper::vector<Node*>::iterator it = std::find(m_listenedNodes.begin(), m_listenedNodes.end(), node);
+    if (it == m_listenedNodes.end())
+        return;
+    m_listenedNodes.erase(it);
+    node->removeListener(this);
+    for (Node::ChildIterator child = node->child.begin(); child != node->child.end(); ++child)
+        removeListeners(child->get());
+}
+
+void TaskGraphVisitorScheduler::clearListeners()
+{
+    for (std::size_t i = 0; i < m_listenedNodes.size(); ++i)
+        m_listenedNodes[i]->removeListener(this);
+    m_listenedNodes.clear();
+}
+
+bool TaskGraphVisitorScheduler::collectStates(Node* node, helper::vector<core::behavior::BaseMechanicalState*>& states)
+{
+    node->addListener(this);
+    m_listenedNodes.push_back(node);
+
+    bool isTree = (node == m_graphNode || node->getNbParents() <= 1);
+
+    addState(states, node->mechanicalState);
+    if (node->mechanicalMapping)
+    {
+        const helper::vector<core::behavior::BaseMechanicalState*> from = node->mechanicalMapping->getMechFrom();
+        const helper::vector<core::behavior::BaseMechanicalState*> to = node->mechanicalMapping->getMechTo();
+        states.insert(states.end(), from.begin(), from.end());
+        states.insert(states.end(), to.begin(), to.end());
+    }
+    for (unsigned i = 0; i < node->interactionForceField.size(); ++i)
+    {
+        addState(states, node->interactionForceField[i]->getMechModel1());
+        addState(states, node->interactionForceField[i]->getMechModel2());
+    }
+    for (unsigned i = 0; i < node->constraintSet.size(); ++i)
+    {
+        if (core::behavior::BaseInteractionConstraint* constraint = dynamic_cast<core::behavior::BaseInteractionConstraint*>(node->constraintSet[i]))
+        {
+            addState(states, constraint->getMechModel1());
+            addState(states, constraint->getMechModel2());
+        }
+    }
+    for (unsigned i = 0; i < node->projectiveConstraintSet.size(); ++i)
+    {
+        if (core::behavior::BaseInteractionProjectiveConstraintSet* constraint = dynamic_cast<core::behavior::BaseInteractionProjectiveConstraintSet*>(node->projectiveConstraintSet[i]))
+        {
+            addState(states, constraint->getMechModel1());
+            addState(states, constraint->getMechModel2());
+        }
+    }
+
+    // a child sub-graph is processed after all the previous ones accessing one of its states
+    Waves waves;
+    helper::vector< helper::vector<core::behavior::BaseMechanicalState*> > childStates;
+    helper::vector<std::size_t> childWaves;
+    for (Node::ChildIterator it = node->child.begin(); it != node->child.end(); ++it)
+    {
+        helper::vector<core::behavior::BaseMechanicalState*> subGraphStates;
+        isTree = collectStates(it->get(), subGraphStates) && isTree;
+
+        std::size_t wave = 0;
+        for (std::size_t i = 0; i < childStates.size(); ++i)
+            if (childWaves[i] >= wave && intersect(childStates[i], subGraphStates))
+                wave = childWaves[i] + 1;
+
+        if (wave >= waves.size())
+            waves.resize(wave + 1);
+        waves[wave].push_back(it->get());
+        states.insert(states.end(), subGraphStates.begin(), subGraphStates.end());
+        childStates.push_back(subGraphStates);
+        childWaves.push_back(wave);
+    }
+
+    // nothing to gain if all the sub-graphs depend on each other
+    if (waves.size() < node->child.size())
+        m_waves[node].swap(waves);
+
+    std::sort(states.begin(), states.end());
+    states.erase(std::unique(states.begin(), states.end()), states.end());
+    return isTree;
+}
+
+void TaskGraphVisitorScheduler::buildGraph(Node* node)
+{
+    clearListeners();
+    m_waves.clear();
+    m_graphNode = node;
+    m_graphChanged = false;
+    m_detached = false;
+
+    helper::vector<core::behavior::BaseMechanicalState*> states;
+    m_isTree = collectStates(node, states);
+
+    msg_info() << node->child.size() << " sub-graphs scheduled in " << getWaves(node).size() << " waves, "
+               << m_waves.size() << " nodes with parallel children"
+               << (m_isTree ? "" : " (not used, the graph contains nodes with several parents)");
+}
+
+void TaskGraphVisitorScheduler::executeParallelVisitor(Node* node, Visitor* action)
+{
+    BaseMechanicalVisitor* mechanicalVisitor = dynamic_cast<BaseMechanicalVisitor*>(action);
+    Visitor::TreeTraversalRepetition repeat;
+    if (!mechanicalVisitor || mechanicalVisitor->readNodeData() || mechanicalVisitor->writeNodeData()
+            || action->treeTraversal(repeat) || !m_taskScheduler)
+    {
+        doExecuteVisitor(node, action);
+        return;
+    }
+
+    if (m_graphChanged || node != m_graphNode)
+        buildGraph(node);
+
+    if (!m_isTree || m_waves.empty())
+    {
+        doExecuteVisitor(node, action);
+        return;
+    }
+
+    // the copies of the visitor are only used by the tasks, check they can be created beforehand
+    Visitor* copy = action->clone();
+    if (!copy)
+    {
+        doExecuteVisitor(node, action);
+        return;
+    }
+    delete copy;
+
+    processGraph(node, action);
+}
+
+void TaskGraphVisitorScheduler::processNode(Node* node, Visitor* visitor)
+{
+    if (!m_waves.count(node))
+    {
+        node->executeVisitor(visitor);
+        return;
+    }
+
+    if (!node->isActive()) return;
+    if (node->isSleeping() && !visitor->canAccessSleepingNode) return;
+    processGraph(node, visitor);
+}
+
+void TaskGraphVisitorScheduler::processGraph(Node* node, Visitor* visitor)
+{
+    if (visitor->processNodeTopDown(node) != Visitor::RESULT_PRUNE)
+    {
+        const bool reversed = visitor->childOrderReversed(node);
+        std::map<Node*, Waves>::const_iterator it = m_waves.find(node);
+        if (it == m_waves.end())
+        {
+            const std::size_t n = node->child.size();
+            for (std::size_t i = 0; i < n; ++i)
+                processNode(node->child[reversed ? n - 1 - i : i].get(), visitor);
+        }
+        else
+        {
+            const Waves& waves = it->second;
+            for (std::size_t w = 0; w < waves.size(); ++w)
+            {
+                const helper::vector<Node*>& nodes = waves[reversed ? waves.size() - 1 - w : w];
+
+                // each task works on its own copy of the visitor, the first sub-graph is processed by this thread
+                Task::Status status;
+                helper::vector<Visitor*> copies;
+                for (std::size_t i = 1; i < nodes.size(); ++i)
+                {
+                    copies.push_back(visitor->clone());
+                    m_taskScheduler->addTask(new VisitorTask(this, nodes[i], copies.back(), &status));
+                }
+                processNode(nodes[0], visitor);
+                if (!copies.empty())
+                    m_taskScheduler->workUntilDone(&status);
+                for (std::size_t i = 0; i < copies.size(); ++i)
+                    delete copies[i];
+            }
+        }
+    }
+    visitor->processNodeBottomUp(node);
+}
+
+
+VisitorTask::VisitorTask(TaskGraphVisitorScheduler* scheduler, Node* node, Visitor* visitor, Task::Status* status)
+    : Task(status)
+    , m_scheduler(scheduler)
+    , m_node(node)
+    , m_visitor(visitor)
+{
+}
+
+VisitorTask::~VisitorTask()
+{
+}
+
+bool VisitorTask::run()
+{
+    m_scheduler->processNode(m_node, m_visitor);
+    return true;
+}
+
+} // namespace simulation
+
+} // namespace sofa
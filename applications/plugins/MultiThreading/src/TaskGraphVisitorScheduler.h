@@ -0,0 +1,146 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_SIMULATION_TASKGRAPHVISITORSCHEDULER_H
+#define SOFA_SIMULATION_TASKGRAPHVISITORSCHEDULER_H
+
+#include <MultiThreading/config.h>
+
+#include <sofa/simulation/ParallelVisitorScheduler.h>
+#include <sofa/simulation/MutationListener.h>
+#include <sofa/core/behavior/BaseMechanicalState.h>
+
+#include "Task.h"
+
+#include <map>
+
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+class TaskScheduler;
+
+/**
+ * Execute the mechanical visitors started from the node it is attached to (typically the node of an
+ * OdeSolver) by processing the independent sub-graphs below this node as parallel tasks.
+ *
+ * For each node of the graph, a dependency graph between its child sub-graphs is built from the
+ * mechanical states each of them accesses: its own states, the inputs of its mappings and the states
+ * linked by its interaction force fields and constraints. Two sub-graphs accessing the same state are
+ * processed in the order of the scene graph, the independent ones are processed concurrently, each
+ * task working on its own copy of the visitor (see Visitor::clone). The dependency graphs are only
+ * rebuilt when the graph below the node changes.
+ *
+ * Visitors which are not thread-safe or cannot be copied, reductions (dot products) and graphs
+ * containing nodes with several parents are executed sequentially.
+ */
+class SOFA_MULTITHREADING_PLUGIN_API TaskGraphVisitorScheduler : public simulation::ParallelVisitorScheduler, public simulation::MutationListener
+{
+public:
+    SOFA_CLASS(TaskGraphVisitorScheduler, simulation::ParallelVisitorScheduler);
+
+    Data<unsigned int> d_threadNumber; ///< number of threads (0 to keep the current setting of the task scheduler)
+
+    virtual void init() override;
+    virtual void reinit() override;
+    virtual void cleanup() override;
+
+    /// Sub-graphs processed in the same wave are independent and executed concurrently
+    typedef helper::vector< helper::vector<Node*> > Waves;
+
+    /// Waves of the child sub-graphs of the node the scheduler is attached to
+    const Waves& getWaves() const { return getWaves(m_graphNode); }
+
+    /// Waves of the child sub-graphs of a node, empty if its children are processed sequentially
+    const Waves& getWaves(Node* node) const;
+
+    /// @name MutationListener API, used to detect the changes of the graph
+    /// @{
+    virtual void addChild(Node* parent, Node* child) override;
+    virtual void removeChild(Node* parent, Node* child) override;
+    virtual void moveChild(Node* previous, Node* parent, Node* child) override;
+    virtual void addObject(Node* parent, core::objectmodel::BaseObject* object) override;
+    virtual void removeObject(Node* parent, core::objectmodel::BaseObject* object) override;
+    virtual void moveObject(Node* previous, Node* parent, core::objectmodel::BaseObject* object) override;
+    /// @}
+
+protected:
+    friend class VisitorTask;
+
+    TaskGraphVisitorScheduler();
+    virtual ~TaskGraphVisitorScheduler();
+
+    virtual ParallelVisitorScheduler* clone() override;
+    virtual void executeParallelVisitor(Node* node, Visitor* action) override;
+
+    /// Compute the waves of independent sub-graphs below the given node
+    void buildGraph(Node* node);
+
+    /// Collect the mechanical states accessed while visiting a sub-graph and compute the waves of the
+    /// children of its nodes, return false if it is not a tree
+    bool collectStates(Node* node, helper::vector<core::behavior::BaseMechanicalState*>& states);
+
+    /// Execute a visitor on a node and its sub-graph, running the waves of its children in parallel
+    void processGraph(Node* node, Visitor* visitor);
+
+    /// Execute a visitor on a node below the graph node, with the same checks as Node::executeVisitor
+    void processNode(Node* node, Visitor* visitor);
+
+    /// Stop listening to the given node and its descendants
+    void removeListeners(Node* node);
+
+    void clearListeners();
+
+    TaskScheduler* m_taskScheduler;
+    Node* m_graphNode;
+    bool m_graphChanged;
+    bool m_isTree;
+    /// true when the scheduler was removed from the graph node, which is then still alive in the destructor
+    bool m_detached;
+    std::map<Node*, Waves> m_waves;
+    /// Not owned: a node is removed from this list when it leaves the graph
+    helper::vector<Node*> m_listenedNodes;
+};
+
+
+/// Execute a visitor on a sub-graph
+class VisitorTask : public Task
+{
+public:
+    VisitorTask(TaskGraphVisitorScheduler* scheduler, Node* node, Visitor* visitor, Task::Status* status);
+    virtual ~VisitorTask();
+
+    virtual bool run() final;
+
+private:
+    TaskGraphVisitorScheduler* m_scheduler;
+    Node* m_node;
+    Visitor* m_visitor;
+};
+
+} // namespace simulation
+
+} // namespace sofa
+
+#endif // SOFA_SIMULATION_TASKGRAPHVISITORSCHEDULER_H
@@ -0,0 +1,157 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <MultiThreading/src/TaskGraphVisitorScheduler.h>
+using sofa::simulation::TaskGraphVisitorScheduler ;
+
+#include <SofaTest/Sofa_test.h>
+#include <SofaSimulationCommon/SceneLoaderXML.h>
+using sofa::simulation::SceneLoaderXML ;
+using sofa::simulation::Node ;
+
+#include <SofaBaseMechanics/MechanicalObject.h>
+typedef sofa::component::container::MechanicalObject<sofa::defaulttype::Vec3Types> MechanicalObject3 ;
+
+namespace sofa
+{
+
+struct TaskGraphVisitorScheduler_test : public Sofa_test<>
+{
+    /// Five bodies falling under gravity, the two first ones are linked by a spring, the two last ones
+    /// are independent children of a group node
+    Node::SPtr createScene(bool parallel)
+    {
+        std::stringstream scene ;
+        scene << "<Node name='root' gravity='0 -9.81 0' dt='0.01'>                                        \n"
+                 "   <EulerImplicitSolver/>                                                                \n"
+                 "   <CGLinearSolver iterations='100' tolerance='1e-12' threshold='1e-12'/>                \n"
+              << (parallel ? "   <TaskGraphVisitorScheduler name='scheduler'/>                           \n" : "")
+              << "   <Node name='A'>                                                                       \n"
+                 "       <MechanicalObject name='dofs' position='0 0 0  1 0 0'/>                           \n"
+                 "       <UniformMass totalMass='1'/>                                                      \n"
+                 "       <StiffSpringForceField object1='@dofs' object2='@../B/dofs' spring='1 0 100 1 1'/>\n"
+                 "   </Node>                                                                               \n"
+                 "   <Node name='B'>                                                                       \n"
+                 "       <MechanicalObject name='dofs' position='2 1 0  3 1 0'/>                           \n"
+                 "       <UniformMass totalMass='2'/>                                                      \n"
+                 "   </Node>                                                                               \n"
+                 "   <Node name='C'>                                                                       \n"
+                 "       <MechanicalObject name='dofs' position='0 5 0  1 5 0'/>                           \n"
+                 "       <UniformMass totalMass='1'/>                                                      \n"
+                 "   </Node>                                                                               \n"
+                 "   <Node name='D'>                                                                       \n"
+                 "       <Node name='D1'>                                                                  \n"
+                 "           <MechanicalObject name='dofs' position='0 -5 0  1 -5 0'/>                     \n"
+                 "           <UniformMass totalMass='1'/>                                                  \n"
+                 "       </Node>                                                                           \n"
+                 "       <Node name='D2'>                                                                  \n"
+                 "           <MechanicalObject name='dofs' position='0 -8 0  1 -8 0'/>                     \n"
+                 "           <UniformMass totalMass='3'/>                                                  \n"
+                 "       </Node>                                                                           \n"
+                 "   </Node>                                                                               \n"
+                 "</Node>                                                                                  \n" ;
+
+        Node::SPtr root = SceneLoaderXML::loadFromMemory("testscene", scene.str().c_str(), scene.str().size()) ;
+        sofa::simulation::getSimulation()->init(root.get()) ;
+        return root ;
+    }
+
+    void animate(Node::SPtr sequential, Node::SPtr parallel, int steps)
+    {
+        for (int i = 0; i < steps; ++i)
+        {
+            sofa::simulation::getSimulation()->animate(sequential.get(), 0.01) ;
+            sofa::simulation::getSimulation()->animate(parallel.get(), 0.01) ;
+        }
+    }
+
+    void compareStates(Node::SPtr sequential, Node::SPtr parallel)
+    {
+        std::vector<MechanicalObject3*> sequentialStates, parallelStates ;
+        sequential->getTreeObjects<MechanicalObject3>(&sequentialStates) ;
+        parallel->getTreeObjects<MechanicalObject3>(&parallelStates) ;
+        ASSERT_EQ(sequentialStates.size(), parallelStates.size()) ;
+        for (std::size_t i = 0; i < sequentialStates.size(); ++i)
+        {
+            const MechanicalObject3::VecCoord& x0 = sequentialStates[i]->x.getValue() ;
+            const MechanicalObject3::VecCoord& x1 = parallelStates[i]->x.getValue() ;
+            ASSERT_EQ(x0.size(), x1.size()) ;
+            for (std::size_t j = 0; j < x0.size(); ++j)
+                EXPECT_LT((x0[j] - x1[j]).norm(), 1e-10) ;
+        }
+    }
+
+    void checkSameResults()
+    {
+        Node::SPtr sequential = createScene(false) ;
+        Node::SPtr parallel = createScene(true) ;
+        animate(sequential, parallel, 10) ;
+
+        TaskGraphVisitorScheduler* scheduler = parallel->get<TaskGraphVisitorScheduler>() ;
+        ASSERT_NE(scheduler, nullptr) ;
+        // B depends on A through the spring, C and D are independent
+        ASSERT_EQ(scheduler->getWaves().size(), 2u) ;
+        EXPECT_EQ(scheduler->getWaves()[0].size(), 3u) ;
+        EXPECT_EQ(scheduler->getWaves()[1].size(), 1u) ;
+        // the children of D are processed in parallel too
+        ASSERT_EQ(scheduler->getWaves(parallel->getChild("D")).size(), 1u) ;
+        EXPECT_EQ(scheduler->getWaves(parallel->getChild("D"))[0].size(), 2u) ;
+
+        compareStates(sequential, parallel) ;
+
+        sofa::simulation::getSimulation()->unload(sequential) ;
+        sofa::simulation::getSimulation()->unload(parallel) ;
+    }
+
+    /// The scheduler must not keep the nodes removed from the graph
+    void checkRemovedNode()
+    {
+        Node::SPtr sequential = createScene(false) ;
+        Node::SPtr parallel = createScene(true) ;
+        animate(sequential, parallel, 5) ;
+
+        sequential->removeChild(sequential->getChild("C")) ;
+        parallel->removeChild(parallel->getChild("C")) ;
+        animate(sequential, parallel, 5) ;
+
+        TaskGraphVisitorScheduler* scheduler = parallel->get<TaskGraphVisitorScheduler>() ;
+        ASSERT_NE(scheduler, nullptr) ;
+        ASSERT_EQ(scheduler->getWaves().size(), 2u) ;
+        EXPECT_EQ(scheduler->getWaves()[0].size(), 2u) ;
+
+        compareStates(sequential, parallel) ;
+
+        sofa::simulation::getSimulation()->unload(sequential) ;
+        sofa::simulation::getSimulation()->unload(parallel) ;
+    }
+};
+
+TEST_F(TaskGraphVisitorScheduler_test, sameResultsAsSequential)
+{
+    checkSameResults() ;
+}
+
+TEST_F(TaskGraphVisitorScheduler_test, removedNode)
+{
+    checkRemovedNode() ;
+}
+
+} // namespace sofa
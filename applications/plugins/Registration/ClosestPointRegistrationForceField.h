@@ -31,7 +31,7 @@
 #include <sofa/helper/OptionsGroup.h>
 #include <sofa/core/objectmodel/DataFileName.h>
 
-#include <sofa/helper/kdTree.h>
+#include <Registration/IncrementalKdTree.h>
 
 #include <set>
 #include <Registration/config.h>
@@ -80,7 +80,7 @@ public:
     typedef defaulttype::Mat<N,N,Real> Mat;
 
     typedef helper::fixed_array <unsigned int,3> tri;
-    typedef helper::kdTree<Coord> KDT;
+    typedef IncrementalKdTree<Coord> KDT;
     typedef typename KDT::distanceSet distanceSet;
     typedef typename KDT::distanceToPoint distanceToPoint;
 
@@ -139,6 +139,7 @@ protected :
     helper::vector< bool > sourceBorder;
     helper::vector< bool > sourceIgnored;  // flag ignored vertices
     helper::vector< bool > targetIgnored;  // flag ignored vertices
+    helper::vector< unsigned char > queryFailed;  // flag closest points that could not be found with the current trees
     void initSource(); // built k-d tree and identify border vertices
 
     // target mesh data
@@ -147,8 +148,10 @@ protected :
     Data< helper::vector< tri > > targetTriangles; ///< Triangles of the target mesh.
     helper::vector< distanceSet >  closestTarget; // CacheSize-closest source points from target
     KDT targetKdTree;
+    int targetCounter; // value of targetPositions counter when the k-d tree was updated
     helper::vector< bool > targetBorder;
     void initTarget();  // built k-d tree and identify border vertices
+    void updateTarget(); // update k-d tree and bounding box when target points have moved
 
     Data<float> showArrowSize; ///< size of the axis.
     Data<int> drawMode; ///< Draw Mode: 0=Line - 1=Cylinder - 2=Arrow
@@ -76,6 +76,7 @@ ClosestPointRegistrationForceField<DataTypes>::ClosestPointRegistrationForceFiel
     , targetPositions(initData(&targetPositions,"position","Vertices of the target mesh."))
     , targetNormals(initData(&targetNormals,"normals","Normals of the target mesh."))
     , targetTriangles(initData(&targetTriangles,"triangles","Triangles of the target mesh."))
+    , targetCounter(-1)
     , showArrowSize(initData(&showArrowSize,0.01f,"showArrowSize","size of the axis."))
     , drawMode(initData(&drawMode,0,"drawMode","The way springs will be drawn:\n- 0: Line\n- 1:Cylinder\n- 2: Arrow."))
     , drawColorMap(initData(&drawColorMap,false,"drawColorMap","Hue mapping of distances to closest point"))
@@ -157,15 +158,30 @@ void ClosestPointRegistrationForceField<DataTypes>::initTarget()
 {
     // build k-d tree
     const VecCoord&  p = targetPositions.getValue();
-    if(p.size()) targetKdTree.build(p);
+    targetKdTree.build(p);
+    targetCounter = targetPositions.getCounter();
 
     // updatebbox
+    targetBbox = defaulttype::BoundingBox();
     for(unsigned int i=0;i<p.size();++i)    targetBbox.include(p[i]);
 
     // detect border
     if(targetBorder.size()!=p.size()) { targetBorder.resize(p.size()); detectBorder(targetBorder,targetTriangles.getValue()); }
 }
 
+template<class DataTypes>
+void ClosestPointRegistrationForceField<DataTypes>::updateTarget()
+{
+    // the k-d tree is kept as long as the points move little
+    const VecCoord&  p = targetPositions.getValue();
+    if(targetKdTree.update(p)) closestSource.fill(distanceSet()); // cached closest points refer to the previous tree
+    targetCounter = targetPositions.getCounter();
+
+    // updatebbox
+    targetBbox = defaulttype::BoundingBox();
+    for(unsigned int i=0;i<p.size();++i)    targetBbox.include(p[i]);
+}
+
 
 
 template<class DataTypes>
@@ -178,7 +194,8 @@ void ClosestPointRegistrationForceField<DataTypes>::updateClosestPoints()
 
     distanceSet emptyset;
     if(nbs!=closestSource.size()) {initSource();  closestSource.resize(nbs);	closestSource.fill(emptyset); cacheThresh_max.resize(nbs); cacheThresh_min.resize(nbs); previousX.assign(x.begin(),x.end());}
-    if(nbt!=closestTarget.size()) {initTarget();  closestTarget.resize(nbt);	closestTarget.fill(emptyset);}
+    if(nbt!=closestTarget.size()) {initTarget();  closestTarget.resize(nbt);	closestTarget.fill(emptyset); closestSource.fill(emptyset);}
+    else if(targetCounter!=targetPositions.getCounter()) updateTarget();
 
     this->sourceIgnored.resize(nbs); sourceIgnored.fill(false);
     this->targetIgnored.resize(nbt); targetIgnored.fill(false);
@@ -188,23 +205,61 @@ void ClosestPointRegistrationForceField<DataTypes>::updateClosestPoints()
     // closest target points from source points
     if(blendingFactor.getValue()<1) {
 
+        // while target points are the ones of the k-d tree, cached closest points are used
+        // otherwise closest points are searched among the candidates of the k-d tree
+        const bool cached = targetKdTree.getDisplacement()==0;
+        queryFailed.resize(nbs); queryFailed.fill(0);
+
         //unsigned int count=0;
 #ifdef _OPENMP
 #pragma omp parallel for
 #endif
         for(int i=0;i<(int)nbs;i++)
             if(rejectOutsideBbox.getValue() && !targetBbox.contains(x[i])) sourceIgnored[i]=true;
-            else targetKdTree.getNClosestCached(closestSource[i], cacheThresh_max[i], cacheThresh_min[i], this->previousX[i], x[i], this->targetPositions.getValue(), this->cacheSize.getValue());
+            else if(cached) targetKdTree.getNClosestCached(closestSource[i], cacheThresh_max[i], cacheThresh_min[i], this->previousX[i], x[i], tp, this->cacheSize.getValue());
+            else
+            {
+                queryFailed[i] = !targetKdTree.getNClosest(closestSource[i], x[i], tp, this->cacheSize.getValue(), this->cacheSize.getValue());
+                cacheThresh_max[i].first=0; // invalidate the cache
+            }
+
+        // target points have moved too much: rebuild the tree for the failed queries
+        unsigned int nbFailed=0; for(unsigned int i=0;i<nbs;i++) if(queryFailed[i]) nbFailed++;
+        if(nbFailed)
+        {
+            targetKdTree.build(tp);
+            if(4*nbFailed>nbs) targetKdTree.rebuildAtNextUpdate();
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+            for(int i=0;i<(int)nbs;i++)
+                if(queryFailed[i]) targetKdTree.getNClosestCached(closestSource[i], cacheThresh_max[i], cacheThresh_min[i], this->previousX[i], x[i], tp, this->cacheSize.getValue());
+        }
     }
     // closest source points from target points
     if(blendingFactor.getValue()>0)
     {
-        initSource();
+        // the k-d tree is kept as long as the source points move little
+        sourceKdTree.update(x);
+        queryFailed.resize(nbt); queryFailed.fill(0);
 #ifdef _OPENMP
 #pragma omp parallel for
 #endif
         for(int i=0;i<(int)nbt;i++)
-            sourceKdTree.getNClosest(closestTarget[i],tp[i], this->mstate->read(core::ConstVecCoordId::position())->getValue(),1);
+            queryFailed[i] = !sourceKdTree.getNClosest(closestTarget[i],tp[i],x,1,this->cacheSize.getValue());
+
+        // source points have moved too much: rebuild the tree for the failed queries
+        unsigned int nbFailed=0; for(unsigned int i=0;i<nbt;i++) if(queryFailed[i]) nbFailed++;
+        if(nbFailed)
+        {
+            sourceKdTree.build(x);
+            if(4*nbFailed>nbt) sourceKdTree.rebuildAtNextUpdate();
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+            for(int i=0;i<(int)nbt;i++)
+                if(queryFailed[i]) sourceKdTree.getNClosest(closestTarget[i],tp[i],x,1,1);
+        }
     }
 
 
@@ -0,0 +1,119 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef REGISTRATION_INCREMENTALKDTREE_H
+#define REGISTRATION_INCREMENTALKDTREE_H
+
+#include <sofa/helper/kdTree.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace forcefield
+{
+
+/**
+*  k-d tree over moving points, for closest point queries repeated at each time step.
+*  - the tree is built on a copy of the positions, and kept while the points move (update(p) only measures how much they moved)
+*  - getNClosest() retrieves candidates in the tree, and returns their current distances. The closest point is guaranteed:
+*    points outside the candidates were farther than the last candidate when the tree was built, minus their displacement.
+*    When this does not allow to conclude, getNClosest() returns false, and the tree has to be rebuilt for this query.
+**/
+
+template<class Coord>
+class IncrementalKdTree : public helper::kdTree<Coord>
+{
+public:
+    typedef helper::kdTree<Coord> Inherit;
+    typedef typename Inherit::Real Real;
+    typedef typename Inherit::VecCoord VecCoord;
+    typedef typename Inherit::distanceToPoint distanceToPoint;
+    typedef typename Inherit::distanceSet distanceSet;
+    typedef typename Inherit::distanceSetIt distanceSetIt;
+
+    IncrementalKdTree() : displacement(0), rebuildRequired(true) {}
+
+    /// rebuild the tree from the current positions
+    void build(const VecCoord& positions)
+    {
+        treePositions = positions;
+        displacement = 0;
+        rebuildRequired = false;
+        if(treePositions.size()) Inherit::build(treePositions);
+    }
+
+    /// update the tree with the current positions: it is only rebuilt when required
+    /// @returns true if the tree has been rebuilt
+    bool update(const VecCoord& positions)
+    {
+        if(rebuildRequired || positions.size()!=treePositions.size()) { build(positions); return true; }
+        Real d2 = 0;
+        for(std::size_t i=0; i<positions.size(); i++) d2 = std::max(d2, (positions[i]-treePositions[i]).norm2());
+        displacement = std::sqrt(d2);
+        return false;
+    }
+
+    /// force the tree to be rebuilt at next update (e.g. when points move too fast for the tree to be reused)
+    void rebuildAtNextUpdate() { rebuildRequired = true; }
+
+    /// maximum distance between the current positions and the ones used to build the tree
+    Real getDisplacement() const { return displacement; }
+
+    /// positions used to build the tree
+    const VecCoord& getTreePositions() const { return treePositions; }
+
+    /// get an ordered set of n distance/index pairs between current positions and x, among nbCandidates points retrieved in the tree
+    /// @returns false if the closest point cannot be guaranteed
+    bool getNClosest(distanceSet &cl, const Coord &x, const VecCoord& positions, const unsigned int n, const unsigned int nbCandidates) const
+    {
+        if(displacement==0) { Inherit::getNClosest(cl,x,positions,n); return true; }
+
+        distanceSet candidates;
+        Inherit::getNClosest(candidates,x,treePositions,std::max(std::max(n,nbCandidates),(unsigned int)2));
+        cl.clear();
+        for(distanceSetIt it=candidates.begin(); it!=candidates.end(); it++) cl.insert(distanceToPoint((positions[it->second]-x).norm(),it->second));
+        while(cl.size()>n) { distanceSetIt it=cl.end(); it--; cl.erase(it); }
+
+        // all points are candidates
+        if(candidates.size()==treePositions.size()) return true;
+        // other points are at least at this distance
+        return cl.size() && cl.begin()->first <= candidates.rbegin()->first - displacement;
+    }
+
+protected:
+    VecCoord treePositions;
+    Real displacement;
+    bool rebuildRequired;
+};
+
+} // namespace forcefield
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
@@ -0,0 +1,130 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <Registration/IncrementalKdTree.h>
+
+#include <sofa/defaulttype/VecTypes.h>
+#include <sofa/helper/random.h>
+
+#include <sofa/helper/testing/BaseTest.h>
+using sofa::helper::testing::BaseTest ;
+
+
+namespace sofa {
+
+
+/**  Test suite for IncrementalKdTree: the closest points found in a tree built on former
+ *   positions are compared with a brute force search on the current positions.
+ */
+
+struct IncrementalKdTreeTest: public BaseTest
+{
+    typedef SReal Real;
+    typedef defaulttype::Vec<3,Real> Coord;
+    typedef std::vector<Coord> VecCoord;
+
+    typedef component::forcefield::IncrementalKdTree<Coord> KDT;
+    typedef KDT::distanceSet distanceSet;
+
+    void generateRandomPoint(VecCoord &position,const unsigned int nbp, const Real range)
+    {
+        position.clear();
+        position.reserve(nbp);
+        for(unsigned int i=0;i<nbp;i++) position.push_back(Coord(Real(helper::drand(range)),Real(helper::drand(range)),Real(helper::drand(range))));
+    }
+
+    /// brute detection = gold standard
+    Real getClosestDistance(const Coord& p, const VecCoord &position)
+    {
+        Real d = std::numeric_limits<Real>::max();
+        for(unsigned int i=0;i<position.size();i++) d = std::min(d,(p-position[i]).norm());
+        return d;
+    }
+
+    /// move the target points nbSteps times by at most dprange, and check the closest target points
+    /// of the source points: when the tree certifies its result it must be the closest point,
+    /// otherwise the result after a rebuild must be.
+    /// @returns the number of queries the tree could not certify
+    unsigned int testMovingTarget(const unsigned int nbSteps, const unsigned int nbp_source, const unsigned int nbp_target, const Real range, const Real dprange, const unsigned int nbCandidates)
+    {
+        VecCoord sourceposition;
+        generateRandomPoint(sourceposition,nbp_source,range);
+        VecCoord targetposition;
+        generateRandomPoint(targetposition,nbp_target,range);
+
+        KDT tree;
+        EXPECT_TRUE( tree.update(targetposition) );
+
+        unsigned int nbFailed = 0;
+        for(unsigned int step=0;step<nbSteps;step++)
+        {
+            VecCoord displacement;
+            generateRandomPoint(displacement,nbp_target,dprange);
+            for(unsigned int i=0;i<nbp_target;i++) targetposition[i] += displacement[i] - Coord(dprange,dprange,dprange)*0.5;
+
+            // the tree is kept while the points move
+            EXPECT_FALSE( tree.update(targetposition) );
+            EXPECT_GT( tree.getDisplacement(), 0 );
+
+            for(unsigned int i=0;i<nbp_source;i++)
+            {
+                const Real brute = getClosestDistance(sourceposition[i],targetposition);
+                distanceSet closest;
+                if(tree.getNClosest(closest,sourceposition[i],targetposition,1,nbCandidates))
+                {
+                    EXPECT_EQ( brute, closest.begin()->first );
+                    EXPECT_EQ( brute, (sourceposition[i]-targetposition[closest.begin()->second]).norm() );
+                }
+                else
+                {
+                    nbFailed++;
+                    KDT rebuilt;
+                    rebuilt.build(targetposition);
+                    EXPECT_TRUE( rebuilt.getNClosest(closest,sourceposition[i],targetposition,1,nbCandidates) );
+                    EXPECT_EQ( brute, (sourceposition[i]-targetposition[closest.begin()->second]).norm() );
+                }
+            }
+        }
+
+        // a rebuild resets the displacement
+        tree.rebuildAtNextUpdate();
+        EXPECT_TRUE( tree.update(targetposition) );
+        EXPECT_EQ( 0, tree.getDisplacement() );
+        return nbFailed;
+    }
+};
+
+TEST_F(IncrementalKdTreeTest, smallDisplacements )
+{
+    // the points barely move: nearly all the queries are certified
+    const unsigned int nbp_source=100, nbSteps=10;
+    const unsigned int nbFailed = this->testMovingTarget(nbSteps,nbp_source,1000,1.,1E-4,5);
+    EXPECT_LT( nbFailed, nbSteps*nbp_source/10 );
+}
+
+TEST_F(IncrementalKdTreeTest, largeDisplacements )
+{
+    // the points move more than their spacing: queries fail and the tree has to be rebuilt
+    const unsigned int nbFailed = this->testMovingTarget(5,100,1000,1.,0.5,5);
+    EXPECT_GT( nbFailed, 0u );
+}
+
+}// namespace sofa
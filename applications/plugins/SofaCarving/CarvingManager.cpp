@@ -171,6 +171,11 @@ void CarvingManager::doCarve()
     const ContactVector* contacts = NULL;
     core::collision::NarrowPhaseDetection::DetectionOutputMap::const_iterator it = detectionOutputs.begin(); 
     
+    // the elements carved from all the surfaces are removed at once at the end of the step,
+    // the contacts of all the surfaces refer to their topologies before any removal
+    static TopologicalChangeManager manager;
+    manager.beginTransaction();
+
     for (it = detectionOutputs.begin(); it != detectionOutputs.end(); ++it)
     {
         contacts = dynamic_cast<const ContactVector*>(it->second);
@@ -181,7 +186,6 @@ void CarvingManager::doCarve()
         if (ncontacts == 0)
             continue;
 
-        int nbelems = 0;
         helper::vector<int> elemsToRemove;
 
         for (size_t j = 0; j < ncontacts; ++j)
@@ -195,17 +199,18 @@ void CarvingManager::doCarve()
             }
         }
 
-        sofa::helper::AdvancedTimer::stepBegin("CarveElems");
         if (!elemsToRemove.empty())
         {
-            static TopologicalChangeManager manager;
             if (it->first.first == m_toolCollisionModel)
-                nbelems += manager.removeItemsFromCollisionModel(it->first.second, elemsToRemove);
+                manager.removeItemsFromCollisionModel(it->first.second, elemsToRemove);
             else
-                nbelems += manager.removeItemsFromCollisionModel(it->first.first, elemsToRemove);
+                manager.removeItemsFromCollisionModel(it->first.first, elemsToRemove);
         }
     }
     
+    sofa::helper::AdvancedTimer::stepBegin("CarveElems");
+    manager.commitTransaction();
+    sofa::helper::AdvancedTimer::stepEnd("CarveElems");
 
     m_detectionNP->setInstance(NULL);
 }
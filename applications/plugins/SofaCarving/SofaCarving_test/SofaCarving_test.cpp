@@ -23,6 +23,7 @@
 #include <sofa/helper/system/FileRepository.h>
 #include <SofaCarving/CarvingManager.h>
 #include <SofaSimulationGraph/SimpleApi.h>
+#include <SofaUserInteraction/TopologicalChangeManager.h>
 
 using namespace sofa::helper::testing;
 using namespace sofa::component::collision;
@@ -47,6 +48,7 @@ public:
     bool ManagerInit();
     bool doCarving();
     bool doCarvingWithPenetration();
+    bool removeInTransaction();
 
 private:
     sofa::simulation::Simulation::SPtr m_simu;
@@ -311,6 +313,64 @@ bool SofaCarving_test::doCarvingWithPenetration()
 }
 
 
+bool SofaCarving_test::removeInTransaction()
+{
+    // remove the same triangles from a scene directly and from another scene in a transaction
+    std::vector<int> removed[2];
+    for (unsigned int scene = 0; scene < 2; ++scene)
+    {
+        createScene("0.1");
+        m_simu->init(m_root.get());
+
+        sofa::simulation::Node* cylinder = m_root->getChild("cylinder");
+        sofa::core::topology::BaseMeshTopology* topo = cylinder->getMeshTopology();
+        TriangleModel* triangles = NULL;
+        cylinder->getChild("Surface")->get(triangles);
+        EXPECT_NE(triangles, nullptr);
+        if (triangles == NULL)
+            return false;
+
+        TopologicalChangeManager manager;
+        if (scene == 0)
+        {
+            sofa::helper::vector<int> indices;
+            for (int i = 0; i < 10; ++i)
+                indices.push_back(i);
+            manager.removeItemsFromCollisionModel(triangles, indices);
+        }
+        else
+        {
+            sofa::helper::vector<int> indices1, indices2;
+            for (int i = 0; i < 6; ++i)
+                indices1.push_back(i);
+            for (int i = 4; i < 10; ++i)
+                indices2.push_back(i);
+
+            manager.beginTransaction();
+            EXPECT_TRUE(manager.isInTransaction());
+            manager.removeItemsFromCollisionModel(triangles, indices1);
+            manager.removeItemsFromCollisionModel(triangles, indices2);
+
+            // nothing is removed before the commit
+            EXPECT_EQ(topo->getNbTetrahedra(), 2430);
+            EXPECT_GT(manager.commitTransaction(), 0);
+            EXPECT_FALSE(manager.isInTransaction());
+        }
+
+        removed[scene].push_back(topo->getNbPoints());
+        removed[scene].push_back(topo->getNbEdges());
+        removed[scene].push_back(topo->getNbTriangles());
+        removed[scene].push_back(topo->getNbTetrahedra());
+        EXPECT_LT(topo->getNbTetrahedra(), 2430);
+
+        m_simu->unload(m_root);
+    }
+
+    EXPECT_EQ(removed[0], removed[1]);
+
+    return true;
+}
+
 
 TEST_F(SofaCarving_test, testManagerEmpty)
 {
@@ -333,3 +393,8 @@ TEST_F(SofaCarving_test, testdoCarvingWithPenetration)
 }
 
 
+
+TEST_F(SofaCarving_test, testRemoveInTransaction)
+{
+    ASSERT_TRUE(removeInTransaction());
+}
@@ -34,10 +34,13 @@
 
 #include <fstream>
 #include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <algorithm>
 
 #include <sofa/helper/logging/Messaging.h>
+#include <sofa/helper/system/FileSystem.h>
 
-#define FMM_VERBOSE false
 
 namespace sofa
 {
@@ -55,6 +58,7 @@ namespace _distancegrid_
 {
 
 using namespace defaulttype;
+using helper::system::FileSystem;
 
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
@@ -136,7 +140,8 @@ bool DistanceGrid::release()
 //todo(dmarchal) we should make a loader for that...
 DistanceGrid* DistanceGrid::load(const std::string& filename,
                                  double scale, double sampling,
-                                 int nx, int ny, int nz, Coord pmin, Coord pmax)
+                                 int nx, int ny, int nz, Coord pmin, Coord pmax,
+                                 const std::string& cacheDirectory)
 {
     double absscale=fabs(scale);
     if (filename == "#cube")
@@ -251,6 +256,21 @@ DistanceGrid* DistanceGrid::load(const std::string& filename,
     }
     else if (filename.length()>4 && filename.substr(filename.length()-4) == ".obj")
     {
+        std::string cacheFilename;
+        if (!cacheDirectory.empty())
+        {
+            cacheFilename = getCacheFilename(cacheDirectory, filename, scale, sampling, nx, ny, nz, pmin, pmax);
+            if (!cacheFilename.empty())
+            {
+                DistanceGrid* grid = loadCache(cacheFilename);
+                if (grid)
+                {
+                    msg_info("DistanceGrid")<< "Reusing distance grid of " << filename << " cached in " << cacheFilename;
+                    return grid;
+                }
+            }
+        }
+
         Mesh* mesh = Mesh::Create(filename);
         const helper::vector<Vector3> & vertices = mesh->getVertices();
 
@@ -297,6 +317,8 @@ DistanceGrid* DistanceGrid::load(const std::string& filename,
         }
         grid->computeBBox();
         delete mesh;
+        if (!cacheFilename.empty())
+            grid->saveCache(cacheFilename);
         return grid;
     }
     else
@@ -611,554 +633,317 @@ void DistanceGrid::calcCubeDistance(SReal dim, int np)
     m_bbmax = Coord( dim, dim, dim);
 }
 
+namespace
+{
+
+/// State of the cells while computing the distance field: the cells at the ends of the grid edges
+/// crossing the surface are known to be inside or outside, the other ones are decided afterward
+enum SweepStatus { SWEEP_FAR = 0, SWEEP_OUT = 1, SWEEP_IN = 2 };
+
+/// Minimum number of cells per thread when computing the distance field
+enum { ParallelMinSize = 4096 };
+
+/// Triangle of the mesh with the range of cells whose edges can cross it
+struct SeedTriangle
+{
+    Coord p0, p1, p2;
+    Coord normal;
+    SReal d;
+    int ix0, iy0, iz0, ix1, iy1, iz1;
+};
+
+/// Initialize a cell from a crossing point of one of its edges, keeping the nearest one
+inline void seedCell(SReal* dists, unsigned char* status, int ind, SReal dist, bool inside)
+{
+    if (dist < dists[ind])
+    {
+        // nearest triangle
+        dists[ind] = dist;
+        status[ind] = (inside ? SWEEP_IN : SWEEP_OUT);
+    }
+}
+
+/// Update the distance of a cell from one of its neighbors, unless it is initialized from the surface
+struct DistanceRelax
+{
+    SReal* dists;
+    const unsigned char* status;
+    SReal width[3];
+
+    int operator()(int ind, int ind2, int axis) const
+    {
+        if (status[ind] != SWEEP_FAR) return 0;
+        const SReal dist = dists[ind2] + width[axis];
+        if (!(dist < dists[ind])) return 0;
+        dists[ind] = dist;
+        return 1;
+    }
+};
+
+/// Give the smallest label to two neighbor cells which are not initialized from the surface (labelled -1)
+struct RegionRelax
+{
+    int* regions;
+
+    int operator()(int ind, int ind2, int) const
+    {
+        const int r = regions[ind2];
+        if (r < 0 || !(r < regions[ind])) return 0;
+        regions[ind] = r;
+        return 1;
+    }
+};
+
+/// Sweep the grid along each axis in both directions, updating each cell from its previous neighbor.
+/// Each step works on independent lines or slabs of cells, distributed over the threads.
+/// Returns the number of updated cells.
+template<class Relax>
+int sweepGrid(const Relax& relax, int nx, int ny, int nz)
+{
+    const int nxny = nx*ny;
+    const int nyz = ny*nz;
+    int changes = 0;
+
+    // X lines
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:changes) if(nxny*nz >= ParallelMinSize)
+#endif
+    for (int l=0; l<nyz; l++)
+    {
+        const int ind0 = l*nx;
+        for (int x=1; x<nx; x++)
+            changes += relax(ind0+x, ind0+x-1, 0);
+        for (int x=nx-2; x>=0; x--)
+            changes += relax(ind0+x, ind0+x+1, 0);
+    }
+
+    // Y rows within each Z slice
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:changes) if(nxny*nz >= ParallelMinSize)
+#endif
+    for (int z=0; z<nz; z++)
+    {
+        const int ind0 = z*nxny;
+        for (int y=1; y<ny; y++)
+            for (int x=0; x<nx; x++)
+                changes += relax(ind0+y*nx+x, ind0+(y-1)*nx+x, 1);
+        for (int y=ny-2; y>=0; y--)
+            for (int x=0; x<nx; x++)
+                changes += relax(ind0+y*nx+x, ind0+(y+1)*nx+x, 1);
+    }
+
+    // Z rows within each Y slice
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:changes) if(nxny*nz >= ParallelMinSize)
+#endif
+    for (int y=0; y<ny; y++)
+    {
+        const int ind0 = y*nx;
+        for (int z=1; z<nz; z++)
+            for (int x=0; x<nx; x++)
+                changes += relax(ind0+z*nxny+x, ind0+(z-1)*nxny+x, 2);
+        for (int z=nz-2; z>=0; z--)
+            for (int x=0; x<nx; x++)
+                changes += relax(ind0+z*nxny+x, ind0+(z+1)*nxny+x, 2);
+    }
+
+    return changes;
+}
+
+} // namespace
+
 /// Compute distance field from given mesh
+///
+/// The cells at both ends of the grid edges crossing the surface are initialized with their
+/// distance to the surface. These distances are then propagated to the other cells by sweeping
+/// the grid along each axis in both directions until nothing changes.
 void DistanceGrid::calcDistance(sofa::helper::io::Mesh* mesh, double scale)
 {
-    m_fmm_status.resize(m_nxnynz);
-    m_fmm_heap.resize(m_nxnynz);
-    m_fmm_heap_size = 0;
-    dmsg_info("DistanceGrid")<< "FMM: Init.";
+    dmsg_info("DistanceGrid")<< "Distance: Init.";
 
-    std::fill(m_fmm_status.begin(), m_fmm_status.end(), FMM_FAR);
+    helper::vector<unsigned char> status(m_nxnynz, (unsigned char)SWEEP_FAR);
     std::fill(m_dists.begin(), m_dists.end(), maxDist());
+    if (m_nxnynz == 0) return;
+    SReal* dists = &m_dists[0];
+    unsigned char* st = &status[0];
 
     const helper::vector<Vector3> & vertices = mesh->getVertices();
     const helper::vector<helper::vector<helper::vector<int> > > & facets = mesh->getFacets();
 
-    // Initialize distance of edges crossing triangles
-    dmsg_info("DistanceGrid")<< "FMM: Initialize distance of edges crossing triangles.";
-
+    helper::vector<SeedTriangle> triangles;
     for (unsigned int i=0; i<facets.size(); i++)
     {
         const helper::vector<int>& pts = facets[i][0];
-        const int pt0 = 0;
-        const Coord p0 = vertices[pts[pt0]]*scale;
         for (unsigned int pt2=2; pt2<pts.size(); pt2++)
         {
-            const int pt1 = pt2-1;
-            const Coord p1 = vertices[pts[pt1]]*scale;
-            const Coord p2 = vertices[pts[pt2]]*scale;
-            Coord bbmin = p0, bbmax = p0;
-            for (int c=0; c<3; c++)
-                if (p1[c] < bbmin[c]) bbmin[c] = p1[c];
-                else if (p1[c] > bbmax[c]) bbmax[c] = p1[c];
-            for (int c=0; c<3; c++)
-                if (p2[c] < bbmin[c]) bbmin[c] = p2[c];
-                else if (p2[c] > bbmax[c]) bbmax[c] = p2[c];
-
-            Coord normal = (p1-p0).cross(p2-p0);
-            normal.normalize();
-            SReal d = -(p0*normal);
-            int nedges = 0;
-            int ix0 = ix(bbmin)-1; if (ix0 < 0) ix0 = 0;
-            int iy0 = iy(bbmin)-1; if (iy0 < 0) iy0 = 0;
-            int iz0 = iz(bbmin)-1; if (iz0 < 0) iz0 = 0;
-            int ix1 = ix(bbmax)+2; if (ix1 >= m_nx) ix1 = m_nx-1;
-            int iy1 = iy(bbmax)+2; if (iy1 >= m_ny) iy1 = m_ny-1;
-            int iz1 = iz(bbmax)+2; if (iz1 >= m_nz) iz1 = m_nz-1;
-            for (int z=iz0; z<iz1; z++)
-                for (int y=iy0; y<iy1; y++)
-                    for (int x=ix0; x<ix1; x++)
+            SeedTriangle t;
+            t.p0 = vertices[pts[0]]*scale;
+            t.p1 = vertices[pts[pt2-1]]*scale;
+            t.p2 = vertices[pts[pt2]]*scale;
+            triangles.push_back(t);
+        }
+    }
+    const int nbTriangles = (int)triangles.size();
+
+#ifdef _OPENMP
+#pragma omp parallel for if(nbTriangles >= 256)
+#endif
+    for (int i=0; i<nbTriangles; i++)
+    {
+        SeedTriangle& t = triangles[i];
+        Coord bbmin = t.p0, bbmax = t.p0;
+        for (int c=0; c<3; c++)
+            if (t.p1[c] < bbmin[c]) bbmin[c] = t.p1[c];
+            else if (t.p1[c] > bbmax[c]) bbmax[c] = t.p1[c];
+        for (int c=0; c<3; c++)
+            if (t.p2[c] < bbmin[c]) bbmin[c] = t.p2[c];
+            else if (t.p2[c] > bbmax[c]) bbmax[c] = t.p2[c];
+
+        t.normal = (t.p1-t.p0).cross(t.p2-t.p0);
+        t.normal.normalize();
+        t.d = -(t.p0*t.normal);
+        t.ix0 = ix(bbmin)-1; if (t.ix0 < 0) t.ix0 = 0;
+        t.iy0 = iy(bbmin)-1; if (t.iy0 < 0) t.iy0 = 0;
+        t.iz0 = iz(bbmin)-1; if (t.iz0 < 0) t.iz0 = 0;
+        t.ix1 = ix(bbmax)+2; if (t.ix1 >= m_nx) t.ix1 = m_nx-1;
+        t.iy1 = iy(bbmax)+2; if (t.iy1 >= m_ny) t.iy1 = m_ny-1;
+        t.iz1 = iz(bbmax)+2; if (t.iz1 >= m_nz) t.iz1 = m_nz-1;
+    }
+
+    // Initialize distance of edges crossing triangles
+    dmsg_info("DistanceGrid")<< "Distance: Initialize distance of edges crossing triangles.";
+
+    // The grid is split in slabs along Z, each one only writing its own cells. Within a slab the
+    // triangles are processed in order, so that the nearest one is chosen as in a sequential loop.
+    const int nbSlabs = (m_nz < 64 ? m_nz : 64);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) if(nbTriangles >= 256)
+#endif
+    for (int s=0; s<nbSlabs; s++)
+    {
+        const int z0 = (m_nz*s)/nbSlabs;
+        const int z1 = (m_nz*(s+1))/nbSlabs;
+        for (int i=0; i<nbTriangles; i++)
+        {
+            const SeedTriangle& t = triangles[i];
+            // the Z edges of the cells just below the slab end in it
+            const int zb = (t.iz0 > z0-1 ? t.iz0 : z0-1);
+            const int ze = (t.iz1 < z1 ? t.iz1 : z1);
+            for (int z=zb; z<ze; z++)
+            {
+                const bool own = (z >= z0);
+                const bool own2 = (z+1 < z1);
+                for (int y=t.iy0; y<t.iy1; y++)
+                    for (int x=t.ix0; x<t.ix1; x++)
                     {
                         Coord pos = coord(x,y,z);
                         int ind = index(x,y,z);
-                        SReal dist = pos*normal + d;
-                        //if (rabs(dist) > cellWidth) continue; // no edge from this point can cross the plane
+                        SReal dist = pos*t.normal + t.d;
 
                         // X edge
-                        if (rabs(normal[0]) > 1e-6)
+                        if (own && rabs(t.normal[0]) > 1e-6)
                         {
-                            SReal dist1 = -dist / normal[0];
-                            int ind2 = ind+1;
-                            if (dist1 >= -0.01*m_cellWidth[0] && dist1 <= 1.01*m_cellWidth[0])
+                            SReal dist1 = -dist / t.normal[0];
+                            if (dist1 >= -0.01*m_cellWidth[0] && dist1 <= 1.01*m_cellWidth[0]
+                                && pointInTriangle<1,2>(pos,t.p0,t.p1,t.p2))
                             {
-                                // edge crossed plane
-                                if (pointInTriangle<1,2>(pos,p0,p1,p2))
-                                {
-                                    // edge crossed triangle
-                                    ++nedges;
-                                    SReal dist2 = m_cellWidth[0] - dist1;
-                                    if (normal[0]<0)
-                                    {
-                                        // p1 is in outside, p2 inside
-                                        if (dist1 < (m_dists[ind]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind] = dist1;
-                                            m_fmm_status[ind] = FMM_KNOWN_OUT;
-                                        }
-                                        if (dist2 < (m_dists[ind2]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind2] = dist2;
-                                            m_fmm_status[ind2] = FMM_KNOWN_IN;
-                                        }
-                                    }
-                                    else
-                                    {
-                                        // p1 is in inside, p2 outside
-                                        if (dist1 < (m_dists[ind]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind] = dist1;
-                                            m_fmm_status[ind] = FMM_KNOWN_IN;
-                                        }
-                                        if (dist2 < (m_dists[ind2]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind2] = dist2;
-                                            m_fmm_status[ind2] = FMM_KNOWN_OUT;
-                                        }
-                                    }
-                                }
+                                // edge crossed triangle, the first point is outside if the normal is opposite to the edge
+                                seedCell(dists, st, ind, dist1, t.normal[0] >= 0);
+                                seedCell(dists, st, ind+1, m_cellWidth[0] - dist1, t.normal[0] < 0);
                             }
                         }
 
                         // Y edge
-                        if (rabs(normal[1]) > 1e-6)
+                        if (own && rabs(t.normal[1]) > 1e-6)
                         {
-                            SReal dist1 = -dist / normal[1];
-                            int ind2 = ind+m_nx;
-                            if (dist1 >= -0.01*m_cellWidth[1] && dist1 <= 1.01*m_cellWidth[1])
+                            SReal dist1 = -dist / t.normal[1];
+                            if (dist1 >= -0.01*m_cellWidth[1] && dist1 <= 1.01*m_cellWidth[1]
+                                && pointInTriangle<2,0>(pos,t.p0,t.p1,t.p2))
                             {
-                                // edge crossed plane
-                                if (pointInTriangle<2,0>(pos,p0,p1,p2))
-                                {
-                                    // edge crossed triangle
-                                    ++nedges;
-                                    SReal dist2 = m_cellWidth[1] - dist1;
-                                    if (normal[1]<0)
-                                    {
-                                        // p1 is in outside, p2 inside
-                                        if (dist1 < (m_dists[ind]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind] = dist1;
-                                            m_fmm_status[ind] = FMM_KNOWN_OUT;
-                                        }
-                                        if (dist2 < (m_dists[ind2]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind2] = dist2;
-                                            m_fmm_status[ind2] = FMM_KNOWN_IN;
-                                        }
-                                    }
-                                    else
-                                    {
-                                        // p1 is in inside, p2 outside
-                                        if (dist1 < (m_dists[ind]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind] = dist1;
-                                            m_fmm_status[ind] = FMM_KNOWN_IN;
-                                        }
-                                        if (dist2 < (m_dists[ind2]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind2] = dist2;
-                                            m_fmm_status[ind2] = FMM_KNOWN_OUT;
-                                        }
-                                    }
-                                }
+                                seedCell(dists, st, ind, dist1, t.normal[1] >= 0);
+                                seedCell(dists, st, ind+m_nx, m_cellWidth[1] - dist1, t.normal[1] < 0);
                             }
                         }
 
                         // Z edge
-                        if (rabs(normal[2]) > 1e-6)
+                        if (rabs(t.normal[2]) > 1e-6)
                         {
-                            SReal dist1 = -dist / normal[2];
-                            int ind2 = ind+m_nxny;
-                            if (dist1 >= -0.01*m_cellWidth[2] && dist1 <= 1.01*m_cellWidth[2])
+                            SReal dist1 = -dist / t.normal[2];
+                            if (dist1 >= -0.01*m_cellWidth[2] && dist1 <= 1.01*m_cellWidth[2]
+                                && pointInTriangle<0,1>(pos,t.p0,t.p1,t.p2))
                             {
-                                // edge crossed plane
-                                if (pointInTriangle<0,1>(pos,p0,p1,p2))
-                                {
-                                    // edge crossed triangle
-                                    ++nedges;
-                                    SReal dist2 = m_cellWidth[2] - dist1;
-                                    if (normal[2]<0)
-                                    {
-                                        // p1 is in outside, p2 inside
-                                        if (dist1 < (m_dists[ind]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind] = dist1;
-                                            m_fmm_status[ind] = FMM_KNOWN_OUT;
-                                        }
-                                        if (dist2 < (m_dists[ind2]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind2] = dist2;
-                                            m_fmm_status[ind2] = FMM_KNOWN_IN;
-                                        }
-                                    }
-                                    else
-                                    {
-                                        // p1 is in inside, p2 outside
-                                        if (dist1 < (m_dists[ind]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind] = dist1;
-                                            m_fmm_status[ind] = FMM_KNOWN_IN;
-                                        }
-                                        if (dist2 < (m_dists[ind2]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind2] = dist2;
-                                            m_fmm_status[ind2] = FMM_KNOWN_OUT;
-                                        }
-                                    }
-                                }
+                                if (own)
+                                    seedCell(dists, st, ind, dist1, t.normal[2] >= 0);
+                                if (own2)
+                                    seedCell(dists, st, ind+m_nxny, m_cellWidth[2] - dist1, t.normal[2] < 0);
                             }
                         }
                     }
-         }
-    }
-
-    // Update known points neighbors
-    for (int z=0, ind=0; z<m_nz; z++)
-        for (int y=0; y<m_ny; y++)
-            for (int x=0; x<m_nx; x++, ind++)
-            {
-                if (m_fmm_status[ind] < FMM_FAR)
-                {
-                    int ind2;
-                    SReal dist1 = m_dists[ind];
-                    SReal dist2 = dist1+m_cellWidth[0];
-                    // X-1
-                    if (x>0)
-                    {
-                        ind2 = ind-1;
-                        if (x>0 && m_fmm_status[ind2] >= FMM_FAR && (m_dists[ind2]) > dist2)
-                        {
-                            m_dists[ind2] = dist2;
-                            fmm_push(ind2);
-                        }
-                    }
-                    // X+1
-                    if (x<m_nx-1)
-                    {
-                        ind2 = ind+1;
-                        if (x>0 && m_fmm_status[ind2] >= FMM_FAR && (m_dists[ind2]) > dist2)
-                        {
-                            m_dists[ind2] = dist2;
-                            fmm_push(ind2);
-                        }
-                    }
-                    dist2 = dist1+m_cellWidth[1];
-                    // Y-1
-                    if (y>0)
-                    {
-                        ind2 = ind-m_nx;
-                        if (x>0 && m_fmm_status[ind2] >= FMM_FAR && (m_dists[ind2]) > dist2)
-                        {
-                            m_dists[ind2] = dist2;
-                            fmm_push(ind2);
-                        }
-                    }
-                    // Y+1
-                    if (y<m_ny-1)
-                    {
-                        ind2 = ind+m_nx;
-                        if (x>0 && m_fmm_status[ind2] >= FMM_FAR && (m_dists[ind2]) > dist2)
-                        {
-                            m_dists[ind2] = dist2;
-                            fmm_push(ind2);
-                        }
-                    }
-                    dist2 = dist1+m_cellWidth[2];
-                    // Z-1
-                    if (z>0)
-                    {
-                        ind2 = ind-m_nxny;
-                        if (x>0 && m_fmm_status[ind2] >= FMM_FAR && (m_dists[ind2]) > dist2)
-                        {
-                            m_dists[ind2] = dist2;
-                            fmm_push(ind2);
-                        }
-                    }
-                    // Z+1
-                    if (z<m_nz-1)
-                    {
-                        ind2 = ind+m_nxny;
-                        if (x>0 && m_fmm_status[ind2] >= FMM_FAR && (m_dists[ind2]) > dist2)
-                        {
-                            m_dists[ind2] = dist2;
-                            fmm_push(ind2);
-                        }
-                    }
-                }
-            }
-
-    // March through the heap
-    while (m_fmm_heap_size > 0)
-    {
-        int ind = fmm_pop();
-        int nbin = 0, nbout = 0;
-        int x = ind%m_nx;
-        int y = (ind/m_nx)%m_ny;
-        int z = ind/m_nxny;
-
-        int ind2;
-        SReal dist1 = m_dists[ind];
-        SReal dist2 = dist1+m_cellWidth[0];
-        // X-1
-        if (x>0)
-        {
-            ind2 = ind-1;
-            if (m_fmm_status[ind2] < FMM_FAR)
-            {
-                if (m_fmm_status[ind2] == FMM_KNOWN_IN) ++nbin; else ++nbout;
-            }
-            else if ((m_dists[ind2]) > dist2)
-            {
-                m_dists[ind2] = dist2;
-                fmm_push(ind2); // create or update the corresponding entry in the heap
-            }
-        }
-        // X+1
-        if (x<m_nx-1)
-        {
-            ind2 = ind+1;
-            if (m_fmm_status[ind2] < FMM_FAR)
-            {
-                if (m_fmm_status[ind2] == FMM_KNOWN_IN) ++nbin; else ++nbout;
-            }
-            else if ((m_dists[ind2]) > dist2)
-            {
-                m_dists[ind2] = dist2;
-                fmm_push(ind2); // create or update the corresponding entry in the heap
-            }
-        }
-        dist2 = dist1+m_cellWidth[1];
-        // Y-1
-        if (y>0)
-        {
-            ind2 = ind-m_nx;
-            if (m_fmm_status[ind2] < FMM_FAR)
-            {
-                if (m_fmm_status[ind2] == FMM_KNOWN_IN) ++nbin; else ++nbout;
-            }
-            else if ((m_dists[ind2]) > dist2)
-            {
-                m_dists[ind2] = dist2;
-                fmm_push(ind2); // create or update the corresponding entry in the heap
             }
         }
-        // Y+1
-        if (y<m_ny-1)
-        {
-            ind2 = ind+m_nx;
-            if (m_fmm_status[ind2] < FMM_FAR)
-            {
-                if (m_fmm_status[ind2] == FMM_KNOWN_IN) ++nbin; else ++nbout;
-            }
-            else if ((m_dists[ind2]) > dist2)
-            {
-                m_dists[ind2] = dist2;
-                fmm_push(ind2); // create or update the corresponding entry in the heap
-            }
-        }
-        dist2 = dist1+m_cellWidth[2];
-        // Z-1
-        if (z>0)
-        {
-            ind2 = ind-m_nxny;
-            if (m_fmm_status[ind2] < FMM_FAR)
-            {
-                if (m_fmm_status[ind2] == FMM_KNOWN_IN) ++nbin; else ++nbout;
-            }
-            else if ((m_dists[ind2]) > dist2)
-            {
-                m_dists[ind2] = dist2;
-                fmm_push(ind2); // create or update the corresponding entry in the heap
-            }
-        }
-        // Z+1
-        if (z<m_nz-1)
-        {
-            ind2 = ind+m_nxny;
-            if (m_fmm_status[ind2] < FMM_FAR)
-            {
-                if (m_fmm_status[ind2] == FMM_KNOWN_IN) ++nbin; else ++nbout;
-            }
-            else if ((m_dists[ind2]) > dist2)
-            {
-                m_dists[ind2] = dist2;
-                fmm_push(ind2); // create or update the corresponding entry in the heap
-            }
-        }
-        if (nbin && nbout)
-        {
-            msg_warning("DistanceGrid")<< "FMM WARNING: in/out conflict at cell "<<x<<" "<<y<<" "<<z<<" ( "<<nbin<<" in, "<<nbout<<" out), dist = "<<m_dists[ind];
-        }
-        if (nbin > nbout)
-            m_fmm_status[ind] = FMM_KNOWN_IN;
-        else
-            m_fmm_status[ind] = FMM_KNOWN_OUT;
     }
 
-    // Finalize distances
-    int nbin = 0;
+    // Propagate the distances
+    DistanceRelax distanceRelax;
+    distanceRelax.dists = dists;
+    distanceRelax.status = st;
+    for (int c=0; c<3; c++)
+        distanceRelax.width[c] = m_cellWidth[c];
+    int nbSweeps = 1;
+    while (sweepGrid(distanceRelax, m_nx, m_ny, m_nz) > 0)
+        ++nbSweeps;
+
+    // Any path of cells between the inside and the outside of a closed surface goes through a
+    // grid edge crossing it, whose ends are initialized from the surface. So each region of
+    // connected cells which are not initialized is either inside or outside, as decided by a
+    // vote of the initialized cells around it.
+    helper::vector<int> regions(m_nxnynz);
+    int* reg = &regions[0];
+#ifdef _OPENMP
+#pragma omp parallel for if(m_nxnynz >= ParallelMinSize)
+#endif
+    for (int ind=0; ind<m_nxnynz; ind++)
+        reg[ind] = (st[ind] == SWEEP_FAR ? ind : -1);
+    RegionRelax regionRelax;
+    regionRelax.regions = reg;
+    while (sweepGrid(regionRelax, m_nx, m_ny, m_nz) > 0)
+        ;
+
+    std::map<int, int> votes;
     for (int z=0, ind=0; z<m_nz; z++)
         for (int y=0; y<m_ny; y++)
             for (int x=0; x<m_nx; x++, ind++)
             {
-                if (m_fmm_status[ind] == FMM_KNOWN_IN)
-                {
-                    m_dists[ind] = -m_dists[ind];
-                    ++nbin;
-                }
-                else if (m_fmm_status[ind] != FMM_KNOWN_OUT)
-                {
-                }
+                if (reg[ind] < 0) continue;
+                int vote = 0;
+                if (x > 0)      vote += (st[ind-1] == SWEEP_IN) - (st[ind-1] == SWEEP_OUT);
+                if (x < m_nx-1) vote += (st[ind+1] == SWEEP_IN) - (st[ind+1] == SWEEP_OUT);
+                if (y > 0)      vote += (st[ind-m_nx] == SWEEP_IN) - (st[ind-m_nx] == SWEEP_OUT);
+                if (y < m_ny-1) vote += (st[ind+m_nx] == SWEEP_IN) - (st[ind+m_nx] == SWEEP_OUT);
+                if (z > 0)      vote += (st[ind-m_nxny] == SWEEP_IN) - (st[ind-m_nxny] == SWEEP_OUT);
+                if (z < m_nz-1) vote += (st[ind+m_nxny] == SWEEP_IN) - (st[ind+m_nxny] == SWEEP_OUT);
+                if (vote)
+                    votes[reg[ind]] += vote;
             }
-    msg_info("DistanceGrid")<< "FMM: DONE. "<< nbin << " points inside ( " << (nbin*100)/size() <<" % )";
-}
-
-inline void DistanceGrid::fmm_swap(int entry1, int entry2)
-{
-    int ind1 = m_fmm_heap[entry1];
-    int ind2 = m_fmm_heap[entry2];
-    m_fmm_heap[entry1] = ind2;
-    m_fmm_heap[entry2] = ind1;
-    m_fmm_status[ind1] = entry2 + FMM_FRONT0;
-    m_fmm_status[ind2] = entry1 + FMM_FRONT0;
-}
+    // the status of the first cell of each region is the decision for the whole region
+    for (std::map<int, int>::const_iterator it = votes.begin(); it != votes.end(); ++it)
+        st[it->first] = (it->second > 0 ? SWEEP_IN : SWEEP_OUT);
 
-int DistanceGrid::fmm_pop()
-{
-
-    int res = m_fmm_heap[0];
-
-    if(FMM_VERBOSE)
-        msg_info("DistanceGrid")<< "fmm_pop -> <"<<(res%m_nx)<<','<<((res/m_nx)%m_ny)<<','<<(res/m_nxny)<<">="<<m_dists[res];
-
-    --m_fmm_heap_size;
-    if (m_fmm_heap_size>0)
-    {
-        fmm_swap(0, m_fmm_heap_size);
-        int i=0;
-        SReal phi = (m_dists[m_fmm_heap[i]]);
-        while (i*2+1 < m_fmm_heap_size)
-        {
-            SReal phi1 = (m_dists[m_fmm_heap[i*2+1]]);
-            if (i*2+2 < m_fmm_heap_size)
-            {
-                SReal phi2 = (m_dists[m_fmm_heap[i*2+2]]);
-                if (phi1 < phi)
-                {
-                    if (phi1 < phi2)
-                    {
-                        fmm_swap(i, i*2+1);
-                        i = i*2+1;
-                    }
-                    else
-                    {
-                        fmm_swap(i, i*2+2);
-                        i = i*2+2;
-                    }
-                }
-                else if (phi2 < phi)
-                {
-                    fmm_swap(i, i*2+2);
-                    i = i*2+2;
-                }
-                else break;
-            }
-            else if (phi1 < phi)
-            {
-                fmm_swap(i, i*2+1);
-                i = i*2+1;
-            }
-            else break;
-        }
-    }
-
-    if(FMM_VERBOSE){
-        std::stringstream tmp;
-        tmp << "fmm_heap = [";
-        for (int i=0; i<m_fmm_heap_size; i++)
-            tmp << " <"<<(m_fmm_heap[i]%m_nx)<<','<<((m_fmm_heap[i]/m_nx)%m_ny)<<','<<(m_fmm_heap[i]/m_nxny)<<">="<<m_dists[m_fmm_heap[i]];
-        msg_info("DistanceGrid") << tmp.str() ;
-    }
-
-    return res;
-}
-
-void DistanceGrid::fmm_push(int index)
-{
-    SReal phi = (m_dists[index]);
-    int i;
-    if (m_fmm_status[index] >= FMM_FRONT0)
-    {
-        i = m_fmm_status[index] - FMM_FRONT0;
-
-        if(FMM_VERBOSE)
-           dmsg_info("DistanceGrid") << "fmm update <"<<(index%m_nx)<<','<<((index/m_nx)%m_ny)<<','<<(index/m_nxny)<<">="<<m_dists[index]<<" from entry "<<i ;
-
-        while (i>0 && phi < (m_dists[m_fmm_heap[(i-1)/2]]))
-        {
-            fmm_swap(i,(i-1)/2);
-            i = (i-1)/2;
-        }
-        while (i*2+1 < m_fmm_heap_size)
-        {
-            SReal phi1 = (m_dists[m_fmm_heap[i*2+1]]);
-            if (i*2+2 < m_fmm_heap_size)
-            {
-                SReal phi2 = (m_dists[m_fmm_heap[i*2+2]]);
-                if (phi1 < phi)
-                {
-                    if (phi1 < phi2)
-                    {
-                        fmm_swap(i, i*2+1);
-                        i = i*2+1;
-                    }
-                    else
-                    {
-                        fmm_swap(i, i*2+2);
-                        i = i*2+2;
-                    }
-                }
-                else if (phi2 < phi)
-                {
-                    fmm_swap(i, i*2+2);
-                    i = i*2+2;
-                }
-                else break;
-            }
-            else if (phi1 < phi)
-            {
-                fmm_swap(i, i*2+1);
-                i = i*2+1;
-            }
-            else break;
-        }
-    }
-    else
+    // Finalize distances
+    int nbin = 0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:nbin) if(m_nxnynz >= ParallelMinSize)
+#endif
+    for (int ind=0; ind<m_nxnynz; ind++)
     {
-        if(FMM_VERBOSE)
-           dmsg_info("DistanceGrid") << "fmm push <"<<(index%m_nx)<<','<<((index/m_nx)%m_ny)<<','<<(index/m_nxny)<<">="<<m_dists[index] ;
-
-        i = m_fmm_heap_size;
-        ++m_fmm_heap_size;
-        m_fmm_heap[i] = index;
-        m_fmm_status[index] = i;
-        while (i>0 && phi < (m_dists[m_fmm_heap[(i-1)/2]]))
+        if (st[reg[ind] < 0 ? ind : reg[ind]] == SWEEP_IN)
         {
-            fmm_swap(i,(i-1)/2);
-            i = (i-1)/2;
+            dists[ind] = -dists[ind];
+            ++nbin;
         }
     }
-
-    if(FMM_VERBOSE){
-        std::stringstream tmp;
-        tmp << "fmm_heap = [";
-        for (int i=0; i<m_fmm_heap_size; i++)
-            tmp << " <"<<(m_fmm_heap[i]%m_nx)<<','<<((m_fmm_heap[i]/m_nx)%m_ny)<<','<<(m_fmm_heap[i]/m_nxny)<<">="<<m_dists[m_fmm_heap[i]];
-        msg_info("DistanceGrid") << tmp.str() ;
-    }
+    msg_info("DistanceGrid")<< "Distance: DONE after " << nbSweeps << " sweeps, " << votes.size() << " regions. "
+                            << nbin << " points inside ( " << (nbin*100)/m_nxnynz <<" % )";
 }
 
 /// Sample the surface with points approximately separated by the given sampling distance (expressed in voxels if the value is negative)
@@ -1256,7 +1041,8 @@ void DistanceGrid::sampleSurface(double sampling)
 
 
 DistanceGrid* DistanceGrid::loadShared(const std::string& filename,
-                                       double scale, double sampling, int nx, int ny, int nz, Coord pmin, Coord pmax)
+                                       double scale, double sampling, int nx, int ny, int nz, Coord pmin, Coord pmax,
+                                       const std::string& cacheDirectory)
 {
     DistanceGridParams params;
     params.filename = filename;
@@ -1273,8 +1059,149 @@ DistanceGrid* DistanceGrid::loadShared(const std::string& filename,
         return it->second->addRef();
     else
     {
-        return shared[params] = load(filename, scale, sampling, nx, ny, nz, pmin, pmax);
+        return shared[params] = load(filename, scale, sampling, nx, ny, nz, pmin, pmax, cacheDirectory);
+    }
+}
+
+namespace
+{
+
+/// FNV-1a hash of the data identifying a cached grid
+struct CacheHash
+{
+    unsigned long long value;
+    CacheHash() : value(14695981039346656037ull) {}
+    void add(const void* data, std::size_t size)
+    {
+        const unsigned char* p = (const unsigned char*)data;
+        for (std::size_t i=0; i<size; i++)
+        {
+            value ^= p[i];
+            value *= 1099511628211ull;
+        }
+    }
+    template<class T>
+    void add(const T& v) { add(&v, sizeof(T)); }
+};
+
+const char cacheMagic[8] = { 'S','O','F','A','D','G','C','1' };
+
+} // namespace
+
+/// Name of the file caching the grid computed from a mesh with the given parameters,
+/// or an empty string if the mesh file cannot be found.
+/// The size and the date of the mesh file are part of the name, so that modifying the mesh
+/// invalidates the cache.
+std::string DistanceGrid::getCacheFilename(const std::string& cacheDirectory, const std::string& filename,
+                                           double scale, double sampling,
+                                           int nx, int ny, int nz, Coord pmin, Coord pmax)
+{
+    unsigned long long fileSize = 0;
+    long long lastWriteTime = 0;
+    if (!FileSystem::getFileInfo(filename, fileSize, lastWriteTime))
+        return std::string();
+
+    CacheHash hash;
+    hash.add(filename.c_str(), filename.size());
+    hash.add(fileSize);
+    hash.add(lastWriteTime);
+    hash.add(scale);
+    hash.add(sampling);
+    hash.add(nx); hash.add(ny); hash.add(nz);
+    for (int c=0; c<3; c++)
+    {
+        hash.add(pmin[c]);
+        hash.add(pmax[c]);
     }
+
+    std::string name = FileSystem::stripDirectory(filename);
+    name = name.substr(0, name.length()-4); // remove ".obj"
+    std::ostringstream out;
+    out << cacheDirectory << '/' << name << '-' << std::hex << std::setw(16) << std::setfill('0') << hash.value << ".dgc";
+    return out.str();
+}
+
+/// Load a grid previously saved by saveCache, or return NULL if the file does not exist or is invalid
+DistanceGrid* DistanceGrid::loadCache(const std::string& cacheFilename)
+{
+    std::ifstream in(cacheFilename.c_str(), std::ios::in | std::ios::binary);
+    if (!in.is_open())
+        return NULL;
+
+    char magic[8];
+    int header[5]; // nx, ny, nz, sizeof(SReal), number of mesh points
+    Coord pmin, pmax, bbmin, bbmax;
+    in.read(magic, sizeof(magic));
+    in.read((char*)header, sizeof(header));
+    in.read((char*)pmin.ptr(), 3*sizeof(SReal));
+    in.read((char*)pmax.ptr(), 3*sizeof(SReal));
+    in.read((char*)bbmin.ptr(), 3*sizeof(SReal));
+    in.read((char*)bbmax.ptr(), 3*sizeof(SReal));
+    if (!in || !std::equal(magic, magic+sizeof(magic), cacheMagic) || header[3] != (int)sizeof(SReal)
+        || header[0] < 0 || header[1] < 0 || header[2] < 0 || header[4] < 0)
+    {
+        msg_warning("DistanceGrid")<< "Ignoring invalid cached distance grid " << cacheFilename;
+        return NULL;
+    }
+
+    DistanceGrid* grid = new DistanceGrid(header[0], header[1], header[2], pmin, pmax);
+    grid->m_bbmin = bbmin;
+    grid->m_bbmax = bbmax;
+    if (grid->m_nxnynz > 0)
+        in.read((char*)&(grid->m_dists[0]), grid->m_nxnynz*sizeof(SReal));
+    grid->meshPts.resize(header[4]);
+    if (header[4] > 0)
+        in.read((char*)grid->meshPts[0].ptr(), header[4]*sizeof(Coord));
+    if (!in)
+    {
+        msg_warning("DistanceGrid")<< "Ignoring truncated cached distance grid " << cacheFilename;
+        delete grid;
+        return NULL;
+    }
+    return grid;
+}
+
+/// Save this grid so that it can be reloaded by loadCache
+bool DistanceGrid::saveCache(const std::string& cacheFilename)
+{
+    FileSystem::findOrCreateAValidPath(FileSystem::getParentDirectory(cacheFilename));
+
+    // write to a temporary file first, so that other processes never read a partial file
+    const std::string tmpFilename = cacheFilename + ".tmp";
+    {
+        std::ofstream out(tmpFilename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+        {
+            msg_warning("DistanceGrid")<< "Cannot write distance grid cache file " << tmpFilename;
+            return false;
+        }
+        const int header[5] = { m_nx, m_ny, m_nz, (int)sizeof(SReal), (int)meshPts.size() };
+        out.write(cacheMagic, sizeof(cacheMagic));
+        out.write((const char*)header, sizeof(header));
+        out.write((const char*)m_pmin.ptr(), 3*sizeof(SReal));
+        out.write((const char*)m_pmax.ptr(), 3*sizeof(SReal));
+        out.write((const char*)m_bbmin.ptr(), 3*sizeof(SReal));
+        out.write((const char*)m_bbmax.ptr(), 3*sizeof(SReal));
+        if (m_nxnynz > 0)
+            out.write((const char*)&(m_dists[0]), m_nxnynz*sizeof(SReal));
+        if (!meshPts.empty())
+            out.write((const char*)meshPts[0].ptr(), meshPts.size()*sizeof(Coord));
+        if (!out)
+        {
+            msg_warning("DistanceGrid")<< "Cannot write distance grid cache file " << tmpFilename;
+            out.close();
+            std::remove(tmpFilename.c_str());
+            return false;
+        }
+    }
+    std::remove(cacheFilename.c_str());
+    if (std::rename(tmpFilename.c_str(), cacheFilename.c_str()) != 0)
+    {
+        msg_warning("DistanceGrid")<< "Cannot write distance grid cache file " << cacheFilename;
+        std::remove(tmpFilename.c_str());
+        return false;
+    }
+    return true;
 }
 
 
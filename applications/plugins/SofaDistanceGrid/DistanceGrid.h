@@ -73,11 +73,14 @@ public:
     ~DistanceGrid();
 
 public:
-    /// Load a distance grid
+    /// Load a distance grid.
+    /// If cacheDirectory is not empty, the grids computed from meshes are stored in this
+    /// directory and reused as long as the mesh file and the parameters are unchanged.
     static DistanceGrid* load(const std::string& filename,
                               double scale=1.0, double sampling=0.0,
                               int m_nx=64, int m_ny=64, int m_nz=64,
-                              Coord m_pmin = Coord(), Coord m_pmax = Coord());
+                              Coord m_pmin = Coord(), Coord m_pmax = Coord(),
+                              const std::string& cacheDirectory = std::string());
 
     static DistanceGrid* loadVTKFile(const std::string& filename,
                                      double scale=1.0, double sampling=0.0);
@@ -86,7 +89,8 @@ public:
     static DistanceGrid* loadShared(const std::string& filename,
                                     double scale=1.0, double sampling=0.0,
                                     int m_nx=64, int m_ny=64, int m_nz=64,
-                                    Coord m_pmin = Coord(), Coord m_pmax = Coord());
+                                    Coord m_pmin = Coord(), Coord m_pmax = Coord(),
+                                    const std::string& cacheDirectory = std::string());
 
     /// Add one reference to this grid. Note that loadShared already does this.
     DistanceGrid* addRef();
@@ -240,15 +244,12 @@ protected:
 
     SReal m_cubeDim; ///< Cube dimension (!=0 if this is actually a cube
 
-    /// Fast Marching Method Update
-    enum Status { FMM_FRONT0 = 0, FMM_FAR = -1, FMM_KNOWN_OUT = -2, FMM_KNOWN_IN = -3 };
-    helper::vector<int> m_fmm_status;
-    helper::vector<int> m_fmm_heap;
-    int m_fmm_heap_size;
-
-    int fmm_pop();
-    void fmm_push(int index);
-    void fmm_swap(int entry1, int entry2);
+    /// Cache of the grids computed from meshes
+    static std::string getCacheFilename(const std::string& cacheDirectory, const std::string& filename,
+                                        double scale, double sampling,
+                                        int nx, int ny, int nz, Coord pmin, Coord pmax);
+    static DistanceGrid* loadCache(const std::string& cacheFilename);
+    bool saveCache(const std::string& cacheFilename);
 
     /// Grid shared resources
     struct DistanceGridParams
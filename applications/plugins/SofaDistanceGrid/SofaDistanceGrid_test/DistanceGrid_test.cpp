@@ -27,6 +27,12 @@ using sofa::Sofa_test ;
 #include <SofaDistanceGrid/DistanceGrid.h>
 using sofa::component::container::DistanceGrid ;
 
+#include <sofa/helper/system/FileSystem.h>
+using sofa::helper::system::FileSystem ;
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
 namespace sofa
 {
 namespace component
@@ -36,6 +42,7 @@ namespace container
 namespace _distancegrid_
 {
 using sofa::defaulttype::Vector3 ;
+using sofa::helper::rabs ;
 
 struct DistanceGrid_test : public Sofa_test<SReal>
 {
@@ -63,6 +70,74 @@ struct DistanceGrid_test : public Sofa_test<SReal>
         EXPECT_FALSE(grid.isCube());
     }
 
+    /// Write a closed cube of half-size 1 centered on the origin
+    std::string writeCubeMesh()
+    {
+        std::string filename = boost::filesystem::temp_directory_path().string()+"/DistanceGrid_test_cube.obj" ;
+        std::ofstream out(filename.c_str()) ;
+        out << "v -1 -1 -1\nv 1 -1 -1\nv 1 1 -1\nv -1 1 -1\n"
+               "v -1 -1 1\nv 1 -1 1\nv 1 1 1\nv -1 1 1\n"
+               "f 1 4 3 2\nf 5 6 7 8\nf 1 2 6 5\nf 2 3 7 6\nf 3 4 8 7\nf 4 1 5 8\n" ;
+        return filename ;
+    }
+
+    void checkDistanceFromMesh(){
+        std::string filename = writeCubeMesh() ;
+        DistanceGrid* grid = DistanceGrid::load(filename, 1.0, 0.0, 21, 21, 21) ;
+        ASSERT_NE(grid, nullptr) ;
+
+        for (int z=0; z<grid->getNz(); z++)
+            for (int y=0; y<grid->getNy(); y++)
+                for (int x=0; x<grid->getNx(); x++)
+                {
+                    DistanceGrid::Coord p = grid->coord(x,y,z) ;
+                    bool inside = rabs(p[0]) < 1 && rabs(p[1]) < 1 && rabs(p[2]) < 1 ;
+                    SReal d = (*grid)[grid->index(x,y,z)] ;
+                    if (rabs(rabs(p[0])-1) > 1e-3 && rabs(rabs(p[1])-1) > 1e-3 && rabs(rabs(p[2])-1) > 1e-3)
+                    {
+                        EXPECT_EQ(d < 0, inside) << "at cell " << x << " " << y << " " << z ;
+                    }
+                }
+        // the distances are propagated along the axes of the grid
+        EXPECT_NEAR((*grid)[grid->index(10,10,10)], -1.0, 1e-6) ;
+        EXPECT_NEAR((*grid)[grid->index(10,10,0)], 0.2, 1e-6) ;
+        grid->release() ;
+    }
+
+    void checkDistanceCache(){
+        std::string filename = writeCubeMesh() ;
+        std::string cacheDirectory = boost::filesystem::temp_directory_path().string()+"/DistanceGrid_test_cache" ;
+        FileSystem::removeAll(cacheDirectory) ;
+
+        DistanceGrid* grid = DistanceGrid::load(filename, 1.0, 0.0, 16, 16, 16, DistanceGrid::Coord(), DistanceGrid::Coord(), cacheDirectory) ;
+        ASSERT_NE(grid, nullptr) ;
+        std::vector<std::string> files ;
+        FileSystem::listDirectory(cacheDirectory, files) ;
+        ASSERT_EQ(files.size(), 1u) ;
+
+        DistanceGrid* cached = DistanceGrid::load(filename, 1.0, 0.0, 16, 16, 16, DistanceGrid::Coord(), DistanceGrid::Coord(), cacheDirectory) ;
+        ASSERT_NE(cached, nullptr) ;
+        ASSERT_EQ(cached->size(), grid->size()) ;
+        for (int i=0; i<grid->size(); i++)
+            EXPECT_EQ((*cached)[i], (*grid)[i]) ;
+        EXPECT_EQ(cached->meshPts.size(), grid->meshPts.size()) ;
+        EXPECT_EQ(cached->getBBMin(), grid->getBBMin()) ;
+        EXPECT_EQ(cached->getBBMax(), grid->getBBMax()) ;
+
+        // other parameters use another cache file
+        DistanceGrid* other = DistanceGrid::load(filename, 1.0, 0.0, 8, 8, 8, DistanceGrid::Coord(), DistanceGrid::Coord(), cacheDirectory) ;
+        ASSERT_NE(other, nullptr) ;
+        EXPECT_EQ(other->getNx(), 8) ;
+        files.clear() ;
+        FileSystem::listDirectory(cacheDirectory, files) ;
+        EXPECT_EQ(files.size(), 2u) ;
+
+        grid->release() ;
+        cached->release() ;
+        other->release() ;
+        FileSystem::removeAll(cacheDirectory) ;
+    }
+
     void checInvalidConstructorsCube(int x, int y, int z,
                                      float mx, float my, float mz,
                                      float ex, float ey, float ez){
@@ -97,6 +172,13 @@ TEST_F(DistanceGrid_test, chekcInvalidConstructorsCube) {
     }
 }
 
+TEST_F(DistanceGrid_test, checkDistanceFromMesh) {
+    ASSERT_NO_THROW(this->checkDistanceFromMesh()) ;
+}
+
+TEST_F(DistanceGrid_test, checkDistanceCache) {
+    ASSERT_NO_THROW(this->checkDistanceCache()) ;
+}
 
 } // __distance_grid__
 } // container
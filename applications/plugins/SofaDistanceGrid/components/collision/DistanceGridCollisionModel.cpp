@@ -77,6 +77,7 @@ RigidDistanceGridCollisionModel::RigidDistanceGridCollisionModel()
     , ny( initData( &ny, 64, "ny", "number of values on Y axis") )
     , nz( initData( &nz, 64, "nz", "number of values on Z axis") )
     , dumpfilename( initData( &dumpfilename, "dumpfilename","write distance grid to specified file"))
+    , cacheDirectory( initData( &cacheDirectory, "cacheDirectory","if not empty: directory where the grids computed from meshes are cached, to be reused as long as the mesh and the parameters are unchanged"))
     , usePoints( initData( &usePoints, true, "usePoints", "use mesh vertices for collision detection"))
     , flipNormals( initData( &flipNormals, false, "flipNormals", "reverse surface direction, i.e. points are considered in collision if they move outside of the object instead of inside"))
     , showMeshPoints( initData( &showMeshPoints, true, "showMeshPoints", "Enable rendering of mesh points"))
@@ -115,7 +116,7 @@ void RigidDistanceGridCollisionModel::init()
     if (sampling.getValue()!=0.0) sout<<" sampling="<<sampling.getValue();
     if (box.getValue()[0][0]<box.getValue()[1][0]) sout<<" bbox=<"<<box.getValue()[0]<<">-<"<<box.getValue()[0]<<">";
     sout << sendl;
-    grid = DistanceGrid::loadShared(fileRigidDistanceGrid.getFullPath(), scale.getValue(), sampling.getValue(), nx.getValue(),ny.getValue(),nz.getValue(),box.getValue()[0],box.getValue()[1]);
+    grid = DistanceGrid::loadShared(fileRigidDistanceGrid.getFullPath(), scale.getValue(), sampling.getValue(), nx.getValue(),ny.getValue(),nz.getValue(),box.getValue()[0],box.getValue()[1], cacheDirectory.getValue());
     if (grid->getNx() != this->nx.getValue())
         this->nx.setValue(grid->getNx());
     if (grid->getNy() != this->ny.getValue())
@@ -448,6 +449,7 @@ FFDDistanceGridCollisionModel::FFDDistanceGridCollisionModel()
     , ny( initData( &ny, 64, "ny", "number of values on Y axis") )
     , nz( initData( &nz, 64, "nz", "number of values on Z axis") )
     , dumpfilename( initData( &dumpfilename, "dumpfilename","write distance grid to specified file"))
+    , cacheDirectory( initData( &cacheDirectory, "cacheDirectory","if not empty: directory where the grids computed from meshes are cached, to be reused as long as the mesh and the parameters are unchanged"))
     , usePoints( initData( &usePoints, true, "usePoints", "use mesh vertices for collision detection"))
     , singleContact( initData( &singleContact, false, "singleContact", "keep only the deepest contact in each cell"))
 {
@@ -488,7 +490,7 @@ void FFDDistanceGridCollisionModel::init()
     if (sampling.getValue()!=0.0) sout<<" sampling="<<sampling.getValue();
     if (box.getValue()[0][0]<box.getValue()[1][0]) sout<<" bbox=<"<<box.getValue()[0]<<">-<"<<box.getValue()[0]<<">";
     sout << sendl;
-    grid = DistanceGrid::loadShared(fileFFDDistanceGrid.getFullPath(), scale.getValue(), sampling.getValue(), nx.getValue(),ny.getValue(),nz.getValue(),box.getValue()[0],box.getValue()[1]);
+    grid = DistanceGrid::loadShared(fileFFDDistanceGrid.getFullPath(), scale.getValue(), sampling.getValue(), nx.getValue(),ny.getValue(),nz.getValue(),box.getValue()[0],box.getValue()[1], cacheDirectory.getValue());
     if (!dumpfilename.getValue().empty())
     {
         sout << "FFDDistanceGridCollisionModel: dump grid to "<<dumpfilename.getValue()<<sendl;
@@ -133,6 +133,7 @@ public:
     Data< int > ny; ///< number of values on Y axis
     Data< int > nz; ///< number of values on Z axis
     sofa::core::objectmodel::DataFileName dumpfilename;
+    Data< std::string > cacheDirectory; ///< if not empty: directory where the grids computed from meshes are cached
 
     Data< bool > usePoints; ///< use mesh vertices for collision detection
     Data< bool > flipNormals; ///< reverse surface direction, i.e. points are considered in collision if they move outside of the object instead of inside
@@ -438,6 +439,7 @@ protected:
     Data< int > ny; ///< number of values on Y axis
     Data< int > nz; ///< number of values on Z axis
     sofa::core::objectmodel::DataFileName dumpfilename;
+    Data< std::string > cacheDirectory; ///< if not empty: directory where the grids computed from meshes are cached
 
     core::behavior::MechanicalState<defaulttype::Vec3Types>* ffd;
     core::topology::BaseMeshTopology* ffdMesh;
@@ -56,7 +56,7 @@ const unsigned long* Grid2D::obstacles = NULL;
       }                                       \
 }
 
-#define FOR_READ_INNER_CELLS(cmd)             \
+#define FOR_INNER_CELLS(grid,cmd)             \
 {                                             \
   int ind = index(1,1);                       \
     for (int y=1;y<ny-1;y++,ind+=index(2,0))  \
@@ -66,7 +66,10 @@ const unsigned long* Grid2D::obstacles = NULL;
       }                                       \
 }
 
-#define FOR_INNER_CELLS(grid,cmd)             \
+// Surface cells  are inner  cells and borders  between a  fluid inner
+// cell and an empty out cell (right or bottom side)
+
+#define FOR_SURFACE_CELLS(grid,cmd)           \
 {                                             \
   int ind = index(1,1);                       \
     for (int y=1;y<ny-1;y++,ind+=index(2,0))  \
@@ -76,17 +79,70 @@ const unsigned long* Grid2D::obstacles = NULL;
       }                                       \
 }
 
-// Surface cells  are inner  cells and borders  between a  fluid inner
-// cell and an empty out cell (right or bottom side)
+// Parallel versions of the loops above: the rows are processed concurrently
+// when SOFA is compiled with OpenMP, and the index is recomputed for each row so
+// that the loop on x is a plain unit-stride loop the compiler can vectorize.
+// They can only be used when each iteration only writes its own cell.
+// FOR_INNER_CELLS_SUM also accumulates the given variable(s) over all the cells.
 
-#define FOR_SURFACE_CELLS(grid,cmd)           \
+enum { ParallelMinSize = 128*128 };
+
+#ifdef _OPENMP
+#define GRID_OMP_PRAGMA(x) _Pragma(#x)
+#else
+#define GRID_OMP_PRAGMA(x)
+#endif
+
+#define FOR_ALL_CELLS_PARALLEL(grid,cmd)      \
 {                                             \
-  int ind = index(1,1);                       \
-    for (int y=1;y<ny-1;y++,ind+=index(2,0))  \
+  GRID_OMP_PRAGMA(omp parallel for if(ncell >= ParallelMinSize)) \
+    for (int y=0;y<ny;y++)                    \
+    {                                         \
+      int ind = index(0,y);                   \
+      for (int x=0;x<nx;x++,ind+=index(1,0))  \
+      {                                       \
+    cmd;                                  \
+      }                                       \
+    }                                         \
+}
+
+#define FOR_INNER_CELLS_PARALLEL(grid,cmd)    \
+{                                             \
+  GRID_OMP_PRAGMA(omp parallel for if(ncell >= ParallelMinSize)) \
+    for (int y=1;y<ny-1;y++)                  \
+    {                                         \
+      int ind = index(1,y);                   \
+      for (int x=1;x<nx-1;x++,ind+=index(1,0))\
+      {                                       \
+    cmd;                                  \
+      }                                       \
+    }                                         \
+}
+
+#define FOR_INNER_CELLS_SUM(sum,cmd)          \
+{                                             \
+  GRID_OMP_PRAGMA(omp parallel for reduction(+:sum) if(ncell >= ParallelMinSize)) \
+    for (int y=1;y<ny-1;y++)                  \
+    {                                         \
+      int ind = index(1,y);                   \
+      for (int x=1;x<nx-1;x++,ind+=index(1,0))\
+      {                                       \
+    cmd;                                  \
+      }                                       \
+    }                                         \
+}
+
+#define FOR_INNER_CELLS_SUM2(sum1,sum2,cmd)   \
+{                                             \
+  GRID_OMP_PRAGMA(omp parallel for reduction(+:sum1,sum2) if(ncell >= ParallelMinSize)) \
+    for (int y=1;y<ny-1;y++)                  \
+    {                                         \
+      int ind = index(1,y);                   \
       for (int x=1;x<nx-1;x++,ind+=index(1,0))\
       {                                       \
     cmd;                                  \
       }                                       \
+    }                                         \
 }
 
 Grid2D::Grid2D()
@@ -149,7 +205,7 @@ void Grid2D::clear(int _nx, int _ny)
 void Grid2D::seed(real height)
 {
     //seed(vec2(0,0), vec2(nx,height));
-    FOR_ALL_CELLS(fdata,
+    FOR_ALL_CELLS_PARALLEL(fdata,
     {
         real d = y - height;
         levelset[ind] = d;
@@ -159,7 +215,7 @@ void Grid2D::seed(real height)
 void Grid2D::seed(real height, vec2 normal)
 {
     normal.normalize();
-    FOR_ALL_CELLS(fdata,
+    FOR_ALL_CELLS_PARALLEL(fdata,
     {
         real d = vec2((real)x,(real)y)*normal - height;
         levelset[ind] = d;
@@ -177,7 +233,7 @@ void Grid2D::seed(vec2 p0, vec2 p1, vec2 velocity)
     msg_info("Grid2D") << "p0="<<p0<<" p1="<<p1;
     vec2 center = (p0+p1)*0.5f;
     vec2 dim = (p1-p0)*0.5f;
-    FOR_ALL_CELLS(fdata,
+    FOR_ALL_CELLS_PARALLEL(fdata,
     {
         vec2 v ((real)x,(real)y);
         v -= center;
@@ -226,7 +282,7 @@ void Grid2D::step_init(const Grid2D* /*prev*/, Grid2D* /*temp*/, real /*dt*/, re
     const unsigned char* obs = (const unsigned char*)obstacles;
     int lnsize = (nx+7)/8;
 
-    FOR_ALL_CELLS(fdata,
+    FOR_ALL_CELLS_PARALLEL(fdata,
     {
         if (x<bsize || y<bsize || x>=nx-bsize || y>=ny-bsize
         || (obs!=NULL && ((obs[(y)*lnsize+((x)>>3)])&(1<<((x)&7))))
@@ -253,7 +309,7 @@ void Grid2D::step_levelset(Grid2D* prev, Grid2D* temp, real dt, real /*diff*/)
 
     // Modified Eulerian / Midpoint method
     // Carlson Thesis page 22
-    FOR_INNER_CELLS(levelset,
+    FOR_INNER_CELLS_PARALLEL(levelset,
     {
         //if (prev->fdata[ind].type != PART_WALL && rabs(prev->levelset[ind]) < 5)
         if (rabs(prev->levelset[ind]) < 5)
@@ -274,7 +330,7 @@ void Grid2D::step_levelset(Grid2D* prev, Grid2D* temp, real dt, real /*diff*/)
 
     // fill border levelset using neighbors
 
-    FOR_ALL_CELLS(fmm_status,
+    FOR_ALL_CELLS_PARALLEL(fmm_status,
     {
         fmm_status[ind] = FMM_FAR;
         if (fdata[ind].type == PART_WALL)
@@ -306,7 +362,7 @@ void Grid2D::step_levelset(Grid2D* prev, Grid2D* temp, real dt, real /*diff*/)
     const int dind[2] = { 1, nx };
 
     // Compute all known points
-    FOR_ALL_CELLS(fdata,
+    FOR_ALL_CELLS_PARALLEL(fdata,
     {
         int c[2]; c[0] = x; c[1] = y;
         bool known = false;
@@ -432,7 +488,7 @@ void Grid2D::step_levelset(Grid2D* prev, Grid2D* temp, real dt, real /*diff*/)
         }
     }
 
-    FOR_ALL_CELLS(levelset,
+    FOR_ALL_CELLS_PARALLEL(levelset,
     {
         if(temp->levelset[ind] < 0)
         {
@@ -576,7 +632,7 @@ void Grid2D::step_forces(const Grid2D* prev, Grid2D* /*temp*/, real dt, real /*d
 
     vec2 f(0,-5*dt);
 
-    FOR_INNER_CELLS(fdata,
+    FOR_INNER_CELLS_PARALLEL(fdata,
     {
         vec2 u = f;
         int p0 = fdata[ind].type;
@@ -723,7 +779,7 @@ void Grid2D::step_advect(const Grid2D* /*prev*/, Grid2D* temp, real dt, real /*d
 
     memset(temp->fdata,0,temp->ncell*sizeof(Cell));
 
-    FOR_INNER_CELLS(temp->fdata,
+    FOR_INNER_CELLS_PARALLEL(temp->fdata,
     {
         // X Axis
         vec2 px( x-0.5f - dt*(fdata[ind].u[0]),
@@ -752,7 +808,7 @@ void Grid2D::step_diffuse(const Grid2D* /*prev*/, Grid2D* temp, real /*dt*/, rea
     real a = diff;
     real inv_c = 1.0f / (1.0001f + 4*a);
 
-    FOR_INNER_CELLS(fdata,
+    FOR_INNER_CELLS_PARALLEL(fdata,
     {
         fdata[ind].u = (temp->fdata[ind].u +
         (temp->fdata[ind+index(-1,0)].u+temp->fdata[ind+index(1,0)].u+
@@ -786,7 +842,7 @@ void Grid2D::step_project(const Grid2D* prev, Grid2D* temp, real dt, real /*diff
 
     //  int nbdiag[7]={0,0,0,0,0,0,0};
 
-    FOR_INNER_CELLS(diag,
+    FOR_INNER_CELLS_PARALLEL(diag,
     {
         if (fdata[ind].type>0)
         {
@@ -800,7 +856,7 @@ void Grid2D::step_project(const Grid2D* prev, Grid2D* temp, real dt, real /*diff
         }
     });
 
-    FOR_INNER_CELLS(b,
+    FOR_INNER_CELLS_SUM(b_norm2,
     {
         if (fdata[ind].type>0)
         {
@@ -810,17 +866,24 @@ void Grid2D::step_project(const Grid2D* prev, Grid2D* temp, real dt, real /*diff
         }
     });
 
-    FOR_ALL_CELLS(pressure,
+    FOR_ALL_CELLS_PARALLEL(pressure,
     {
         if (fdata[ind].type>0)
             pressure[ind] = prev->pressure[ind]; // use previous pressure as initial estimate
         else pressure[ind] = 0;
     });
 
-    real err = 0.0;
+    // Conjugate gradient preconditioned by a modified incomplete Cholesky factorization of A
+    // (see Grid3D). The preconditioner arrays reuse temp->levelset (recomputed by step_levelset)
+    // and b (only needed to initialize r).
+    real* precon = temp->levelset;
+    real* rp = b; // preconditioned residual
+
+    real err = 0.0; // r.r, used for the stopping criterion
+    real rr_p = 0.0;  // r.rp
 
     // r = b - Ax
-    FOR_INNER_CELLS(r,
+    FOR_INNER_CELLS_PARALLEL(r,
     {
         if (diag[ind] != 0)
         {
@@ -830,36 +893,44 @@ void Grid2D::step_project(const Grid2D* prev, Grid2D* temp, real dt, real /*diff
         }
     });
 
-    FOR_ALL_CELLS(g,
-    {
-        g[ind] = r[ind]; // first direction is r
-    });
+    mic0_init(diag, precon);
+    mic0_apply(precon, r, rp);
 
     real min_err = 0.0001f*b_norm2;
 
     int step;
     for (step=0; step<100; step++)
     {
-        real err_old = err;
+        real rr_p_old = rr_p;
         err = 0.0f;
-        FOR_READ_INNER_CELLS(
+        rr_p = 0.0f;
+        FOR_INNER_CELLS_SUM2(err, rr_p,
         {
             err += r[ind]*r[ind];
+            rr_p += r[ind]*rp[ind];
         });
 
         if (err<=min_err) break;
         if (step>0)
         {
-            real beta = err/err_old;
-            // g = g*beta + r
-            FOR_ALL_CELLS(g,
+            real beta = rr_p/rr_p_old;
+            // g = g*beta + rp
+            FOR_ALL_CELLS_PARALLEL(g,
             {
-                g[ind] = g[ind]*beta + r[ind];
+                g[ind] = g[ind]*beta + rp[ind];
+            });
+        }
+        else
+        {
+            // first direction is rp
+            FOR_ALL_CELLS_PARALLEL(g,
+            {
+                g[ind] = rp[ind];
             });
         }
         real g_q = 0.0;
         // q = Ag
-        FOR_INNER_CELLS(q,
+        FOR_INNER_CELLS_SUM(g_q,
         {
             if (diag[ind] != 0)
             {
@@ -871,13 +942,15 @@ void Grid2D::step_project(const Grid2D* prev, Grid2D* temp, real dt, real /*diff
             }
         });
 
-        real alpha = err/g_q;
+        real alpha = rr_p/g_q;
 
-        FOR_ALL_CELLS(pressure,
+        FOR_ALL_CELLS_PARALLEL(pressure,
         {
             pressure[ind] += alpha*g[ind];
             r[ind] -= alpha*q[ind];
         });
+
+        mic0_apply(precon, r, rp);
     }
 
     // Now apply pressure back to velocity
@@ -888,7 +961,7 @@ void Grid2D::step_project(const Grid2D* prev, Grid2D* temp, real dt, real /*diff
     //max_pressure = 0.0f;
     max_pressure = prev->max_pressure;
 
-    FOR_INNER_CELLS(fdata,
+    FOR_INNER_CELLS_PARALLEL(fdata,
     {
         if (fdata[ind].type>=PART_EMPTY)
         {
@@ -909,6 +982,53 @@ void Grid2D::step_project(const Grid2D* prev, Grid2D* temp, real dt, real /*diff
     });
 }
 
+// Modified incomplete Cholesky factorization MIC(0) of the pressure matrix (see Grid3D).
+
+void Grid2D::mic0_init(const real* diag, real* precon) const
+{
+    const real tau = 0.97f; // amount of modification
+    const real sigma = 0.25f; // safety threshold
+    memset(precon,0,ncell*sizeof(real));
+    FOR_INNER_CELLS(precon,
+    {
+        if (diag[ind] != 0)
+        {
+            real e = diag[ind];
+            real p;
+            p = precon[ind-index(1,0)];
+            e -= p*p*(1 + tau*(diag[ind+index(-1,1)] != 0));
+            p = precon[ind-index(0,1)];
+            e -= p*p*(1 + tau*(diag[ind+index(1,-1)] != 0));
+            if (e < sigma*diag[ind]) e = diag[ind];
+            precon[ind] = 1/sqrtf(e);
+        }
+    });
+}
+
+void Grid2D::mic0_apply(const real* precon, const real* src, real* dst) const
+{
+    // dst is zero outside of the fluid, as src and precon
+    // solve L y = src, y being stored in dst
+    FOR_INNER_CELLS(dst,
+    {
+        if (precon[ind] != 0)
+            dst[ind] = (src[ind] + precon[ind-index(1,0)]*dst[ind-index(1,0)]
+                             + precon[ind-index(0,1)]*dst[ind-index(0,1)])*precon[ind];
+        else
+            dst[ind] = 0;
+    });
+    // solve L^T dst = y
+    for (int y=ny-2; y>=1; y--)
+    {
+        int ind = index(nx-2,y);
+        for (int x=nx-2; x>=1; x--, ind-=index(1,0))
+        {
+            if (precon[ind] != 0)
+                dst[ind] = (dst[ind] + precon[ind]*(dst[ind+index(1,0)] + dst[ind+index(0,1)]))*precon[ind];
+        }
+    }
+}
+
 } // namespace eulerianfluid
 
 } // namespace behaviormodel
@@ -255,6 +255,10 @@ public:
     void step_project(const Grid2D* prev, Grid2D* temp, real dt, real diff);
     void step_color(const Grid2D* prev, Grid2D* temp, real dt, real diff);
 
+    // Preconditioner of the pressure solve in step_project
+    void mic0_init(const real* diag, real* precon) const;
+    void mic0_apply(const real* precon, const real* src, real* dst) const;
+
     // internal helper function
     //  template<int C> inline real find_velocity(int x, int y, int ind, int ind2, const Grid2D* prev, const Grid2D* temp);
 
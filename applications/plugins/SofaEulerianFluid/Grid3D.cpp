@@ -59,7 +59,7 @@ const unsigned long* Grid3D::obstacles = NULL;
       }                                         \
 }
 
-#define FOR_READ_INNER_CELLS(cmd)               \
+#define FOR_INNER_CELLS(grid,cmd)               \
 {                                               \
   int ind = index(1,1,1);                       \
   for (int z=1;z<nz-1;z++,ind+=index(0,2,0))    \
@@ -70,7 +70,10 @@ const unsigned long* Grid3D::obstacles = NULL;
       }                                         \
 }
 
-#define FOR_INNER_CELLS(grid,cmd)               \
+// Surface cells  are inner  cells and borders  between a  fluid inner
+// cell and an empty out cell (right or bottom side)
+
+#define FOR_SURFACE_CELLS(grid,cmd)             \
 {                                               \
   int ind = index(1,1,1);                       \
   for (int z=1;z<nz-1;z++,ind+=index(0,2,0))    \
@@ -81,18 +84,74 @@ const unsigned long* Grid3D::obstacles = NULL;
       }                                         \
 }
 
-// Surface cells  are inner  cells and borders  between a  fluid inner
-// cell and an empty out cell (right or bottom side)
+// Parallel versions of the loops above: the z slices are processed concurrently
+// when SOFA is compiled with OpenMP, and the index is recomputed for each row so
+// that the loop on x is a plain unit-stride loop the compiler can vectorize.
+// They can only be used when each iteration only writes its own cell.
+// FOR_INNER_CELLS_SUM also accumulates the given variable(s) over all the cells.
 
-#define FOR_SURFACE_CELLS(grid,cmd)             \
+enum { ParallelMinSize = 32*32*32 };
+
+#ifdef _OPENMP
+#define GRID_OMP_PRAGMA(x) _Pragma(#x)
+#else
+#define GRID_OMP_PRAGMA(x)
+#endif
+
+#define FOR_ALL_CELLS_PARALLEL(grid,cmd)        \
 {                                               \
-  int ind = index(1,1,1);                       \
-  for (int z=1;z<nz-1;z++,ind+=index(0,2,0))    \
-    for (int y=1;y<ny-1;y++,ind+=index(2,0,0))  \
+  GRID_OMP_PRAGMA(omp parallel for if(ncell >= ParallelMinSize)) \
+  for (int z=0;z<nz;z++)                        \
+    for (int y=0;y<ny;y++)                      \
+    {                                           \
+      int ind = index(0,y,z);                   \
+      for (int x=0;x<nx;x++,ind+=index(1,0,0))  \
+      {                                         \
+    cmd;                                    \
+      }                                         \
+    }                                           \
+}
+
+#define FOR_INNER_CELLS_PARALLEL(grid,cmd)      \
+{                                               \
+  GRID_OMP_PRAGMA(omp parallel for if(ncell >= ParallelMinSize)) \
+  for (int z=1;z<nz-1;z++)                      \
+    for (int y=1;y<ny-1;y++)                    \
+    {                                           \
+      int ind = index(1,y,z);                   \
+      for (int x=1;x<nx-1;x++,ind+=index(1,0,0))\
+      {                                         \
+    cmd;                                    \
+      }                                         \
+    }                                           \
+}
+
+#define FOR_INNER_CELLS_SUM(sum,cmd)            \
+{                                               \
+  GRID_OMP_PRAGMA(omp parallel for reduction(+:sum) if(ncell >= ParallelMinSize)) \
+  for (int z=1;z<nz-1;z++)                      \
+    for (int y=1;y<ny-1;y++)                    \
+    {                                           \
+      int ind = index(1,y,z);                   \
+      for (int x=1;x<nx-1;x++,ind+=index(1,0,0))\
+      {                                         \
+    cmd;                                    \
+      }                                         \
+    }                                           \
+}
+
+#define FOR_INNER_CELLS_SUM2(sum1,sum2,cmd)     \
+{                                               \
+  GRID_OMP_PRAGMA(omp parallel for reduction(+:sum1,sum2) if(ncell >= ParallelMinSize)) \
+  for (int z=1;z<nz-1;z++)                      \
+    for (int y=1;y<ny-1;y++)                    \
+    {                                           \
+      int ind = index(1,y,z);                   \
       for (int x=1;x<nx-1;x++,ind+=index(1,0,0))\
       {                                         \
     cmd;                                    \
       }                                         \
+    }                                           \
 }
 
 Grid3D::Grid3D()
@@ -156,7 +215,7 @@ void Grid3D::clear(int _nx, int _ny, int _nz)
 void Grid3D::seed(real height)
 {
     //seed(vec3(0,0,0), vec3(nx,height,nz));
-    FOR_ALL_CELLS(fdata,
+    FOR_ALL_CELLS_PARALLEL(fdata,
     {
         real d = y - height;
         levelset[ind] = d;
@@ -166,7 +225,7 @@ void Grid3D::seed(real height)
 void Grid3D::seed(real height, vec3 normal)
 {
     normal.normalize();
-    FOR_ALL_CELLS(fdata,
+    FOR_ALL_CELLS_PARALLEL(fdata,
     {
         real d = vec3((real)x,(real)y,(real)z)*normal - height;
         levelset[ind] = d;
@@ -187,7 +246,7 @@ void Grid3D::seed(vec3 p0, vec3 p1, vec3 velocity)
     msg_info("Grid3D") << "p0="<<p0<<" p1="<<p1;
     vec3 center = (p0+p1)*0.5f;
     vec3 dim = (p1-p0)*0.5f;
-    FOR_ALL_CELLS(fdata,
+    FOR_ALL_CELLS_PARALLEL(fdata,
     {
         vec3 v ((real)x,(real)y,(real)z);
         v -= center;
@@ -241,7 +300,7 @@ void Grid3D::step_init(const Grid3D* prev, Grid3D* /*temp*/, real /*dt*/, real /
     int lnsize = (nx+7)/8;
     int plsize = lnsize*ny;
 
-    FOR_ALL_CELLS(fdata,
+    FOR_ALL_CELLS_PARALLEL(fdata,
     {
         //levelset[ind] = 5;
         levelset[ind] = prev->levelset[ind];
@@ -274,7 +333,7 @@ void Grid3D::step_levelset(Grid3D* prev, Grid3D* temp, real dt, real /*diff*/)
     // Modified Eulerian / Midpoint method
     // Carlson Thesis page 22
 
-    FOR_INNER_CELLS(levelset,
+    FOR_INNER_CELLS_PARALLEL(levelset,
     {
         //if (prev->fdata[ind].type != PART_WALL && rabs(prev->levelset[ind]) < 5)
         if (rabs(prev->levelset[ind]) < 5)
@@ -297,7 +356,7 @@ void Grid3D::step_levelset(Grid3D* prev, Grid3D* temp, real dt, real /*diff*/)
 
     // fill border levelset using neighbors
 
-    FOR_ALL_CELLS(fmm_status,
+    FOR_ALL_CELLS_PARALLEL(fmm_status,
     {
         fmm_status[ind] = FMM_FAR;
         if (fdata[ind].type == PART_WALL)
@@ -331,7 +390,7 @@ void Grid3D::step_levelset(Grid3D* prev, Grid3D* temp, real dt, real /*diff*/)
     const int dind[3] = { 1, nx, nxny };
 
     // Compute all known points
-    FOR_ALL_CELLS(fdata,
+    FOR_ALL_CELLS_PARALLEL(fdata,
     {
         int c[3]; c[0] = x; c[1] = y; c[2] = z;
         bool known = false;
@@ -457,7 +516,7 @@ void Grid3D::step_levelset(Grid3D* prev, Grid3D* temp, real dt, real /*diff*/)
         }
     }
 
-    FOR_ALL_CELLS(levelset,
+    FOR_ALL_CELLS_PARALLEL(levelset,
     {
         if(temp->levelset[ind] < 0)
         {
@@ -610,7 +669,7 @@ void Grid3D::step_forces(const Grid3D* prev, Grid3D* /*temp*/, real dt, real /*d
     //vec3 f(0,0,-9.81*dt/scale);
     vec3 f = gravity * dt; //(0,-5*dt,0);
 
-    FOR_INNER_CELLS(fdata,
+    FOR_INNER_CELLS_PARALLEL(fdata,
     {
         vec3 u = f;
         int p0 = fdata[ind].type;
@@ -838,7 +897,7 @@ void Grid3D::step_advect(const Grid3D* /*prev*/, Grid3D* temp, real dt, real /*d
 
     memset(temp->fdata,0,temp->ncell*sizeof(Cell));
 
-    FOR_INNER_CELLS(temp->fdata,
+    FOR_INNER_CELLS_PARALLEL(temp->fdata,
     {
         // X Axis
         vec3 px( x-0.5f - dt*(fdata[ind].u[0]),
@@ -874,7 +933,7 @@ void Grid3D::step_diffuse(const Grid3D* /*prev*/, Grid3D* temp, real /*dt*/, rea
     real a = diff;
     real inv_c = 1.0f / (1.0001f + 6*a);
 
-    FOR_INNER_CELLS(fdata,
+    FOR_INNER_CELLS_PARALLEL(fdata,
     {
         fdata[ind].u = (temp->fdata[ind].u +
         (temp->fdata[ind+index(-1,0,0)].u+temp->fdata[ind+index(1,0,0)].u+
@@ -909,7 +968,7 @@ void Grid3D::step_project(const Grid3D* prev, Grid3D* temp, real dt, real /*diff
 
     //  int nbdiag[7]={0,0,0,0,0,0,0};
 
-    FOR_INNER_CELLS(diag,
+    FOR_INNER_CELLS_PARALLEL(diag,
     {
         if (fdata[ind].type>0)
         {
@@ -925,7 +984,7 @@ void Grid3D::step_project(const Grid3D* prev, Grid3D* temp, real dt, real /*diff
         }
     });
 
-    FOR_INNER_CELLS(b,
+    FOR_INNER_CELLS_SUM(b_norm2,
     {
         if (fdata[ind].type>0)
         {
@@ -935,17 +994,25 @@ void Grid3D::step_project(const Grid3D* prev, Grid3D* temp, real dt, real /*diff
         }
     });
 
-    FOR_ALL_CELLS(pressure,
+    FOR_ALL_CELLS_PARALLEL(pressure,
     {
         if (fdata[ind].type>0)
             pressure[ind] = prev->pressure[ind]; // use previous pressure as initial estimate
         else pressure[ind] = 0;
     });
 
-    double err = 0.0;
+    // Conjugate gradient preconditioned by a modified incomplete Cholesky factorization of A,
+    // which divides the number of iterations by 2 to 3 compared to the plain CG.
+    // The preconditioner arrays reuse temp->levelset (recomputed by step_levelset) and
+    // b (only needed to initialize r).
+    real* precon = temp->levelset;
+    real* rp = b; // preconditioned residual
+
+    double err = 0.0; // r.r, used for the stopping criterion
+    double rr_p = 0.0;  // r.rp
 
     // r = b - Ax
-    FOR_INNER_CELLS(r,
+    FOR_INNER_CELLS_PARALLEL(r,
     {
         if (diag[ind] != 0)
         {
@@ -955,36 +1022,44 @@ void Grid3D::step_project(const Grid3D* prev, Grid3D* temp, real dt, real /*diff
         }
     });
 
-    FOR_ALL_CELLS(g,
-    {
-        g[ind] = r[ind]; // first direction is r
-    });
+    mic0_init(diag, precon);
+    mic0_apply(precon, r, rp);
 
     double min_err = 0.000001f*b_norm2;
 
     int step;
     for (step=0; step<100; step++)
     {
-        double err_old = err;
+        double rr_p_old = rr_p;
         err = 0.0;
-        FOR_READ_INNER_CELLS(
+        rr_p = 0.0;
+        FOR_INNER_CELLS_SUM2(err, rr_p,
         {
             err += r[ind]*r[ind];
+            rr_p += r[ind]*rp[ind];
         });
 
         if (err<=min_err) break;
         if (step>0)
         {
-            real beta = (real)(err/err_old);
-            // g = g*beta + r
-            FOR_ALL_CELLS(g,
+            real beta = (real)(rr_p/rr_p_old);
+            // g = g*beta + rp
+            FOR_ALL_CELLS_PARALLEL(g,
             {
-                g[ind] = g[ind]*beta + r[ind];
+                g[ind] = g[ind]*beta + rp[ind];
+            });
+        }
+        else
+        {
+            // first direction is rp
+            FOR_ALL_CELLS_PARALLEL(g,
+            {
+                g[ind] = rp[ind];
             });
         }
         double g_q = 0.0;
         // q = Ag
-        FOR_INNER_CELLS(q,
+        FOR_INNER_CELLS_SUM(g_q,
         {
             if (diag[ind] != 0)
             {
@@ -996,13 +1071,15 @@ void Grid3D::step_project(const Grid3D* prev, Grid3D* temp, real dt, real /*diff
             }
         });
 
-        real alpha = (real)(err/g_q);
+        real alpha = (real)(rr_p/g_q);
 
-        FOR_ALL_CELLS(pressure,
+        FOR_ALL_CELLS_PARALLEL(pressure,
         {
             pressure[ind] += alpha*g[ind];
             r[ind] -= alpha*q[ind];
         });
+
+        mic0_apply(precon, r, rp);
     }
 
     // Now apply pressure back to velocity
@@ -1013,7 +1090,7 @@ void Grid3D::step_project(const Grid3D* prev, Grid3D* temp, real dt, real /*diff
     //max_pressure = 0.0;
     max_pressure = prev->max_pressure;
 
-    FOR_INNER_CELLS(fdata,
+    FOR_INNER_CELLS_PARALLEL(fdata,
     {
         if (fdata[ind].type>=PART_EMPTY)
         {
@@ -1040,6 +1117,60 @@ void Grid3D::step_project(const Grid3D* prev, Grid3D* temp, real dt, real /*diff
     });
 }
 
+// Modified incomplete Cholesky factorization MIC(0) of the pressure matrix
+// (see R. Bridson, "Fluid Simulation for Computer Graphics", chapter 4).
+// Fluid cells are the ones with a non-zero diagonal, they are coupled by -1 coefficients.
+// The factorization and the triangular solves are sequential sweeps over the grid.
+
+void Grid3D::mic0_init(const real* diag, real* precon) const
+{
+    const real tau = 0.97f; // amount of modification
+    const real sigma = 0.25f; // safety threshold
+    memset(precon,0,ncell*sizeof(real));
+    FOR_INNER_CELLS(precon,
+    {
+        if (diag[ind] != 0)
+        {
+            real e = diag[ind];
+            real p;
+            p = precon[ind-index(1,0,0)];
+            e -= p*p*(1 + tau*((diag[ind+index(-1,1,0)] != 0) + (diag[ind+index(-1,0,1)] != 0)));
+            p = precon[ind-index(0,1,0)];
+            e -= p*p*(1 + tau*((diag[ind+index(1,-1,0)] != 0) + (diag[ind+index(0,-1,1)] != 0)));
+            p = precon[ind-index(0,0,1)];
+            e -= p*p*(1 + tau*((diag[ind+index(1,0,-1)] != 0) + (diag[ind+index(0,1,-1)] != 0)));
+            if (e < sigma*diag[ind]) e = diag[ind];
+            precon[ind] = 1/sqrtf(e);
+        }
+    });
+}
+
+void Grid3D::mic0_apply(const real* precon, const real* src, real* dst) const
+{
+    // dst is zero outside of the fluid, as src and precon
+    // solve L y = src, y being stored in dst
+    FOR_INNER_CELLS(dst,
+    {
+        if (precon[ind] != 0)
+            dst[ind] = (src[ind] + precon[ind-index(1,0,0)]*dst[ind-index(1,0,0)]
+                             + precon[ind-index(0,1,0)]*dst[ind-index(0,1,0)]
+                             + precon[ind-index(0,0,1)]*dst[ind-index(0,0,1)])*precon[ind];
+        else
+            dst[ind] = 0;
+    });
+    // solve L^T dst = y
+    for (int z=nz-2; z>=1; z--)
+        for (int y=ny-2; y>=1; y--)
+        {
+            int ind = index(nx-2,y,z);
+            for (int x=nx-2; x>=1; x--, ind-=index(1,0,0))
+            {
+                if (precon[ind] != 0)
+                    dst[ind] = (dst[ind] + precon[ind]*(dst[ind+index(1,0,0)] + dst[ind+index(0,1,0)] + dst[ind+index(0,0,1)]))*precon[ind];
+            }
+        }
+}
+
 } // namespace eulerianfluid
 
 } // namespace behaviormodel
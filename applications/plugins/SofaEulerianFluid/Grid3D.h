@@ -286,6 +286,10 @@ public:
     void step_project(const Grid3D* prev, Grid3D* temp, real dt, real diff);
     void step_color(const Grid3D* prev, Grid3D* temp, real dt, real diff);
 
+    // Preconditioner of the pressure solve in step_project
+    void mic0_init(const real* diag, real* precon) const;
+    void mic0_apply(const real* precon, const real* src, real* dst) const;
+
     // internal helper function
     //  template<int C> inline real find_velocity(int x, int y, int z, int ind, int ind2, const Grid3D* prev, const Grid3D* temp);
 
@@ -144,7 +144,19 @@ struct ImageContainerSpecialization< defaulttype::Image<T> >
 
                 double scale[3]={1.,1.,1.},translation[3]={0.,0.,0.},affine[9]={1.,0.,0.,0.,1.,0.,0.,0.,1.},offsetT=0.,scaleT=1.;
                 int isPerspective=0;
-                wimage->getCImgList().assign(cimg_library::load_metaimage<T,double>(fname.c_str(),scale,translation,affine,&offsetT,&scaleT,&isPerspective));
+                bool mapped=false;
+                if(container->mapFile.getValue())
+                {
+                    std::string imageFilename,inputType;
+                    unsigned int dim[4],nbchannels;
+                    if(cimg_library::load_metaimage_header<T,double>(fname.c_str(),imageFilename,dim,nbchannels,inputType,scale,translation,affine,&offsetT,&scaleT,&isPerspective))
+                    {
+                        // voxels can only be used in place when they do not need a conversion
+                        if(inputType==std::string(cimg_library::cimg::type<T>::string())) mapped=wimage->mapRaw(imageFilename,typename ImageContainerT::imCoord(dim[0],dim[1],dim[2],nbchannels,dim[3]));
+                        if(!mapped) container->serr << "Cannot map " << imageFilename << ", it is read instead" << container->sendl;
+                    }
+                }
+                if(!mapped) wimage->getCImgList().assign(cimg_library::load_metaimage<T,double>(fname.c_str(),scale,translation,affine,&offsetT,&scaleT,&isPerspective));
                 if (!container->transformIsSet)
                 {
                     for(unsigned int i=0;i<3;i++) wtransform->getScale()[i]=(Real)scale[i];
@@ -174,7 +186,8 @@ struct ImageContainerSpecialization< defaulttype::Image<T> >
                 fileStream.close();
 
                 std::string imgName (fname);  imgName.replace(imgName.find_last_of('.')+1,imgName.size(),"raw");
-                wimage->getCImgList().push_back(cimg_library::CImg<T>().load_raw(imgName.c_str(),dim[0],dim[1],dim[2]));
+                if(!container->mapFile.getValue() || !wimage->isEmpty() || !wimage->mapRaw(imgName,typename ImageContainerT::imCoord(dim[0],dim[1],dim[2],1,1)))
+                    wimage->getCImgList().push_back(cimg_library::CImg<T>().load_raw(imgName.c_str(),dim[0],dim[1],dim[2]));
             }
             else if(fname.find(".cimg")!=std::string::npos || fname.find(".CIMG")!=std::string::npos || fname.find(".Cimg")!=std::string::npos || fname.find(".CImg")!=std::string::npos)
                 wimage->getCImgList().load_cimg(fname.c_str());
@@ -364,6 +377,12 @@ public:
     */
     Data<unsigned int> nFrames; ///< The number of frames of the sequence to be loaded. Default is the entire sequence.
 
+    /**
+    * If true, uncompressed raw voxels (.mhd/.raw and .nfo files) are memory-mapped instead of being read:
+    * they are only loaded when accessed, which allows volumes larger than the physical memory.
+    */
+    Data<bool> mapFile; ///< map the voxels of raw files instead of reading them
+
 
     virtual std::string getTemplateName() const	override { return templateName(this); }
     static std::string templateName(const ImageContainer<ImageTypes>* = NULL) {	return ImageTypes::Name(); }
@@ -375,6 +394,7 @@ public:
       , drawBB(initData(&drawBB,false,"drawBB","draw bounding box"))
       , sequence(initData(&sequence, false, "sequence", "load a sequence of images"))
       , nFrames (initData(&nFrames, "numberOfFrames", "The number of frames of the sequence to be loaded. Default is the entire sequence."))
+      , mapFile(initData(&mapFile, false, "mapFile", "map the voxels of uncompressed raw files (.mhd/.raw, .nfo) instead of reading them, so that they are loaded on demand"))
       , transformIsSet (false)
     {
         this->addAlias(&image, "inputImage");
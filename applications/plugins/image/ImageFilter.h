@@ -29,6 +29,12 @@
 #include <sofa/defaulttype/Vec.h>
 #include <sofa/helper/rmath.h>
 #include <sofa/helper/OptionsGroup.h>
+#include <algorithm>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #define NONE 0
 #define BLURDERICHE 1
@@ -71,8 +77,110 @@ namespace component
 namespace engine
 {
 
+/**
+ * Labels the 6-connected components of each channel of an image, with the same result as CImg::get_label(false,tolerance):
+ * neighbors belong to the same component when their values differ by at most the tolerance,
+ * and components are numbered from 0 in the order of their first voxel.
+ * The union-find is performed in parallel on slabs of slices, which are then merged along their boundaries.
+ */
+template<typename T>
+cimg_library::CImg<unsigned long> labelConnectedComponents(const cimg_library::CImg<T>& img, const float tolerance=0)
+{
+    typedef unsigned long Tlabel;
+    typedef typename cimg_library::CImg<T>::Tfloat Tfloat;
+
+    cimg_library::CImg<Tlabel> res(img.width(),img.height(),img.depth(),img.spectrum());
+    if(img.is_empty()) return res;
+
+    const long w=img.width(), h=img.height(), d=img.depth(), wh=w*h;
+    std::vector<Tlabel> parent(wh*d);
+
+    int nbSlabs=1;
+#ifdef _OPENMP
+    nbSlabs=std::max(1,std::min(omp_get_max_threads(),(int)d));
+#endif
+    std::vector<long> slab(nbSlabs+1); // first slice of each slab
+    for(int s=0;s<=nbSlabs;++s) slab[s]=d*s/nbSlabs;
+    std::vector<Tlabel> firstLabel(nbSlabs+1);
+
+    // union of the trees of p and q, the root of a tree is always its smallest voxel index
+    struct UnionFind
+    {
+        static void unite(std::vector<Tlabel>& parent, Tlabel p, Tlabel q)
+        {
+            while(parent[p]!=p) { parent[p]=parent[parent[p]]; p=parent[p]; }
+            while(parent[q]!=q) { parent[q]=parent[parent[q]]; q=parent[q]; }
+            if(p<q) parent[q]=p; else if(q<p) parent[p]=q;
+        }
+    };
+
+    cimg_forC(img,c)
+    {
+        const T* v = img.data(0,0,0,c);
+        Tlabel* label = res.data(0,0,0,c);
+
+        // union-find inside each slab, a tree only contains voxels of its slab
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for(int s=0;s<nbSlabs;++s)
+        {
+            for(long p=slab[s]*wh;p<slab[s+1]*wh;++p) parent[p]=p;
+            for(long z=slab[s];z<slab[s+1];++z) for(long y=0;y<h;++y) for(long x=0;x<w;++x)
+            {
+                const long p=x+y*w+z*wh;
+                if(x+1<w && (Tfloat)cimg_library::cimg::abs(v[p]-v[p+1])<=tolerance) UnionFind::unite(parent,p,p+1);
+                if(y+1<h && (Tfloat)cimg_library::cimg::abs(v[p]-v[p+w])<=tolerance) UnionFind::unite(parent,p,p+w);
+                if(z+1<slab[s+1] && (Tfloat)cimg_library::cimg::abs(v[p]-v[p+wh])<=tolerance) UnionFind::unite(parent,p,p+wh);
+            }
+        }
+
+        // merge the slabs along their boundaries
+        for(int s=1;s<nbSlabs;++s)
+            for(long p=(slab[s]-1)*wh;p<slab[s]*wh;++p)
+                if((Tfloat)cimg_library::cimg::abs(v[p]-v[p+wh])<=tolerance) UnionFind::unite(parent,p,p+wh);
+
+        // number the roots in voxel order, then propagate their labels
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for(int s=0;s<nbSlabs;++s)
+        {
+            Tlabel nb=0;
+            for(long p=slab[s]*wh;p<slab[s+1]*wh;++p) if(parent[p]==(Tlabel)p) ++nb;
+            firstLabel[s+1]=nb;
+        }
+        firstLabel[0]=0;
+        for(int s=0;s<nbSlabs;++s) firstLabel[s+1]+=firstLabel[s];
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for(int s=0;s<nbSlabs;++s)
+        {
+            Tlabel nb=firstLabel[s];
+            for(long p=slab[s]*wh;p<slab[s+1]*wh;++p) if(parent[p]==(Tlabel)p) label[p]=nb++;
+        }
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for(int s=0;s<nbSlabs;++s)
+            for(long p=slab[s]*wh;p<slab[s+1]*wh;++p) if(parent[p]!=(Tlabel)p)
+            {
+                Tlabel r=parent[p];
+                while(parent[r]!=r) r=parent[r];
+                label[p]=label[r];
+            }
+    }
+    return res;
+}
+
+
 /**
  * This class computes a filtered image
+ * Filters implemented here (threshold, gradient, hessian, resample, mean diffusion, connected components)
+ * are computed in parallel on slices when OpenMP is enabled, CImg filters use their own OpenMP implementation.
  */
 
 
@@ -340,10 +448,15 @@ protected:
                 Ti valuemax=cimg_library::cimg::type<Ti>::max(); if(p.size()>1) valuemax=(Ti)p[1];
 
                 cimglist_for(img,l)
-                        cimg_forXYZ(img(l),x,y,z)
                 {
-                    if(inimg(l)(x,y,z)>=valuemin && inimg(l)(x,y,z)<=valuemax) img(l)(x,y,z)=(To)1;
-                    else img(l)(x,y,z)=(To)0;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+                    cimg_forZ(img(l),z) cimg_forXY(img(l),x,y)
+                    {
+                        if(inimg(l)(x,y,z)>=valuemin && inimg(l)(x,y,z)<=valuemax) img(l)(x,y,z)=(To)1;
+                        else img(l)(x,y,z)=(To)0;
+                    }
                 }
             }
             break;
@@ -383,21 +496,39 @@ protected:
             if(updateImage || updateTransform)
             {
                 char axis='a';  if(p.size()) { if((int)p[0]==0) axis='x'; else if((int)p[0]==1) axis='y'; else if((int)p[0]==2) axis='z'; }
+                const To sx=(To)inT->getScale()[0], sy=(To)inT->getScale()[1], sz=(To)inT->getScale()[2];
 
-                CImg_3x3x3(I,To);
                 cimglist_for(img,l)
                 {
-                    To *ptrd = img(l)._data;
-                    // Central finite differences.
-                    if(axis=='x') cimg_forC(inimg(l),c) cimg_for3x3x3(inimg(l),x,y,z,c,I,To)      *(ptrd++) = (Incc - Ipcc)*(To)0.5/(To)inT->getScale()[0];
-                    else if(axis=='y') cimg_forC(inimg(l),c) cimg_for3x3x3(inimg(l),x,y,z,c,I,To) *(ptrd++) = (Icnc - Icpc)*(To)0.5/(To)inT->getScale()[1];
-                    else if(axis=='z') cimg_forC(inimg(l),c) cimg_for3x3x3(inimg(l),x,y,z,c,I,To) *(ptrd++) = (Iccn - Iccp)*(To)0.5/(To)inT->getScale()[2];
-                    else  cimg_forC(inimg(l),c) cimg_for3x3x3(inimg(l),x,y,z,c,I,To)
+                    const cimg_library::CImg<Ti>& I = inimg(l);
+                    const int w=I.width(), h=I.height(), d=I.depth();
+                    // Central finite differences (with Neumann boundary conditions).
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+                    for(int z=0;z<d;++z)
                     {
-                        To ix = (Incc - Ipcc)*(To)0.5/(To)inT->getScale()[0];
-                        To iy = (Icnc - Icpc)*(To)0.5/(To)inT->getScale()[1];
-                        To iz = (Iccn - Iccp)*(To)0.5/(To)inT->getScale()[2];
-                        *(ptrd++) = (To)sqrt( (SReal) ix*ix+iy*iy+iz*iz);
+                        const int zp=z>0?z-1:z, zn=z<d-1?z+1:z;
+                        cimg_forC(I,c) for(int y=0;y<h;++y)
+                        {
+                            const int yp=y>0?y-1:y, yn=y<h-1?y+1:y;
+                            const Ti *Ic=I.data(0,y,z,c), *Ipy=I.data(0,yp,z,c), *Iny=I.data(0,yn,z,c), *Ipz=I.data(0,y,zp,c), *Inz=I.data(0,y,zn,c);
+                            To *ptrd = img(l).data(0,y,z,c);
+                            for(int x=0;x<w;++x)
+                            {
+                                const int xp=x>0?x-1:x, xn=x<w-1?x+1:x;
+                                if(axis=='x') *(ptrd++) = ((To)Ic[xn] - (To)Ic[xp])*(To)0.5/sx;
+                                else if(axis=='y') *(ptrd++) = ((To)Iny[x] - (To)Ipy[x])*(To)0.5/sy;
+                                else if(axis=='z') *(ptrd++) = ((To)Inz[x] - (To)Ipz[x])*(To)0.5/sz;
+                                else
+                                {
+                                    To ix = ((To)Ic[xn] - (To)Ic[xp])*(To)0.5/sx;
+                                    To iy = ((To)Iny[x] - (To)Ipy[x])*(To)0.5/sy;
+                                    To iz = ((To)Inz[x] - (To)Ipz[x])*(To)0.5/sz;
+                                    *(ptrd++) = (To)sqrt( (SReal) ix*ix+iy*iy+iz*iz);
+                                }
+                            }
+                        }
                     }
                 }
             }
@@ -408,17 +539,37 @@ protected:
                 char axis1='x';  if(p.size()) { if((int)p[0]==1) axis1='y'; else if((int)p[0]==2) axis1='z'; }
                 char axis2='x';  if(p.size()>1) { if((int)p[1]==1) axis2='y'; else if((int)p[1]==2) axis2='z'; }
                 if (axis1>axis2) cimg_library::cimg::swap(axis1,axis2);
-                CImg_3x3x3(I,To);
+                const Real sx=inT->getScale()[0], sy=inT->getScale()[1], sz=inT->getScale()[2];
+
                 cimglist_for(img,l)
                 {
-                    To *ptrd = img(l)._data;
-                    // Central finite differences.
-                    if(axis1=='x' && axis2=='x') cimg_forC(inimg(l),c) cimg_for3x3x3(inimg(l),x,y,z,c,I,To)  *(ptrd++) = (Ipcc + Incc - 2*Iccc)              /(To)(inT->getScale()[0]*inT->getScale()[0]);
-                    else if(axis1=='x' && axis2=='y') cimg_forC(inimg(l),c) cimg_for3x3x3(inimg(l),x,y,z,c,I,To)  *(ptrd++) = (Ippc + Innc - Ipnc - Inpc)*(To)0.25/(To)(inT->getScale()[0]*inT->getScale()[1]);
-                    else if(axis1=='x' && axis2=='z') cimg_forC(inimg(l),c) cimg_for3x3x3(inimg(l),x,y,z,c,I,To)  *(ptrd++) = (Ipcp + Incn - Ipcn - Incp)*(To)0.25/(To)(inT->getScale()[0]*inT->getScale()[2]);
-                    else if(axis1=='y' && axis2=='y') cimg_forC(inimg(l),c) cimg_for3x3x3(inimg(l),x,y,z,c,I,To)  *(ptrd++) = (Icpc + Icnc - 2*Iccc)              /(To)(inT->getScale()[1]*inT->getScale()[1]);
-                    else if(axis1=='y' && axis2=='z') cimg_forC(inimg(l),c) cimg_for3x3x3(inimg(l),x,y,z,c,I,To)  *(ptrd++) = (Icpp + Icnn - Icpn - Icnp)*(To)0.25/(To)(inT->getScale()[1]*inT->getScale()[2]);
-                    else if(axis1=='z' && axis2=='z') cimg_forC(inimg(l),c) cimg_for3x3x3(inimg(l),x,y,z,c,I,To)  *(ptrd++) = (Iccn + Iccp - 2*Iccc)              /(To)(inT->getScale()[2]*inT->getScale()[2]);
+                    const cimg_library::CImg<Ti>& I = inimg(l);
+                    const int w=I.width(), h=I.height(), d=I.depth();
+                    // Central finite differences (with Neumann boundary conditions).
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+                    for(int z=0;z<d;++z)
+                    {
+                        const int zs[3]={z>0?z-1:z, z, z<d-1?z+1:z};
+                        cimg_forC(I,c) for(int y=0;y<h;++y)
+                        {
+                            const int ys[3]={y>0?y-1:y, y, y<h-1?y+1:y};
+                            const Ti* r[3][3]; // rows at [y-1,y,y+1][z-1,z,z+1]
+                            for(unsigned int j=0;j<3;++j) for(unsigned int k=0;k<3;++k) r[j][k]=I.data(0,ys[j],zs[k],c);
+                            To *ptrd = img(l).data(0,y,z,c);
+                            for(int x=0;x<w;++x)
+                            {
+                                const int xp=x>0?x-1:x, xn=x<w-1?x+1:x;
+                                if(axis1=='x' && axis2=='x') *(ptrd++) = ((To)r[1][1][xp] + (To)r[1][1][xn] - 2*(To)r[1][1][x])/(To)(sx*sx);
+                                else if(axis1=='x' && axis2=='y') *(ptrd++) = ((To)r[0][1][xp] + (To)r[2][1][xn] - (To)r[2][1][xp] - (To)r[0][1][xn])*(To)0.25/(To)(sx*sy);
+                                else if(axis1=='x' && axis2=='z') *(ptrd++) = ((To)r[1][0][xp] + (To)r[1][2][xn] - (To)r[1][2][xp] - (To)r[1][0][xn])*(To)0.25/(To)(sx*sz);
+                                else if(axis1=='y' && axis2=='y') *(ptrd++) = ((To)r[0][1][x] + (To)r[2][1][x] - 2*(To)r[1][1][x])/(To)(sy*sy);
+                                else if(axis1=='y' && axis2=='z') *(ptrd++) = ((To)r[0][0][x] + (To)r[2][2][x] - (To)r[0][2][x] - (To)r[2][0][x])*(To)0.25/(To)(sy*sz);
+                                else if(axis1=='z' && axis2=='z') *(ptrd++) = ((To)r[1][0][x] + (To)r[1][2][x] - 2*(To)r[1][1][x])/(To)(sz*sz);
+                            }
+                        }
+                    }
                 }
             }
             break;
@@ -462,7 +613,10 @@ protected:
                 cimglist_for(img,l)
                 {
                     img(l).resize(dimx,dimy,dimz,nbc);
-                    cimg_forXYZ(img(l),x,y,z)
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+                    cimg_forZ(img(l),z) cimg_forXY(img(l),x,y)
                     {
                         Coord p=inT->toImage(outT->fromImage(Coord(x,y,z)));
                         if(p[0]<-0.5 || p[1]<-0.5 || p[2]<-0.5 || p[0]>inimg(l).width()-0.5 || p[1]>inimg(l).height()-0.5 || p[2]>inimg(l).depth()-0.5)
@@ -547,7 +701,10 @@ protected:
                     {
                         change = false;
 
-                        cimg_forXYZ(mask,x,y,z)
+#ifdef _OPENMP
+#pragma omp parallel for reduction(||:change)
+#endif
+                        cimg_forZ(mask,z) cimg_forXY(mask,x,y)
                         {
                             if( mask(x,y,z) == false ) // to compute
                             {
@@ -614,7 +771,7 @@ protected:
 
                 cimglist_for(img,l)
                 {
-                    img(l).label(false,tol);
+                    img(l) = labelConnectedComponents(img(l),tol);
                 }
             }
             break;
@@ -627,17 +784,20 @@ protected:
 
                 cimglist_for(img,l)
                 {
-                    typedef unsigned int Tlabel;
-                    cimg_library::CImg<Tlabel> im = inimg(l);
-                    im.label(false,tol);
+                    typedef unsigned long Tlabel;
+                    const cimg_library::CImg<Tlabel> im = labelConnectedComponents(cimg_library::CImg<unsigned int>(inimg(l)),tol);
                     //histo
-                    std::map<Tlabel,unsigned long> histo;
+                    std::vector<unsigned long> histo(im.max()+1,0);
                     cimg_foroff(im,off) histo[im[off]]++;
                     Tlabel val=0; unsigned long mx=0;
                     // get max size
-                    for (typename std::map<Tlabel,unsigned long>::iterator it=histo.begin(); it!=histo.end(); ++it) if(it->second>=mx && it->first!=(Tlabel)0.) { mx=it->second; val=it->first; }
+                    for (Tlabel i=1; i<histo.size(); ++i) if(histo[i]>=mx) { mx=histo[i]; val=i; }
                     // mask input
-                    cimg_foroff(im,off) if(im[off]==val) img(l)[off]=(To)inimg(l)[off]; else     img(l)[off]=(To)0.;
+                    const long nbVoxels=(long)im.size();
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+                    for(long off=0; off<nbVoxels; ++off) if(im[off]==val) img(l)[off]=(To)inimg(l)[off]; else     img(l)[off]=(To)0.;
                 }
             }
             break;
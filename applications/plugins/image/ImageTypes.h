@@ -41,8 +41,10 @@
 #include <sofa/helper/rmath.h>
 #include <sofa/helper/accessor.h>
 #include <sofa/helper/fixed_array.h>
+#include <sofa/helper/io/MappedFile.h>
 #include "VectorVis.h"
 #include <sofa/helper/rmath.h>
+#include <memory>
 
 namespace sofa
 {
@@ -82,36 +84,81 @@ struct Image : public BaseImage
 
 protected:
     cimg_library::CImgList<T> img; // list of images along temporal dimension. Each image is 4-dimensional (x,y,z,s) where s is the spectrum (e.g. channels for color images, vector or tensor values, etc.)
+    std::shared_ptr<helper::io::MappedFile> mapping; // file viewed by the images of the list, see mapRaw()
 
 public:
     static const char* Name();
 
     ///constructors/destructors
     Image() {}
-    Image(const Image<T>& _img, bool shared=false) : img(_img.getCImgList(), shared) {}
+    Image(const Image<T>& _img, bool shared=false) { assign(_img,shared); }
     Image( const cimg_library::CImg<T>& _img ) : img(_img) {}
 
     /// copy operators
+    /// copies of a mapped image view the same voxels until they are modified (see detach())
     Image<T>& operator=(const Image<T>& im)
     {
-        if(im.getCImgList().size()) img.assign(im.getCImgList());
-        return *this;
+        return assign(im);
     }
     Image<T>& assign(const Image<T>& im, const bool shared=false)
     {
-        if(im.getCImgList().size()) img.assign(im.getCImgList(),shared);
+        if(&im==this) return *this;
+        if(im.isMapped())
+        {
+            // CImgList::assign would copy the shared images: build the views one by one
+            cimg_library::CImgList<T> views(im.img.size());
+            cimglist_for(views,l) views(l).assign(im.img(l)._data, im.img(l).width(), im.img(l).height(), im.img(l).depth(), im.img(l).spectrum(), true);
+            views.swap(img);
+            mapping=im.mapping;
+        }
+        else if(im.getCImgList().size()) { img.assign(im.getCImgList(),shared); mapping.reset(); }
         return *this;
     }
 
+    /// Views the voxels stored in a raw file (x fastest, then y, z, s and t), without reading them.
+    /// The file is memory-mapped and the images of the list point into the mapping: voxels are loaded
+    /// on first access and can be released by the system when memory is short. There is no brick
+    /// cache on top of it, the page cache of the system already loads and evicts the voxels by pages.
+    /// Modified voxels are private copies, the file is never written.
+    /// @returns false if the file cannot be mapped or is too small, the image is then left unchanged.
+    bool mapRaw(const std::string& filename, const imCoord& dim)
+    {
+        const size_t nb = (size_t)dim[0]*dim[1]*dim[2]*dim[3];
+        if(!nb || !dim[4]) return false;
+        std::shared_ptr<helper::io::MappedFile> file(new helper::io::MappedFile(filename, helper::io::MappedFile::CopyOnWrite));
+        if(!file->isMapped() || file->size() < nb*dim[4]*sizeof(T)) return false;
+        T* data = (T*)file->writableData();
+
+        cimg_library::CImgList<T> views(dim[4]);
+        cimglist_for(views,l) views(l).assign(data + l*nb, dim[0], dim[1], dim[2], dim[3], true);
+        views.swap(img);
+        mapping = file;
+        return true;
+    }
+
+    /// @returns true if the images point into a file mapped by mapRaw()
+    bool isMapped() const { return mapping && !img.is_empty(); }
+
+    /// Gives the images their own voxels if the mapped voxels are also viewed by other images.
+    /// It is done before any modification (non-const accessors), so that the copies of a mapped
+    /// image only duplicate the voxels when they are modified.
+    void detach()
+    {
+        if(!mapping || mapping.use_count()==1) return;
+        cimg_library::CImgList<T> copy(img,false);
+        copy.swap(img);
+        mapping.reset();
+    }
 
-    void clear() { img.assign(); }
+    void clear() { img.assign(); mapping.reset(); }
     ~Image() { clear(); }
 
     //accessors
-    cimg_library::CImgList<T>& getCImgList() { return img; }
+    cimg_library::CImgList<T>& getCImgList() { detach(); return img; }
     const cimg_library::CImgList<T>& getCImgList() const { return img; }
 
     cimg_library::CImg<T>& getCImg(const unsigned int t=0) {
+        detach();
         if (t>=img.size())   {
             assert(img._data != NULL);
             return *img._data;
@@ -160,6 +207,14 @@ public:
     //affectors
     void setDimensions(const imCoord& dim)
     {
+        if(mapping && getDimensions()!=dim)
+        {
+            // mapped images cannot be reallocated: give them their own voxels first
+            cimg_library::CImgList<T> copy(img,false);
+            copy.swap(img);
+            mapping.reset();
+        }
+        else detach();
         cimglist_for(img,l) img(l).resize(dim[0],dim[1],dim[2],dim[3]);
         if(img.size()>dim[4]) img.remove(dim[4],img.size()-1);
         else if(img.size()<dim[4]) img.insert(dim[4]-img.size(),cimg_library::CImg<T>(dim[0],dim[1],dim[2],dim[3]));
@@ -167,6 +222,7 @@ public:
 
     void fill(const SReal val)
     {
+        detach();
         cimglist_for(img,l) img(l).fill((T)val);
     }
 
@@ -86,6 +86,51 @@ struct DataImageLink_test : public Sofa_test<>
         ASSERT_EQ(data1.getValue(),data2.getValue());
     }
 
+    // Test link to a mapped image
+    void testMappedImageDataLink()
+    {
+        std::string fileName = std::string(IMAGETEST_SCENES_DIR) + "/" + "beam.raw";
+
+        ImageContainer::SPtr readContainer = sofa::core::objectmodel::New<ImageContainer>();
+        readContainer->m_filename.setValue(fileName);
+        readContainer->init();
+
+        ImageContainer::SPtr mappedContainer = sofa::core::objectmodel::New<ImageContainer>();
+        mappedContainer->m_filename.setValue(fileName);
+        mappedContainer->mapFile.setValue(true);
+        mappedContainer->init();
+
+        const Image& mapped = mappedContainer->image.getValue();
+        ASSERT_TRUE(mapped.isMapped());
+        ASSERT_FALSE(readContainer->image.getValue().isMapped());
+        ASSERT_EQ(readContainer->image.getValue(), mapped);
+        const unsigned char* voxels = mapped.getCImg(0).data();
+
+        // the linked data views the same voxels
+        core::objectmodel::Data< Image > linked;
+        sofa::modeling::setDataLink(&mappedContainer->image,&linked);
+        ASSERT_TRUE(linked.getValue().isMapped());
+        EXPECT_EQ(voxels, linked.getValue().getCImg(0).data());
+
+        // so does a copy, until it is modified
+        Image copy(linked.getValue());
+        EXPECT_TRUE(copy.isMapped());
+        EXPECT_EQ(voxels, static_cast<const Image&>(copy).getCImg(0).data());
+
+        copy.getCImg(0).fill(0);
+        EXPECT_FALSE(copy.isMapped());
+        EXPECT_NE(voxels, static_cast<const Image&>(copy).getCImg(0).data());
+
+        // modifying the linked data does not modify its source
+        {
+            helper::WriteAccessor<Data< Image > > w(linked);
+            w->getCImg(0).fill(0);
+        }
+        EXPECT_TRUE(mappedContainer->image.getValue().isMapped());
+        EXPECT_EQ(voxels, mappedContainer->image.getValue().getCImg(0).data());
+        EXPECT_EQ(readContainer->image.getValue(), mappedContainer->image.getValue());
+    }
+
     void loadImage()
     {
         ImageContainer::SPtr ic = sofa::core::objectmodel::New<ImageContainer>();
@@ -120,6 +165,10 @@ TEST_F(DataImageLink_test , testImageDataLink )
 {
     this->testImageDataLink();
 }
+TEST_F(DataImageLink_test , testMappedImageDataLink )
+{
+    this->testMappedImageDataLink();
+}
 
 }// namespace sofa
 
@@ -0,0 +1,62 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program. If not, see <http://www.gnu.org/licenses/>.              *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaTest/Sofa_test.h>
+#include <image/ImageFilter.h>
+
+namespace sofa {
+
+/**  Test suite for the connected component labeling of ImageFilter.
+Labels computed by slabs must be the same as the ones of CImg::get_label().
+  */
+struct ImageFilterLabel_test : public Sofa_test<>
+{
+    template<typename T>
+    void checkLabels(const cimg_library::CImg<T>& img, const float tolerance)
+    {
+        const cimg_library::CImg<unsigned long> labels = component::engine::labelConnectedComponents(img,tolerance);
+        const cimg_library::CImg<unsigned long> expected = img.get_label(false,tolerance);
+        ASSERT_TRUE(labels.is_sameXYZC(expected));
+        cimg_foroff(labels,off) ASSERT_EQ(expected[off],labels[off]);
+    }
+
+    void testLabels()
+    {
+        cimg_library::CImg<unsigned char> binary(23,17,31,1);
+        cimg_foroff(binary,off) binary[off]=(unsigned char)(std::rand()%2);
+        checkLabels(binary,0);
+
+        cimg_library::CImg<double> smooth(20,25,15,2);
+        smooth.rand(0,10).blur(1.5);
+        checkLabels(smooth,0.2f);
+
+        cimg_library::CImg<unsigned short> slice(40,30,1,1);
+        cimg_foroff(slice,off) slice[off]=(unsigned short)(std::rand()%3);
+        checkLabels(slice,1);
+    }
+};
+
+TEST_F(ImageFilterLabel_test , labels )
+{
+    testLabels();
+}
+
+}// namespace sofa
@@ -57,16 +57,38 @@ public:
     virtual void createScene();
 
     /// Start the simulation
-    /// Currently this simply sets the animated flag to true, but this might
-    /// start a separate computation thread in a future version
+    /// This simply sets the animated flag to true, see startAsync()
+    /// to compute the steps on a separate thread
     void start();
 
     /// Stop/pause the simulation
     void stop();
 
     /// Compute one simulation time-step
+    /// In asynchronous mode, acquire the last computed step instead, without waiting
     void step();
 
+    /// Compute the steps on a separate thread, at most maxStepsPerSecond
+    /// per second (0 for no limit), as long as the simulation is animated.
+    /// Output meshes and data monitors then give the state of the last step
+    /// acquired by step(), while data controllers values are applied
+    /// before the following computed step.
+    /// Not available when the GUI is used, as it must be driven by the host thread
+    /// @return false if the asynchronous mode could not be started
+    bool startAsync(double maxStepsPerSecond = 0);
+
+    /// Wait for the current step and stop the simulation thread
+    void stopAsync();
+
+    /// Return true if the steps are computed on a separate thread
+    bool isAsync() const;
+
+    /// Return the number of steps computed per second
+    double getSimulationRate() const;
+
+    /// Return the number of calls to step() per second
+    double getConsumerRate() const;
+
     /// Reset the simulation to its initial state
     void reset();
 
@@ -92,8 +114,8 @@ public:
     SofaPhysicsOutputMesh** getOutputMeshes();
 
     /// Return true if the simulation is running
-    /// Note that currently you must call the step() method
-    /// periodically to actually animate the scene
+    /// Note that unless startAsync() was called you must call the
+    /// step() method periodically to actually animate the scene
     bool isAnimated() const;
 
     /// Set the animated state to a given value (requires a
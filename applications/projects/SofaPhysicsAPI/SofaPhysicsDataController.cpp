@@ -56,6 +56,8 @@ using namespace sofa::core::objectmodel;
 
 
 SofaPhysicsDataController::Impl::Impl()
+    : deferred(false)
+    , hasPendingValue(false)
 {
 }
 
@@ -76,6 +78,34 @@ ID SofaPhysicsDataController::Impl::getID() ///< unique ID of this object
 
 void SofaPhysicsDataController::Impl::setValue(const char* v) ///< Set the value of the associated variable
 {
+    if (deferred)
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pendingValue = v;
+        hasPendingValue = true;
+        return;
+    }
     if (sObj)
         sObj->setValue(v);
 }
+
+void SofaPhysicsDataController::Impl::setDeferred(bool d)
+{
+    if (!d)
+        applyPendingValue();
+    deferred = d;
+}
+
+void SofaPhysicsDataController::Impl::applyPendingValue()
+{
+    std::string v;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        if (!hasPendingValue)
+            return;
+        v.swap(pendingValue);
+        hasPendingValue = false;
+    }
+    if (sObj)
+        sObj->setValue(v.c_str());
+}
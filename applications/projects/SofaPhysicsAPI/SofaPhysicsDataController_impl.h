@@ -25,6 +25,9 @@
 #include "SofaPhysicsAPI.h"
 #include <SofaValidation/DataController.h>
 
+#include <mutex>
+#include <string>
+
 class SofaPhysicsDataController::Impl
 {
 public:
@@ -42,9 +45,20 @@ public:
 protected:
     SofaDataController::SPtr sObj;
 
+    /// When true, setValue() only records the value until applyPendingValue() is called
+    bool deferred;
+    bool hasPendingValue;
+    std::string pendingValue;
+    std::mutex pendingMutex;
+
 public:
     SofaDataController* getObject() { return sObj.get(); }
     void setObject(SofaDataController* dc) { sObj = dc; }
+
+    /// Record the values set by the host thread instead of applying them
+    void setDeferred(bool d);
+    /// Apply the last recorded value, if any (simulation thread)
+    void applyPendingValue();
 };
 
 #endif // SOFAPHYSICSDATAMONITOR_IMPL_H
@@ -56,6 +56,7 @@ using namespace sofa::core::objectmodel;
 
 
 SofaPhysicsDataMonitor::Impl::Impl()
+    : buffered(false)
 {
 }
 
@@ -77,5 +78,18 @@ ID SofaPhysicsDataMonitor::Impl::getID() ///< unique ID of this object
 const char* SofaPhysicsDataMonitor::Impl::getValue() ///< Get the value of the associated variable
 {
     if (!sObj) return 0;
+    if (buffered) return values.getFront().c_str();
     return sObj->getValue();
 }
+
+void SofaPhysicsDataMonitor::Impl::publishValue()
+{
+    if (!sObj) return;
+    values.getBack() = sObj->getValue();
+    values.publish();
+}
+
+bool SofaPhysicsDataMonitor::Impl::acquireValue()
+{
+    return values.acquire();
+}
@@ -23,8 +23,11 @@
 #define SOFAPHYSICSDATAMONITOR_IMPL_H
 
 #include "SofaPhysicsAPI.h"
+#include "SofaPhysicsTripleBuffer.h"
 #include <SofaValidation/DataMonitor.h>
 
+#include <string>
+
 class SofaPhysicsDataMonitor::Impl
 {
 public:
@@ -42,9 +45,20 @@ public:
 protected:
     SofaDataMonitor::SPtr sObj;
 
+    /// When true, getValue() reads the last acquired value instead of the object
+    bool buffered;
+    SofaPhysicsTripleBuffer<std::string> values;
+
 public:
     SofaDataMonitor* getObject() { return sObj.get(); }
     void setObject(SofaDataMonitor* dm) { sObj = dm; }
+
+    /// Read the values published by publishValue() instead of the object
+    void setBuffered(bool b) { buffered = b; }
+    /// Copy the current value of the variable (simulation thread)
+    void publishValue();
+    /// Use the last published value, if any (host thread)
+    bool acquireValue();
 };
 
 #endif // SOFAPHYSICSDATAMONITOR_IMPL_H
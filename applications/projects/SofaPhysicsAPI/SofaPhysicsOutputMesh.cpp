@@ -142,8 +142,18 @@ using namespace sofa::defaulttype;
 using namespace sofa::core::objectmodel;
 
 
+SofaPhysicsOutputMesh::Impl::Frame::Frame()
+    : verticesRevision(-1)
+    , normalsRevision(-1)
+    , texCoordRevision(-1)
+    , trianglesRevision(-1)
+    , quadsRevision(-1)
+{
+}
+
 SofaPhysicsOutputMesh::Impl::Impl()
 	: sObj(NULL)
+    , buffered(false)
 {
 }
 
@@ -153,7 +163,7 @@ SofaPhysicsOutputMesh::Impl::~Impl()
 
 void SofaPhysicsOutputMesh::Impl::setObject(SofaOutputMesh* o)
 {
-	if (!sObj)
+	if (!o)
 		return;
 
     sObj = o;
@@ -171,6 +181,50 @@ void SofaPhysicsOutputMesh::Impl::setObject(SofaOutputMesh* o)
     }
 }
 
+Data<ResizableExtVector<SofaPhysicsOutputMesh::Impl::Coord> >* SofaPhysicsOutputMesh::Impl::getPositionsData()
+{
+    return (!sObj->m_vertPosIdx.getValue().empty()) ?
+        &(sObj->m_vertices2) : &(sObj->m_positions);
+}
+
+/// Copy the values of a Data to a frame buffer, if they changed since the buffer was last filled
+template<class T, class V>
+static void copyIfChanged(const Data<V>& data, std::vector<T>& values, int& revision)
+{
+    const V& v = data.getValue(); // make sure the data is updated
+    if (revision == data.getCounter())
+        return;
+    revision = data.getCounter();
+    const T* begin = (const T*) v.getData();
+    values.assign(begin, begin + v.size() * (sizeof(typename V::value_type) / sizeof(T)));
+}
+
+void SofaPhysicsOutputMesh::Impl::publishFrame()
+{
+    if (!sObj) return;
+    Frame& frame = frames.getBack();
+    copyIfChanged(*getPositionsData(), frame.positions, frame.verticesRevision);
+    copyIfChanged(sObj->m_vnormals, frame.normals, frame.normalsRevision);
+    copyIfChanged(sObj->m_vtexcoords, frame.texCoords, frame.texCoordRevision);
+    copyIfChanged(sObj->m_triangles, frame.triangles, frame.trianglesRevision);
+    copyIfChanged(sObj->m_quads, frame.quads, frame.quadsRevision);
+
+    frame.attributes.resize(sVA.size());
+    frame.attributesRevision.resize(sVA.size(), -1);
+    for (unsigned int i = 0; i < sVA.size(); ++i)
+    {
+        Data<ResizableExtVector<Real> >* data = dynamic_cast< Data<ResizableExtVector<Real> >* >(sVA[i]->getSEValue());
+        if (data)
+            copyIfChanged(*data, frame.attributes[i], frame.attributesRevision[i]);
+    }
+    frames.publish();
+}
+
+bool SofaPhysicsOutputMesh::Impl::acquireFrame()
+{
+    return frames.acquire();
+}
+
 const char* SofaPhysicsOutputMesh::Impl::getName() ///< (non-unique) name of this object
 {
     if (!sObj) return "";
@@ -185,33 +239,34 @@ ID SofaPhysicsOutputMesh::Impl::getID() ///< unique ID of this object
 unsigned int SofaPhysicsOutputMesh::Impl::getNbVertices() ///< number of vertices
 {
     if (!sObj) return 0;
+    if (buffered) return (unsigned int) (frames.getFront().positions.size() / 3);
     // we cannot use getVertices() method directly as we need the Data revision
-    Data<ResizableExtVector<Coord> > * data =
-        (!sObj->m_vertPosIdx.getValue().empty()) ?
-        &(sObj->m_vertices2) : &(sObj->m_positions);
+    Data<ResizableExtVector<Coord> > * data = getPositionsData();
     return (unsigned int) data->getValue().size();
 }
 const Real* SofaPhysicsOutputMesh::Impl::getVPositions()  ///< vertices positions (Vec3)
 {
-    Data<ResizableExtVector<Coord> > * data =
-        (!sObj->m_vertPosIdx.getValue().empty()) ?
-        &(sObj->m_vertices2) : &(sObj->m_positions);
+    if (buffered) return frames.getFront().positions.data();
+    Data<ResizableExtVector<Coord> > * data = getPositionsData();
     return (const Real*) data->getValue().getData();
 }
 const Real* SofaPhysicsOutputMesh::Impl::getVNormals()    ///< vertices normals   (Vec3)
 {
+    if (buffered) return frames.getFront().normals.data();
     Data<ResizableExtVector<Deriv> > * data = &(sObj->m_vnormals);
     return (const Real*) data->getValue().getData();
 }
 
 const Real* SofaPhysicsOutputMesh::Impl::getVTexCoords()  ///< vertices UVs       (Vec2)
 {
+    if (buffered) return frames.getFront().texCoords.data();
     Data<ResizableExtVector<TexCoord> > * data = &(sObj->m_vtexcoords);
     return (const Real*) data->getValue().getData();
 }
 
 int SofaPhysicsOutputMesh::Impl::getTexCoordRevision()    ///< changes each time tex coord data are updated
 {
+    if (buffered) return frames.getFront().texCoordRevision;
     Data<ResizableExtVector<TexCoord> > * data = &(sObj->m_vtexcoords);
     data->getValue(); // make sure the data is updated
     return data->getCounter();
@@ -219,9 +274,8 @@ int SofaPhysicsOutputMesh::Impl::getTexCoordRevision()    ///< changes each time
 
 int SofaPhysicsOutputMesh::Impl::getVerticesRevision()    ///< changes each time vertices data are updated
 {
-    Data<ResizableExtVector<Coord> > * data =
-        (!sObj->m_vertPosIdx.getValue().empty()) ?
-        &(sObj->m_vertices2) : &(sObj->m_positions);
+    if (buffered) return frames.getFront().verticesRevision;
+    Data<ResizableExtVector<Coord> > * data = getPositionsData();
     data->getValue(); // make sure the data is updated
     return data->getCounter();
 }
@@ -236,6 +290,8 @@ unsigned int SofaPhysicsOutputMesh::Impl::getNbAttributes(int index)
 {
   if ((unsigned)index >= sVA.size())
     return 0;
+  else if (buffered)
+    return (unsigned)index < frames.getFront().attributes.size() ? frames.getFront().attributes[index].size() : 0;
   else 
     return dynamic_cast< Data<ResizableExtVector<Real> >* >(sVA[index]->getSEValue())->getValue().size();
 }
@@ -266,6 +322,8 @@ const Real*  SofaPhysicsOutputMesh::Impl::getVAttributeValue(int index)
 {
     if ((unsigned)index >= sVA.size())
         return NULL;
+    else if (buffered)
+        return (unsigned)index < frames.getFront().attributes.size() ? frames.getFront().attributes[index].data() : NULL;
     else
         return (const Real*)((ResizableExtVector<Real>*)sVA[index]->getSEValue()->getValueVoidPtr())->getData();
 }
@@ -274,6 +332,8 @@ int          SofaPhysicsOutputMesh::Impl::getVAttributeRevision(int index)
 {
     if ((unsigned)index >= sVA.size())
         return 0;
+    else if (buffered)
+        return (unsigned)index < frames.getFront().attributesRevision.size() ? frames.getFront().attributesRevision[index] : 0;
     else
     {
         sVA[index]->getSEValue()->getValueVoidPtr(); // make sure the data is updated
@@ -297,16 +357,19 @@ int SofaPhysicsOutputMesh::Impl::getLinesRevision()    ///< changes each time li
 
 unsigned int SofaPhysicsOutputMesh::Impl::getNbTriangles() ///< number of triangles
 {
+    if (buffered) return (unsigned int) (frames.getFront().triangles.size() / 3);
     Data<ResizableExtVector<Triangle> > * data = &(sObj->m_triangles);
     return (unsigned int) data->getValue().size();
 }
 const Index* SofaPhysicsOutputMesh::Impl::getTriangles()   ///< triangles topology (3 indices / triangle)
 {
+    if (buffered) return frames.getFront().triangles.data();
     Data<ResizableExtVector<Triangle> > * data = &(sObj->m_triangles);
     return (const Index*) data->getValue().getData();
 }
 int SofaPhysicsOutputMesh::Impl::getTrianglesRevision()    ///< changes each time triangles data is updated
 {
+    if (buffered) return frames.getFront().trianglesRevision;
     Data<ResizableExtVector<Triangle> > * data = &(sObj->m_triangles);
     data->getValue(); // make sure the data is updated
     return data->getCounter();
@@ -314,16 +377,19 @@ int SofaPhysicsOutputMesh::Impl::getTrianglesRevision()    ///< changes each tim
 
 unsigned int SofaPhysicsOutputMesh::Impl::getNbQuads() ///< number of quads
 {
+    if (buffered) return (unsigned int) (frames.getFront().quads.size() / 4);
     Data<ResizableExtVector<Quad> > * data = &(sObj->m_quads);
     return (unsigned int) data->getValue().size();
 }
 const Index* SofaPhysicsOutputMesh::Impl::getQuads()   ///< quads topology (4 indices / quad)
 {
+    if (buffered) return frames.getFront().quads.data();
     Data<ResizableExtVector<Quad> > * data = &(sObj->m_quads);
     return (const Index*) data->getValue().getData();
 }
 int SofaPhysicsOutputMesh::Impl::getQuadsRevision()    ///< changes each time quads data is updated
 {
+    if (buffered) return frames.getFront().quadsRevision;
     Data<ResizableExtVector<Quad> > * data = &(sObj->m_quads);
     data->getValue(); // make sure the data is updated
     return data->getCounter();
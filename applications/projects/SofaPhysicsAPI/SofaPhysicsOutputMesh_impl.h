@@ -23,11 +23,14 @@
 #define SOFAPHYSICSOUTPUTMESH_IMPL_H
 
 #include "SofaPhysicsAPI.h"
+#include "SofaPhysicsTripleBuffer.h"
 
 #include <SofaBaseVisual/VisualModelImpl.h>
 #include <sofa/core/visual/VisualModel.h>
 #include <sofa/core/visual/Shader.h>
 
+#include <vector>
+
 class SOFA_SOFAPHYSICSAPI_API SofaPhysicsOutputMesh::Impl
 {
 public:
@@ -76,13 +79,47 @@ public:
     typedef SofaOutputMesh::Quad Quad;
     typedef sofa::core::visual::ShaderElement SofaVAttribute;
 
+    /// Copy of the mesh data, as published by the simulation thread in asynchronous mode
+    struct Frame
+    {
+        std::vector<Real> positions;
+        std::vector<Real> normals;
+        std::vector<Real> texCoords;
+        std::vector<Index> triangles;
+        std::vector<Index> quads;
+        std::vector< std::vector<Real> > attributes;
+        int verticesRevision;
+        int normalsRevision;
+        int texCoordRevision;
+        int trianglesRevision;
+        int quadsRevision;
+        std::vector<int> attributesRevision;
+
+        Frame();
+    };
+
 protected:
     SofaOutputMesh::SPtr sObj;
     sofa::helper::vector<SofaVAttribute::SPtr> sVA;
 
+    /// When true, the accessors read the last acquired frame instead of the object
+    bool buffered;
+    SofaPhysicsTripleBuffer<Frame> frames;
+
+    sofa::core::objectmodel::Data<sofa::defaulttype::ResizableExtVector<Coord> >* getPositionsData();
+
 public:
     SofaOutputMesh* getObject() { return sObj.get(); }
     void setObject(SofaOutputMesh* o);
+
+    /// Read the frames published by publishFrame() instead of the object
+    void setBuffered(bool b) { buffered = b; }
+    bool isBuffered() const { return buffered; }
+    /// Copy the current state of the object to a new frame (simulation thread)
+    void publishFrame();
+    /// Use the last published frame, if any (host thread)
+    /// @return true if a new frame was acquired
+    bool acquireFrame();
 };
 
 #endif // SOFAPHYSICSOUTPUTMESH_IMPL_H
@@ -45,6 +45,7 @@
 
 #include <math.h>
 #include <iostream>
+#include <chrono>
 
 #include "../plugins/SceneCreator/SceneCreator.h"
 
@@ -93,6 +94,31 @@ void SofaPhysicsAPI::step()
     impl->step();
 }
 
+bool SofaPhysicsAPI::startAsync(double maxStepsPerSecond)
+{
+    return impl->startAsync(maxStepsPerSecond);
+}
+
+void SofaPhysicsAPI::stopAsync()
+{
+    impl->stopAsync();
+}
+
+bool SofaPhysicsAPI::isAsync() const
+{
+    return impl->isAsync();
+}
+
+double SofaPhysicsAPI::getSimulationRate() const
+{
+    return impl->getSimulationRate();
+}
+
+double SofaPhysicsAPI::getConsumerRate() const
+{
+    return impl->getConsumerRate();
+}
+
 void SofaPhysicsAPI::reset()
 {
     impl->reset();
@@ -206,6 +232,8 @@ static sofa::core::ObjectFactory::ClassEntry::SPtr classVisualModel;
 SofaPhysicsSimulation::SofaPhysicsSimulation(bool useGUI_, int GUIFramerate_)
     : useGUI(useGUI_)
     , GUIFramerate(GUIFramerate_)
+    , asyncRunning(false)
+    , asyncMaxStepsPerSecond(0.0)
 {
     sofa::helper::init();
     static bool first = true;
@@ -259,6 +287,8 @@ SofaPhysicsSimulation::SofaPhysicsSimulation(bool useGUI_, int GUIFramerate_)
 
 SofaPhysicsSimulation::~SofaPhysicsSimulation()
 {
+    stopAsync();
+
     for (std::map<SofaOutputMesh*, SofaPhysicsOutputMesh*>::const_iterator it = outputMeshMap.begin(), itend = outputMeshMap.end(); it != itend; ++it)
     {
         if (it->second) delete it->second;
@@ -286,6 +316,7 @@ bool SofaPhysicsSimulation::load(const char* cfilename)
 {
     std::string filename = cfilename;
     std::cout << "FROM APP: SofaPhysicsSimulation::load(" << filename << ")" << std::endl;
+    stopAsync();
     sofa::helper::BackTrace::autodump();
 
     //bool wasAnimated = isAnimated();
@@ -319,6 +350,7 @@ bool SofaPhysicsSimulation::load(const char* cfilename)
 
 void SofaPhysicsSimulation::createScene()
 {
+    stopAsync();
     m_RootNode = sofa::modeling::createRootWithCollisionPipeline();
     if (m_RootNode.get())
     {
@@ -343,6 +375,7 @@ void SofaPhysicsSimulation::createScene_impl()
 void SofaPhysicsSimulation::sendValue(const char* name, double value)
 {
     // send a GUIEvent to the tree
+    std::lock_guard<std::mutex> lock(sceneMutex);
     if (m_RootNode!=0)
     {
         std::ostringstream oss;
@@ -378,6 +411,7 @@ void SofaPhysicsSimulation::setTimeStep(double dt)
 {
     if (getScene())
     {
+        std::lock_guard<std::mutex> lock(sceneMutex);
         getScene()->getContext()->setDt(dt);
     }
 }
@@ -413,6 +447,7 @@ double *SofaPhysicsSimulation::getGravity() const
 void SofaPhysicsSimulation::setGravity(double* gravity)
 {
     Vec3d g = Vec3d(gravity[0], gravity[1], gravity[2]);
+    std::lock_guard<std::mutex> lock(sceneMutex);
     getScene()->getContext()->setGravity(g);
 }
 
@@ -420,6 +455,7 @@ void SofaPhysicsSimulation::setGravity(double* gravity)
 void SofaPhysicsSimulation::start()
 {
     std::cout << "FROM APP: start()" << std::endl;
+    std::lock_guard<std::mutex> lock(sceneMutex);
     if (isAnimated()) return;
     if (getScene())
     {
@@ -431,6 +467,7 @@ void SofaPhysicsSimulation::start()
 void SofaPhysicsSimulation::stop()
 {
     std::cout << "FROM APP: stop()" << std::endl;
+    std::lock_guard<std::mutex> lock(sceneMutex);
     if (!isAnimated()) return;
     if (getScene())
     {
@@ -443,6 +480,7 @@ void SofaPhysicsSimulation::stop()
 void SofaPhysicsSimulation::reset()
 {
     std::cout << "FROM APP: reset()" << std::endl;
+    std::lock_guard<std::mutex> lock(sceneMutex);
     if (getScene())
     {
         getSimulation()->reset(getScene());
@@ -470,8 +508,15 @@ void SofaPhysicsSimulation::update()
 
 void SofaPhysicsSimulation::step()
 {
+    if (isAsync())
+    {
+        acquireFrame();
+        return;
+    }
     sofa::simulation::Node* groot = getScene();
     if (!groot) return;
+    consumerRate.tick();
+    simulationRate.tick();
     beginStep();
     getSimulation()->animate(groot);
     getSimulation()->updateVisual(groot);
@@ -491,6 +536,149 @@ void SofaPhysicsSimulation::step()
     endStep();
 }
 
+bool SofaPhysicsSimulation::startAsync(double maxStepsPerSecond)
+{
+    if (useGUI)
+    {
+        std::cerr << "ERROR in SofaPhysicsSimulation::startAsync(): not available with the GUI" << std::endl;
+        return false;
+    }
+    if (!getScene())
+        return false;
+    stopAsync();
+
+    initDataMonitors();
+    initDataControllers();
+    for (unsigned int i=0; i<outputMeshes.size(); ++i)
+        outputMeshes[i]->impl->setBuffered(true);
+    for (unsigned int i=0; i<dataMonitors.size(); ++i)
+        dataMonitors[i]->impl->setBuffered(true);
+    for (unsigned int i=0; i<dataControllers.size(); ++i)
+        dataControllers[i]->impl->setDeferred(true);
+
+    // the host reads the current state until the first computed step
+    publishFrame();
+    acquireFrame();
+
+    asyncMaxStepsPerSecond = maxStepsPerSecond;
+    simulationRate.reset();
+    consumerRate.reset();
+    asyncRunning = true;
+    asyncThread = std::thread(&SofaPhysicsSimulation::asyncLoop, this);
+    return true;
+}
+
+void SofaPhysicsSimulation::stopAsync()
+{
+    if (!asyncThread.joinable())
+        return;
+    asyncRunning = false;
+    asyncThread.join();
+
+    for (unsigned int i=0; i<outputMeshes.size(); ++i)
+        outputMeshes[i]->impl->setBuffered(false);
+    for (unsigned int i=0; i<dataMonitors.size(); ++i)
+        dataMonitors[i]->impl->setBuffered(false);
+    for (unsigned int i=0; i<dataControllers.size(); ++i)
+        dataControllers[i]->impl->setDeferred(false);
+}
+
+bool SofaPhysicsSimulation::isAsync() const
+{
+    return asyncThread.joinable();
+}
+
+double SofaPhysicsSimulation::getSimulationRate() const
+{
+    return simulationRate.getRate();
+}
+
+double SofaPhysicsSimulation::getConsumerRate() const
+{
+    return consumerRate.getRate();
+}
+
+void SofaPhysicsSimulation::asyncLoop()
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point nextStep = Clock::now();
+    sofa::simulation::Node* groot = getScene();
+    while (asyncRunning)
+    {
+        {
+            std::unique_lock<std::mutex> lock(sceneMutex);
+            if (!isAnimated())
+            {
+                lock.unlock();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                nextStep = Clock::now();
+                continue;
+            }
+            for (unsigned int i=0; i<dataControllers.size(); ++i)
+                dataControllers[i]->impl->applyPendingValue();
+            beginStep();
+            getSimulation()->animate(groot);
+            getSimulation()->updateVisual(groot);
+            update();
+            updateCurrentFPS();
+            publishFrame();
+        }
+        simulationRate.tick();
+
+        if (asyncMaxStepsPerSecond > 0)
+        {
+            nextStep += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / asyncMaxStepsPerSecond));
+            const Clock::time_point now = Clock::now();
+            if (nextStep < now)
+                nextStep = now; // do not try to catch up with late steps
+            else
+                std::this_thread::sleep_until(nextStep);
+        }
+    }
+}
+
+void SofaPhysicsSimulation::publishFrame()
+{
+    for (unsigned int i=0; i<outputMeshes.size(); ++i)
+        outputMeshes[i]->impl->publishFrame();
+    for (unsigned int i=0; i<dataMonitors.size(); ++i)
+        dataMonitors[i]->impl->publishValue();
+}
+
+void SofaPhysicsSimulation::acquireFrame()
+{
+    consumerRate.tick();
+    for (unsigned int i=0; i<outputMeshes.size(); ++i)
+        outputMeshes[i]->impl->acquireFrame();
+    for (unsigned int i=0; i<dataMonitors.size(); ++i)
+        dataMonitors[i]->impl->acquireValue();
+}
+
+void SofaPhysicsSimulation::RateCounter::reset()
+{
+    start = 0;
+    count = 0;
+    rate = 0.0;
+}
+
+void SofaPhysicsSimulation::RateCounter::tick()
+{
+    const sofa::helper::system::thread::ctime_t ticksPerSec = sofa::helper::system::thread::CTime::getRefTicksPerSec();
+    const sofa::helper::system::thread::ctime_t curtime = sofa::helper::system::thread::CTime::getRefTime();
+    if (count == 0 && start == 0)
+    {
+        start = curtime;
+        return;
+    }
+    ++count;
+    if (curtime - start >= ticksPerSec / 2)
+    {
+        rate = ((double)ticksPerSec * count) / (curtime - start);
+        start = curtime;
+        count = 0;
+    }
+}
+
 void SofaPhysicsSimulation::beginStep()
 {
 }
@@ -581,14 +769,15 @@ unsigned int SofaPhysicsSimulation::getNbDataMonitors()
     return dataMonitors.size();
 }
 
-SofaPhysicsDataMonitor** SofaPhysicsSimulation::getDataMonitors()
+void SofaPhysicsSimulation::initDataMonitors()
 {
-    if (dataMonitors.empty())
+    // the list is used by the simulation thread in asynchronous mode
+    if (dataMonitors.empty() && !isAsync())
     {
         sofa::simulation::Node* groot = getScene();
         if (!groot)
         {
-            return NULL;
+            return;
         }
         groot->get<SofaDataMonitor>(&sofaDataMonitors, sofa::core::objectmodel::BaseContext::SearchDown);
         dataMonitors.resize(sofaDataMonitors.size());
@@ -600,6 +789,13 @@ SofaPhysicsDataMonitor** SofaPhysicsSimulation::getDataMonitors()
             dataMonitors[i] = oData;
         }
     }
+}
+
+SofaPhysicsDataMonitor** SofaPhysicsSimulation::getDataMonitors()
+{
+    initDataMonitors();
+    if (dataMonitors.empty())
+        return NULL;
     return &(dataMonitors[0]);
 }
 
@@ -608,14 +804,15 @@ unsigned int SofaPhysicsSimulation::getNbDataControllers()
     return dataControllers.size();
 }
 
-SofaPhysicsDataController** SofaPhysicsSimulation::getDataControllers()
+void SofaPhysicsSimulation::initDataControllers()
 {
-    if (dataControllers.empty())
+    // the list is used by the simulation thread in asynchronous mode
+    if (dataControllers.empty() && !isAsync())
     {
         sofa::simulation::Node* groot = getScene();
         if (!groot)
         {
-            return NULL;
+            return;
         }
         groot->get<SofaDataController>(&sofaDataControllers, sofa::core::objectmodel::BaseContext::SearchDown);
         dataControllers.resize(sofaDataControllers.size());
@@ -627,6 +824,13 @@ SofaPhysicsDataController** SofaPhysicsSimulation::getDataControllers()
             dataControllers[i] = oData;
         }
     }
+}
+
+SofaPhysicsDataController** SofaPhysicsSimulation::getDataControllers()
+{
+    initDataControllers();
+    if (dataControllers.empty())
+        return NULL;
     return &(dataControllers[0]);
 }
 
@@ -715,6 +919,7 @@ void SofaPhysicsSimulation::drawGL()
 
     if (m_RootNode.get())
     {
+        std::lock_guard<std::mutex> lock(sceneMutex);
         sofa::simulation::Node* groot = m_RootNode.get();
         if (!initTexturesDone)
         {
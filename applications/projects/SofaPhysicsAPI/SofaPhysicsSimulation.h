@@ -34,6 +34,9 @@
 #include <sofa/helper/gl/Texture.h>
 
 #include <map>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 
 class SOFA_SOFAPHYSICSAPI_API SofaPhysicsSimulation
@@ -50,6 +53,12 @@ public:
     void start();
     void stop();
     void step();
+
+    bool startAsync(double maxStepsPerSecond);
+    void stopAsync();
+    bool isAsync() const;
+    double getSimulationRate() const;
+    double getConsumerRate() const;
     void reset();
     void resetView();
     void sendValue(const char* name, double value);
@@ -116,12 +125,41 @@ protected:
     int frameCounter;
     double currentFPS;
 
+    /// Number of events per second, measured over periods of half a second
+    /// (the rate can be read from another thread)
+    class RateCounter
+    {
+    public:
+        RateCounter() : start(0), count(0), rate(0.0) {}
+        void reset();
+        void tick();
+        double getRate() const { return rate; }
+    protected:
+        sofa::helper::system::thread::ctime_t start;
+        int count;
+        std::atomic<double> rate;
+    };
+
+    /// Thread computing the steps in asynchronous mode
+    std::thread asyncThread;
+    std::atomic<bool> asyncRunning;
+    double asyncMaxStepsPerSecond;
+    /// Held while the scene is modified, by the simulation thread in asynchronous mode
+    std::mutex sceneMutex;
+    RateCounter simulationRate;
+    RateCounter consumerRate;
+
     void update();
     void updateOutputMeshes();
     void updateCurrentFPS();
     void beginStep();
     void endStep();
     void calcProjection();
+    void initDataMonitors();
+    void initDataControllers();
+    void asyncLoop();
+    void publishFrame();
+    void acquireFrame();
 
     virtual void createScene_impl();
 
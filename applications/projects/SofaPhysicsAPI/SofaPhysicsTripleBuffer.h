@@ -0,0 +1,76 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program. If not, see <http://www.gnu.org/licenses/>.              *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFAPHYSICSTRIPLEBUFFER_H
+#define SOFAPHYSICSTRIPLEBUFFER_H
+
+#include <atomic>
+
+/// Hand over successive values of T from one producer thread to one consumer thread.
+///
+/// The producer fills the back buffer and publishes it, the consumer acquires the
+/// last published value in the front buffer. The third buffer holds the value in
+/// transit, so that neither side ever waits for the other: values published while
+/// the consumer does not acquire are simply overwritten by the following ones.
+/// As the buffers are reused, each one keeps the content it had two publications ago,
+/// which allows the producer to only update what changed.
+template<class T>
+class SofaPhysicsTripleBuffer
+{
+public:
+    SofaPhysicsTripleBuffer()
+        : middle(1), back(0), front(2)
+    {
+    }
+
+    /// Buffer to fill before publish() (producer thread only)
+    T& getBack() { return buffers[back]; }
+
+    /// Make the back buffer available to the consumer (producer thread only)
+    void publish()
+    {
+        back = middle.exchange(back | NEW_VALUE) & INDEX_MASK;
+    }
+
+    /// Make the last published value the front buffer, if there is one
+    /// not yet acquired (consumer thread only)
+    /// @return true if the front buffer changed
+    bool acquire()
+    {
+        if (!(middle.load() & NEW_VALUE))
+            return false;
+        front = middle.exchange(front) & INDEX_MASK;
+        return true;
+    }
+
+    /// Last acquired value (consumer thread only)
+    const T& getFront() const { return buffers[front]; }
+
+protected:
+    enum { INDEX_MASK = 3, NEW_VALUE = 4 };
+
+    T buffers[3];
+    std::atomic<int> middle; ///< index of the buffer in transit, and whether it holds a new value
+    int back;
+    int front;
+};
+
+#endif // SOFAPHYSICSTRIPLEBUFFER_H
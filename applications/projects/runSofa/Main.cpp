@@ -113,6 +113,32 @@ using sofa::helper::logging::ClangMessageHandler ;
 #include <sofa/helper/logging/ExceptionMessageHandler.h>
 using sofa::helper::logging::ExceptionMessageHandler;
 
+#include <sofa/helper/logging/AsyncMessageHandler.h>
+using sofa::helper::logging::AsyncMessageHandler;
+
+#include <sofa/helper/logging/RateLimitingMessageHandler.h>
+using sofa::helper::logging::RateLimitingMessageHandler;
+using sofa::helper::logging::MessageHandler;
+
+/// Stops the thread of the asynchronous message handler, after all its pending messages
+/// are printed, then prints the count of suppressed messages, whenever main returns.
+struct AsyncMessageHandlerShutdown
+{
+    RateLimitingMessageHandler* rateHandler = nullptr ;
+    AsyncMessageHandler* asyncHandler = nullptr ;
+
+    ~AsyncMessageHandlerShutdown()
+    {
+        if (asyncHandler)
+        {
+            MessageDispatcher::rmHandler(asyncHandler) ;
+            delete asyncHandler ;
+        }
+        if (rateHandler)
+            rateHandler->flush() ;
+    }
+} ;
+
 #define STRINGIFY(x) #x
 #define TOSTRING(x) STRINGIFY(x)
 
@@ -219,6 +245,8 @@ int main(int argc, char** argv)
     string colorsStatus = "unset";
     string messageHandler = "auto";
     bool enableInteraction = false ;
+    unsigned int messageRate = 0 ;
+    bool asyncMessages = false ;
     int width = 800;
     int height = 600;
 
@@ -253,6 +281,8 @@ int main(int argc, char** argv)
     argParser->addArgument(po::value<std::string>(&verif)->default_value(""), "verification,v",                     "load verification data for the scene");
     argParser->addArgument(po::value<std::string>(&colorsStatus)->default_value("unset", "auto")->implicit_value("yes"),     "colors,c", "use colors on stdout and stderr (yes, no, auto)");
     argParser->addArgument(po::value<std::string>(&messageHandler)->default_value("auto"), "formatting,f",          "select the message formatting to use (auto, clang, sofa, rich, test)");
+    argParser->addArgument(po::value<unsigned int>(&messageRate)->default_value(0),                                 "messageRate", "maximum number of messages per second printed from a same line of code (0 means no limit)");
+    argParser->addArgument(po::value<bool>(&asyncMessages)->default_value(false)->implicit_value(true),             "asyncMessages", "print the messages from a background thread");
     argParser->addArgument(po::value<bool>(&enableInteraction)->default_value(false)->implicit_value(true),         "interactive,i", "enable interactive mode for the GUI which includes idle and mouse events (EXPERIMENTAL)");
     argParser->addArgument(po::value<std::vector<std::string> >()->multitoken(), "argv",                            "forward extra args to the python interpreter");
 
@@ -313,32 +343,47 @@ int main(int argc, char** argv)
         sofa::helper::console::setStatus(sofa::helper::console::Status::Off);
 
     //TODO(dmarchal): Use smart pointer there to avoid memory leaks !!
+    MessageHandler* formattingHandler = nullptr ;
     if (messageHandler == "auto" )
     {
         MessageDispatcher::clearHandlers() ;
-        MessageDispatcher::addHandler( new ConsoleMessageHandler() ) ;
+        formattingHandler = new ConsoleMessageHandler() ;
     }
     else if (messageHandler == "clang")
     {
         MessageDispatcher::clearHandlers() ;
-        MessageDispatcher::addHandler( new ClangMessageHandler() ) ;
+        formattingHandler = new ClangMessageHandler() ;
     }
     else if (messageHandler == "sofa")
     {
         MessageDispatcher::clearHandlers() ;
-        MessageDispatcher::addHandler( new ConsoleMessageHandler() ) ;
+        formattingHandler = new ConsoleMessageHandler() ;
     }
     else if (messageHandler == "rich")
     {
         MessageDispatcher::clearHandlers() ;
-        MessageDispatcher::addHandler( new ConsoleMessageHandler(&RichConsoleStyleMessageFormatter::getInstance()) ) ;
+        formattingHandler = new ConsoleMessageHandler(&RichConsoleStyleMessageFormatter::getInstance()) ;
     }
     else if (messageHandler == "test"){
-        MessageDispatcher::addHandler( new ExceptionMessageHandler() ) ;
+        MessageDispatcher::clearHandlers() ;
+        formattingHandler = new ConsoleMessageHandler() ;
     }
     else{
         msg_warning("") << "Invalid argument '" << messageHandler << "' for '--formatting'";
     }
+
+    AsyncMessageHandlerShutdown asyncShutdown ;
+    if (formattingHandler)
+    {
+        if (messageRate > 0)
+            formattingHandler = asyncShutdown.rateHandler = new RateLimitingMessageHandler(formattingHandler, messageRate, 1.0) ;
+        if (asyncMessages)
+            formattingHandler = asyncShutdown.asyncHandler = new AsyncMessageHandler(formattingHandler) ;
+        MessageDispatcher::addHandler( formattingHandler ) ;
+    }
+    /// the messages are printed before the exception is thrown, in the emitting thread
+    if (messageHandler == "test")
+        MessageDispatcher::addHandler( new ExceptionMessageHandler() ) ;
     MessageDispatcher::addHandler(&MainPerComponentLoggingMessageHandler::getInstance()) ;
 
 
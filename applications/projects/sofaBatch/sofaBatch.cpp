@@ -21,7 +21,11 @@
 ******************************************************************************/
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <ctime>
+#include <thread>
+#include <atomic>
+#include <algorithm>
 
 #include <sofa/helper/ArgumentParser.h>
 #include <sofa/helper/system/PluginManager.h>
@@ -49,17 +53,38 @@ using std::cerr;
 using std::endl;
 using std::cout;
 
+using sofa::helper::ArgumentParser;
+namespace po = boost::program_options;
+
 // ---------------------------------------------------------------------
 // ---
 // ---------------------------------------------------------------------
 
+/// One simulation of the batch: a scene, its number of steps and its output name
+struct Task
+{
+    std::string input;
+    unsigned int nbsteps;
+    std::string output;
+
+    sofa::simulation::Node::SPtr groot;
+    std::string mstate;
+    std::ostringstream log;
+
+    Task(const std::string& input, unsigned int nbsteps, const std::string& output)
+        : input(input), nbsteps(nbsteps), output(output)
+    {
+    }
+};
 
-void apply(std::string &input, unsigned int nbsteps, std::string &output)
+/// Load and initialize the scene of a task.
+/// Loading uses shared resources (factories, file repositories, plugins), it is done sequentially.
+void prepare(Task& task)
 {
-    cout<<"\n****SIMULATION*  (.scn:"<< input<<", #steps:"<<nbsteps<<", .simu:"<<output<<")"<<endl;
+    cout<<"\n****SIMULATION*  (.scn:"<< task.input<<", #steps:"<<task.nbsteps<<", .simu:"<<task.output<<")"<<endl;
 
     // --- Create simulation graph ---
-    sofa::simulation::Node::SPtr groot = sofa::core::objectmodel::SPtr_dynamic_cast<sofa::simulation::Node>( sofa::simulation::getSimulation()->load(input.c_str()));
+    sofa::simulation::Node::SPtr groot = sofa::core::objectmodel::SPtr_dynamic_cast<sofa::simulation::Node>( sofa::simulation::getSimulation()->load(task.input.c_str()));
     if (groot==NULL)
     {
         groot = sofa::simulation::getSimulation()->createNewGraph("");
@@ -77,40 +102,59 @@ void apply(std::string &input, unsigned int nbsteps, std::string &output)
 
     // --- Init output file ---
     std::string outputdir =  sofa::helper::system::SetDirectory::GetParentDir(sofa::helper::system::DataRepository.getFirstPath().c_str()) + std::string("/applications/projects/sofaBatch/simulation/");
-    std::string mstate = outputdir + sofa::helper::system::SetDirectory::GetFileName(output.c_str());
+    task.mstate = outputdir + sofa::helper::system::SetDirectory::GetFileName(task.output.c_str());
 
     // --- Init Write state visitor ---
     sofa::component::misc::WriteStateCreator visitor(sofa::core::ExecParams::defaultInstance());
-    visitor.setSceneName(mstate);
+    visitor.setSceneName(task.mstate);
     visitor.execute(groot.get());
 
     sofa::component::misc::WriteStateActivator v_write(sofa::core::ExecParams::defaultInstance(), true);
     v_write.execute(groot.get());
 
+    task.groot = groot;
+}
+
+/// Compute the steps of a task.
+/// The scenes of the tasks are independent: several tasks can be run concurrently,
+/// each one on its own thread, with the ExecParams of this thread.
+void run(Task& task)
+{
+    if (!task.groot)
+        return;
+    sofa::simulation::Node* groot = task.groot.get();
 
     // --- Sofa GUI Batch animationLoop ---
-    sofa::simulation::getSimulation()->animate(groot.get());
+    sofa::simulation::getSimulation()->animate(groot);
 
-    std::cout << "Computing "<<nbsteps<<" iterations." << std::endl;
+    task.log << "Computing "<<task.nbsteps<<" iterations of "<<task.input<<"." << std::endl;
     sofa::simulation::Visitor::ctime_t rtfreq = sofa::helper::system::thread::CTime::getRefTicksPerSec();
     sofa::simulation::Visitor::ctime_t tfreq = sofa::helper::system::thread::CTime::getTicksPerSec();
     sofa::simulation::Visitor::ctime_t rt = sofa::helper::system::thread::CTime::getRefTime();
     sofa::simulation::Visitor::ctime_t t = sofa::helper::system::thread::CTime::getFastTime();
-    for (unsigned int i=0; i<nbsteps; i++)
-        sofa::simulation::getSimulation()->animate(groot.get());
+    for (unsigned int i=0; i<task.nbsteps; i++)
+        sofa::simulation::getSimulation()->animate(groot);
 
     t = sofa::helper::system::thread::CTime::getFastTime()-t;
     rt = sofa::helper::system::thread::CTime::getRefTime()-rt;
 
-    std::cout << nbsteps << " iterations done in "<< ((double)t)/((double)tfreq) << " s ( " << (((double)tfreq)*nbsteps)/((double)t) << " FPS)." << std::endl;
-    std::cout << nbsteps << " iterations done in "<< ((double)rt)/((double)rtfreq) << " s ( " << (((double)rtfreq)*nbsteps)/((double)rt) << " FPS)." << std::endl;
+    task.log << task.nbsteps << " iterations done in "<< ((double)t)/((double)tfreq) << " s ( " << (((double)tfreq)*task.nbsteps)/((double)t) << " FPS)." << std::endl;
+    task.log << task.nbsteps << " iterations done in "<< ((double)rt)/((double)rtfreq) << " s ( " << (((double)rtfreq)*task.nbsteps)/((double)rt) << " FPS)." << std::endl;
+}
+
+/// Save the simulation parameters of a task and unload its scene
+void finish(Task& task)
+{
+    if (!task.groot)
+        return;
+    cout << task.log.str();
 
     // --- Exporting output simulation ---
-    std::string simulationFileName = mstate + std::string(".simu") ;
+    std::string simulationFileName = task.mstate + std::string(".simu") ;
     std::ofstream out(simulationFileName.c_str());
     if (!out.fail())
     {
-        out << input.c_str() << " Init: 0.000 s End: " << nbsteps*groot.get()->getDt() << " s " << groot.get()->getDt() << " baseName: "<<mstate;
+        out << task.input.c_str() << " Init: 0.000 s End: " << task.nbsteps*task.groot->getDt() << " s " << task.groot->getDt() << " baseName: "<<task.mstate;
         out.close();
 
         std::cout << "Simulation parameters saved in "<<simulationFileName<<std::endl;
@@ -121,31 +165,64 @@ void apply(std::string &input, unsigned int nbsteps, std::string &output)
     }
 
 
-    sofa::simulation::getSimulation()->unload(groot);
+    sofa::simulation::getSimulation()->unload(task.groot);
+    task.groot.reset();
+}
+
+/// Run the tasks on nbThreads threads, each thread taking the next task not yet run
+void runAll(std::vector<Task*>& tasks, unsigned int nbThreads)
+{
+    if (nbThreads > tasks.size())
+        nbThreads = (unsigned int)tasks.size();
+    if (nbThreads <= 1)
+    {
+        for (std::size_t i=0; i<tasks.size(); ++i)
+            run(*tasks[i]);
+        return;
+    }
 
-    return;
+    std::atomic<std::size_t> nextTask(0);
+    std::vector<std::thread> threads;
+    for (unsigned int i=0; i<nbThreads; ++i)
+    {
+        threads.push_back(std::thread([&tasks, &nextTask]()
+        {
+            for (std::size_t t = nextTask++; t < tasks.size(); t = nextTask++)
+                run(*tasks[t]);
+        }));
+    }
+    for (unsigned int i=0; i<nbThreads; ++i)
+        threads[i].join();
 }
 
 
 int main(int argc, char** argv)
 {
-    sofa::simulation::tree::init();
-    sofa::component::initComponentBase();
-    sofa::component::initComponentCommon();
-    sofa::component::initComponentGeneral();
-    sofa::component::initComponentAdvanced();
-    sofa::component::initComponentMisc();
-
     // --- Parameter initialisation ---
+    bool showHelp = false;
     std::vector<std::string> files;
     std::string fileName ;
     std::vector<std::string> plugins;
-    std::vector<unsigned int> nbstepsations;
-
-    sofa::helper::parse(&files, "\nThis is a SOFA batch that permits to run and to save simulation states without GUI.\nGive a name file containing actions == list of (input .scn, #simulated time steps, output .simu). See file tasks for an example.\n\nHere are the command line arguments")
-    .option(&plugins,'l',"load","load given plugins")
-    (argc,argv);
-
+    unsigned int nbThreads = 1;
+    unsigned int batchSize = 0;
+
+    ArgumentParser* argParser = new ArgumentParser(argc, argv);
+    argParser->addArgument(po::value<bool>(&showHelp)->default_value(false)->implicit_value(true), "help,h", "Display this help message");
+    argParser->addArgument(po::value<std::vector<std::string>>(&plugins), "load,l", "load given plugins");
+    argParser->addArgument(po::value<unsigned int>(&nbThreads)->default_value(1), "threads,j", "number of simulations computed concurrently (0 for the number of cores)");
+    argParser->addArgument(po::value<unsigned int>(&batchSize)->default_value(0), "batch,n", "number of scenes loaded at the same time (0 for all the tasks)");
+    argParser->parse();
+    files = argParser->getInputFileList();
+
+    if (showHelp)
+    {
+        cout << "\nThis is a SOFA batch that permits to run and to save simulation states without GUI.\n"
+                "Give a name file containing actions == list of (input .scn, #simulated time steps, output .simu),\n"
+                "or directly one action as 3 arguments. See file tasks for an example.\n"
+                "The independent simulations can be computed concurrently (see --threads).\n\n";
+        argParser->showHelp();
+        return 0;
+    }
 
     // --- check input file
     if (!files.empty())
@@ -156,9 +233,12 @@ int main(int argc, char** argv)
         return 0;
     }
 
-    fileName = sofa::helper::system::DataRepository.getFile(fileName);
-    //sofa::helper::system::DataRepository.findFile(fileName);
-
+    sofa::simulation::tree::init();
+    sofa::component::initComponentBase();
+    sofa::component::initComponentCommon();
+    sofa::component::initComponentGeneral();
+    sofa::component::initComponentAdvanced();
+    sofa::component::initComponentMisc();
 
     // --- Init component ---
     sofa::simulation::setSimulation(new sofa::simulation::tree::TreeSimulation());
@@ -171,25 +251,55 @@ int main(int argc, char** argv)
     sofa::helper::system::PluginManager::getInstance().init();
 
 
+    // --- Read task list ---
+    std::vector<Task*> tasks;
+    if (files.size() >= 3)
+    {
+        std::string strfilename(files[0]);
+        sofa::helper::system::DataRepository.findFile(strfilename);
+        tasks.push_back(new Task(strfilename, atoi(files[1].c_str()), files[2]));
+    }
+    else
+    {
+        fileName = sofa::helper::system::DataRepository.getFile(fileName);
+        std::ifstream end(fileName.c_str());
+
+        std::string input;
+        unsigned int nbsteps;
+        std::string output;
+        while( end >> input && end >>nbsteps && end >> output  )
+        {
+            sofa::helper::system::DataRepository.findFile(input);
+            tasks.push_back(new Task(input, nbsteps, output));
+        }
+        end.close();
+    }
+
+    if (nbThreads == 0)
+        nbThreads = std::max(1u, std::thread::hardware_concurrency());
+    if (batchSize == 0)
+        batchSize = (unsigned int)tasks.size();
+    batchSize = std::max(batchSize, nbThreads);
+
+
     // --- Perform task list ---
-    //std::ifstream end(fileName.c_str());
+    // The scenes of a batch are loaded sequentially, then simulated concurrently:
+    // the plugins, factories and loaded resources are shared by all the tasks.
+    for (std::size_t first = 0; first < tasks.size(); first += batchSize)
+    {
+        std::vector<Task*> batch(tasks.begin() + first, tasks.begin() + std::min(tasks.size(), first + batchSize));
+        for (std::size_t i=0; i<batch.size(); ++i)
+            prepare(*batch[i]);
 
-    std::string input;
-//    int nbsteps;
-    std::string output;
+        runAll(batch, nbThreads);
+
+        for (std::size_t i=0; i<batch.size(); ++i)
+            finish(*batch[i]);
+    }
 
-//    while( end >> input && end >>nbsteps && end >> output  )
-//    {
-//        std::cout<<"input "<<input<<std::endl;
-//        sofa::helper::system::DataRepository.findFile(input);
-//        apply(input, nbsteps, output);
-//    }
-//    end.close();
-
-    std::string strfilename(argv[1]);
-    std::string stroutput(argv[3]);
-    sofa::helper::system::DataRepository.findFile(strfilename);
-    apply(strfilename, atoi(argv[2]), stroutput);
+    for (std::size_t i=0; i<tasks.size(); ++i)
+        delete tasks[i];
+    delete argParser;
 
     sofa::simulation::tree::cleanup();
     return 0;
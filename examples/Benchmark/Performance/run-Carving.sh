@@ -0,0 +1,10 @@
+#!/bin/bash
+# Measure the per-frame cost of carving, with a grid of tools removing many tetrahedra at each step.
+# The timer statistics are averaged over the steps: see the CarveElems step for the removals.
+# usage: run-Carving.sh [number of steps] [runSofa executable]
+n=${1:-100}
+runSofa=${2:-runSofa}
+dir=$(cd "$(dirname "$0")" && pwd)
+
+echo Carving - $n steps
+$runSofa -g batch -n $n --computationTimeSampling $n "$dir/Carving.scn"
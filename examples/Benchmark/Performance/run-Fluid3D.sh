@@ -0,0 +1,20 @@
+#!/bin/bash
+# Measure the per-frame cost of Fluid3D for several grid resolutions and numbers of threads
+# (SOFA built with SOFA_OPENMP). The scene is resized next to itself, keeping the same fluid height ratio.
+# usage: run-Fluid3D.sh [number of steps] [runSofa executable] [resolutions] [numbers of threads]
+n=${1:-50}
+runSofa=${2:-runSofa}
+sizes=${3:-"64 128 256"}
+threads=${4:-"1 2 4 8"}
+dir=$(cd "$(dirname "$0")" && pwd)
+
+for s in $sizes
+do
+    sed -e "s/nx=\"64\" ny=\"64\" nz=\"64\"/nx=\"$s\" ny=\"$s\" nz=\"$s\"/" \
+        -e "s/height=\"41\"/height=\"$((s*41/64))\"/" "$dir/Fluid3D.scn" > "$dir/Fluid3D-$s.scn"
+    for t in $threads
+    do
+        echo Fluid3D $s^3 - $n steps - $t threads
+        OMP_NUM_THREADS=$t $runSofa -g batch -n $n --computationTimeSampling $n "$dir/Fluid3D-$s.scn"
+    done
+done
@@ -0,0 +1,43 @@
+#!/bin/bash
+# Measure the loading time of large OBJ and legacy VTK (ascii and binary) meshes.
+# A n x n grid of triangles is generated next to the scenes (default n=1000, i.e. 2M triangles).
+# usage: run-MeshLoading.sh [n] [runSofa executable]
+n=${1:-1000}
+runSofa=${2:-runSofa}
+dir=$(cd "$(dirname "$0")" && pwd)
+
+python3 - "$n" "$dir" <<'PYTHON'
+import struct, sys
+n = int(sys.argv[1])
+d = sys.argv[2]
+points = [(i / float(n), j / float(n), 0.0) for j in range(n + 1) for i in range(n + 1)]
+triangles = []
+for j in range(n):
+    for i in range(n):
+        a = j * (n + 1) + i
+        triangles.append((a, a + 1, a + n + 2))
+        triangles.append((a, a + n + 2, a + n + 1))
+
+with open(d + "/MeshLoading-grid.obj", "w") as f:
+    f.writelines("v %.9g %.9g %.9g\n" % p for p in points)
+    f.writelines("f %d %d %d\n" % (t[0] + 1, t[1] + 1, t[2] + 1) for t in triangles)
+
+header = "# vtk DataFile Version 3.0\nMeshLoading grid\n%s\nDATASET POLYDATA\nPOINTS %d float\n"
+with open(d + "/MeshLoading-grid.vtk", "w") as f:
+    f.write(header % ("ASCII", len(points)))
+    f.writelines("%.9g %.9g %.9g\n" % p for p in points)
+    f.write("POLYGONS %d %d\n" % (len(triangles), 4 * len(triangles)))
+    f.writelines("3 %d %d %d\n" % t for t in triangles)
+
+with open(d + "/MeshLoading-grid-binary.vtk", "wb") as f:
+    f.write((header % ("BINARY", len(points))).encode())
+    f.write(b"".join(struct.pack(">3f", *p) for p in points))
+    f.write(("\nPOLYGONS %d %d\n" % (len(triangles), 4 * len(triangles))).encode())
+    f.write(b"".join(struct.pack(">4i", 3, *t) for t in triangles))
+PYTHON
+
+for scene in MeshLoading-obj MeshLoading-vtk MeshLoading-vtk-binary;
+do
+echo $scene - $n
+/usr/bin/time -f "%e s, %M kB" $runSofa -g batch -n 1 "$dir/$scene.scn" > /dev/null
+done
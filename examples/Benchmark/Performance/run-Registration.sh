@@ -0,0 +1,19 @@
+#!/bin/bash
+# Measure the per-frame cost of closest point registration for several point cloud resolutions and numbers of threads
+# (SOFA built with SOFA_OPENMP). Source and target grids are resized together.
+# usage: run-Registration.sh [number of steps] [runSofa executable] [resolutions] [numbers of threads]
+n=${1:-50}
+runSofa=${2:-runSofa}
+sizes=${3:-"16 32 64"}
+threads=${4:-"1 2 4 8"}
+dir=$(cd "$(dirname "$0")" && pwd)
+
+for s in $sizes
+do
+    sed -e "s/n=\"32 32 32\"/n=\"$s $s $s\"/g" "$dir/Registration.scn" > "$dir/Registration-$s.scn"
+    for t in $threads
+    do
+        echo Registration $s^3 - $n steps - $t threads
+        OMP_NUM_THREADS=$t $runSofa -g batch -n $n --computationTimeSampling $n "$dir/Registration-$s.scn"
+    done
+done
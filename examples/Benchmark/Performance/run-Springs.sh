@@ -0,0 +1,14 @@
+#!/bin/bash
+# Measure the scaling of the spring forces with the number of threads (SOFA built with SOFA_OPENMP),
+# on a cloth of about 360000 springs. See the ComputeForce and MBKSolve steps in the timer statistics.
+# usage: run-Springs.sh [number of steps] [runSofa executable] [numbers of threads]
+n=${1:-100}
+runSofa=${2:-runSofa}
+threads=${3:-"1 2 4 8"}
+dir=$(cd "$(dirname "$0")" && pwd)
+
+for t in $threads
+do
+    echo Springs - $n steps - $t threads
+    OMP_NUM_THREADS=$t $runSofa -g batch -n $n --computationTimeSampling $n "$dir/Springs.scn"
+done
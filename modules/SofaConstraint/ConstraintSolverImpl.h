@@ -29,6 +29,8 @@
 
 #include <SofaBaseLinearSolver/FullMatrix.h>
 
+#include <mutex>
+
 namespace sofa
 {
 
@@ -61,9 +63,14 @@ public:
 
     unsigned int getProblemId();
 
+    /// Mutex serializing the solves done outside of the simulation thread,
+    /// as several haptic devices may share the same problem.
+    std::mutex& getSolveMutex() { return solveMutex; }
+
 protected:
     int dimension;
     unsigned int problemId;
+    std::mutex solveMutex;
 };
 
 
@@ -556,6 +556,8 @@ void GenericConstraintProblem::clear(int nbC)
     freeConstraintResolutions();
     constraintsResolutions.resize(nbC);
     _d.resize(nbC);
+    _tempForces.resize(nbC);
+    _errF.resize(nbC);
 }
 
 void GenericConstraintProblem::freeConstraintResolutions()
@@ -632,8 +634,7 @@ void GenericConstraintProblem::gaussSeidel(double timeout, GenericConstraintSolv
     double error=0.0;
 
     bool convergence = false;
-    sofa::helper::vector<double> tempForces;
-    if(sor != 1.0) tempForces.resize(dimension);
+    double *tempForces = _tempForces.ptr();
 
     if(scaleTolerance && !allVerified)
         tol *= dimension;
@@ -696,7 +697,7 @@ void GenericConstraintProblem::gaussSeidel(double timeout, GenericConstraintSolv
             //2. for each line we compute the actual value of d
             //   (a)d is set to dfree
             
-            std::vector<double> errF(nb, 0);
+            double *errF = _errF.ptr() + j;
 
             for(l=0; l<nb; l++)
             {
@@ -880,8 +881,7 @@ void GenericConstraintProblem::unbuiltGaussSeidel(double timeout, GenericConstra
     double error=0.0;
 
     bool convergence = false;
-    sofa::helper::vector<double> tempForces;
-    if(sor != 1.0) tempForces.resize(dimension);
+    double *tempForces = _tempForces.ptr();
 
     if(scaleTolerance && !allVerified)
         tol *= dimension;
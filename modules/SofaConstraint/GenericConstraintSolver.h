@@ -51,6 +51,8 @@ class SOFA_CONSTRAINT_API GenericConstraintProblem : public ConstraintProblem
 {
 public:
     sofa::component::linearsolver::FullVector<double> _d;
+    /// workspace of gaussSeidel, allocated by clear() so that the solves in an haptic thread do not allocate
+    sofa::component::linearsolver::FullVector<double> _tempForces, _errF;
 	std::vector<core::behavior::ConstraintResolution*> constraintsResolutions;
 	bool scaleTolerance, allVerified, unbuilt;
 	double sor;
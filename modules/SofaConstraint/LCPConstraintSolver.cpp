@@ -46,9 +46,16 @@ namespace component
 namespace constraintset
 {
 
+void LCPConstraintProblem::clear(int nbConstraints)
+{
+    ConstraintProblem::clear(nbConstraints);
+
+    W33.resize(nbConstraints/3);
+}
+
 void LCPConstraintProblem::solveTimed(double tolerance, int maxIt, double timeout)
 {
-    helper::nlcp_gaussseidelTimed(dimension, getDfree(), getW(), getF(), mu, tolerance, maxIt, true, timeout);
+    helper::nlcp_gaussseidelTimed(dimension, getDfree(), getW(), getF(), mu, tolerance, maxIt, true, timeout, W33.empty() ? NULL : &W33[0]);
 }
 
 bool LCPConstraintSolver::prepareStates(const core::ConstraintParams * /*cParams*/, MultiVecId /*res1*/, MultiVecId /*res2*/)
@@ -51,7 +51,12 @@ class LCPConstraintProblem : public ConstraintProblem
 public:
     double mu;
 
+    void clear(int nbConstraints);
     void solveTimed(double tolerance, int maxIt, double timeout);
+
+protected:
+    /// workspace of solveTimed, allocated by clear() so that the solves in an haptic thread do not allocate
+    std::vector<helper::LocalBlock33> W33;
 };
 
 class MechanicalGetConstraintInfoVisitor : public simulation::BaseMechanicalVisitor
@@ -33,6 +33,7 @@
 #include <sofa/core/objectmodel/BaseObject.h>
 #include <sofa/core/behavior/MechanicalState.h>
 #include <sofa/core/topology/BaseMeshTopology.h>
+#include <sofa/core/topology/ElementSelection.h>
 #include <sofa/core/loader/MeshLoader.h>
 
 namespace sofa
@@ -123,6 +124,19 @@ protected:
 
     void computePlane(unsigned int planeIndex);
 
+    /// Return false if the selection must be computed again from scratch, i.e. if not only the
+    /// positions changed since the last update
+    bool canUpdateSelection();
+    template <class Element, class Test>
+    void computeElementSelection(core::topology::ElementSelection<Element>& selection,
+                                 const Data<helper::vector<Element> >& elements,
+                                 Data<SetIndex>& indices, Data<helper::vector<Element> >& elementsInROI, Test test);
+    template <class Element, class Test>
+    void updateElementSelection(core::topology::ElementSelection<Element>& selection,
+                                const Data<helper::vector<Element> >& elements,
+                                Data<SetIndex>& indices, Data<helper::vector<Element> >& elementsInROI,
+                                const helper::vector<PointID>& movedPoints, Test test);
+
 
 public:
     //Input
@@ -157,6 +171,15 @@ private:
 
     Vec3 p0, p1, p2, p3, p4, p5, p6, p7, plane0, plane1, plane2, plane3, vdepth;
     Real width, length, depth;
+
+    /// Current selection, used to update it incrementally
+    /// @{
+    core::topology::PointSelection<VecCoord> m_pointSelection;
+    core::topology::ElementSelection<Edge> m_edgeSelection;
+    core::topology::ElementSelection<Triangle> m_triangleSelection;
+    core::topology::ElementSelection<Tetra> m_tetrahedronSelection;
+    bool m_isSelectionValid;
+    /// @}
 };
 
 #if defined(SOFA_EXTERN_TEMPLATE) && !defined(SOFA_COMPONENT_ENGINE_PLANEROI_CPP)
@@ -29,6 +29,7 @@
 #include <SofaGeneralEngine/PlaneROI.h>
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/defaulttype/RGBAColor.h>
+#include <algorithm>
 
 namespace sofa
 {
@@ -63,6 +64,7 @@ PlaneROI<DataTypes>::PlaneROI()
     , p_drawTriangles( initData(&p_drawTriangles,false,"drawTriangles","Draw Triangles") )
     , p_drawTetrahedra( initData(&p_drawTetrahedra,false,"drawTetrahedra","Draw Tetrahedra") )
     , _drawSize( initData(&_drawSize,0.0,"drawSize","rendering size for box and topological elements") )
+    , m_isSelectionValid(false)
 {
     planes.beginEdit()->push_back(Vec10(sofa::defaulttype::Vec<9,Real>(0,0,0,0,0,0,0,0,0),0));
     planes.endEdit();
@@ -148,6 +150,11 @@ void PlaneROI<DataTypes>::init()
     addInput(&f_triangles);
     addInput(&f_tetrahedra);
 
+    const DDGLinkContainer& inputs = getInputs();
+    for (std::size_t i=0; i<inputs.size(); ++i)
+        if (const BaseData* input = dynamic_cast<const BaseData*>(inputs[i]))
+            m_dataTracker.trackData(*input);
+
     addOutput(&f_indices);
     addOutput(&f_edgeIndices);
     addOutput(&f_triangleIndices);
@@ -162,6 +169,8 @@ void PlaneROI<DataTypes>::init()
 template <class DataTypes>
 void PlaneROI<DataTypes>::reinit()
 {
+    // the planes or the options may have changed
+    m_isSelectionValid = false;
     update();
 }
 
@@ -285,123 +294,171 @@ bool PlaneROI<DataTypes>::isTetrahedronInPlane(const Tetra& t)
 
 
 template <class DataTypes>
-void PlaneROI<DataTypes>::update()
+bool PlaneROI<DataTypes>::canUpdateSelection()
 {
-    const helper::vector<Vec10>& vp=planes.getValue();
-    if (vp.empty())
-        return;
-
-    // Read accessor for input topology
-    helper::ReadAccessor< Data<helper::vector<Edge> > > edges = f_edges;
-    helper::ReadAccessor< Data<helper::vector<Triangle> > > triangles = f_triangles;
-    helper::ReadAccessor< Data<helper::vector<Tetra> > > tetrahedra = f_tetrahedra;
-
+    if (!m_isSelectionValid)
+        return false;
 
-    const VecCoord* x0 = &f_X0.getValue();
+    // only the positions may have changed
+    const DDGLinkContainer& inputs = getInputs();
+    for (std::size_t i=0; i<inputs.size(); ++i)
+    {
+        const core::objectmodel::BaseData* input = dynamic_cast<const core::objectmodel::BaseData*>(inputs[i]);
+        if (input && input != &f_X0 && m_dataTracker.isDirty(*input))
+            return false;
+    }
 
-    cleanDirty();
+    if (f_X0.getValue().size() != m_pointSelection.size())
+        return false;
 
-    // Write accessor for topological element indices in SPHERE
-    SetIndex& indices = *(f_indices.beginWriteOnly());
-    SetIndex& edgeIndices = *(f_edgeIndices.beginWriteOnly());
-    SetIndex& triangleIndices = *(f_triangleIndices.beginWriteOnly());
-    SetIndex& tetrahedronIndices = *f_tetrahedronIndices.beginWriteOnly();
+    // the selections of elements must have been computed
+    if ((f_computeEdges.getValue() && m_edgeSelection.size() != f_edges.getValue().size())
+            || (f_computeTriangles.getValue() && m_triangleSelection.size() != f_triangles.getValue().size())
+            || (f_computeTetrahedra.getValue() && m_tetrahedronSelection.size() != f_tetrahedra.getValue().size()))
+        return false;
 
-    // Write accessor for toplogical element in SPHERE
-    helper::WriteOnlyAccessor< Data<VecCoord > > pointsInROI = f_pointsInROI;
-    helper::WriteOnlyAccessor< Data<helper::vector<Edge> > > edgesInROI = f_edgesInROI;
-    helper::WriteOnlyAccessor< Data<helper::vector<Triangle> > > trianglesInROI = f_trianglesInROI;
-    helper::WriteOnlyAccessor< Data<helper::vector<Tetra> > > tetrahedraInROI = f_tetrahedraInROI;
+    return true;
+}
 
+template <class DataTypes> template <class Element, class Test>
+void PlaneROI<DataTypes>::computeElementSelection(core::topology::ElementSelection<Element>& selection,
+                                                  const Data<helper::vector<Element> >& elements,
+                                                  Data<SetIndex>& indices, Data<helper::vector<Element> >& elementsInROI, Test test)
+{
+    const helper::vector<Element>& e = elements.getValue();
+    selection.select(e, test);
+    selection.getSelection(e, *indices.beginWriteOnly(), *elementsInROI.beginWriteOnly());
+    indices.endEdit();
+    elementsInROI.endEdit();
+}
 
-    // Clear lists
-    indices.clear();
-    edgeIndices.clear();
-    triangleIndices.clear();
-    tetrahedronIndices.clear();
+template <class DataTypes> template <class Element, class Test>
+void PlaneROI<DataTypes>::updateElementSelection(core::topology::ElementSelection<Element>& selection,
+                                                 const Data<helper::vector<Element> >& elements,
+                                                 Data<SetIndex>& indices, Data<helper::vector<Element> >& elementsInROI,
+                                                 const helper::vector<PointID>& movedPoints, Test test)
+{
+    const helper::vector<Element>& e = elements.getValue();
+    if (selection.update(e, movedPoints, f_X0.getValue().size(), test))
+    {
+        selection.getSelection(e, *indices.beginWriteOnly(), *elementsInROI.beginWriteOnly());
+        indices.endEdit();
+        elementsInROI.endEdit();
+    }
+}
 
-    pointsInROI.clear();
-    edgesInROI.clear();
-    trianglesInROI.clear();
-    tetrahedraInROI.clear();
+template <class DataTypes>
+void PlaneROI<DataTypes>::update()
+{
+    const helper::vector<Vec10>& vp=planes.getValue();
+    if (vp.empty())
+    {
+        m_isSelectionValid = false;
+        return;
+    }
 
+    const VecCoord& x0 = f_X0.getValue();
 
-    //Points
-    for( unsigned i=0; i<x0->size(); ++i )
+    auto pointTest = [&](PointID i)
     {
         for (unsigned int j=0; j<vp.size(); ++j)
         {
             this->computePlane(j);
             if (isPointInPlane(i))
-            {
-                indices.push_back(i);
-                pointsInROI.push_back((*x0)[i]);
-                break;
-            }
+                return true;
         }
-    }
+        return false;
+    };
 
-    //Edges
-    if (f_computeEdges.getValue())
+    auto edgeTest = [&](const Edge& edge)
     {
-        for(unsigned int i=0 ; i<edges.size() ; i++)
+        for (unsigned int j=0; j<vp.size(); ++j)
         {
-            Edge edge = edges[i];
-            for (unsigned int j=0; j<vp.size(); ++j)
-            {
-                this->computePlane(j);
-                if (isEdgeInPlane(edge))
-                {
-                    edgeIndices.push_back(i);
-                    edgesInROI.push_back(edge);
-                    break;
-                }
-            }
+            this->computePlane(j);
+            if (isEdgeInPlane(edge))
+                return true;
         }
-    }
+        return false;
+    };
 
-    //Triangles
-    if (f_computeTriangles.getValue())
+    auto triangleTest = [&](const Triangle& tri)
     {
-        for(unsigned int i=0 ; i<triangles.size() ; i++)
+        for (unsigned int j=0; j<vp.size(); ++j)
         {
-            Triangle tri = triangles[i];
-            for (unsigned int j=0; j<vp.size(); ++j)
-            {
-                this->computePlane(j);
-                if (isTriangleInPlane(tri))
-                {
-                    triangleIndices.push_back(i);
-                    trianglesInROI.push_back(tri);
-                    break;
-                }
-            }
+            this->computePlane(j);
+            if (isTriangleInPlane(tri))
+                return true;
         }
-    }
+        return false;
+    };
 
-    //Tetrahedra
-    if (f_computeTetrahedra.getValue())
+    auto tetrahedronTest = [&](const Tetra& t)
     {
-        for(unsigned int i=0 ; i<tetrahedra.size() ; i++)
+        for (unsigned int j=0; j<vp.size(); ++j)
         {
-            Tetra t = tetrahedra[i];
-            for (unsigned int j=0; j<vp.size(); ++j)
-            {
-                this->computePlane(j);
-                if (isTetrahedronInPlane(t))
-                {
-                    tetrahedronIndices.push_back(i);
-                    tetrahedraInROI.push_back(t);
-                    break;
-                }
-            }
+            this->computePlane(j);
+            if (isTetrahedronInPlane(t))
+                return true;
+        }
+        return false;
+    };
+
+    // When only some positions were modified since the last update, only the moved points and the
+    // elements using them are tested again.
+    const bool isIncremental = canUpdateSelection();
+
+    cleanDirty();
+
+    helper::vector<PointID> movedPoints;
+    if (!isIncremental)
+        m_pointSelection.select(x0, pointTest);
+    if (!isIncremental || m_pointSelection.update(x0, pointTest, movedPoints))
+    {
+        m_pointSelection.getSelection(x0, *f_indices.beginWriteOnly(), *f_pointsInROI.beginWriteOnly());
+        f_indices.endEdit();
+        f_pointsInROI.endEdit();
+    }
+    else
+    {
+        // same points in the ROI, only the positions of the moved ones are copied
+        const SetIndex& indices = f_indices.getValue();
+        helper::vector<PointID> ranks;
+        for (unsigned int i=0; i<movedPoints.size(); ++i)
+            if (m_pointSelection.isSelected(movedPoints[i]))
+                ranks.push_back((PointID)(std::lower_bound(indices.begin(), indices.end(), movedPoints[i]) - indices.begin()));
+
+        if (!ranks.empty())
+        {
+            helper::WriteAccessor< Data<VecCoord > > pointsInROI = f_pointsInROI;
+            for (unsigned int i=0; i<ranks.size(); ++i)
+                pointsInROI[ranks[i]] = x0[indices[ranks[i]]];
         }
     }
 
-    f_indices.endEdit();
-    f_edgeIndices.endEdit();
-    f_triangleIndices.endEdit();
-    f_tetrahedronIndices.endEdit();
+    if (!isIncremental)
+    {
+        m_edgeSelection.clear();
+        m_triangleSelection.clear();
+        m_tetrahedronSelection.clear();
+
+        if (f_computeEdges.getValue())
+            computeElementSelection(m_edgeSelection, f_edges, f_edgeIndices, f_edgesInROI, edgeTest);
+        if (f_computeTriangles.getValue())
+            computeElementSelection(m_triangleSelection, f_triangles, f_triangleIndices, f_trianglesInROI, triangleTest);
+        if (f_computeTetrahedra.getValue())
+            computeElementSelection(m_tetrahedronSelection, f_tetrahedra, f_tetrahedronIndices, f_tetrahedraInROI, tetrahedronTest);
+    }
+    else if (!movedPoints.empty())
+    {
+        if (f_computeEdges.getValue())
+            updateElementSelection(m_edgeSelection, f_edges, f_edgeIndices, f_edgesInROI, movedPoints, edgeTest);
+        if (f_computeTriangles.getValue())
+            updateElementSelection(m_triangleSelection, f_triangles, f_triangleIndices, f_trianglesInROI, movedPoints, triangleTest);
+        if (f_computeTetrahedra.getValue())
+            updateElementSelection(m_tetrahedronSelection, f_tetrahedra, f_tetrahedronIndices, f_tetrahedraInROI, movedPoints, tetrahedronTest);
+    }
+
+    m_isSelectionValid = true;
 }
 
 template <class DataTypes>
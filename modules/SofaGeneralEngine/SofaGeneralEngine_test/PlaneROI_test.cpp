@@ -164,6 +164,33 @@ struct PlaneROI_test : public Sofa_test<typename _DataTypes::Real>,
         EXPECT_EQ(m_node2->getChild("node")->getObject("PlaneROI")->findData("tetrahedronIndices")->getValueString(),"0");
         EXPECT_EQ(m_node2->getChild("node")->getObject("PlaneROI")->findData("tetrahedraInROI")->getValueString(),"0 1 2 3");
     }
+
+
+    /// Test the update of the selection when only some positions are modified
+    void incrementalUpdateTest()
+    {
+        sofa::core::objectmodel::BaseObject* planeROI = m_node2->getChild("node")->getObject("PlaneROI");
+        planeROI->findData("position")->read("1. 0. 0. 1. 1. 0. -1 0 0");
+        planeROI->findData("edges")->read("0 1 1 2");
+        planeROI->init();
+
+        EXPECT_EQ(planeROI->findData("indices")->getValueString(),"0 1");
+        EXPECT_EQ(planeROI->findData("edgeIndices")->getValueString(),"0");
+
+        // move the point 2 in the plane
+        planeROI->findData("position")->read("1. 0. 0. 1. 1. 0. 1.5 0.5 0.");
+
+        EXPECT_EQ(planeROI->findData("indices")->getValueString(),"0 1 2");
+        EXPECT_EQ(planeROI->findData("edgeIndices")->getValueString(),"0 1");
+        EXPECT_EQ(planeROI->findData("edgesInROI")->getValueString(),"0 1 1 2");
+
+        // move the point 0 out of the plane
+        planeROI->findData("position")->read("-1. 0. 0. 1. 1. 0. 1.5 0.5 0.");
+
+        EXPECT_EQ(planeROI->findData("indices")->getValueString(),"1 2");
+        EXPECT_EQ(planeROI->findData("pointsInROI")->getValueString(),"1 1 0 1.5 0.5 0");
+        EXPECT_EQ(planeROI->findData("edgeIndices")->getValueString(),"1");
+    }
 };
 
 using testing::Types;
@@ -201,4 +228,9 @@ TYPED_TEST(PlaneROI_test, isTetrahedraInPlaneTest) {
     ASSERT_NO_THROW(this->isTetrahedraInPlaneTest()) ;
 }
 
+TYPED_TEST(PlaneROI_test, incrementalUpdateTest) {
+    EXPECT_MSG_NOEMIT(Error) ;
+    ASSERT_NO_THROW(this->incrementalUpdateTest()) ;
+}
+
 }
@@ -160,6 +160,43 @@ struct SphereROI_test : public Sofa_test<typename _DataTypes::Real>,
         EXPECT_EQ(m_thisObject->findData("tetrahedronIndices")->getValueString(),"0");
         EXPECT_EQ(m_thisObject->findData("tetrahedraInROI")->getValueString(),"0 1 2 3");
     }
+
+
+    /// Test the update of the selection when only some positions are modified
+    void incrementalUpdateTest()
+    {
+        m_thisObject->findData("centers")->read("0. 0. 0.");
+        m_thisObject->findData("radii")->read("1.");
+        m_thisObject->findData("position")->read("0. 0. 0. 0.5 0. 0. 2. 0. 0.");
+        m_thisObject->findData("edges")->read("0 1 1 2");
+        m_thisObject->init();
+
+        EXPECT_EQ(m_thisObject->findData("indices")->getValueString(),"0 1");
+        EXPECT_EQ(m_thisObject->findData("edgeIndices")->getValueString(),"0");
+
+        // move the point 2 in the sphere
+        m_thisObject->findData("position")->read("0. 0. 0. 0.5 0. 0. 0. 0.5 0.");
+
+        EXPECT_EQ(m_thisObject->findData("indices")->getValueString(),"0 1 2");
+        EXPECT_EQ(m_thisObject->findData("indicesOut")->getValueString(),"");
+        EXPECT_EQ(m_thisObject->findData("edgeIndices")->getValueString(),"0 1");
+
+        // move the point 1 inside the sphere: the selections are not modified, only the position in the ROI
+        const int indicesCounter = m_thisObject->f_indices.getCounter();
+        const int edgeIndicesCounter = m_thisObject->f_edgeIndices.getCounter();
+        m_thisObject->findData("position")->read("0. 0. 0. 0. 0.5 0. 0. 0.5 0.");
+
+        EXPECT_EQ(m_thisObject->findData("pointsInROI")->getValueString(),"0 0 0 0 0.5 0 0 0.5 0");
+        EXPECT_EQ(m_thisObject->f_indices.getCounter(), indicesCounter);
+        EXPECT_EQ(m_thisObject->f_edgeIndices.getCounter(), edgeIndicesCounter);
+
+        // a change of the sphere computes the selection from scratch
+        m_thisObject->findData("radii")->read("0.1");
+
+        EXPECT_EQ(m_thisObject->findData("indices")->getValueString(),"0");
+        EXPECT_EQ(m_thisObject->findData("indicesOut")->getValueString(),"1 2");
+        EXPECT_EQ(m_thisObject->findData("edgeIndices")->getValueString(),"");
+    }
 };
 
 using testing::Types;
@@ -198,4 +235,9 @@ TYPED_TEST(SphereROI_test, isTetrahedraInSphereTest) {
     ASSERT_NO_THROW(this->isTetrahedraInSphereTest()) ;
 }
 
+TYPED_TEST(SphereROI_test, incrementalUpdateTest) {
+    EXPECT_MSG_NOEMIT(Error) ;
+    ASSERT_NO_THROW(this->incrementalUpdateTest()) ;
+}
+
 }
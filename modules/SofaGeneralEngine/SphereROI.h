@@ -32,6 +32,7 @@
 #include <sofa/core/objectmodel/BaseObject.h>
 #include <sofa/core/behavior/MechanicalState.h>
 #include <sofa/core/topology/BaseMeshTopology.h>
+#include <sofa/core/topology/ElementSelection.h>
 #include <sofa/core/loader/MeshLoader.h>
 
 namespace sofa
@@ -126,6 +127,19 @@ protected:
     bool isQuadInSphere(const Vec3& c, const Real& r, const sofa::core::topology::BaseMeshTopology::Quad& quad);
     bool isTetrahedronInSphere(const Vec3& c, const Real& r, const sofa::core::topology::BaseMeshTopology::Tetra& tetrahedron);
 
+    /// Return false if the selection must be computed again from scratch, i.e. if not only the
+    /// positions changed since the last update
+    bool canUpdateSelection();
+    template <class Element, class Test>
+    void computeElementSelection(core::topology::ElementSelection<Element>& selection,
+                                 const Data<helper::vector<Element> >& elements,
+                                 Data<SetIndex>& indices, Data<helper::vector<Element> >& elementsInROI, Test test);
+    template <class Element, class Test>
+    void updateElementSelection(core::topology::ElementSelection<Element>& selection,
+                                const Data<helper::vector<Element> >& elements,
+                                Data<SetIndex>& indices, Data<helper::vector<Element> >& elementsInROI,
+                                const helper::vector<PointID>& movedPoints, Test test);
+
 public:
     //Input
     Data< helper::vector<Vec3> > centers; ///< Center(s) of the sphere(s)
@@ -170,6 +184,16 @@ public:
     Data<bool> p_drawTetrahedra; ///< Draw Tetrahedra
     Data<double> _drawSize; ///< rendering size for box and topological elements
 
+protected:
+    /// Current selection, used to update it incrementally
+    /// @{
+    core::topology::PointSelection<VecCoord> m_pointSelection;
+    core::topology::ElementSelection<Edge> m_edgeSelection;
+    core::topology::ElementSelection<Triangle> m_triangleSelection;
+    core::topology::ElementSelection<Quad> m_quadSelection;
+    core::topology::ElementSelection<Tetra> m_tetrahedronSelection;
+    bool m_isSelectionValid;
+    /// @}
 };
 
 #ifndef SOFA_FLOAT
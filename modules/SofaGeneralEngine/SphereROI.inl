@@ -29,6 +29,7 @@
 #include <SofaGeneralEngine/SphereROI.h>
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/defaulttype/RGBAColor.h>
+#include <algorithm>
 
 namespace sofa
 {
@@ -74,6 +75,7 @@ SphereROI<DataTypes>::SphereROI()
     , p_drawQuads( initData(&p_drawQuads,false,"drawQuads","Draw Quads") )
     , p_drawTetrahedra( initData(&p_drawTetrahedra,false,"drawTetrahedra","Draw Tetrahedra") )
     , _drawSize( initData(&_drawSize,0.0,"drawSize","rendering size for box and topological elements") )
+    , m_isSelectionValid(false)
 {
     //Adding alias to handle TrianglesInSphereROI input/output
     addAlias(&p_drawSphere,"isVisible");
@@ -177,6 +179,11 @@ void SphereROI<DataTypes>::init()
     addInput(&edgeAngle);
     addInput(&triAngle);
 
+    const DDGLinkContainer& inputs = getInputs();
+    for (std::size_t i=0; i<inputs.size(); ++i)
+        if (const BaseData* input = dynamic_cast<const BaseData*>(inputs[i]))
+            m_dataTracker.trackData(*input);
+
     addOutput(&f_indices);
     addOutput(&f_edgeIndices);
     addOutput(&f_triangleIndices);
@@ -195,6 +202,8 @@ void SphereROI<DataTypes>::init()
 template <class DataTypes>
 void SphereROI<DataTypes>::reinit()
 {
+    // the options may have changed
+    m_isSelectionValid = false;
     update();
 }
 
@@ -274,6 +283,61 @@ bool SphereROI<DataTypes>::isTetrahedronInSphere(const Vec3& c, const Real& r, c
 }
 
 
+template <class DataTypes>
+bool SphereROI<DataTypes>::canUpdateSelection()
+{
+    if (!m_isSelectionValid)
+        return false;
+
+    // only the positions may have changed
+    const DDGLinkContainer& inputs = getInputs();
+    for (std::size_t i=0; i<inputs.size(); ++i)
+    {
+        const core::objectmodel::BaseData* input = dynamic_cast<const core::objectmodel::BaseData*>(inputs[i]);
+        if (input && input != &f_X0 && m_dataTracker.isDirty(*input))
+            return false;
+    }
+
+    if (f_X0.getValue().size() != m_pointSelection.size())
+        return false;
+
+    // the selections of elements must have been computed
+    if ((f_computeEdges.getValue() && m_edgeSelection.size() != f_edges.getValue().size())
+            || (f_computeTriangles.getValue() && m_triangleSelection.size() != f_triangles.getValue().size())
+            || (f_computeQuads.getValue() && m_quadSelection.size() != f_quads.getValue().size())
+            || (f_computeTetrahedra.getValue() && m_tetrahedronSelection.size() != f_tetrahedra.getValue().size()))
+        return false;
+
+    return true;
+}
+
+template <class DataTypes> template <class Element, class Test>
+void SphereROI<DataTypes>::computeElementSelection(core::topology::ElementSelection<Element>& selection,
+                                                   const Data<helper::vector<Element> >& elements,
+                                                   Data<SetIndex>& indices, Data<helper::vector<Element> >& elementsInROI, Test test)
+{
+    const helper::vector<Element>& e = elements.getValue();
+    selection.select(e, test);
+    selection.getSelection(e, *indices.beginWriteOnly(), *elementsInROI.beginWriteOnly());
+    indices.endEdit();
+    elementsInROI.endEdit();
+}
+
+template <class DataTypes> template <class Element, class Test>
+void SphereROI<DataTypes>::updateElementSelection(core::topology::ElementSelection<Element>& selection,
+                                                  const Data<helper::vector<Element> >& elements,
+                                                  Data<SetIndex>& indices, Data<helper::vector<Element> >& elementsInROI,
+                                                  const helper::vector<PointID>& movedPoints, Test test)
+{
+    const helper::vector<Element>& e = elements.getValue();
+    if (selection.update(e, movedPoints, f_X0.getValue().size(), test))
+    {
+        selection.getSelection(e, *indices.beginWriteOnly(), *elementsInROI.beginWriteOnly());
+        indices.endEdit();
+        elementsInROI.endEdit();
+    }
+}
+
 template <class DataTypes>
 void SphereROI<DataTypes>::update()
 {
@@ -281,7 +345,10 @@ void SphereROI<DataTypes>::update()
     const helper::vector<Real>& rad = (radii.getValue());
 
     if (cen.empty())
+    {
+        m_isSelectionValid = false;
         return;
+    }
 
     if (cen.size() != rad.size())
     {
@@ -294,6 +361,7 @@ void SphereROI<DataTypes>::update()
 		else
 		{
 			serr << "WARNING: number of sphere centers and radius doesn't match." << sendl;
+			m_isSelectionValid = false;
 			return;
 		}
     }
@@ -309,157 +377,136 @@ void SphereROI<DataTypes>::update()
     if (tAngle>0)
         norm.normalize();
 
-    // Read accessor for input topology
-    helper::ReadAccessor< Data<helper::vector<Edge> > > edges = f_edges;
-    helper::ReadAccessor< Data<helper::vector<Triangle> > > triangles = f_triangles;
-    helper::ReadAccessor< Data<helper::vector<Quad> > > quads = f_quads;
-    helper::ReadAccessor< Data<helper::vector<Tetra> > > tetrahedra = f_tetrahedra;
-
-    const VecCoord* x0 = &f_X0.getValue();
-
-
-    cleanDirty();
-
-
-
-
-    // Write accessor for topological element indices in SPHERE
-    SetIndex& indices = *(f_indices.beginWriteOnly());
-    SetIndex& edgeIndices = *(f_edgeIndices.beginWriteOnly());
-    SetIndex& triangleIndices = *(f_triangleIndices.beginWriteOnly());
-    SetIndex& quadIndices = *(f_quadIndices.beginWriteOnly());
-    SetIndex& tetrahedronIndices = *f_tetrahedronIndices.beginWriteOnly();
-    SetIndex& indicesOut = *(f_indicesOut.beginWriteOnly());
-
-    // Write accessor for toplogical element in SPHERE
-    helper::WriteOnlyAccessor< Data<VecCoord > > pointsInROI = f_pointsInROI;
-    helper::WriteOnlyAccessor< Data<helper::vector<Edge> > > edgesInROI = f_edgesInROI;
-    helper::WriteOnlyAccessor< Data<helper::vector<Triangle> > > trianglesInROI = f_trianglesInROI;
-    helper::WriteOnlyAccessor< Data<helper::vector<Quad> > > quadsInROI = f_quadsInROI;
-    helper::WriteOnlyAccessor< Data<helper::vector<Tetra> > > tetrahedraInROI = f_tetrahedraInROI;
-
-    // Clear lists
-    indices.clear();
-    edgeIndices.clear();
-    triangleIndices.clear();
-    quadIndices.clear();
-    tetrahedronIndices.clear();
-    indicesOut.clear();
-
-    pointsInROI.clear();
-    edgesInROI.clear();
-    trianglesInROI.clear();
-    quadsInROI.clear();
-    tetrahedraInROI.clear();
-
+    const VecCoord& x0 = f_X0.getValue();
 
-    //Points
-    for( unsigned i=0; i<x0->size(); ++i )
+    auto pointTest = [&](PointID i)
     {
-        bool isInSpheres = false;
         for (unsigned int j=0; j<cen.size(); ++j)
-        {
-            if (isPointInSphere(cen[j], rad[j], (*x0)[i]))
-            {
-                indices.push_back(i);
-                pointsInROI.push_back((*x0)[i]);
-                isInSpheres = true;
-                break;
-            }
-        }
-        if (!isInSpheres) indicesOut.push_back(i);
-    }
+            if (isPointInSphere(cen[j], rad[j], x0[i]))
+                return true;
+        return false;
+    };
 
-    //Edges
-    if (f_computeEdges.getValue())
+    auto edgeTest = [&](const Edge& edge)
     {
-        for(unsigned int i=0 ; i<edges.size() ; i++)
+        for (unsigned int j=0; j<cen.size(); ++j)
         {
-            Edge edge = edges[i];
-            for (unsigned int j=0; j<cen.size(); ++j)
+            if (isEdgeInSphere(cen[j], rad[j], edge))
             {
-                if (isEdgeInSphere(cen[j], rad[j], edge))
+                if (eAngle > 0)
                 {
-                    if (eAngle > 0)
-                    {
-                        Coord n = (*x0)[edge[1]]-(*x0)[edge[0]];
-                        n.normalize();
-                        if (fabs(dot(n,dir)) < fabs(cos(eAngle*M_PI/180.0))) continue;
-                    }
-                    edgeIndices.push_back(i);
-                    edgesInROI.push_back(edge);
-                    break;
+                    Coord n = x0[edge[1]]-x0[edge[0]];
+                    n.normalize();
+                    if (fabs(dot(n,dir)) < fabs(cos(eAngle*M_PI/180.0))) continue;
                 }
+                return true;
             }
         }
-    }
+        return false;
+    };
 
-    //Triangles
-    if (f_computeTriangles.getValue())
+    auto triangleTest = [&](const Triangle& tri)
     {
-        for(unsigned int i=0 ; i<triangles.size() ; i++)
+        for (unsigned int j=0; j<cen.size(); ++j)
         {
-            Triangle tri = triangles[i];
-            for (unsigned int j=0; j<cen.size(); ++j)
+            if (isTriangleInSphere(cen[j], rad[j], tri))
             {
-                if (isTriangleInSphere(cen[j], rad[j], tri))
+                if (tAngle > 0)
                 {
-                    if (tAngle > 0)
-                    {
-                        Coord n = cross((*x0)[tri[2]]-(*x0)[tri[0]], (*x0)[tri[1]]-(*x0)[tri[0]]);
-                        n.normalize();
-                        if (dot(n,norm) < cos(tAngle*M_PI/180.0)) continue;
-                    }
-                    triangleIndices.push_back(i);
-                    trianglesInROI.push_back(tri);
-                    break;
+                    Coord n = cross(x0[tri[2]]-x0[tri[0]], x0[tri[1]]-x0[tri[0]]);
+                    n.normalize();
+                    if (dot(n,norm) < cos(tAngle*M_PI/180.0)) continue;
                 }
+                return true;
             }
         }
-    }
+        return false;
+    };
+
+    auto quadTest = [&](const Quad& qua)
+    {
+        for (unsigned int j=0; j<cen.size(); ++j)
+            if (isQuadInSphere(cen[j], rad[j], qua))
+                return true;
+        return false;
+    };
 
-    //Quads
-    if (f_computeQuads.getValue())
+    auto tetrahedronTest = [&](const Tetra& t)
     {
-        for(unsigned int i=0 ; i<quads.size() ; i++)
+        for (unsigned int j=0; j<cen.size(); ++j)
+            if (isTetrahedronInSphere(cen[j], rad[j], t))
+                return true; //tAngle > 0 ??
+        return false;
+    };
+
+    // When only some positions were modified since the last update, only the moved points and the
+    // elements using them are tested again.
+    const bool isIncremental = canUpdateSelection();
+
+    cleanDirty();
+
+    helper::vector<PointID> movedPoints;
+    if (!isIncremental)
+        m_pointSelection.select(x0, pointTest);
+    if (!isIncremental || m_pointSelection.update(x0, pointTest, movedPoints))
+    {
+        SetIndex& indices = *(f_indices.beginWriteOnly());
+        SetIndex& indicesOut = *(f_indicesOut.beginWriteOnly());
+        m_pointSelection.getSelection(x0, indices, *f_pointsInROI.beginWriteOnly());
+        indicesOut.clear();
+        for (unsigned int i=0; i<x0.size(); ++i)
+            if (!m_pointSelection.isSelected(i))
+                indicesOut.push_back(i);
+        f_indices.endEdit();
+        f_indicesOut.endEdit();
+        f_pointsInROI.endEdit();
+    }
+    else
+    {
+        // same points in the ROI, only the positions of the moved ones are copied
+        const SetIndex& indices = f_indices.getValue();
+        helper::vector<PointID> ranks;
+        for (unsigned int i=0; i<movedPoints.size(); ++i)
+            if (m_pointSelection.isSelected(movedPoints[i]))
+                ranks.push_back((PointID)(std::lower_bound(indices.begin(), indices.end(), movedPoints[i]) - indices.begin()));
+
+        if (!ranks.empty())
         {
-            Quad qua = quads[i];
-            for (unsigned int j=0; j<cen.size(); ++j)
-            {
-                if (isQuadInSphere(cen[j], rad[j], qua))
-                {
-                    quadIndices.push_back(i);
-                    quadsInROI.push_back(qua);
-                    break;
-                }
-            }
+            helper::WriteAccessor< Data<VecCoord > > pointsInROI = f_pointsInROI;
+            for (unsigned int i=0; i<ranks.size(); ++i)
+                pointsInROI[ranks[i]] = x0[indices[ranks[i]]];
         }
     }
 
-    //Tetrahedra
-    if (f_computeTetrahedra.getValue())
+    if (!isIncremental)
     {
-        for(unsigned int i=0 ; i<tetrahedra.size() ; i++)
-        {
-            Tetra t = tetrahedra[i];
-            for (unsigned int j=0; j<cen.size(); ++j)
-            {
-                if (isTetrahedronInSphere(cen[j], rad[j], t))
-                {
-                    //tAngle > 0 ??
-                    tetrahedronIndices.push_back(i);
-                    tetrahedraInROI.push_back(t);
-                    break;
-                }
-            }
-        }
+        m_edgeSelection.clear();
+        m_triangleSelection.clear();
+        m_quadSelection.clear();
+        m_tetrahedronSelection.clear();
+
+        if (f_computeEdges.getValue())
+            computeElementSelection(m_edgeSelection, f_edges, f_edgeIndices, f_edgesInROI, edgeTest);
+        if (f_computeTriangles.getValue())
+            computeElementSelection(m_triangleSelection, f_triangles, f_triangleIndices, f_trianglesInROI, triangleTest);
+        if (f_computeQuads.getValue())
+            computeElementSelection(m_quadSelection, f_quads, f_quadIndices, f_quadsInROI, quadTest);
+        if (f_computeTetrahedra.getValue())
+            computeElementSelection(m_tetrahedronSelection, f_tetrahedra, f_tetrahedronIndices, f_tetrahedraInROI, tetrahedronTest);
+    }
+    else if (!movedPoints.empty())
+    {
+        if (f_computeEdges.getValue())
+            updateElementSelection(m_edgeSelection, f_edges, f_edgeIndices, f_edgesInROI, movedPoints, edgeTest);
+        if (f_computeTriangles.getValue())
+            updateElementSelection(m_triangleSelection, f_triangles, f_triangleIndices, f_trianglesInROI, movedPoints, triangleTest);
+        if (f_computeQuads.getValue())
+            updateElementSelection(m_quadSelection, f_quads, f_quadIndices, f_quadsInROI, movedPoints, quadTest);
+        if (f_computeTetrahedra.getValue())
+            updateElementSelection(m_tetrahedronSelection, f_tetrahedra, f_tetrahedronIndices, f_tetrahedraInROI, movedPoints, tetrahedronTest);
     }
 
-    f_indices.endEdit();
-    f_edgeIndices.endEdit();
-    f_triangleIndices.endEdit();
-    f_quadIndices.endEdit();
-    f_tetrahedronIndices.endEdit();
+    m_isSelectionValid = true;
 }
 
 template <class DataTypes>
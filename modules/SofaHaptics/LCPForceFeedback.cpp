@@ -81,14 +81,13 @@ using sofa::defaulttype::Rigid3fTypes;
 template <>
 void LCPForceFeedback< Rigid3fTypes >::computeForce(SReal x, SReal y, SReal z, SReal, SReal, SReal, SReal, SReal& fx, SReal& fy, SReal& fz)
 {
-    Rigid3fTypes::VecCoord state;
-    Rigid3fTypes::VecDeriv forces;
-    state.resize(1);
-    state[0].getCenter() = sofa::defaulttype::Vec3f((float)x,(float)y,(float)z);
-    computeForce(state,forces);
-    fx = getVCenter(forces[0]).x();
-    fy = getVCenter(forces[0]).y();
-    fz = getVCenter(forces[0]).z();
+    mHapticState.resize(1);
+    mHapticState[0].clear();
+    mHapticState[0].getCenter() = sofa::defaulttype::Vec3f((float)x,(float)y,(float)z);
+    computeForce(mHapticState,mHapticForces);
+    fx = getVCenter(mHapticForces[0]).x();
+    fy = getVCenter(mHapticForces[0]).y();
+    fz = getVCenter(mHapticForces[0]).z();
 }
 
 #endif // SOFA_DOUBLE
@@ -100,14 +99,13 @@ using sofa::defaulttype::Rigid3dTypes;
 template <>
 void LCPForceFeedback< Rigid3dTypes >::computeForce(double x, double y, double z, double, double, double, double, double& fx, double& fy, double& fz)
 {
-    Rigid3dTypes::VecCoord state;
-    Rigid3dTypes::VecDeriv forces;
-    state.resize(1);
-    state[0].getCenter() = sofa::defaulttype::Vec3d(x,y,z);
-    computeForce(state,forces);
-    fx = getVCenter(forces[0]).x();
-    fy = getVCenter(forces[0]).y();
-    fz = getVCenter(forces[0]).z();
+    mHapticState.resize(1);
+    mHapticState[0].clear();
+    mHapticState[0].getCenter() = sofa::defaulttype::Vec3d(x,y,z);
+    computeForce(mHapticState,mHapticForces);
+    fx = getVCenter(mHapticForces[0]).x();
+    fy = getVCenter(mHapticForces[0]).y();
+    fz = getVCenter(mHapticForces[0]).z();
 }
 
 
@@ -124,17 +122,15 @@ void LCPForceFeedback< Rigid3dTypes >::computeWrench(const sofa::defaulttype::So
     }
 
 
-    Rigid3dTypes::VecCoord state;
-    Rigid3dTypes::VecDeriv forces;
-    state.resize(1);
-    state[0].getCenter()	  = world_H_tool.getOrigin();
-    state[0].getOrientation() = world_H_tool.getOrientation();
+    mHapticState.resize(1);
+    mHapticState[0].getCenter()	  = world_H_tool.getOrigin();
+    mHapticState[0].getOrientation() = world_H_tool.getOrientation();
 
 
-    computeForce(state,forces);
+    computeForce(mHapticState,mHapticForces);
 
-    W_tool_world.setForce(getVCenter(forces[0]));
-    W_tool_world.setTorque(getVOrientation(forces[0]));
+    W_tool_world.setForce(getVCenter(mHapticForces[0]));
+    W_tool_world.setTorque(getVOrientation(mHapticForces[0]));
 
 
 
@@ -27,6 +27,7 @@
 #include <sofa/core/behavior/MechanicalState.h>
 
 #include <sofa/helper/system/thread/CTime.h>
+#include <sofa/helper/system/thread/TripleBuffer.h>
 
 
 namespace sofa
@@ -67,7 +68,10 @@ public:
     void draw( const core::visual::VisualParams* ) override
     {
         // draw the haptic_freq in the openGL window
-        dmsg_info() << "haptic_freq = " << std::fixed << haptic_freq << " Hz   " << '\xd';
+        dmsg_info() << "haptic_freq = " << std::fixed << haptic_freq << " Hz   "
+                    << "period = [" << haptic_period_min << ", " << haptic_period_max << "] ms   "
+                    << "solve = " << solve_time_mean << " (max " << solve_time_max << ") ms   "
+                    << "latency = " << latency_mean << " (max " << latency_max << ") ms   " << '\xd';
     }
 
     Data< double > forceCoef; ///< multiply haptic force by this coef.
@@ -93,7 +97,10 @@ protected:
         delete(_timer);
     }
 
+    /// Update the haptic rate statistics, called once per haptic iteration.
     virtual void updateStats();
+    /// Switch to the last buffer published by the simulation thread, if any.
+    /// Return true if the buffer in use changed.
     virtual bool updateConstraintProblem();
     virtual void doComputeForce(const  VecCoord& state,  VecDeriv& forces);
 
@@ -131,9 +138,20 @@ protected:
     component::constraintset::ConstraintProblem* mCP[3];
     /* 	std::vector<int> *id_buf; */
     /* 	typename DataType::VecCoord *val; */
-    unsigned char mNextBufferId; // Next buffer id to be use
-    unsigned char mCurBufferId; // Current buffer id in use
-    bool mIsCuBufferInUse; // Is current buffer currently in use right now
+
+    /// Work vectors of each buffer, sized by the simulation thread so that the
+    /// haptic thread does not allocate.
+    VecDeriv mDx[3];
+    VecDeriv mTempForces[3];
+    helper::system::thread::ctime_t mPublishTime[3]; ///< Time at which each buffer was published
+
+    /// Triple buffering of the constraint problem between the simulation thread,
+    /// which fills the back buffer, and the haptic thread, which reads the front one.
+    helper::system::thread::TripleBuffer mBuffers;
+
+    /// State and forces used by the device API (computeForce(x,y,z...) and computeWrench)
+    VecCoord mHapticState;
+    VecDeriv mHapticForces;
 
     //core::behavior::MechanicalState<defaulttype::Vec1dTypes> *mState1d; ///< The device try to follow this mechanical state.
     sofa::component::constraintset::ConstraintSolverImpl* constraintSolver;
@@ -143,6 +161,17 @@ protected:
     int timer_iterations;
     double haptic_freq;
     unsigned int num_constraints;
+
+    // statistics accumulated by the haptic thread over one second
+    helper::system::thread::ctime_t mLastIterationTime;
+    helper::system::thread::ctime_t mPeriodMin, mPeriodMax;
+    helper::system::thread::ctime_t mSolveTimeSum, mSolveTimeMax;
+    helper::system::thread::ctime_t mLatencySum, mLatencyMax;
+    int mNbSolves, mNbUpdates;
+    // statistics of the last second, in ms
+    double haptic_period_min, haptic_period_max;
+    double solve_time_mean, solve_time_max;
+    double latency_mean, latency_max;
 };
 
 
@@ -29,6 +29,7 @@
 #include <sofa/simulation/AnimateEndEvent.h>
 
 #include <algorithm>
+#include <limits>
 #include <mutex>
 
 namespace
@@ -148,20 +149,34 @@ LCPForceFeedback<DataTypes>::LCPForceFeedback()
     , d_derivRotations(initData(&d_derivRotations, false, "derivRotations", "if true, deriv the rotations when updating the violations"))
     , d_localHapticConstraintAllFrames(initData(&d_localHapticConstraintAllFrames, false, "localHapticConstraintAllFrames", "Flag to enable/disable constraint haptic influence from all frames"))
     , mState(NULL)
-    , mNextBufferId(0)
-    , mCurBufferId(0)
-    , mIsCuBufferInUse(false)
     , constraintSolver(NULL)
     , _timer(NULL)
     , time_buf(0)
     , timer_iterations(0)
     , haptic_freq(0.0)
     , num_constraints(0)
+    , mLastIterationTime(0)
+    , mPeriodMin(std::numeric_limits<helper::system::thread::ctime_t>::max())
+    , mPeriodMax(0)
+    , mSolveTimeSum(0)
+    , mSolveTimeMax(0)
+    , mLatencySum(0)
+    , mLatencyMax(0)
+    , mNbSolves(0)
+    , mNbUpdates(0)
+    , haptic_period_min(0.0)
+    , haptic_period_max(0.0)
+    , solve_time_mean(0.0)
+    , solve_time_max(0.0)
+    , latency_mean(0.0)
+    , latency_max(0.0)
 {
     this->f_listening.setValue(true);
-    mCP[0] = NULL;
-    mCP[1] = NULL;
-    mCP[2] = NULL;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        mCP[i] = NULL;
+        mPublishTime[i] = 0;
+    }
     _timer = new helper::system::thread::CTime();
     time_buf = _timer->getTime();
     timer_iterations = 0;
@@ -196,8 +211,6 @@ void LCPForceFeedback<DataTypes>::init()
     }
 }
 
-std::mutex s_mtx;
-
 template <class DataTypes>
 void LCPForceFeedback<DataTypes>::computeForce(const VecCoord& state,  VecDeriv& forces)
 {    
@@ -215,40 +228,52 @@ void LCPForceFeedback<DataTypes>::updateStats()
     using namespace helper::system::thread;
 
     ctime_t actualTime = _timer->getTime();
+    if (mLastIterationTime)
+    {
+        const ctime_t period = actualTime - mLastIterationTime;
+        if (period < mPeriodMin) mPeriodMin = period;
+        if (period > mPeriodMax) mPeriodMax = period;
+    }
+    mLastIterationTime = actualTime;
     ++timer_iterations;
     if (actualTime - time_buf >= sofa::helper::system::thread::CTime::getTicksPerSec())
     {
+        const double toMs = 1000.0 / (double)CTime::getTicksPerSec();
         haptic_freq = (double)(timer_iterations*sofa::helper::system::thread::CTime::getTicksPerSec())/ (double)( actualTime - time_buf) ;
+        haptic_period_min = mPeriodMin <= mPeriodMax ? mPeriodMin * toMs : 0.0;
+        haptic_period_max = mPeriodMax * toMs;
+        solve_time_mean = mNbSolves ? mSolveTimeSum * toMs / mNbSolves : 0.0;
+        solve_time_max = mSolveTimeMax * toMs;
+        latency_mean = mNbUpdates ? mLatencySum * toMs / mNbUpdates : 0.0;
+        latency_max = mLatencyMax * toMs;
         time_buf = actualTime;
         timer_iterations = 0;
+        mPeriodMin = std::numeric_limits<ctime_t>::max();
+        mPeriodMax = 0;
+        mSolveTimeSum = mSolveTimeMax = 0;
+        mLatencySum = mLatencyMax = 0;
+        mNbSolves = mNbUpdates = 0;
     }
 }
 
 template <class DataTypes>
 bool LCPForceFeedback<DataTypes>::updateConstraintProblem()
 {
-    int prevId = mCurBufferId;
-
     //
     // Retrieve the last LCP and constraints computed by the Sofa thread.
     //
-    mIsCuBufferInUse = true;
+    if (!mBuffers.acquire())
+        return false;
 
-    {
-        // TODO: Lock and/or memory barrier HERE
-        mCurBufferId = mNextBufferId;
-    }
-
-    bool changed = (prevId != mCurBufferId);
+    const unsigned int curBufferId = mBuffers.frontBuffer();
 
-    component::constraintset::ConstraintProblem* cp = mCP[mCurBufferId];
+    // latency between the publication of the buffer and its first use
+    const helper::system::thread::ctime_t latency = _timer->getTime() - mPublishTime[curBufferId];
+    mLatencySum += latency;
+    if (latency > mLatencyMax) mLatencyMax = latency;
+    ++mNbUpdates;
 
-    if(!cp)
-    {
-        mIsCuBufferInUse = false;
-    }
-
-    return changed;
+    return true;
 }
 
 template <class DataTypes>
@@ -264,9 +289,10 @@ void LCPForceFeedback<DataTypes>::doComputeForce(const VecCoord& state,  VecDeri
     if(!constraintSolver||!mState)
         return;
 
-    const MatrixDeriv& constraints = mConstraints[mCurBufferId];
-    VecCoord &val = mVal[mCurBufferId];
-    component::constraintset::ConstraintProblem* cp = mCP[mCurBufferId];
+    const unsigned int curBufferId = mBuffers.frontBuffer();
+    const MatrixDeriv& constraints = mConstraints[curBufferId];
+    const VecCoord &val = mVal[curBufferId];
+    component::constraintset::ConstraintProblem* cp = mCP[curBufferId];
 
     if(!cp)
     {
@@ -275,61 +301,72 @@ void LCPForceFeedback<DataTypes>::doComputeForce(const VecCoord& state,  VecDeri
 
     if(!constraints.empty())
     {
-        VecDeriv dx;
+        // work vectors sized when the buffer was filled
+        VecDeriv& dx = mDx[curBufferId];
+        VecDeriv& tempForces = mTempForces[curBufferId];
 
         derivVectors< DataTypes >(val, state, dx, d_derivRotations.getValue());
 
         const bool localHapticConstraintAllFrames = d_localHapticConstraintAllFrames.getValue();
 
-        // Modify Dfree
         MatrixDerivRowConstIterator rowItEnd = constraints.end();
         num_constraints = constraints.size();
 
-        for (MatrixDerivRowConstIterator rowIt = constraints.begin(); rowIt != rowItEnd; ++rowIt)
         {
-            MatrixDerivColConstIterator colItEnd = rowIt.end();
+            // Dfree and F are shared by all the devices using this problem
+            std::lock_guard<std::mutex> lock(cp->getSolveMutex());
 
-            for (MatrixDerivColConstIterator colIt = rowIt.begin(); colIt != colItEnd; ++colIt)
+            // Modify Dfree
+            for (MatrixDerivRowConstIterator rowIt = constraints.begin(); rowIt != rowItEnd; ++rowIt)
             {
-                cp->getDfree()[rowIt.index()] += computeDot<DataTypes>(colIt.val(), dx[localHapticConstraintAllFrames ? 0 : colIt.index()]);
-            }
-        }
+                MatrixDerivColConstIterator colItEnd = rowIt.end();
 
-        s_mtx.lock();
+                for (MatrixDerivColConstIterator colIt = rowIt.begin(); colIt != colItEnd; ++colIt)
+                {
+                    cp->getDfree()[rowIt.index()] += computeDot<DataTypes>(colIt.val(), dx[localHapticConstraintAllFrames ? 0 : colIt.index()]);
+                }
+            }
 
-        // Solving constraints
-        cp->solveTimed(cp->tolerance * 0.001, 100, solverTimeout.getValue());	// tol, maxIt, timeout
+            // Solving constraints
+            const helper::system::thread::ctime_t solveStart = _timer->getTime();
+            cp->solveTimed(cp->tolerance * 0.001, 100, solverTimeout.getValue());	// tol, maxIt, timeout
+            const helper::system::thread::ctime_t solveTime = _timer->getTime() - solveStart;
+            mSolveTimeSum += solveTime;
+            if (solveTime > mSolveTimeMax) mSolveTimeMax = solveTime;
+            ++mNbSolves;
 
-        s_mtx.unlock();
+            // Restore Dfree
+            for (MatrixDerivRowConstIterator rowIt = constraints.begin(); rowIt != rowItEnd; ++rowIt)
+            {
+                MatrixDerivColConstIterator colItEnd = rowIt.end();
 
-        // Restore Dfree
-        for (MatrixDerivRowConstIterator rowIt = constraints.begin(); rowIt != rowItEnd; ++rowIt)
-        {
-            MatrixDerivColConstIterator colItEnd = rowIt.end();
+                for (MatrixDerivColConstIterator colIt = rowIt.begin(); colIt != colItEnd; ++colIt)
+                {
+                    cp->getDfree()[rowIt.index()] -= computeDot<DataTypes>(colIt.val(), dx[localHapticConstraintAllFrames ? 0 : colIt.index()]);
+                }
+            }
 
-            for (MatrixDerivColConstIterator colIt = rowIt.begin(); colIt != colItEnd; ++colIt)
+            for (unsigned int i = 0; i < tempForces.size(); ++i)
             {
-                cp->getDfree()[rowIt.index()] -= computeDot<DataTypes>(colIt.val(), dx[localHapticConstraintAllFrames ? 0 : colIt.index()]);
+                tempForces[i].clear();
             }
-        }
 
-        VecDeriv tempForces;
-        tempForces.resize(val.size());
-
-        for (MatrixDerivRowConstIterator rowIt = constraints.begin(); rowIt != rowItEnd; ++rowIt)
-        {
-            if (cp->getF()[rowIt.index()] != 0.0)
+            for (MatrixDerivRowConstIterator rowIt = constraints.begin(); rowIt != rowItEnd; ++rowIt)
             {
-                MatrixDerivColConstIterator colItEnd = rowIt.end();
-
-                for (MatrixDerivColConstIterator colIt = rowIt.begin(); colIt != colItEnd; ++colIt)
+                if (cp->getF()[rowIt.index()] != 0.0)
                 {
-                    tempForces[localHapticConstraintAllFrames ? 0 : colIt.index()] += colIt.val() * cp->getF()[rowIt.index()];
+                    MatrixDerivColConstIterator colItEnd = rowIt.end();
+
+                    for (MatrixDerivColConstIterator colIt = rowIt.begin(); colIt != colItEnd; ++colIt)
+                    {
+                        tempForces[localHapticConstraintAllFrames ? 0 : colIt.index()] += colIt.val() * cp->getF()[rowIt.index()];
+                    }
                 }
             }
         }
 
-        for(unsigned int i = 0; i < stateSize; ++i)
+        const unsigned int nbForces = std::min(stateSize, (unsigned int)tempForces.size());
+        for(unsigned int i = 0; i < nbForces; ++i)
         {
             forces[i] = tempForces[i] * forceCoef.getValue();
         }
@@ -354,17 +391,9 @@ void LCPForceFeedback<DataTypes>::handleEvent(sofa::core::objectmodel::Event *ev
     if (!new_cp)
         return;
 
-    // Find available buffer
-
-    unsigned char buf_index=0;
-    unsigned char cbuf_index=mCurBufferId;
-    unsigned char nbuf_index=mNextBufferId;
+    // The back buffer is not used by the haptic thread
 
-    if (buf_index == cbuf_index || buf_index == nbuf_index)
-        buf_index++;
-
-    if (buf_index == cbuf_index || buf_index == nbuf_index)
-        buf_index++;
+    const unsigned int buf_index = mBuffers.backBuffer();
 
     // Compute constraints, id_buf lcp and val for the current lcp.
 
@@ -392,18 +421,22 @@ void LCPForceFeedback<DataTypes>::handleEvent(sofa::core::objectmodel::Event *ev
         constraints.addLine(rowIt.index(), rowIt.row());
     }
 
-    // valid buffer
-
-    {
-        // TODO: Lock and/or memory barrier HERE
-        mNextBufferId = buf_index;
-    }
-
-    // Lock lcp to prevent its use by the SOFA thread while it is used by haptic thread
-    if(mIsCuBufferInUse)
-        constraintSolver->lockConstraintProblem(this, mCP[mCurBufferId], mCP[mNextBufferId]);
-    else
-        constraintSolver->lockConstraintProblem(this, mCP[mNextBufferId]);
+    mDx[buf_index].resize(val.size());
+    mTempForces[buf_index].resize(val.size());
+
+    // valid buffer: the release ordering makes its content visible to the haptic
+    // thread, and we get back the previous next buffer if it was not taken
+    mPublishTime[buf_index] = _timer->getTime();
+    const unsigned int backBufferId = mBuffers.publish();
+
+    // Lock lcp to prevent its use by the SOFA thread while it is used by haptic thread:
+    // the haptic thread may use any buffer but the back one
+    component::constraintset::ConstraintProblem* cp1 = mCP[(backBufferId+1)%3];
+    component::constraintset::ConstraintProblem* cp2 = mCP[(backBufferId+2)%3];
+    if (!cp1)
+        std::swap(cp1, cp2);
+    if (cp1)
+        constraintSolver->lockConstraintProblem(this, cp1, cp2);
 }
 
 
@@ -58,6 +58,8 @@ class NeoHookean : public HyperelasticMaterial<DataTypes>{
   typedef defaulttype::Mat<6,6,Real> Matrix6;
   typedef defaulttype::MatSym<3,Real> MatrixSym;
  
+public:
+
   virtual Real getStrainEnergy(StrainInformation<DataTypes> *sinfo, const MaterialParameters<DataTypes> &param) {
 		Real mu=param.parameterArray[0];
 		Real k=param.parameterArray[1];
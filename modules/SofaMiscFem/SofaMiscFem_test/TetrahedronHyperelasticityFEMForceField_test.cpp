@@ -0,0 +1,226 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaTest/Sofa_test.h>
+#include <SofaTest/TestMessageHandler.h>
+
+#include <SofaSimulationGraph/DAGSimulation.h>
+#include <SofaSimulationCommon/SceneLoaderXML.h>
+using sofa::simulation::SceneLoaderXML ;
+using sofa::simulation::Node ;
+
+#include <sofa/simulation/MechanicalVisitor.h>
+#include <SofaBaseLinearSolver/FullMatrix.h>
+#include <SofaBaseLinearSolver/SingleMatrixAccessor.h>
+
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaMiscFem/TetrahedronHyperelasticityFEMForceField.h>
+
+#include <cstdio>
+
+namespace sofa {
+
+/** @brief Regression test of the forces and of the stiffness of TetrahedronHyperelasticityFEMForceField, for each material.
+ *
+ * A unit cube split in five tetrahedra is deformed by a fixed displacement field. The forces (addForce) and the
+ * change of force for a fixed displacement (addDForce, and the product with the matrix of addKToMatrix) are
+ * compared to reference values, which were computed with the implementation evaluating the material through
+ * virtual calls. Set debug to true to print the values to be stored.
+ */
+struct TetrahedronHyperelasticityFEMForceField_test : public Sofa_test<SReal>
+{
+    typedef defaulttype::Vec3Types DataTypes;
+    typedef DataTypes::VecCoord VecCoord;
+    typedef DataTypes::VecDeriv VecDeriv;
+    typedef component::container::MechanicalObject<DataTypes> DOF;
+    typedef component::forcefield::TetrahedronHyperelasticityFEMForceField<DataTypes> ForceField;
+
+    enum { NbValues = 24 }; ///< 8 vertices in 3D
+
+    Node::SPtr root;
+    bool debug;
+
+    TetrahedronHyperelasticityFEMForceField_test()
+        : debug(true)
+    {
+        sofa::simulation::setSimulation(new sofa::simulation::graph::DAGSimulation());
+    }
+
+    void TearDown()
+    {
+        if (root)
+            sofa::simulation::getSimulation()->unload(root);
+    }
+
+    /// The scene, where the vertex of index i is the corner (i&1, (i>>1)&1, (i>>2)&1) of the cube at rest
+    void createScene(const std::string& materialName, const std::string& parameterSet)
+    {
+        std::stringstream scene ;
+        scene << "<?xml version='1.0'?>"
+                 "<Node name='Root' gravity='0 0 0'>                                                    \n"
+                 "   <MechanicalObject name='dofs'                                                      \n"
+                 "       rest_position='0 0 0  1 0 0  0 1 0  1 1 0  0 0 1  1 0 1  0 1 1  1 1 1'         \n"
+                 "       position='0.02 -0.01 0.01  1.1 0.03 -0.02  -0.04 0.95 0.02  1.08 1.12 0.05     \n"
+                 "                 0.01 0.03 0.9  1.05 -0.06 1.1  0.03 1.02 1.04  0.96 0.98 1.15'/>     \n"
+                 "   <TetrahedronSetTopologyContainer name='topology'                                   \n"
+                 "       tetrahedra='0 1 2 4  3 2 1 7  5 1 4 7  6 4 2 7  1 2 4 7'/>                     \n"
+                 "   <TetrahedronHyperelasticityFEMForceField name='fem' materialName='" << materialName << "' \n"
+                 "       ParameterSet='" << parameterSet << "'/>                                        \n"
+                 "</Node>                                                                               \n" ;
+
+        root = SceneLoaderXML::loadFromMemory("testscene", scene.str().c_str(), scene.str().size()) ;
+        ASSERT_NE(root.get(), nullptr) ;
+        sofa::simulation::getSimulation()->init(root.get()) ;
+    }
+
+    void printValues(const char* name, const VecDeriv& values) const
+    {
+        std::printf("    static const SReal %s[NbValues] = {\n", name);
+        for (unsigned int i=0; i<values.size(); i++)
+            std::printf("        %.17g, %.17g, %.17g%s\n", values[i][0], values[i][1], values[i][2], i+1<values.size() ? "," : "");
+        std::printf("    };\n");
+    }
+
+    void checkValues(const char* name, const VecDeriv& values, const SReal* expected) const
+    {
+        ASSERT_EQ((unsigned int)NbValues, values.size()*3);
+
+        SReal maxValue = 0;
+        for (unsigned int i=0; i<NbValues; i++)
+            maxValue = std::max(maxValue, std::abs(expected[i]));
+
+        for (unsigned int i=0; i<values.size(); i++)
+            for (unsigned int j=0; j<3; j++)
+                EXPECT_NEAR(expected[3*i+j], values[i][j], 1e-10*maxValue) << name << " of vertex " << i << " coordinate " << j;
+    }
+
+    /// Compare the forces, and the change of forces for a fixed displacement, to the expected values
+    void checkMaterial(const std::string& materialName, const std::string& parameterSet,
+                       const SReal* expectedForces, const SReal* expectedDf)
+    {
+        EXPECT_MSG_NOEMIT(Error) ;
+
+        createScene(materialName, parameterSet);
+        DOF* dof = NULL;
+        root->getTreeObject(dof);
+        ASSERT_NE(dof, nullptr);
+        ForceField* fem = NULL;
+        root->getTreeObject(fem);
+        ASSERT_NE(fem, nullptr);
+
+        core::MechanicalParams mparams;
+        mparams.setKFactor(1.0);
+
+        // forces
+        simulation::MechanicalResetForceVisitor resetForce(&mparams, core::VecDerivId::force());
+        simulation::MechanicalComputeForceVisitor computeForce(&mparams, core::VecDerivId::force());
+        root->execute(resetForce);
+        root->execute(computeForce);
+
+        VecDeriv forces = dof->readForces().ref();
+        if (debug) printValues("forces", forces);
+        checkValues("force", forces, expectedForces);
+
+        // change of forces computed by addDForce
+        VecDeriv dx(forces.size());
+        for (unsigned int i=0; i<dx.size(); i++)
+            dx[i] = DataTypes::Deriv((SReal)0.001*(i%3+1), (SReal)-0.002*((i+1)%4), (SReal)0.0015*((i+2)%5)-(SReal)0.003);
+        dof->vRealloc(&mparams, core::VecDerivId::dx());
+        dof->writeDx().wref() = dx;
+
+        simulation::MechanicalComputeDfVisitor computeDf(&mparams, core::VecDerivId::force());
+        root->execute(resetForce);
+        root->execute(computeDf);
+
+        VecDeriv df = dof->readForces().ref();
+        if (debug) printValues("df", df);
+        checkValues("addDForce", df, expectedDf);
+
+        // change of forces computed by the product with the stiffness matrix
+        component::linearsolver::FullMatrix<SReal> K(NbValues, NbValues);
+        component::linearsolver::SingleMatrixAccessor accessor(&K);
+        ((core::behavior::BaseForceField*)fem)->addKToMatrix(&mparams, &accessor);
+
+        VecDeriv Kdx(dx.size());
+        for (unsigned int i=0; i<NbValues; i++)
+            for (unsigned int j=0; j<NbValues; j++)
+                Kdx[i/3][i%3] += K.element(i, j)*dx[j/3][j%3];
+        checkValues("addKToMatrix", Kdx, expectedDf);
+    }
+};
+
+TEST_F(TetrahedronHyperelasticityFEMForceField_test, ArrudaBoyce)
+{
+    std::printf("%s\n", "ArrudaBoyce");
+    static const SReal forces[NbValues] = {};
+    static const SReal df[NbValues] = {};
+    checkMaterial("ArrudaBoyce", "3448.2759 31034.483", forces, df);
+}
+
+TEST_F(TetrahedronHyperelasticityFEMForceField_test, StVenantKirchhoff)
+{
+    std::printf("%s\n", "StVenantKirchhoff");
+    static const SReal forces[NbValues] = {};
+    static const SReal df[NbValues] = {};
+    checkMaterial("StVenantKirchhoff", "3448.2759 31034.483", forces, df);
+}
+
+TEST_F(TetrahedronHyperelasticityFEMForceField_test, NeoHookean)
+{
+    std::printf("%s\n", "NeoHookean");
+    static const SReal forces[NbValues] = {};
+    static const SReal df[NbValues] = {};
+    checkMaterial("NeoHookean", "3448.2759 31034.483", forces, df);
+}
+
+TEST_F(TetrahedronHyperelasticityFEMForceField_test, MooneyRivlin)
+{
+    std::printf("%s\n", "MooneyRivlin");
+    static const SReal forces[NbValues] = {};
+    static const SReal df[NbValues] = {};
+    checkMaterial("MooneyRivlin", "3448.2759 1724.138 31034.483", forces, df);
+}
+
+TEST_F(TetrahedronHyperelasticityFEMForceField_test, VerondaWestman)
+{
+    std::printf("%s\n", "VerondaWestman");
+    static const SReal forces[NbValues] = {};
+    static const SReal df[NbValues] = {};
+    checkMaterial("VerondaWestman", "3448.2759 2 31034.483", forces, df);
+}
+
+TEST_F(TetrahedronHyperelasticityFEMForceField_test, Costa)
+{
+    std::printf("%s\n", "Costa");
+    static const SReal forces[NbValues] = {};
+    static const SReal df[NbValues] = {};
+    checkMaterial("Costa", "3448.2759 31034.483 2 1.5 1 0.5 0.75 1.25", forces, df);
+}
+
+TEST_F(TetrahedronHyperelasticityFEMForceField_test, Ogden)
+{
+    std::printf("%s\n", "Ogden");
+    static const SReal forces[NbValues] = {};
+    static const SReal df[NbValues] = {};
+    checkMaterial("Ogden", "31034.483 3448.2759 2", forces, df);
+}
+
+} // namespace sofa
@@ -220,6 +220,21 @@ public:
     fem::HyperelasticMaterial<DataTypes> *m_myMaterial;
     TetrahedronHandler* m_tetrahedronHandler;
 
+    /// element loops, instantiated for the material chosen in init() so that material calls are not virtual
+    void (TetrahedronHyperelasticityFEMForceField<DataTypes>::*m_computeTetrahedronForces)(const VecCoord&);
+    void (TetrahedronHyperelasticityFEMForceField<DataTypes>::*m_computeTetrahedronStiffness)();
+    template<class Material> void setMaterial();
+    template<class Material> void computeTetrahedronForces(const VecCoord& x);  ///< stress and vertex forces of each tetrahedron
+    template<class Material> void computeTetrahedronStiffness();  ///< edge stiffness matrices of each tetrahedron
+
+    /// tetrahedra contributions, computed in parallel and then summed at each vertex / edge
+    VecDeriv m_tetrahedronForces;   ///< force of vertex l of tetrahedron i in 4*i+l
+    helper::vector<Matrix3> m_tetrahedronEdgeStiffness;   ///< stiffness of edge j of tetrahedron i in 6*i+j
+    helper::vector<unsigned int> m_vertexContributionsBegin, m_vertexContributions;   ///< contributions to vertex v in m_vertexContributions[m_vertexContributionsBegin[v]..m_vertexContributionsBegin[v+1]]
+    helper::vector<unsigned int> m_edgeContributionsBegin, m_edgeContributions;   ///< contributions to edge e, stored the same way
+    int m_contributionsRevision;
+    void updateContributions(); ///< update the contributions lists when the topology has changed
+
     void testDerivatives();
     void saveMesh( const char *filename );
 
@@ -119,7 +119,11 @@ template <class DataTypes> TetrahedronHyperelasticityFEMForceField<DataTypes>::T
     , d_anisotropySet(initData(&d_anisotropySet,"AnisotropyDirections","The global directions of anisotropy of the material"))
     , m_tetrahedronInfo(initData(&m_tetrahedronInfo, "tetrahedronInfo", "Internal tetrahedron data"))
     , m_edgeInfo(initData(&m_edgeInfo, "edgeInfo", "Internal edge data"))
+    , m_myMaterial(NULL)
     , m_tetrahedronHandler(NULL)
+    , m_computeTetrahedronForces(NULL)
+    , m_computeTetrahedronStiffness(NULL)
+    , m_contributionsRevision(-1)
 {
     m_tetrahedronHandler = new TetrahedronHandler(this,&m_tetrahedronInfo);
 }
@@ -156,51 +160,44 @@ template <class DataTypes> void TetrahedronHyperelasticityFEMForceField<DataType
     string material = d_materialName.getValue();
     if (material=="ArrudaBoyce")
     {
-        fem::BoyceAndArruda<DataTypes> *BoyceAndArrudaMaterial = new fem::BoyceAndArruda<DataTypes>;
-        m_myMaterial = BoyceAndArrudaMaterial;
+        setMaterial< fem::BoyceAndArruda<DataTypes> >();
         if (this->f_printLog.getValue())
             msg_info()<<"The model is "<<material;
     }
     else if (material=="StVenantKirchhoff")
     {
-        fem::STVenantKirchhoff<DataTypes> *STVenantKirchhoffMaterial = new fem::STVenantKirchhoff<DataTypes>;
-        m_myMaterial = STVenantKirchhoffMaterial;
+        setMaterial< fem::STVenantKirchhoff<DataTypes> >();
         if (this->f_printLog.getValue())
             msg_info()<<"The model is "<<material;
     }
     else if (material=="NeoHookean")
     {
-        fem::NeoHookean<DataTypes> *NeoHookeanMaterial = new fem::NeoHookean<DataTypes>;
-        m_myMaterial = NeoHookeanMaterial;
+        setMaterial< fem::NeoHookean<DataTypes> >();
         if (this->f_printLog.getValue())
             msg_info()<<"The model is "<<material;
     }
     else if (material=="MooneyRivlin")
     {
-        fem::MooneyRivlin<DataTypes> *MooneyRivlinMaterial = new fem::MooneyRivlin<DataTypes>;
-        m_myMaterial = MooneyRivlinMaterial;
+        setMaterial< fem::MooneyRivlin<DataTypes> >();
         if (this->f_printLog.getValue())
             msg_info()<<"The model is "<<material;
     }
     else if (material=="VerondaWestman")
     {
-        fem::VerondaWestman<DataTypes> *VerondaWestmanMaterial = new fem::VerondaWestman<DataTypes>;
-        m_myMaterial = VerondaWestmanMaterial;
+        setMaterial< fem::VerondaWestman<DataTypes> >();
         if (this->f_printLog.getValue())
             msg_info()<<"The model is "<<material;
     }
 
     else if (material=="Costa")
     {
-        fem::Costa<DataTypes> *CostaMaterial = new fem::Costa<DataTypes>;
-        m_myMaterial = CostaMaterial;
+        setMaterial< fem::Costa<DataTypes> >();
         if (this->f_printLog.getValue())
             msg_info()<<"The model is "<<material;
     }
     else if (material=="Ogden")
     {
-        fem::Ogden<DataTypes> *OgdenMaterial = new fem::Ogden<DataTypes>;
-        m_myMaterial = OgdenMaterial;
+        setMaterial< fem::Ogden<DataTypes> >();
         if (this->f_printLog.getValue())
             msg_info()<<"The model is "<<material;
     }
@@ -269,25 +266,86 @@ void TetrahedronHyperelasticityFEMForceField<DataTypes>::addForce(const core::Me
         printf( "Mesh saved.\n" );
         m_meshSaved = true;
     }
-    unsigned int i=0,j=0,k=0,l=0;
-    unsigned int nbTetrahedra=m_topology->getNbTetrahedra();
+    if (!m_computeTetrahedronForces) { d_f.endEdit(); return; }
 
-    helper::vector<TetrahedronRestInformation>& tetrahedronInf = *(m_tetrahedronInfo.beginEdit());
+    assert(this->mstate);
 
+    // compute the forces of each tetrahedron in parallel
+    (this->*m_computeTetrahedronForces)(x);
 
-    TetrahedronRestInformation *tetInfo;
+    // sum them at each vertex, in the order of tetrahedra
+    updateContributions();
+    const int nbVertices=(int)std::min(f.size(),m_vertexContributionsBegin.size()-1);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int v=0; v<nbVertices; v++)
+        for(unsigned int c=m_vertexContributionsBegin[v]; c<m_vertexContributionsBegin[v+1]; c++)
+            f[v]-=m_tetrahedronForces[m_vertexContributions[c]];
 
-    assert(this->mstate);
+    /// indicates that the next call to addDForce will need to update the stiffness matrix
+    m_updateMatrix=true;
+
+    d_f.endEdit();
+}
+
+template <class DataTypes>
+void TetrahedronHyperelasticityFEMForceField<DataTypes>::updateTangentMatrix()
+{
+    if (!m_computeTetrahedronStiffness) return;
+
+    // compute the edge stiffness matrices of each tetrahedron in parallel
+    (this->*m_computeTetrahedronStiffness)();
+
+    // sum them at each edge, in the order of tetrahedra
+    updateContributions();
+    helper::vector<EdgeInformation>& edgeInf = *(m_edgeInfo.beginEdit());
+    const int nbEdges=(int)std::min(edgeInf.size(),m_edgeContributionsBegin.size()-1);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int l=0; l<nbEdges; l++ )
+    {
+        Matrix3 &edgeDfDx = edgeInf[l].DfDx;
+        edgeDfDx.clear();
+        for(unsigned int c=m_edgeContributionsBegin[l]; c<m_edgeContributionsBegin[l+1]; c++)
+            edgeDfDx+=m_tetrahedronEdgeStiffness[m_edgeContributions[c]];
+    }
+    m_edgeInfo.endEdit();
+    m_updateMatrix=false;
+}
 
-    Coord dp[3],x0,sv;
+template <class DataTypes>
+template <class Material>
+void TetrahedronHyperelasticityFEMForceField<DataTypes>::setMaterial()
+{
+    m_myMaterial = new Material;
+    m_computeTetrahedronForces = &TetrahedronHyperelasticityFEMForceField<DataTypes>::template computeTetrahedronForces<Material>;
+    m_computeTetrahedronStiffness = &TetrahedronHyperelasticityFEMForceField<DataTypes>::template computeTetrahedronStiffness<Material>;
+}
 
+template <class DataTypes>
+template <class Material>
+void TetrahedronHyperelasticityFEMForceField<DataTypes>::computeTetrahedronForces(const VecCoord& x)
+{
+    // the material calls are qualified, hence not virtual
+    Material* material = static_cast<Material*>(m_myMaterial);
+    const int nbTetrahedra=m_topology->getNbTetrahedra();
+    const std::vector< Tetrahedron> &tetrahedronArray=m_topology->getTetrahedra() ;
+    helper::vector<TetrahedronRestInformation>& tetrahedronInf = *(m_tetrahedronInfo.beginEdit());
+    m_tetrahedronForces.resize(4*nbTetrahedra);
 
-    for(i=0; i<nbTetrahedra; i++ )
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int i=0; i<nbTetrahedra; i++ )
     {
-        tetInfo=&tetrahedronInf[i];
-        const Tetrahedron &ta= m_topology->getTetrahedron(i);
+        TetrahedronRestInformation *tetInfo=&tetrahedronInf[i];
+        const Tetrahedron &ta= tetrahedronArray[i];
+        unsigned int j,k,l;
+        Coord dp[3],sv;
 
-        x0=x[ta[0]];
+        const Coord& x0=x[ta[0]];
 
         // compute the deformation gradient
         // deformation gradient = sum of tensor product between vertex position and shape vector
@@ -330,68 +388,57 @@ void TetrahedronHyperelasticityFEMForceField<DataTypes>::addForce(const core::Me
         tetInfo->J = dot( areaVec, dp[0] ) * tetInfo->m_volScale;
         tetInfo->trC = (Real)( tetInfo->deformationTensor(0,0) + tetInfo->deformationTensor(1,1) + tetInfo->deformationTensor(2,2));
         tetInfo->m_SPKTensorGeneral.clear();
-        m_myMaterial->deriveSPKTensor(tetInfo,globalParameters,tetInfo->m_SPKTensorGeneral);
+        material->Material::deriveSPKTensor(tetInfo,globalParameters,tetInfo->m_SPKTensorGeneral);
         for(l=0;l<4;++l)
         {
-            f[ta[l]]-=tetInfo->m_deformationGradient*(tetInfo->m_SPKTensorGeneral*tetInfo->m_shapeVector[l])*tetInfo->m_restVolume;
+            m_tetrahedronForces[4*i+l]=tetInfo->m_deformationGradient*(tetInfo->m_SPKTensorGeneral*tetInfo->m_shapeVector[l])*tetInfo->m_restVolume;
         }
     }
 
-
-    /// indicates that the next call to addDForce will need to update the stiffness matrix
-    m_updateMatrix=true;
     m_tetrahedronInfo.endEdit();
-
-    d_f.endEdit();
 }
 
 template <class DataTypes>
-void TetrahedronHyperelasticityFEMForceField<DataTypes>::updateTangentMatrix()
+template <class Material>
+void TetrahedronHyperelasticityFEMForceField<DataTypes>::computeTetrahedronStiffness()
 {
-    unsigned int i=0,j=0,k=0,l=0;
-    unsigned int nbEdges=m_topology->getNbEdges();
+    // the material calls are qualified, hence not virtual
+    Material* material = static_cast<Material*>(m_myMaterial);
+    const int nbTetrahedra=m_topology->getNbTetrahedra();
     const vector< Edge> &edgeArray=m_topology->getEdges() ;
-
-    helper::vector<EdgeInformation>& edgeInf = *(m_edgeInfo.beginEdit());
+    const std::vector< Tetrahedron> &tetrahedronArray=m_topology->getTetrahedra() ;
     helper::vector<TetrahedronRestInformation>& tetrahedronInf = *(m_tetrahedronInfo.beginEdit());
+    m_tetrahedronEdgeStiffness.resize(6*nbTetrahedra);
 
-    EdgeInformation *einfo;
-    TetrahedronRestInformation *tetInfo;
-    unsigned int nbTetrahedra=m_topology->getNbTetrahedra();
-    const std::vector< Tetrahedron> &tetrahedronArray=m_topology->getTetrahedra() ;
+    if(nbTetrahedra) m_topology->getEdgesInTetrahedron(0); // topology arrays are created on first access, not in parallel
 
-    for(l=0; l<nbEdges; l++ )edgeInf[l].DfDx.clear();
-    for(i=0; i<nbTetrahedra; i++ )
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int i=0; i<nbTetrahedra; i++ )
     {
-        tetInfo=&tetrahedronInf[i];
+        TetrahedronRestInformation *tetInfo=&tetrahedronInf[i];
         Matrix3 &df=tetInfo->m_deformationGradient;
-//			Matrix3 Tdf=df.transposed();
-        BaseMeshTopology::EdgesInTetrahedron te=m_topology->getEdgesInTetrahedron(i);
+        const BaseMeshTopology::EdgesInTetrahedron &te=m_topology->getEdgesInTetrahedron(i);
 
         /// describe the jth vertex index of triangle no i
         const Tetrahedron &ta= tetrahedronArray[i];
-        for(j=0;j<6;j++) {
-            einfo= &edgeInf[te[j]];
+        for(unsigned int j=0;j<6;j++) {
             Edge e=m_topology->getLocalEdgesInTetrahedron(j);
 
-            k=e[0];
-            l=e[1];
+            unsigned int k=e[0];
+            unsigned int l=e[1];
             if (edgeArray[te[j]][0]!=ta[k]) {
                 k=e[1];
                 l=e[0];
             }
-            Matrix3 &edgeDfDx = einfo->DfDx;
-
 
             Coord svl=tetInfo->m_shapeVector[l];
             Coord svk=tetInfo->m_shapeVector[k];
 
             Matrix3  M, N;
             MatrixSym outputTensor;
-            N.clear();
-            vector<MatrixSym> inputTensor;
-            inputTensor.resize(3);
-            //	MatrixSym input1,input2,input3,outputTensor;
+            MatrixSym inputTensor[3];
             for(int m=0; m<3;m++){
                 for (int n=m;n<3;n++){
                     inputTensor[0](m,n)=svl[m]*df[0][n]+df[0][m]*svl[n];
@@ -401,18 +448,10 @@ void TetrahedronHyperelasticityFEMForceField<DataTypes>::updateTangentMatrix()
             }
 
             for(int m=0; m<3; m++){
-
-                m_myMaterial->applyElasticityTensor(tetInfo,globalParameters,inputTensor[m],outputTensor);
-                Coord vectortemp=df*(outputTensor*svk);
-                Matrix3 Nv;
-                //Nv.clear();
-                for(int u=0; u<3;u++){
-                    Nv[u][m]=vectortemp[u];
-                }
-                N+=Nv.transposed();
+                material->Material::applyElasticityTensor(tetInfo,globalParameters,inputTensor[m],outputTensor);
+                N[m]=df*(outputTensor*svk);
             }
 
-
             //Now M
             Real productSD=0;
 
@@ -421,12 +460,46 @@ void TetrahedronHyperelasticityFEMForceField<DataTypes>::updateTangentMatrix()
             M[0][1]=M[0][2]=M[1][0]=M[1][2]=M[2][0]=M[2][1]=0;
             M[0][0]=M[1][1]=M[2][2]=(Real)productSD;
 
-            edgeDfDx += (M+N)*tetInfo->m_restVolume;
-
-
+            m_tetrahedronEdgeStiffness[6*i+j] = (M+N)*tetInfo->m_restVolume;
         }// end of for j
     }//end of for i
-    m_updateMatrix=false;
+
+    m_tetrahedronInfo.endEdit();
+}
+
+template <class DataTypes>
+void TetrahedronHyperelasticityFEMForceField<DataTypes>::updateContributions()
+{
+    const unsigned int nbTetrahedra=m_topology->getNbTetrahedra();
+    const unsigned int nbEdges=m_topology->getNbEdges();
+    const unsigned int nbVertices=this->mstate->getSize();
+    if (m_contributionsRevision==m_topology->getRevision() && m_vertexContributions.size()==4*nbTetrahedra && m_vertexContributionsBegin.size()==nbVertices+1
+            && m_edgeContributions.size()==6*nbTetrahedra && m_edgeContributionsBegin.size()==nbEdges+1)
+        return;
+    m_contributionsRevision=m_topology->getRevision();
+
+    const std::vector< Tetrahedron> &tetrahedronArray=m_topology->getTetrahedra() ;
+    m_vertexContributionsBegin.assign(nbVertices+1,0);
+    m_edgeContributionsBegin.assign(nbEdges+1,0);
+    for(unsigned int i=0; i<nbTetrahedra; i++ )
+    {
+        const BaseMeshTopology::EdgesInTetrahedron &te=m_topology->getEdgesInTetrahedron(i);
+        for(unsigned int l=0;l<4;l++) if(tetrahedronArray[i][l]<nbVertices) m_vertexContributionsBegin[tetrahedronArray[i][l]+1]++;
+        for(unsigned int j=0;j<6;j++) if(te[j]<nbEdges) m_edgeContributionsBegin[te[j]+1]++;
+    }
+    for(unsigned int v=0; v<nbVertices; v++) m_vertexContributionsBegin[v+1]+=m_vertexContributionsBegin[v];
+    for(unsigned int e=0; e<nbEdges; e++) m_edgeContributionsBegin[e+1]+=m_edgeContributionsBegin[e];
+
+    helper::vector<unsigned int> vertexCursor(m_vertexContributionsBegin.begin(),m_vertexContributionsBegin.end()-1);
+    helper::vector<unsigned int> edgeCursor(m_edgeContributionsBegin.begin(),m_edgeContributionsBegin.end()-1);
+    m_vertexContributions.resize(m_vertexContributionsBegin[nbVertices]);
+    m_edgeContributions.resize(m_edgeContributionsBegin[nbEdges]);
+    for(unsigned int i=0; i<nbTetrahedra; i++ )
+    {
+        const BaseMeshTopology::EdgesInTetrahedron &te=m_topology->getEdgesInTetrahedron(i);
+        for(unsigned int l=0;l<4;l++) if(tetrahedronArray[i][l]<nbVertices) m_vertexContributions[vertexCursor[tetrahedronArray[i][l]]++]=4*i+l;
+        for(unsigned int j=0;j<6;j++) if(te[j]<nbEdges) m_edgeContributions[edgeCursor[te[j]]++]=6*i+j;
+    }
 }
 
 
@@ -59,6 +59,8 @@ class VerondaWestman : public HyperelasticMaterial<DataTypes>{
   typedef defaulttype::Mat<6,6,Real> Matrix6;
   typedef defaulttype::MatSym<3,Real> MatrixSym;
 
+public:
+
 	virtual Real getStrainEnergy(StrainInformation<DataTypes> *sinfo, const MaterialParameters<DataTypes> &param) {
 		MatrixSym C=sinfo->deformationTensor;
 		Real I1=sinfo->trC;
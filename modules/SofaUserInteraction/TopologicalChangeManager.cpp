@@ -57,6 +57,7 @@ using namespace sofa::component::topology;
 using helper::vector;
 
 TopologicalChangeManager::TopologicalChangeManager()
+    : m_inTransaction(false)
 {
     incision.firstCut = true;
     incision.indexPoint = core::topology::BaseMeshTopology::InvalidID;
@@ -154,23 +155,7 @@ int TopologicalChangeManager::removeItemsFromTriangleModel(sofa::component::coll
         }
     }
 
-    sofa::helper::vector<unsigned int> vitems;
-    vitems.reserve(items.size());
-    vitems.insert(vitems.end(), items.rbegin(), items.rend());
-
-    int res = vitems.size();
-
-    sofa::core::topology::TopologyModifier* topoMod;
-    topo_curr->getContext()->get(topoMod);
-
-    topoMod->removeItems(vitems);
-
-    topoMod->notifyEndingEvent();
-
-
-    topoMod->propagateTopologicalChanges();
-
-    return res;
+    return removeItemsFromTopology(topo_curr, items);
 }
 
 #if 0
@@ -316,21 +301,62 @@ int TopologicalChangeManager::removeItemsFromSphereModel(sofa::component::collis
         }
     }
 
+    return removeItemsFromTopology(topo_curr, items);
+}
+
+/// Removes the elements of a topology, in decreasing order
+static int removeTopologyItems(sofa::core::topology::TopologyModifier* topoMod, const std::set< unsigned int >& items)
+{
     sofa::helper::vector<unsigned int> vitems;
     vitems.reserve(items.size());
     vitems.insert(vitems.end(), items.rbegin(), items.rend());
 
-    int res = vitems.size();
-
-    sofa::core::topology::TopologyModifier* topoMod;
-    topo_curr->getContext()->get(topoMod);
-
     topoMod->removeItems(vitems);
 
     topoMod->notifyEndingEvent();
 
     topoMod->propagateTopologicalChanges();
 
+    return vitems.size();
+}
+
+int TopologicalChangeManager::removeItemsFromTopology(sofa::core::topology::BaseMeshTopology* topology, const std::set< unsigned int >& items) const
+{
+    sofa::core::topology::TopologyModifier* topoMod;
+    topology->getContext()->get(topoMod);
+    if (topoMod == NULL || items.empty())
+        return 0;
+
+    if (m_inTransaction)
+    {
+        std::set< unsigned int >& transactionItems = m_transactionItems[topoMod];
+        const std::size_t nbItems = transactionItems.size();
+        transactionItems.insert(items.begin(), items.end());
+        return (int)(transactionItems.size() - nbItems);
+    }
+
+    return removeTopologyItems(topoMod, items);
+}
+
+void TopologicalChangeManager::beginTransaction()
+{
+    if (m_inTransaction)
+        msg_warning("TopologicalChangeManager") << "A transaction is already started, its removals will be committed with the new one.";
+    m_inTransaction = true;
+}
+
+int TopologicalChangeManager::commitTransaction()
+{
+    m_inTransaction = false;
+
+    std::map< sofa::core::topology::TopologyModifier*, std::set< unsigned int > > transactionItems;
+    transactionItems.swap(m_transactionItems);
+
+    int res = 0;
+    for (std::map< sofa::core::topology::TopologyModifier*, std::set< unsigned int > >::const_iterator it = transactionItems.begin(); it != transactionItems.end(); ++it)
+    {
+        res += removeTopologyItems(it->first, it->second);
+    }
     return res;
 }
 
@@ -27,6 +27,7 @@
 
 #include <sofa/core/BehaviorModel.h>
 #include <sofa/core/topology/BaseMeshTopology.h>
+#include <sofa/core/topology/BaseTopology.h>
 
 #include <SofaMeshCollision/TriangleModel.h>
 #include <SofaBaseCollision/SphereModel.h>
@@ -37,6 +38,9 @@
 #include <SofaBaseMechanics/MechanicalObject.h>
 #include <sofa/simulation/Node.h>
 
+#include <map>
+#include <set>
+
 
 namespace sofa
 {
@@ -64,6 +68,26 @@ public:
     int removeItemsFromCollisionModel(sofa::core::CollisionModel* model, const int& index) const;
     int removeItemsFromCollisionModel(sofa::core::CollisionModel* model, const helper::vector<int>& indices) const;
 
+    /** Starts a transaction: the elements given to removeItemsFromCollisionModel are only collected
+     * until commitTransaction() is called.
+     *
+     * The removed elements are converted to the elements of the modified topology as they are given,
+     * so all the indices given during a transaction refer to the topologies before the transaction.
+     */
+    void beginTransaction();
+
+    /** Removes at once all the elements collected since beginTransaction().
+     *
+     * The elements of each topology are removed in a single call to its TopologyModifier, so that
+     * a single topological change is propagated to its TopologyData.
+     *
+     * @return int - number of removed elements.
+     */
+    int commitTransaction();
+
+    /// Is a transaction started with beginTransaction() and not yet committed
+    bool isInTransaction() const { return m_inTransaction; }
+
 
     /** Handles Cutting (activated only for a triangular topology)
      *
@@ -155,7 +179,15 @@ private:
 #endif
     int removeItemsFromSphereModel(sofa::component::collision::SphereModel* model, const helper::vector<int>& indices) const;
 
+    /// Removes the given elements of a topology, or collect them if a transaction is started
+    int removeItemsFromTopology(sofa::core::topology::BaseMeshTopology* topology, const std::set< unsigned int >& items) const;
+
 private:
+    bool m_inTransaction;
+
+    /// Elements to remove at the end of the transaction, for each topology
+    mutable std::map< sofa::core::topology::TopologyModifier*, std::set< unsigned int > > m_transactionItems;
+
     /// Global variables to register intermediate informations for point to point incision.(incision along one segment in a triangular mesh)
     struct Incision
     {